@@ -0,0 +1,184 @@
+/**
+ * File: BenchBitset.c
+ * ----------------------
+ * Holds two random sets of ids from a dense range of N_BITS, each id present
+ * with probability a quarter, both as sorted vectors of uint64_t and as
+ * bitsets, and compares
+ *
+ *   memory     - bytes per id stored
+ *   test       - N_PROBES random membership tests, bitset_test against
+ *                vector_search's binary search
+ *   intersect  - vector_intersect_sorted against bitset_and into a copy,
+ *                and against the same and written as a plain loop over
+ *                words
+ *   count      - bitset_count against a loop of __builtin_popcountll, which
+ *                compiles to a library call without -mpopcnt
+ *   rank       - N_PROBES random bitset_rank and bitset_select calls
+ *   iterate    - summing every id from the vector's array, and through a
+ *                bitset_iter one id per call and a batch per call
+ */
+#include "Bitset.h"
+#include "BenchCommon.h"
+#include <stdio.h>
+#include <string.h>
+
+#define N_BITS    (64UL * 1024 * 1024)
+#define N_PROBES  (4000000UL)
+#define N_BATCH   (256)
+
+static void
+make_ids (vector *v, bitset *bs)
+{
+	uint64_t id;
+
+	for (id = 0; id < N_BITS; id++)
+	{
+		if (rng_next () % 4 == 0)
+		{
+			vector_append (v, &id);
+			bitset_set (bs, id);
+		}
+	}
+}
+
+static void __attribute__ ((noinline))
+and_words (uint64_t *dst, const uint64_t *src, size_t n)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++)
+	{
+		dst[i] &= src[i];
+	}
+}
+
+static size_t __attribute__ ((noinline))
+count_words (const uint64_t *words, size_t n)
+{
+	size_t i, count = 0;
+
+	for (i = 0; i < n; i++)
+	{
+		count += (size_t)__builtin_popcountll (words[i]);
+	}
+	return count;
+}
+
+static uint64_t __attribute__ ((noinline))
+scan_ids (const uint64_t *ids, size_t n)
+{
+	uint64_t sum = 0;
+	size_t i;
+
+	for (i = 0; i < n; i++)
+	{
+		sum += ids[i];
+	}
+	return sum;
+}
+
+int
+main (void)
+{
+	vector *va = vector_init (sizeof (uint64_t), 0, NULL), *vb = vector_init (sizeof (uint64_t), 0, NULL);
+	vector *out = vector_init (sizeof (uint64_t), 0, NULL);
+	bitset *a = bitset_init (N_BITS), *b = bitset_init (N_BITS), *dst = bitset_init (N_BITS);
+	size_t n_words = N_BITS / 64, i, n_v = 0, n_b = 0, pos, batch[N_BATCH];
+	uint64_t *probes = malloc (N_PROBES * sizeof (uint64_t)), sum_v = 0, sum_b = 0;
+	double start, t;
+	bitset_iter it;
+
+	make_ids (va, a);
+	make_ids (vb, b);
+	for (i = 0; i < N_PROBES; i++)
+	{
+		probes[i] = rng_next () % N_BITS;
+	}
+
+	printf ("%lu ids in a range of %lu\n", vector_size (va), N_BITS);
+	printf ("  memory     vector %8.2f bytes per id   bitset %8.2f bytes per id\n",
+	        (double)sizeof (uint64_t), (double)(N_BITS / 8) / (double)vector_size (va));
+
+	start = now_sec ();
+	for (i = 0; i < N_PROBES; i++)
+	{
+		n_v += vector_search (va, &probes[i], vector_compare_u64, true) != NULL;
+	}
+	t = now_sec () - start;
+	start = now_sec ();
+	for (i = 0; i < N_PROBES; i++)
+	{
+		n_b += bitset_test (a, probes[i]);
+	}
+	printf ("  test       vector %8.2f ns per id      bitset %8.2f ns per id%s\n",
+	        t * 1e9 / N_PROBES, (now_sec () - start) * 1e9 / N_PROBES, (n_v == n_b) ? "" : "  MISMATCH");
+
+	start = now_sec ();
+	n_v = vector_intersect_sorted (out, va, vb, vector_compare_u64);
+	t = now_sec () - start;
+	memcpy (dst->words, a->words, n_words * sizeof (uint64_t));
+	start = now_sec ();
+	bitset_and (dst, b);
+	printf ("  intersect  vector %8.2f ms             bitset %8.2f ms", t * 1e3, (now_sec () - start) * 1e3);
+	n_b = bitset_count (dst);
+	memcpy (dst->words, a->words, n_words * sizeof (uint64_t));
+	start = now_sec ();
+	and_words (dst->words, b->words, n_words);
+	printf ("   word loop %6.2f ms%s\n", (now_sec () - start) * 1e3, (n_v == n_b) ? "" : "  MISMATCH");
+
+	start = now_sec ();
+	n_b = bitset_count (a);
+	t = now_sec () - start;
+	start = now_sec ();
+	n_v = count_words (a->words, n_words);
+	printf ("  count      bitset %8.2f ms %6.2f GB/s  popcount loop %6.2f ms%s\n", t * 1e3,
+	        (double)(N_BITS / 8) / (t * 1e9), (now_sec () - start) * 1e3, (n_v == n_b) ? "" : "  MISMATCH");
+
+	start = now_sec ();
+	bitset_rank (a, 0);
+	printf ("  rank       index built in %6.2f ms", (now_sec () - start) * 1e3);
+	start = now_sec ();
+	for (i = 0; i < N_PROBES; i++)
+	{
+		sum_b += bitset_rank (a, probes[i]);
+	}
+	t = now_sec () - start;
+	start = now_sec ();
+	for (i = 0; i < N_PROBES; i++)
+	{
+		sum_b += bitset_select (a, probes[i] % n_b);
+	}
+	printf ("  rank %6.2f ns   select %6.2f ns\n", t * 1e9 / N_PROBES, (now_sec () - start) * 1e9 / N_PROBES);
+
+	start = now_sec ();
+	sum_v = scan_ids (vector_access (va, 0), vector_size (va));
+	t = now_sec () - start;
+	printf ("  iterate    vector %8.2f ms", t * 1e3);
+
+	sum_b = 0;
+	start = now_sec ();
+	bitset_iter_init (a, &it, 0);
+	while (bitset_iter_next (&it, &pos))
+	{
+		sum_b += pos;
+	}
+	printf ("             bitset %8.2f ms%s", (now_sec () - start) * 1e3, (sum_v == sum_b) ? "" : "  MISMATCH");
+
+	sum_b = 0;
+	start = now_sec ();
+	bitset_iter_init (a, &it, 0);
+	while ((n_b = bitset_iter_next_many (&it, batch, N_BATCH)) > 0)
+	{
+		sum_b += scan_ids (batch, n_b);
+	}
+	printf ("   batches of %d %6.2f ms%s\n", N_BATCH, (now_sec () - start) * 1e3, (sum_v == sum_b) ? "" : "  MISMATCH");
+
+	free (probes);
+	bitset_destroy (a);
+	bitset_destroy (b);
+	bitset_destroy (dst);
+	vector_destroy (va);
+	vector_destroy (vb);
+	vector_destroy (out);
+	return 0;
+}
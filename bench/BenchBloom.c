@@ -0,0 +1,159 @@
+/**
+ * File: BenchBloom.c
+ * ----------------------
+ * Two parts. The first sizes a filter for N_FILTER random 8 byte keys at
+ * each of several false positive rates, too large for the caches, and
+ * reports the block width chosen, bytes per key, the expected and measured
+ * false positive rates, and the ns per query of bloom_contains against
+ * bloom_contains_many, whose prefetching overlaps the misses.
+ *
+ * The second puts N_KEYS keys in a set with and without set_use_filter at
+ * SET_RATE and times N_PROBES set_contains calls at several miss ratios. A
+ * hit pays the filter's miss on top of the tree's, so the filter only wins
+ * once most lookups are for absent keys.
+ *
+ * Added keys have the low bit clear and absent keys have it set.
+ */
+#include "Bloom.h"
+#include "Set.h"
+#include "BenchCommon.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define N_FILTER (16000000UL)
+#define N_KEYS   (1000000UL)
+#define N_PROBES (4000000UL)
+#define SET_RATE (0.01)
+
+static int
+compare_u64 (const void *elem1, const void *elem2)
+{
+	const uint64_t *ptr1 = elem1;
+	const uint64_t *ptr2 = elem2;
+
+	return (*ptr1 > *ptr2) - (*ptr1 < *ptr2);
+}
+
+static size_t
+hash_u64 (const void *key)
+{
+	return *(const uint64_t *)key;
+}
+
+/* fills probes with keys, each absent with probability miss, the rest drawn from the n added */
+static void
+make_probes (uint64_t *probes, const uint64_t *keys, size_t n, double miss)
+{
+	size_t i;
+
+	for (i = 0; i < N_PROBES; i++)
+	{
+		if ((double)(rng_next () % 1000000) < miss * 1e6)
+		{
+			probes[i] = rng_next () | 1;
+		}
+		else
+		{
+			probes[i] = keys[rng_next () % n];
+		}
+	}
+}
+
+static void
+bench_rates (void)
+{
+	double rates[] = { 0.1, 0.01, 0.001, 0.0001 }, start, t_one;
+	uint64_t *keys = malloc (N_FILTER * sizeof (uint64_t));
+	uint64_t *probes = malloc (N_PROBES * sizeof (uint64_t));
+	bool *maybe = malloc (N_PROBES * sizeof (bool));
+	size_t r, i, n_one, n_many;
+	bloom *b;
+
+	for (i = 0; i < N_FILTER; i++)
+	{
+		keys[i] = rng_next () & ~1ULL;
+	}
+	make_probes (probes, keys, N_FILTER, 1.0);
+
+	printf ("filter of %lu keys, %lu absent probes\n", N_FILTER, N_PROBES);
+	printf ("  rate      words  bytes/key  expected fp  measured fp  contains ns  many ns\n");
+	for (r = 0; r < sizeof (rates) / sizeof (rates[0]); r++)
+	{
+		b = bloom_init (sizeof (uint64_t), N_FILTER, rates[r], hash_u64);
+		for (i = 0; i < N_FILTER; i++)
+		{
+			bloom_add (b, &keys[i]);
+		}
+
+		n_one = 0;
+		start = now_sec ();
+		for (i = 0; i < N_PROBES; i++)
+		{
+			n_one += bloom_contains (b, &probes[i]);
+		}
+		t_one = now_sec () - start;
+		start = now_sec ();
+		n_many = bloom_contains_many (b, probes, N_PROBES, maybe);
+		printf ("  %-8g  %5lu  %9.2f  %11.6f  %11.6f  %11.2f  %7.2f%s\n", rates[r], b->block_words,
+		        (double)bloom_bytes (b) / N_FILTER, bloom_fp_rate (b), (double)n_one / N_PROBES,
+		        t_one * 1e9 / N_PROBES, (now_sec () - start) * 1e9 / N_PROBES, (n_one == n_many) ? "" : "  MISMATCH");
+		bloom_destroy (b);
+	}
+	free (keys);
+	free (probes);
+	free (maybe);
+}
+
+static void
+bench_set (void)
+{
+	double misses[] = { 0.0, 0.5, 0.9, 0.99, 1.0 }, start, t_plain, t_filtered;
+	uint64_t *keys = malloc (N_KEYS * sizeof (uint64_t));
+	uint64_t *probes = malloc (N_PROBES * sizeof (uint64_t));
+	set *plain = set_init (sizeof (uint64_t), compare_u64, NULL);
+	set *filtered = set_init (sizeof (uint64_t), compare_u64, NULL);
+	size_t m, i, n_plain, n_filtered;
+
+	set_use_filter (filtered, hash_u64, SET_RATE);
+	for (i = 0; i < N_KEYS; i++)
+	{
+		keys[i] = rng_next () & ~1ULL;
+		set_add (plain, &keys[i]);
+		set_add (filtered, &keys[i]);
+	}
+
+	printf ("set of %lu keys, filter at %g using %.2f bytes per key\n", N_KEYS, SET_RATE,
+	        (double)bloom_bytes (filtered->filter) / N_KEYS);
+	printf ("  miss ratio  set ns  filtered ns  speedup\n");
+	for (m = 0; m < sizeof (misses) / sizeof (misses[0]); m++)
+	{
+		make_probes (probes, keys, N_KEYS, misses[m]);
+		n_plain = n_filtered = 0;
+		start = now_sec ();
+		for (i = 0; i < N_PROBES; i++)
+		{
+			n_plain += set_contains (plain, &probes[i]);
+		}
+		t_plain = now_sec () - start;
+		start = now_sec ();
+		for (i = 0; i < N_PROBES; i++)
+		{
+			n_filtered += set_contains (filtered, &probes[i]);
+		}
+		t_filtered = now_sec () - start;
+		printf ("  %10.2f  %6.2f  %11.2f  %6.2fx%s\n", misses[m], t_plain * 1e9 / N_PROBES, t_filtered * 1e9 / N_PROBES,
+		        t_plain / t_filtered, (n_plain == n_filtered) ? "" : "  MISMATCH");
+	}
+	set_destroy (plain);
+	set_destroy (filtered);
+	free (keys);
+	free (probes);
+}
+
+int
+main (void)
+{
+	bench_rates ();
+	bench_set ();
+	return 0;
+}
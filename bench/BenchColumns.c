@@ -0,0 +1,128 @@
+/**
+ * File: BenchColumns.c
+ * ----------------------
+ * Filters N_ROWS 64 byte trade records on one field, counting those priced
+ * above a threshold that about a tenth pass, three ways:
+ *
+ *   vector_access - the record vector read through vector_access per row
+ *   vector stride - the record vector's array walked directly, reading the
+ *                   price of each record, so every 64 byte line is loaded
+ *                   for 4 useful bytes
+ *   columns       - the price column of a columns holding the same rows,
+ *                   one dense array of floats the compiler vectorizes
+ *
+ * Each is timed over N_REPS scans and reported as rows per nanosecond and
+ * the memory bandwidth the scan drew.
+ */
+#include "Columns.h"
+#include "BenchCommon.h"
+#include <stddef.h>
+#include <stdio.h>
+
+#define N_ROWS  (8000000UL)
+#define N_REPS  (5)
+#define CUTOFF  (900.0f)
+
+typedef struct
+{
+	uint64_t id;
+	float price;
+	uint32_t qty;
+	uint8_t payload[48];
+} trade;
+
+static size_t __attribute__ ((noinline))
+scan_access (vector *v)
+{
+	size_t i, n = 0;
+
+	for (i = 0; i < vector_size (v); i++)
+	{
+		n += ((trade *)vector_access (v, i))->price > CUTOFF;
+	}
+	return n;
+}
+
+static size_t __attribute__ ((noinline))
+scan_stride (const trade *rows, size_t n_rows)
+{
+	size_t i, n = 0;
+
+	for (i = 0; i < n_rows; i++)
+	{
+		n += rows[i].price > CUTOFF;
+	}
+	return n;
+}
+
+static size_t __attribute__ ((noinline))
+scan_column (const float *price, size_t n_rows)
+{
+	size_t i;
+	uint32_t n = 0;
+
+	for (i = 0; i < n_rows; i++)
+	{
+		n += price[i] > CUTOFF;
+	}
+	return n;
+}
+
+static void
+report (const char *name, double t, size_t bytes_per_row, size_t n)
+{
+	printf ("  %-14s %8.2f ms  %6.2f rows/ns  %6.2f GB/s  (%lu pass)\n", name, t * 1e3,
+	        (double)N_ROWS / (t * 1e9), (double)(N_ROWS * bytes_per_row) / (t * 1e9), n);
+}
+
+int
+main (void)
+{
+	size_t sz[] = { sizeof (uint64_t), sizeof (float), sizeof (uint32_t), 48 };
+	size_t off[] = { offsetof (trade, id), offsetof (trade, price), offsetof (trade, qty),
+	                 offsetof (trade, payload) };
+	vector *v = vector_init (sizeof (trade), N_ROWS, NULL);
+	double start, best_access = 1e9, best_stride = 1e9, best_column = 1e9, t;
+	size_t i, n_access = 0, n_stride = 0, n_column = 0;
+	columns *c;
+	trade row = { 0 };
+
+	for (i = 0; i < N_ROWS; i++)
+	{
+		row.id = i;
+		row.price = (float)(rng_next () % 1000);
+		row.qty = (uint32_t)(rng_next () % 100);
+		vector_append (v, &row);
+	}
+	start = now_sec ();
+	c = columns_from_vector (v, 4, sz, off);
+	t = now_sec () - start;
+
+	printf ("filter %lu rows of %lu bytes on one 4 byte field, best of %d (columns_from_vector %.2f ms)\n",
+	        N_ROWS, sizeof (trade), N_REPS, t * 1e3);
+	for (i = 0; i < N_REPS; i++)
+	{
+		start = now_sec ();
+		n_access = scan_access (v);
+		t = now_sec () - start;
+		best_access = (t < best_access) ? t : best_access;
+
+		start = now_sec ();
+		n_stride = scan_stride (vector_access (v, 0), N_ROWS);
+		t = now_sec () - start;
+		best_stride = (t < best_stride) ? t : best_stride;
+
+		start = now_sec ();
+		n_column = scan_column (columns_column (c, 1), columns_size (c));
+		t = now_sec () - start;
+		best_column = (t < best_column) ? t : best_column;
+	}
+
+	report ("vector_access", best_access, sizeof (trade), n_access);
+	report ("vector stride", best_stride, sizeof (trade), n_stride);
+	report ("columns", best_column, sizeof (float), n_column);
+
+	columns_destroy (c);
+	vector_destroy (v);
+	return 0;
+}
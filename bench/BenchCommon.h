@@ -0,0 +1,50 @@
+/**
+ * File: BenchCommon.h
+ * ------------------------------------------------------
+ * The helpers every benchmark uses: a xorshift generator from a fixed seed,
+ * so each run measures the same keys, and a monotonic clock.
+ */
+
+#ifndef BENCH_COMMON_H
+#define BENCH_COMMON_H
+
+#include <stdint.h>
+#include <time.h>
+
+#define RNG_SEED (0x2545f4914f6cdd1dULL)
+
+static uint64_t rng_state = RNG_SEED;
+
+/* advances a generator of the caller's, for benches that run one per thread */
+static inline uint64_t
+rng_step (uint64_t *state)
+{
+	*state ^= *state << 13;
+	*state ^= *state >> 7;
+	*state ^= *state << 17;
+	return *state;
+}
+
+static inline uint64_t
+rng_next (void)
+{
+	return rng_step (&rng_state);
+}
+
+static inline uint64_t
+now_ns (void)
+{
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static inline double
+now_sec (void)
+{
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+#endif /* BENCH_COMMON_H */
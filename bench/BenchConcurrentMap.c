@@ -0,0 +1,164 @@
+/**
+ * File: BenchConcurrentMap.c
+ * ----------------------
+ * Runs a fixed number of operations per thread against a prefilled
+ * concurrent_map at 1 to 32 threads, for a read only, a read mostly and a
+ * write heavy mix, and reports total throughput. A hashset behind a single
+ * mutex runs the same mixes as the baseline.
+ */
+#include "ConcurrentMap.h"
+#include "HashSet.h"
+#include "BenchCommon.h"
+#include <pthread.h>
+#include <stdio.h>
+
+#define N_KEYS         (1000000UL)
+#define OPS_PER_THREAD (2000000UL)
+#define MAX_THREADS    (32)
+
+typedef struct
+{
+	const char *name;
+	unsigned write_pct;
+	bool locked;
+} bench_mix;
+
+typedef struct
+{
+	const bench_mix *mix;
+	uint64_t rng;
+	size_t found;
+} bench_arg;
+
+static concurrent_map *map;
+static hashset *locked_set;
+static pthread_mutex_t set_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static size_t
+hash_u64 (const void *key)
+{
+	return (size_t)*(const uint64_t *)key;
+}
+
+static int
+compare_u64 (const void *elem1, const void *elem2)
+{
+	const uint64_t *ptr1 = elem1;
+	const uint64_t *ptr2 = elem2;
+
+	return (*ptr1 > *ptr2) - (*ptr1 < *ptr2);
+}
+
+/* half of the writes remove, so the map stays near its starting size */
+static void *
+worker (void *arg)
+{
+	bench_arg *a = arg;
+	uint64_t key, r, val;
+	size_t i;
+
+	for (i = 0; i < OPS_PER_THREAD; i++)
+	{
+		r = rng_step (&a->rng);
+		key = r % (2 * N_KEYS);
+
+		if (a->mix->locked)
+		{
+			pthread_mutex_lock (&set_lock);
+			if ((r >> 32) % 100 >= a->mix->write_pct)
+			{
+				a->found += hashset_contains (locked_set, &key);
+			}
+			else if ((r >> 32) & 1)
+			{
+				hashset_add (locked_set, &key);
+			}
+			else
+			{
+				hashset_remove (locked_set, &key);
+			}
+			pthread_mutex_unlock (&set_lock);
+		}
+		else if ((r >> 32) % 100 >= a->mix->write_pct)
+		{
+			a->found += concurrent_map_get (map, &key, &val);
+		}
+		else if ((r >> 32) & 1)
+		{
+			concurrent_map_put (map, &key, &r);
+		}
+		else
+		{
+			concurrent_map_remove (map, &key);
+		}
+	}
+	return NULL;
+}
+
+static void
+bench_mix_run (const bench_mix *mix)
+{
+	pthread_t threads[MAX_THREADS];
+	bench_arg args[MAX_THREADS];
+	size_t n_threads, i;
+	uint64_t key;
+	double start, elapsed;
+
+	for (n_threads = 1; n_threads <= MAX_THREADS; n_threads *= 2)
+	{
+		map = concurrent_map_init (sizeof (uint64_t), sizeof (uint64_t), hash_u64,
+		                           compare_u64, NULL);
+		locked_set = hashset_init (sizeof (uint64_t), hash_u64, compare_u64, NULL);
+		for (key = 0; key < 2 * N_KEYS; key += 2)
+		{
+			if (mix->locked)
+			{
+				hashset_add (locked_set, &key);
+			}
+			else
+			{
+				concurrent_map_put (map, &key, &key);
+			}
+		}
+
+		start = now_sec ();
+		for (i = 0; i < n_threads; i++)
+		{
+			args[i].mix = mix;
+			args[i].rng = RNG_SEED * (i + 1);
+			args[i].found = 0;
+			pthread_create (&threads[i], NULL, worker, &args[i]);
+		}
+		for (i = 0; i < n_threads; i++)
+		{
+			pthread_join (threads[i], NULL);
+		}
+		elapsed = now_sec () - start;
+
+		printf ("%-22s %2zu threads: %8.2f Mops/s\n", mix->name, n_threads,
+		        (double)(n_threads * OPS_PER_THREAD) / elapsed / 1e6);
+
+		concurrent_map_destroy (map);
+		hashset_destroy (locked_set);
+	}
+}
+
+int
+main (void)
+{
+	static const bench_mix mixes[] = {
+		{ "concurrent_map  0% w", 0, false },
+		{ "concurrent_map 10% w", 10, false },
+		{ "concurrent_map 50% w", 50, false },
+		{ "mutex+hashset   0% w", 0, true },
+		{ "mutex+hashset  50% w", 50, true },
+	};
+	size_t i;
+
+	for (i = 0; i < sizeof (mixes) / sizeof (mixes[0]); i++)
+	{
+		bench_mix_run (&mixes[i]);
+	}
+
+	return 0;
+}
@@ -0,0 +1,115 @@
+/**
+ * File: BenchFlatSet.c
+ * ----------------------
+ * Builds a flat_set and a set from the same random keys and compares build
+ * time, lookup time and memory. The flat_set is built both one insert at a
+ * time, up to the size where that stays reasonable, and with one
+ * insert_many. Memory for the set counts each node as the allocator rounds
+ * it: a header word plus the node, rounded up to 16 bytes.
+ */
+#include "FlatSet.h"
+#include "Set.h"
+#include "BenchCommon.h"
+#include <stdio.h>
+
+#define N_LOOKUPS      (4000000UL)
+#define MAX_ONE_BY_ONE (100000UL)
+
+static int
+compare_u64 (const void *elem1, const void *elem2)
+{
+	const uint64_t *ptr1 = elem1;
+	const uint64_t *ptr2 = elem2;
+
+	return (*ptr1 > *ptr2) - (*ptr1 < *ptr2);
+}
+
+static void
+bench_size (size_t n)
+{
+	uint64_t *keys = malloc (n * sizeof (uint64_t));
+	flat_set *fs;
+	set *s;
+	size_t i, found = 0, set_node;
+	double start, fs_single = 0, fs_batch, s_build, fs_lookup, s_lookup;
+
+	for (i = 0; i < n; i++)
+	{
+		keys[i] = rng_next ();
+	}
+
+	if (n <= MAX_ONE_BY_ONE)
+	{
+		fs = flat_set_init (sizeof (uint64_t), compare_u64, NULL);
+		start = now_sec ();
+		for (i = 0; i < n; i++)
+		{
+			flat_set_insert (fs, &keys[i]);
+		}
+		fs_single = now_sec () - start;
+		flat_set_destroy (fs);
+	}
+
+	fs = flat_set_init (sizeof (uint64_t), compare_u64, NULL);
+	start = now_sec ();
+	flat_set_insert_many (fs, keys, n);
+	fs_batch = now_sec () - start;
+
+	s = set_init (sizeof (uint64_t), compare_u64, NULL);
+	start = now_sec ();
+	for (i = 0; i < n; i++)
+	{
+		set_add (s, &keys[i]);
+	}
+	s_build = now_sec () - start;
+
+	start = now_sec ();
+	for (i = 0; i < N_LOOKUPS; i++)
+	{
+		found += flat_set_contains (fs, &keys[rng_next () % n]);
+	}
+	fs_lookup = now_sec () - start;
+
+	start = now_sec ();
+	for (i = 0; i < N_LOOKUPS; i++)
+	{
+		found += set_contains (s, &keys[rng_next () % n]);
+	}
+	s_lookup = now_sec () - start;
+
+	set_node = (sizeof (size_t) + sizeof (set_elem) + sizeof (uint64_t) + 15) & ~(size_t)15;
+
+	printf ("%8zu keys\n", n);
+	if (n <= MAX_ONE_BY_ONE)
+	{
+		printf ("  build:  flat_set insert %8.2f ms  insert_many %8.2f ms  set %8.2f ms\n",
+		        fs_single * 1e3, fs_batch * 1e3, s_build * 1e3);
+	}
+	else
+	{
+		printf ("  build:  flat_set insert_many %8.2f ms  set %8.2f ms\n",
+		        fs_batch * 1e3, s_build * 1e3);
+	}
+	printf ("  lookup: flat_set %6.1f ns  set %6.1f ns  (%zu)\n",
+	        fs_lookup * 1e9 / N_LOOKUPS, s_lookup * 1e9 / N_LOOKUPS, found);
+	printf ("  memory: flat_set %6.1f B/key  set %6.1f B/key\n",
+	        (double)(fs->elems->capacity * sizeof (uint64_t)) / (double)flat_set_size (fs),
+	        (double)set_node);
+
+	flat_set_destroy (fs);
+	set_destroy (s);
+	free (keys);
+}
+
+int
+main (void)
+{
+	size_t n;
+
+	for (n = 1000; n <= 10000000; n *= 10)
+	{
+		bench_size (n);
+	}
+
+	return 0;
+}
@@ -0,0 +1,100 @@
+/**
+ * File: BenchHashSet.c
+ * ----------------------
+ * Fills a hashset and a set with the same random keys, then times lookups
+ * of keys that are present and of keys that are not, at several sizes.
+ */
+#include "HashSet.h"
+#include "Set.h"
+#include "BenchCommon.h"
+#include <stdio.h>
+
+#define N_LOOKUPS  (4000000UL)
+
+static size_t
+hash_u64 (const void *key)
+{
+	return (size_t)*(const uint64_t *)key;
+}
+
+static int
+compare_u64 (const void *elem1, const void *elem2)
+{
+	const uint64_t *ptr1 = elem1;
+	const uint64_t *ptr2 = elem2;
+
+	return (*ptr1 > *ptr2) - (*ptr1 < *ptr2);
+}
+
+/*
+ * Present keys are even and absent keys odd, so a miss is never a hit by
+ * accident.
+ */
+static void
+bench_size (size_t n)
+{
+	hashset *h = hashset_init (sizeof (uint64_t), hash_u64, compare_u64, NULL);
+	set *s = set_init (sizeof (uint64_t), compare_u64, NULL);
+	uint64_t *keys = malloc (n * sizeof (uint64_t)), probe;
+	size_t i, found;
+	double start, hs_hit, hs_miss, s_hit, s_miss;
+
+	for (i = 0; i < n; i++)
+	{
+		keys[i] = rng_next () & ~1ULL;
+		hashset_add (h, &keys[i]);
+		set_add (s, &keys[i]);
+	}
+
+	found = 0;
+	start = now_sec ();
+	for (i = 0; i < N_LOOKUPS; i++)
+	{
+		found += hashset_contains (h, &keys[rng_next () % n]);
+	}
+	hs_hit = now_sec () - start;
+
+	start = now_sec ();
+	for (i = 0; i < N_LOOKUPS; i++)
+	{
+		probe = rng_next () | 1;
+		found += hashset_contains (h, &probe);
+	}
+	hs_miss = now_sec () - start;
+
+	start = now_sec ();
+	for (i = 0; i < N_LOOKUPS; i++)
+	{
+		found += set_contains (s, &keys[rng_next () % n]);
+	}
+	s_hit = now_sec () - start;
+
+	start = now_sec ();
+	for (i = 0; i < N_LOOKUPS; i++)
+	{
+		probe = rng_next () | 1;
+		found += set_contains (s, &probe);
+	}
+	s_miss = now_sec () - start;
+
+	printf ("%9zu keys  hashset hit %6.1f ns  miss %6.1f ns   set hit %6.1f ns  miss %6.1f ns  (%zu)\n",
+	        n, hs_hit * 1e9 / N_LOOKUPS, hs_miss * 1e9 / N_LOOKUPS,
+	        s_hit * 1e9 / N_LOOKUPS, s_miss * 1e9 / N_LOOKUPS, found);
+
+	hashset_destroy (h);
+	set_destroy (s);
+	free (keys);
+}
+
+int
+main (void)
+{
+	size_t n;
+
+	for (n = 1000; n <= 10000000; n *= 10)
+	{
+		bench_size (n);
+	}
+
+	return 0;
+}
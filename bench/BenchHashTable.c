@@ -0,0 +1,83 @@
+/**
+ * File: BenchHashTable.c
+ * ----------------------
+ * Inserts nodes into a hash_table from empty, timing every insert, and
+ * prints a histogram of insert latencies in power of two buckets. Inserts
+ * that trigger or continue a grow land in the same histogram, so the tail
+ * shows whether any single insert stalls on a resize.
+ */
+#include "HashTable.h"
+#include "BenchCommon.h"
+#include <stddef.h>
+#include <stdio.h>
+
+#define N_NODES    (10000000UL)
+#define N_BINS     (40)
+
+typedef struct
+{
+	hash_elem he;
+	uint64_t key;
+} bench_node;
+
+static size_t
+hash_u64 (const void *key)
+{
+	return (size_t)*(const uint64_t *)key;
+}
+
+static int
+compare_u64 (const void *elem1, const void *elem2)
+{
+	const uint64_t *ptr1 = elem1;
+	const uint64_t *ptr2 = elem2;
+
+	return (*ptr1 > *ptr2) - (*ptr1 < *ptr2);
+}
+
+int
+main (void)
+{
+	bench_node *nodes = malloc (N_NODES * sizeof (bench_node));
+	hash_table *t = hash_table_init (offsetof (bench_node, he),
+	                                 offsetof (bench_node, key),
+	                                 hash_u64, compare_u64, NULL);
+	size_t hist[N_BINS] = { 0 }, i, bin, seen = 0;
+	uint64_t start, elapsed, total = 0, worst = 0;
+
+	for (i = 0; i < N_NODES; i++)
+	{
+		nodes[i].key = rng_next ();
+	}
+
+	for (i = 0; i < N_NODES; i++)
+	{
+		start = now_ns ();
+		hash_table_insert (t, &nodes[i]);
+		elapsed = now_ns () - start;
+
+		total += elapsed;
+		worst = (elapsed > worst) ? elapsed : worst;
+		for (bin = 0; bin < N_BINS - 1 && ((uint64_t)1 << (bin + 1)) <= elapsed; bin++)
+			;
+		++hist[bin];
+	}
+
+	printf ("%lu inserts, mean %.1f ns, worst %lu ns\n",
+	        N_NODES, (double)total / N_NODES, (unsigned long)worst);
+	for (bin = 0; bin < N_BINS; bin++)
+	{
+		if (hist[bin] == 0)
+		{
+			continue;
+		}
+		seen += hist[bin];
+		printf ("  < %10lu ns: %9zu  (%.5f%% at or below)\n",
+		        (unsigned long)1 << (bin + 1), hist[bin], 100.0 * (double)seen / N_NODES);
+	}
+
+	hash_table_destroy (t);
+	free (nodes);
+
+	return 0;
+}
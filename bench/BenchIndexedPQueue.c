@@ -0,0 +1,199 @@
+/**
+ * File: BenchIndexedPQueue.c
+ * ----------------------
+ * Runs Dijkstra's shortest paths over a random directed graph of 1M
+ * vertices and 10M weighted edges. The ipqueue version lowers a vertex's key
+ * in place. The pqueue version pushes a duplicate on every improvement and
+ * skips stale entries when they are popped. Reports the time and the
+ * largest queue each one reached.
+ */
+#include "IndexedPQueue.h"
+#include "PQueue.h"
+#include "BenchCommon.h"
+#include <stdio.h>
+
+#define N_VERTICES (1000000UL)
+#define N_EDGES    (10000000UL)
+#define MAX_WEIGHT (1000U)
+
+typedef struct
+{
+	uint32_t *offsets;
+	uint32_t *targets;
+	uint32_t *weights;
+} graph;
+
+typedef struct
+{
+	uint64_t dist;
+	uint32_t vertex;
+} queued_path;
+
+static int
+compare_u64 (const void *elem1, const void *elem2)
+{
+	const uint64_t *ptr1 = elem1;
+	const uint64_t *ptr2 = elem2;
+
+	return (*ptr1 > *ptr2) - (*ptr1 < *ptr2);
+}
+
+/* queued_path starts with its distance, so it orders the same way */
+#define compare_path compare_u64
+
+/**
+ * Builds the graph in compressed sparse row form: the edges leaving vertex v
+ * are targets[offsets[v]] up to targets[offsets[v + 1]].
+ */
+static void
+graph_generate (graph *g)
+{
+	uint32_t *src = malloc (N_EDGES * sizeof (uint32_t));
+	uint32_t *fill = calloc (N_VERTICES + 1, sizeof (uint32_t));
+	size_t i, v;
+
+	g->offsets = calloc (N_VERTICES + 1, sizeof (uint32_t));
+	g->targets = malloc (N_EDGES * sizeof (uint32_t));
+	g->weights = malloc (N_EDGES * sizeof (uint32_t));
+
+	for (i = 0; i < N_EDGES; i++)
+	{
+		src[i] = (uint32_t)(rng_next () % N_VERTICES);
+		++g->offsets[src[i] + 1];
+	}
+	for (v = 0; v < N_VERTICES; v++)
+	{
+		g->offsets[v + 1] += g->offsets[v];
+	}
+	for (i = 0; i < N_EDGES; i++)
+	{
+		v = src[i];
+		g->targets[g->offsets[v] + fill[v]] = (uint32_t)(rng_next () % N_VERTICES);
+		g->weights[g->offsets[v] + fill[v]] = 1 + (uint32_t)(rng_next () % MAX_WEIGHT);
+		++fill[v];
+	}
+
+	free (src);
+	free (fill);
+}
+
+static uint64_t
+dijkstra_indexed (const graph *g, uint64_t *dist, size_t arity, size_t *peak)
+{
+	ipqueue *q = ipqueue_init (sizeof (uint64_t), arity, N_VERTICES, compare_u64, NULL);
+	uint64_t d, nd, sum = 0;
+	size_t u, v, e;
+
+	for (v = 0; v < N_VERTICES; v++)
+	{
+		dist[v] = UINT64_MAX;
+	}
+	dist[0] = 0;
+	ipqueue_push (q, 0, &dist[0]);
+	*peak = 1;
+
+	while (!ipqueue_is_empty (q))
+	{
+		u = ipqueue_pop (q, &d);
+		sum += d;
+		for (e = g->offsets[u]; e < g->offsets[u + 1]; e++)
+		{
+			v = g->targets[e];
+			nd = d + g->weights[e];
+			if (nd >= dist[v])
+			{
+				continue;
+			}
+
+			if (ipqueue_contains (q, v))
+			{
+				ipqueue_decrease_key (q, v, &nd);
+			}
+			else
+			{
+				ipqueue_push (q, v, &nd);
+			}
+			dist[v] = nd;
+		}
+		*peak = (ipqueue_size (q) > *peak) ? ipqueue_size (q) : *peak;
+	}
+
+	ipqueue_destroy (q);
+	return sum;
+}
+
+static uint64_t
+dijkstra_duplicates (const graph *g, uint64_t *dist, size_t arity, size_t *peak)
+{
+	pqueue *q = pqueue_init (sizeof (queued_path), arity, compare_path, NULL);
+	queued_path p, next;
+	uint64_t sum = 0;
+	size_t v, e;
+
+	for (v = 0; v < N_VERTICES; v++)
+	{
+		dist[v] = UINT64_MAX;
+	}
+	dist[0] = 0;
+	p.dist = 0;
+	p.vertex = 0;
+	pqueue_push (q, &p);
+	*peak = 1;
+
+	while (!pqueue_is_empty (q))
+	{
+		pqueue_pop (q, &p);
+		if (p.dist > dist[p.vertex])
+		{
+			continue;
+		}
+
+		sum += p.dist;
+		for (e = g->offsets[p.vertex]; e < g->offsets[p.vertex + 1]; e++)
+		{
+			next.vertex = g->targets[e];
+			next.dist = p.dist + g->weights[e];
+			if (next.dist < dist[next.vertex])
+			{
+				dist[next.vertex] = next.dist;
+				pqueue_push (q, &next);
+			}
+		}
+		*peak = (pqueue_size (q) > *peak) ? pqueue_size (q) : *peak;
+	}
+
+	pqueue_destroy (q);
+	return sum;
+}
+
+int
+main (void)
+{
+	uint64_t *dist = malloc (N_VERTICES * sizeof (uint64_t)), sum;
+	size_t arity, peak;
+	double start;
+	graph g;
+
+	graph_generate (&g);
+	printf ("%lu vertices, %lu edges\n", N_VERTICES, N_EDGES);
+
+	for (arity = 2; arity <= 4; arity *= 2)
+	{
+		start = now_sec ();
+		sum = dijkstra_indexed (&g, dist, arity, &peak);
+		printf ("ipqueue decrease-key  arity %zu: %6.3f s, peak queue %8zu (sum %llu)\n",
+		        arity, now_sec () - start, peak, (unsigned long long)sum);
+
+		start = now_sec ();
+		sum = dijkstra_duplicates (&g, dist, arity, &peak);
+		printf ("pqueue duplicates     arity %zu: %6.3f s, peak queue %8zu (sum %llu)\n",
+		        arity, now_sec () - start, peak, (unsigned long long)sum);
+	}
+
+	free (g.offsets);
+	free (g.targets);
+	free (g.weights);
+	free (dist);
+
+	return 0;
+}
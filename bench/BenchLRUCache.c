@@ -0,0 +1,130 @@
+/**
+ * File: BenchLRUCache.c
+ * ----------------------
+ * Replays a Zipfian key trace through the lru_cache in get-or-insert fashion
+ * and reports the cost per operation and the hit ratio.
+ */
+#include "LRUCache.h"
+#include "BenchCommon.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <math.h>
+
+#define N_KEYS     (1000000UL)
+#define N_OPS      (10000000UL)
+#define ZIPF_SKEW  (0.99)
+
+typedef struct
+{
+	lru_elem le;
+	uint64_t key;
+	uint64_t value;
+} bench_entry;
+
+static size_t
+hash_u64 (const void *key)
+{
+	return (size_t)*(const uint64_t *)key;
+}
+
+static int
+compare_u64 (const void *elem1, const void *elem2)
+{
+	const uint64_t *ptr1 = elem1;
+	const uint64_t *ptr2 = elem2;
+
+	return (*ptr1 > *ptr2) - (*ptr1 < *ptr2);
+}
+
+static void
+entry_destroy (void *addr)
+{
+	free (addr);
+}
+
+/**
+ * Function: zipf_trace
+ * ------------------------------------------------------
+ * Builds the cumulative distribution of rank probabilities and samples the
+ * trace from it by binary search. Ranks are scattered over the key space so
+ * that popular keys are not adjacent.
+ */
+static uint64_t *
+zipf_trace (size_t n_keys, size_t n_ops, double skew)
+{
+	double *cdf = malloc (n_keys * sizeof (double)), sum = 0, u;
+	uint64_t *trace = malloc (n_ops * sizeof (uint64_t));
+	size_t i, lo, hi, mid;
+
+	for (i = 0; i < n_keys; i++)
+	{
+		sum += 1.0 / pow ((double)(i + 1), skew);
+		cdf[i] = sum;
+	}
+
+	for (i = 0; i < n_ops; i++)
+	{
+		u = (double)(rng_next () >> 11) / 9007199254740992.0 * sum;
+		lo = 0;
+		hi = n_keys - 1;
+		while (lo < hi)
+		{
+			mid = lo + (hi - lo) / 2;
+			if (cdf[mid] < u)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		trace[i] = (uint64_t)lo * 0x9e3779b97f4a7c15ULL;
+	}
+
+	free (cdf);
+	return trace;
+}
+
+static void
+bench_capacity (const uint64_t *trace, size_t capacity)
+{
+	lru_cache *c;
+	bench_entry *e;
+	double start, elapsed;
+	size_t i;
+
+	c = lru_cache_init (capacity, offsetof (bench_entry, key), hash_u64,
+	                    compare_u64, entry_destroy);
+
+	start = now_sec ();
+	for (i = 0; i < N_OPS; i++)
+	{
+		if (lru_cache_get (c, &trace[i]) == NULL)
+		{
+			e = malloc (sizeof (bench_entry));
+			e->key = trace[i];
+			e->value = i;
+			lru_cache_insert (c, e);
+		}
+	}
+	elapsed = now_sec () - start;
+
+	printf ("capacity %8zu: %6.1f ns/op, hit ratio %.3f\n", capacity,
+	        elapsed * 1e9 / N_OPS,
+	        (double)lru_cache_hits (c) / (double)N_OPS);
+
+	lru_cache_destroy (c);
+}
+
+int
+main (void)
+{
+	uint64_t *trace = zipf_trace (N_KEYS, N_OPS, ZIPF_SKEW);
+
+	printf ("zipf(%.2f) over %lu keys, %lu get-or-insert operations\n",
+	        ZIPF_SKEW, N_KEYS, N_OPS);
+
+	bench_capacity (trace, N_KEYS / 1000);
+	bench_capacity (trace, N_KEYS / 100);
+	bench_capacity (trace, N_KEYS / 10);
+
+	free (trace);
+	return 0;
+}
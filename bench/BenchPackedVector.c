@@ -0,0 +1,143 @@
+/**
+ * File: BenchPackedVector.c
+ * ----------------------
+ * Stores N_IDS sorted ids in a vector of uint64_t and in a packed_vector,
+ * for two gap patterns: small random gaps of 1 to 16, and the same with one
+ * gap in 256 of up to a million, which the packed_vector takes as
+ * exceptions. For each it reports the bytes per id and compression ratio,
+ * then times
+ *
+ *   scan   - summing every id, from the vector's array directly and from the
+ *            runs of a packed_vector iterator
+ *   get    - N_PROBES reads at random indexes
+ *   search - N_PROBES lookups of random stored ids, vector_search's binary
+ *            search against packed_vector_search
+ */
+#include "PackedVector.h"
+#include "Vector.h"
+#include "BenchCommon.h"
+#include <stdio.h>
+
+#define N_IDS     (16UL * 1024 * 1024)
+#define N_PROBES  (1000000UL)
+#define N_REPS    (5)
+
+static uint64_t __attribute__ ((noinline))
+scan_vector (const uint64_t *ids, size_t n)
+{
+	uint64_t sum = 0;
+	size_t i;
+
+	for (i = 0; i < n; i++)
+	{
+		sum += ids[i];
+	}
+	return sum;
+}
+
+static uint64_t __attribute__ ((noinline))
+scan_packed (const packed_vector *pv)
+{
+	packed_vector_iter it;
+	const uint64_t *ids;
+	uint64_t sum = 0;
+	size_t i, n;
+
+	packed_vector_iter_init (pv, &it, 0);
+	while ((n = packed_vector_iter_next (&it, &ids)) > 0)
+	{
+		for (i = 0; i < n; i++)
+		{
+			sum += ids[i];
+		}
+	}
+	return sum;
+}
+
+static void
+run (const char *name, uint64_t wide_gaps)
+{
+	vector *v = vector_init (sizeof (uint64_t), N_IDS, NULL);
+	packed_vector *pv = packed_vector_init ();
+	size_t *probes = malloc (N_PROBES * sizeof (size_t)), i, rep, index;
+	double start, best_v = 1e9, best_p = 1e9, t;
+	uint64_t id = 1000000, sum_v = 0, sum_p = 0, check_v = 0, check_p = 0;
+
+	for (i = 0; i < N_IDS; i++)
+	{
+		id += 1 + rng_next () % 16;
+		if (wide_gaps && rng_next () % 256 == 0)
+		{
+			id += rng_next () % 1000000;
+		}
+		vector_append (v, &id);
+		packed_vector_append (pv, id);
+	}
+	for (i = 0; i < N_PROBES; i++)
+	{
+		probes[i] = rng_next () % N_IDS;
+	}
+
+	printf ("%s: vector %.2f bytes per id, packed_vector %.2f, ratio %.2fx\n", name,
+	        (double)sizeof (uint64_t), (double)packed_vector_bytes (pv) / N_IDS,
+	        (double)(N_IDS * sizeof (uint64_t)) / (double)packed_vector_bytes (pv));
+
+	for (rep = 0; rep < N_REPS; rep++)
+	{
+		start = now_sec ();
+		sum_v = scan_vector (vector_access (v, 0), N_IDS);
+		t = now_sec () - start;
+		best_v = (t < best_v) ? t : best_v;
+
+		start = now_sec ();
+		sum_p = scan_packed (pv);
+		t = now_sec () - start;
+		best_p = (t < best_p) ? t : best_p;
+	}
+	printf ("  scan    vector %8.2f ms  %6.2f ids/ns   packed_vector %8.2f ms  %6.2f ids/ns%s\n",
+	        best_v * 1e3, N_IDS / (best_v * 1e9), best_p * 1e3, N_IDS / (best_p * 1e9),
+	        (sum_v == sum_p) ? "" : "  MISMATCH");
+
+	start = now_sec ();
+	for (i = 0; i < N_PROBES; i++)
+	{
+		check_v += *(uint64_t *)vector_access (v, (int)probes[i]);
+	}
+	t = now_sec () - start;
+	start = now_sec ();
+	for (i = 0; i < N_PROBES; i++)
+	{
+		check_p += packed_vector_get (pv, probes[i]);
+	}
+	printf ("  get     vector %8.2f ns per id        packed_vector %8.2f ns per id%s\n",
+	        t * 1e9 / N_PROBES, (now_sec () - start) * 1e9 / N_PROBES, (check_v == check_p) ? "" : "  MISMATCH");
+
+	start = now_sec ();
+	for (i = 0; i < N_PROBES; i++)
+	{
+		id = *(uint64_t *)vector_access (v, (int)probes[i]);
+		check_v += (vector_search (v, &id, vector_compare_u64, true) != NULL);
+	}
+	t = now_sec () - start;
+	start = now_sec ();
+	for (i = 0; i < N_PROBES; i++)
+	{
+		id = *(uint64_t *)vector_access (v, (int)probes[i]);
+		check_p += packed_vector_search (pv, id, &index);
+	}
+	printf ("  search  vector %8.2f ns per id        packed_vector %8.2f ns per id%s\n",
+	        t * 1e9 / N_PROBES, (now_sec () - start) * 1e9 / N_PROBES, (check_v == check_p) ? "" : "  MISMATCH");
+
+	free (probes);
+	packed_vector_destroy (pv);
+	vector_destroy (v);
+}
+
+int
+main (void)
+{
+	printf ("%lu sorted ids, best of %d scans, %lu random probes\n", N_IDS, N_REPS, N_PROBES);
+	run ("gaps 1-16", 0);
+	run ("gaps 1-16, 1 in 256 up to 1M", 1);
+	return 0;
+}
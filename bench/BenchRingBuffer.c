@@ -0,0 +1,283 @@
+/**
+ * File: BenchRingBuffer.c
+ * ----------------------
+ * Hands timestamped records between producer and consumer threads through
+ * the spsc_ring, the mpmc_ring and, as a baseline, a deque behind a mutex.
+ * Reports throughput in millions of records per second and the 99th
+ * percentile time from enqueue to dequeue.
+ */
+#include "RingBuffer.h"
+#include "Deque.h"
+#include "BenchCommon.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+
+#define N_RECORDS     (4000000UL)
+#define RING_CAPACITY (4096UL)
+#define SAMPLE_EVERY  (64UL)
+#define MAX_THREADS   (4)
+
+typedef struct
+{
+	uint64_t stamp_ns;
+	uint64_t seq;
+} record;
+
+typedef size_t (*enqueue_fn) (void *q, const void *elems, size_t n);
+typedef size_t (*dequeue_fn) (void *q, void *out, size_t n);
+
+typedef struct
+{
+	const char *name;
+	void *q;
+	enqueue_fn enqueue;
+	dequeue_fn dequeue;
+	size_t batch;
+	size_t n_per_producer;
+	size_t n_per_consumer;
+} bench_config;
+
+typedef struct
+{
+	bench_config *cfg;
+	uint64_t *samples;
+	size_t n_samples;
+} consumer_arg;
+
+typedef struct
+{
+	pthread_mutex_t lock;
+	deque *d;
+} locked_deque;
+
+static int
+compare_u64 (const void *elem1, const void *elem2)
+{
+	const uint64_t *ptr1 = elem1;
+	const uint64_t *ptr2 = elem2;
+
+	return (*ptr1 > *ptr2) - (*ptr1 < *ptr2);
+}
+
+static size_t
+spsc_enqueue (void *q, const void *elems, size_t n)
+{
+	return spsc_ring_enqueue_many (q, elems, n);
+}
+
+static size_t
+spsc_dequeue (void *q, void *out, size_t n)
+{
+	return spsc_ring_dequeue_many (q, out, n);
+}
+
+static size_t
+mpmc_enqueue (void *q, const void *elems, size_t n)
+{
+	return mpmc_ring_enqueue_many (q, elems, n);
+}
+
+static size_t
+mpmc_dequeue (void *q, void *out, size_t n)
+{
+	return mpmc_ring_dequeue_many (q, out, n);
+}
+
+static size_t
+locked_enqueue (void *q, const void *elems, size_t n)
+{
+	locked_deque *ld = q;
+	size_t space;
+
+	pthread_mutex_lock (&ld->lock);
+	space = RING_CAPACITY - deque_size (ld->d);
+	n = (n < space) ? n : space;
+	deque_push_back_many (ld->d, elems, n);
+	pthread_mutex_unlock (&ld->lock);
+
+	return n;
+}
+
+static size_t
+locked_dequeue (void *q, void *out, size_t n)
+{
+	locked_deque *ld = q;
+	size_t avail;
+
+	pthread_mutex_lock (&ld->lock);
+	avail = deque_size (ld->d);
+	n = (n < avail) ? n : avail;
+	deque_pop_front_many (ld->d, out, n);
+	pthread_mutex_unlock (&ld->lock);
+
+	return n;
+}
+
+static void *
+producer (void *arg)
+{
+	bench_config *cfg = arg;
+	record batch[64];
+	size_t sent = 0, n, i, done;
+
+	while (sent < cfg->n_per_producer)
+	{
+		n = cfg->n_per_producer - sent;
+		n = (n < cfg->batch) ? n : cfg->batch;
+
+		for (i = 0; i < n; i++)
+		{
+			batch[i].seq = sent + i;
+			batch[i].stamp_ns = now_ns ();
+		}
+
+		for (done = 0; done < n; )
+		{
+			i = cfg->enqueue (cfg->q, batch + done, n - done);
+			if (i == 0)
+			{
+				sched_yield ();
+			}
+			done += i;
+		}
+		sent += n;
+	}
+	return NULL;
+}
+
+static void *
+consumer (void *arg)
+{
+	consumer_arg *ca = arg;
+	bench_config *cfg = ca->cfg;
+	record batch[64];
+	size_t received = 0, n, i;
+	uint64_t t;
+
+	while (received < cfg->n_per_consumer)
+	{
+		n = cfg->n_per_consumer - received;
+		n = (n < cfg->batch) ? n : cfg->batch;
+
+		n = cfg->dequeue (cfg->q, batch, n);
+		if (n == 0)
+		{
+			sched_yield ();
+			continue;
+		}
+
+		t = now_ns ();
+		for (i = 0; i < n; i++)
+		{
+			if (batch[i].seq % SAMPLE_EVERY == 0)
+			{
+				ca->samples[ca->n_samples++] = t - batch[i].stamp_ns;
+			}
+		}
+		received += n;
+	}
+	return NULL;
+}
+
+static void
+bench_run (bench_config *cfg, size_t n_producers, size_t n_consumers)
+{
+	pthread_t producers[MAX_THREADS], consumers[MAX_THREADS];
+	consumer_arg args[MAX_THREADS];
+	uint64_t *all, start, elapsed;
+	size_t i, n_all = 0;
+
+	cfg->n_per_producer = N_RECORDS / n_producers;
+	cfg->n_per_consumer = N_RECORDS / n_consumers;
+
+	for (i = 0; i < n_consumers; i++)
+	{
+		args[i].cfg = cfg;
+		args[i].samples = malloc ((N_RECORDS / SAMPLE_EVERY + MAX_THREADS) * sizeof (uint64_t));
+		args[i].n_samples = 0;
+	}
+
+	start = now_ns ();
+	for (i = 0; i < n_consumers; i++)
+	{
+		pthread_create (&consumers[i], NULL, consumer, &args[i]);
+	}
+	for (i = 0; i < n_producers; i++)
+	{
+		pthread_create (&producers[i], NULL, producer, cfg);
+	}
+	for (i = 0; i < n_producers; i++)
+	{
+		pthread_join (producers[i], NULL);
+	}
+	for (i = 0; i < n_consumers; i++)
+	{
+		pthread_join (consumers[i], NULL);
+	}
+	elapsed = now_ns () - start;
+
+	all = malloc ((N_RECORDS / SAMPLE_EVERY + MAX_THREADS) * MAX_THREADS * sizeof (uint64_t));
+	for (i = 0; i < n_consumers; i++)
+	{
+		memcpy (all + n_all, args[i].samples, args[i].n_samples * sizeof (uint64_t));
+		n_all += args[i].n_samples;
+		free (args[i].samples);
+	}
+	qsort (all, n_all, sizeof (uint64_t), compare_u64);
+
+	printf ("%-12s %zuP/%zuC batch %2zu: %7.2f Mops/s, p99 latency %8.2f us\n",
+	        cfg->name, n_producers, n_consumers, cfg->batch,
+	        (double)N_RECORDS * 1e3 / (double)elapsed,
+	        n_all ? (double)all[n_all * 99 / 100] / 1e3 : 0.0);
+
+	free (all);
+}
+
+int
+main (void)
+{
+	bench_config cfg;
+	locked_deque ld;
+	size_t batch, n_threads;
+
+	printf ("%lu records of %zu bytes, capacity %lu\n",
+	        N_RECORDS, sizeof (record), RING_CAPACITY);
+
+	for (batch = 1; batch <= 32; batch *= 32)
+	{
+		cfg.name = "spsc_ring";
+		cfg.q = spsc_ring_init (sizeof (record), RING_CAPACITY, NULL);
+		cfg.enqueue = spsc_enqueue;
+		cfg.dequeue = spsc_dequeue;
+		cfg.batch = batch;
+		bench_run (&cfg, 1, 1);
+		spsc_ring_destroy (cfg.q);
+
+		for (n_threads = 1; n_threads <= MAX_THREADS; n_threads *= 2)
+		{
+			cfg.name = "mpmc_ring";
+			cfg.q = mpmc_ring_init (sizeof (record), RING_CAPACITY, NULL);
+			cfg.enqueue = mpmc_enqueue;
+			cfg.dequeue = mpmc_dequeue;
+			bench_run (&cfg, n_threads, n_threads);
+			mpmc_ring_destroy (cfg.q);
+		}
+
+		for (n_threads = 1; n_threads <= MAX_THREADS; n_threads *= 2)
+		{
+			pthread_mutex_init (&ld.lock, NULL);
+			ld.d = deque_init (sizeof (record), RING_CAPACITY, NULL);
+			cfg.name = "mutex+deque";
+			cfg.q = &ld;
+			cfg.enqueue = locked_enqueue;
+			cfg.dequeue = locked_dequeue;
+			bench_run (&cfg, n_threads, n_threads);
+			deque_destroy (ld.d);
+			pthread_mutex_destroy (&ld.lock);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,230 @@
+/**
+ * File: BenchRoaring.c
+ * ----------------------
+ * Builds two random sets of 32 bit ids in each of three shapes, as sorted
+ * vectors of uint32_t and as roaring bitmaps, and compares
+ *
+ *   memory     - bytes per id of the vector, a flat bitset over the ids'
+ *                range, and the optimized roaring bitmap
+ *   test       - N_PROBES random membership tests, roaring_contains against
+ *                vector_search's binary search
+ *   union      - vector_union_sorted against roaring_union, and against
+ *                bitset_or into a copy where the range is small enough
+ *   intersect  - the same with vector_intersect_sorted, roaring_intersect
+ *                and bitset_and
+ *   iterate    - summing every id from the vector's array and through a
+ *                roaring_iter
+ *   write/read - roaring_write and roaring_read through a temporary file
+ *
+ * The shapes are sparse, N_SPARSE ids spread over all 32 bits, so every
+ * container is a short array; dense, each id below DENSE_RANGE present with
+ * probability a half, so every container is a bitmap; and runs, stretches
+ * of consecutive ids below DENSE_RANGE with gaps between them.
+ */
+#include "Roaring.h"
+#include "BenchCommon.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define N_SPARSE    (2000000UL)
+#define DENSE_RANGE (1UL << 24)
+#define N_PROBES    (2000000UL)
+
+static vector *
+make_ids (int shape)
+{
+	vector *v = vector_init (sizeof (uint32_t), 0, NULL);
+	uint32_t id, len;
+	size_t i;
+
+	if (shape == 0)
+	{
+		for (i = 0; i < N_SPARSE; i++)
+		{
+			id = (uint32_t)rng_next ();
+			vector_append (v, &id);
+		}
+		vector_sort (v, vector_compare_u32);
+		vector_unique (v, vector_compare_u32);
+	}
+	else if (shape == 1)
+	{
+		for (id = 0; id < DENSE_RANGE; id++)
+		{
+			if (rng_next () % 2)
+			{
+				vector_append (v, &id);
+			}
+		}
+	}
+	else
+	{
+		for (id = (uint32_t)(rng_next () % 1000); id < DENSE_RANGE; id += (uint32_t)(rng_next () % 1000))
+		{
+			for (len = 1000 + (uint32_t)(rng_next () % 4000); len > 0 && id < DENSE_RANGE; len--, id++)
+			{
+				vector_append (v, &id);
+			}
+		}
+	}
+	return v;
+}
+
+static uint64_t __attribute__ ((noinline))
+scan_ids (const uint32_t *ids, size_t n)
+{
+	uint64_t sum = 0;
+	size_t i;
+
+	for (i = 0; i < n; i++)
+	{
+		sum += ids[i];
+	}
+	return sum;
+}
+
+static void
+bench_shape (int shape, const char *name)
+{
+	vector *va = make_ids (shape), *vb = make_ids (shape), *out = vector_init (sizeof (uint32_t), 0, NULL);
+	roaring *a = roaring_from_vector (va), *b = roaring_from_vector (vb), *r;
+	uint32_t *probes = malloc (N_PROBES * sizeof (uint32_t)), id;
+	size_t n = vector_size (va), i, n_v = 0, n_r = 0;
+	bitset *ba = NULL, *bb = NULL, *dst;
+	uint64_t sum_v, sum_r = 0;
+	double start, t_v, t_r;
+	char path[] = "/tmp/BenchRoaringXXXXXX";
+	roaring_iter it;
+	int fd;
+
+	roaring_optimize (a);
+	roaring_optimize (b);
+	for (i = 0; i < N_PROBES; i++)
+	{
+		probes[i] = (shape == 0) ? (uint32_t)rng_next () : (uint32_t)(rng_next () % DENSE_RANGE);
+	}
+	if (shape != 0)
+	{
+		ba = bitset_from_vector (va);
+		bb = bitset_from_vector (vb);
+		bitset_resize (ba, DENSE_RANGE);
+		bitset_resize (bb, DENSE_RANGE);
+	}
+
+	printf ("%s: %lu ids in %lu containers\n", name, n, a->n_containers);
+	printf ("  memory     vector %8.2f   bitset %8.2f   roaring %8.2f bytes per id\n", (double)sizeof (uint32_t),
+	        ((shape == 0) ? 512.0 * 1024 * 1024 : (double)DENSE_RANGE / 8) / (double)n,
+	        (double)roaring_bytes (a) / (double)n);
+
+	start = now_sec ();
+	for (i = 0; i < N_PROBES; i++)
+	{
+		n_v += vector_search (va, &probes[i], vector_compare_u32, true) != NULL;
+	}
+	t_v = now_sec () - start;
+	start = now_sec ();
+	for (i = 0; i < N_PROBES; i++)
+	{
+		n_r += roaring_contains (a, probes[i]);
+	}
+	printf ("  test       vector %8.2f ns               roaring %8.2f ns%s\n", t_v * 1e9 / N_PROBES,
+	        (now_sec () - start) * 1e9 / N_PROBES, (n_v == n_r) ? "" : "  MISMATCH");
+
+	start = now_sec ();
+	n_v = vector_union_sorted (out, va, vb, vector_compare_u32);
+	t_v = now_sec () - start;
+	start = now_sec ();
+	r = roaring_union (a, b);
+	t_r = now_sec () - start;
+	n_r = roaring_cardinality (r);
+	roaring_destroy (r);
+	printf ("  union      vector %8.2f ms", t_v * 1e3);
+	if (ba != NULL)
+	{
+		dst = bitset_init (DENSE_RANGE);
+		start = now_sec ();
+		bitset_or (dst, ba);
+		bitset_or (dst, bb);
+		printf ("   bitset %8.2f ms", (now_sec () - start) * 1e3);
+		n_r += bitset_count (dst) - n_v;
+		bitset_destroy (dst);
+	}
+	else
+	{
+		printf ("                  ");
+	}
+	printf ("   roaring %8.2f ms%s\n", t_r * 1e3, (n_v == n_r) ? "" : "  MISMATCH");
+
+	start = now_sec ();
+	n_v = vector_intersect_sorted (out, va, vb, vector_compare_u32);
+	t_v = now_sec () - start;
+	start = now_sec ();
+	r = roaring_intersect (a, b);
+	t_r = now_sec () - start;
+	n_r = roaring_cardinality (r);
+	roaring_destroy (r);
+	printf ("  intersect  vector %8.2f ms", t_v * 1e3);
+	if (ba != NULL)
+	{
+		dst = bitset_init (DENSE_RANGE);
+		start = now_sec ();
+		bitset_or (dst, ba);
+		bitset_and (dst, bb);
+		printf ("   bitset %8.2f ms", (now_sec () - start) * 1e3);
+		n_r += bitset_count (dst) - n_v;
+		bitset_destroy (dst);
+	}
+	else
+	{
+		printf ("                  ");
+	}
+	printf ("   roaring %8.2f ms%s\n", t_r * 1e3, (n_v == n_r) ? "" : "  MISMATCH");
+
+	start = now_sec ();
+	sum_v = scan_ids (vector_access (va, 0), n);
+	t_v = now_sec () - start;
+	start = now_sec ();
+	roaring_iter_init (a, &it);
+	while (roaring_iter_next (&it, &id))
+	{
+		sum_r += id;
+	}
+	printf ("  iterate    vector %8.2f ms               roaring %8.2f ms%s\n", t_v * 1e3,
+	        (now_sec () - start) * 1e3, (sum_v == sum_r) ? "" : "  MISMATCH");
+
+	fd = mkstemp (path);
+	unlink (path);
+	start = now_sec ();
+	roaring_write (a, fd);
+	t_v = now_sec () - start;
+	lseek (fd, 0, SEEK_SET);
+	start = now_sec ();
+	r = roaring_read (fd);
+	t_r = now_sec () - start;
+	printf ("  write/read %8lu bytes   write %8.2f ms   read %8.2f ms%s\n", (unsigned long)lseek (fd, 0, SEEK_CUR),
+	        t_v * 1e3, t_r * 1e3, (r != NULL && roaring_cardinality (r) == n) ? "" : "  MISMATCH");
+	roaring_destroy (r);
+	close (fd);
+
+	if (ba != NULL)
+	{
+		bitset_destroy (ba);
+		bitset_destroy (bb);
+	}
+	free (probes);
+	roaring_destroy (a);
+	roaring_destroy (b);
+	vector_destroy (va);
+	vector_destroy (vb);
+	vector_destroy (out);
+}
+
+int
+main (void)
+{
+	bench_shape (0, "sparse");
+	bench_shape (1, "dense");
+	bench_shape (2, "runs");
+	return 0;
+}
@@ -0,0 +1,115 @@
+/**
+ * File: BenchSegVector.c
+ * ----------------------
+ * Appends N_APPENDS 8 byte elements to a vector and to a seg_vector, timing
+ * each append, and compares total time, the slowest appends and how many
+ * took over 10 us. A vector append that triggers a realloc pays for copying
+ * or remapping everything before it; a seg_vector append at most pays for a
+ * malloc. Each append also touches new memory, so page faults show up in
+ * both. Note that glibc serves large blocks with mmap and grows them with
+ * mremap, which moves pages rather than copying bytes, so on glibc the
+ * vector's growth spikes are far smaller than the copy they stand for.
+ *
+ * Both are then refilled without per append timing to compare throughput.
+ */
+#include "SegVector.h"
+#include "Vector.h"
+#include "BenchCommon.h"
+#include <stdio.h>
+
+#define N_APPENDS  (64UL * 1024 * 1024)
+#define SPIKE_NS   (10000)
+#define N_WORST    (5)
+
+typedef struct
+{
+	uint64_t total;
+	uint64_t worst[N_WORST];
+	size_t n_spikes;
+} latency;
+
+static void
+record (latency *l, uint64_t ns)
+{
+	size_t i;
+
+	l->total += ns;
+	l->n_spikes += (ns > SPIKE_NS);
+	for (i = 0; i < N_WORST; i++)
+	{
+		if (ns > l->worst[i])
+		{
+			uint64_t tmp = l->worst[i];
+			l->worst[i] = ns;
+			ns = tmp;
+		}
+	}
+}
+
+static void
+report (const char *name, const latency *l)
+{
+	size_t i;
+
+	printf ("%-10s  total %8.1f ms  appends over 10 us %6zu  worst (us):",
+	        name, (double)l->total * 1e-6, l->n_spikes);
+	for (i = 0; i < N_WORST; i++)
+	{
+		printf (" %8.1f", (double)l->worst[i] * 1e-3);
+	}
+	printf ("\n");
+}
+
+int
+main (void)
+{
+	latency lv = { 0 }, ls = { 0 };
+	vector *v = vector_init (sizeof (uint64_t), 0, NULL);
+	seg_vector *sv = seg_vector_init (sizeof (uint64_t), 0, NULL);
+	uint64_t i, start, *first_v, *first_s;
+
+	vector_append (v, &i);
+	first_v = vector_access (v, 0);
+	for (i = 1; i < N_APPENDS; i++)
+	{
+		start = now_ns ();
+		vector_append (v, &i);
+		record (&lv, now_ns () - start);
+	}
+
+	seg_vector_append (sv, &i);
+	first_s = seg_vector_access (sv, 0);
+	for (i = 1; i < N_APPENDS; i++)
+	{
+		start = now_ns ();
+		seg_vector_append (sv, &i);
+		record (&ls, now_ns () - start);
+	}
+
+	printf ("%lu appends of 8 byte elements\n", N_APPENDS);
+	report ("vector", &lv);
+	report ("seg_vector", &ls);
+	vector_clear (v);
+	start = now_ns ();
+	for (i = 0; i < N_APPENDS; i++)
+	{
+		vector_append (v, &i);
+	}
+	printf ("refill of allocated storage: vector %8.1f ms", (double)(now_ns () - start) * 1e-6);
+
+	seg_vector_clear (sv);
+	start = now_ns ();
+	for (i = 0; i < N_APPENDS; i++)
+	{
+		seg_vector_append (sv, &i);
+	}
+	printf ("  seg_vector %8.1f ms\n", (double)(now_ns () - start) * 1e-6);
+
+	printf ("first element moved: vector %s, seg_vector %s\n",
+	        (first_v == vector_access (v, 0)) ? "no" : "yes",
+	        (first_s == seg_vector_access (sv, 0)) ? "no" : "yes");
+
+	vector_destroy (v);
+	seg_vector_destroy (sv);
+	return 0;
+}
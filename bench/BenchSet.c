@@ -0,0 +1,114 @@
+/**
+ * File: BenchSet.c
+ * ----------------------
+ * Writes a set of N_KEYS random 8 byte keys to a file on tmpfs with
+ * set_write and reads it back with set_read, which builds the tree in one
+ * pass, against the hand written loop it replaces: an fwrite per element in
+ * order, then an fread and a set_add per element. Throughput is in GB/s of
+ * element data. Either way the cost is in the nodes, not the I/O: writing
+ * visits every node, a cache miss apiece, and reading allocates every node.
+ */
+#include "Set.h"
+#include "BenchCommon.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define N_KEYS (4000000UL)
+
+static int
+compare_u64 (const void *elem1, const void *elem2)
+{
+	const uint64_t *ptr1 = elem1;
+	const uint64_t *ptr2 = elem2;
+
+	return (*ptr1 > *ptr2) - (*ptr1 < *ptr2);
+}
+
+/**
+ * The in order walk the hand written loop needs, one fwrite per element.
+ */
+static void
+hand_write (const set_elem *se, FILE *f)
+{
+	if (se != NULL)
+	{
+		hand_write (se->links[0], f);
+		fwrite (se->data, sizeof (uint64_t), 1, f);
+		hand_write (se->links[1], f);
+	}
+}
+
+int
+main (void)
+{
+	char path[] = "/dev/shm/BenchSetXXXXXX";
+	double gb = (double)(N_KEYS * sizeof (uint64_t)) / 1e9, start, t_write, t_read, t_hwrite, t_hread;
+	set *s, *back;
+	uint64_t key;
+	size_t i, n;
+	FILE *f;
+	int fd;
+
+	s = set_init (sizeof (uint64_t), compare_u64, NULL);
+	for (i = 0; i < N_KEYS; i++)
+	{
+		key = rng_next ();
+		set_add (s, &key);
+	}
+
+	fd = mkstemp (path);
+	if (fd < 0)
+	{
+		printf ("tmpfs unavailable\n");
+		return 1;
+	}
+
+	start = now_sec ();
+	set_write (s, fd);
+	t_write = now_sec () - start;
+	lseek (fd, 0, SEEK_SET);
+	start = now_sec ();
+	back = set_read (fd, compare_u64, NULL);
+	t_read = now_sec () - start;
+	if (back == NULL || set_size (back) != set_size (s))
+	{
+		printf ("set read back failed\n");
+		return 1;
+	}
+	set_destroy (back);
+
+	ftruncate (fd, 0);
+	lseek (fd, 0, SEEK_SET);
+	f = fdopen (fd, "w+");
+	start = now_sec ();
+	n = set_size (s);
+	fwrite (&n, sizeof (n), 1, f);
+	hand_write (s->root, f);
+	fflush (f);
+	t_hwrite = now_sec () - start;
+
+	rewind (f);
+	start = now_sec ();
+	back = set_init (sizeof (uint64_t), compare_u64, NULL);
+	if (fread (&n, sizeof (n), 1, f) == 1)
+	{
+		for (i = 0; i < n && fread (&key, sizeof (key), 1, f) == 1; i++)
+		{
+			set_add (back, &key);
+		}
+	}
+	t_hread = now_sec () - start;
+	set_destroy (back);
+	fclose (f);
+	unlink (path);
+
+	printf ("set of %lu 8 byte keys\n", N_KEYS);
+	printf ("  set_write           %8.2f ms  %6.2f GB/s\n", t_write * 1e3, gb / t_write);
+	printf ("  set_read            %8.2f ms  %6.2f GB/s\n", t_read * 1e3, gb / t_read);
+	printf ("  fwrite per element  %8.2f ms  %6.2f GB/s\n", t_hwrite * 1e3, gb / t_hwrite);
+	printf ("  fread + set_add     %8.2f ms  %6.2f GB/s\n", t_hread * 1e3, gb / t_hread);
+
+	set_destroy (s);
+	return 0;
+}
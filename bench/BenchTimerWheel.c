@@ -0,0 +1,81 @@
+/**
+ * File: BenchTimerWheel.c
+ * ----------------------
+ * Arms ten million connection-style timeouts, cancels most of them before
+ * they fire and advances the wheel through the rest, reporting the cost of
+ * each phase.
+ */
+#include "TimerWheel.h"
+#include "BenchCommon.h"
+#include <stdio.h>
+
+#define N_TIMERS       (10000000UL)
+#define MAX_TIMEOUT    (1UL << 20)
+#define CANCEL_PERCENT (90)
+#define ADVANCE_STEP   (1000)
+
+typedef struct
+{
+	timer_elem te;
+	uint64_t id;
+} bench_timer;
+
+static size_t n_fired;
+
+static void
+bench_fire (void *timer)
+{
+	(void) timer;
+	++n_fired;
+}
+
+int
+main (void)
+{
+	bench_timer *timers = malloc (N_TIMERS * sizeof (bench_timer));
+	timer_wheel *tw = timer_wheel_init (0, bench_fire, NULL);
+	size_t i, n_cancelled = 0, n_batches = 0;
+	double start, elapsed;
+	uint64_t now;
+
+	for (i = 0; i < N_TIMERS; i++)
+	{
+		timer_init (&timers[i]);
+		timers[i].id = i;
+	}
+
+	start = now_sec ();
+	for (i = 0; i < N_TIMERS; i++)
+	{
+		timer_add (tw, &timers[i], 1 + rng_next () % MAX_TIMEOUT);
+	}
+	elapsed = now_sec () - start;
+	printf ("timer_add:     %6.1f ns/op (%lu timers)\n",
+	        elapsed * 1e9 / N_TIMERS, N_TIMERS);
+
+	start = now_sec ();
+	for (i = 0; i < N_TIMERS; i++)
+	{
+		if (rng_next () % 100 < CANCEL_PERCENT)
+		{
+			n_cancelled += timer_cancel (tw, &timers[i]);
+		}
+	}
+	elapsed = now_sec () - start;
+	printf ("timer_cancel:  %6.1f ns/op (%zu cancelled)\n",
+	        elapsed * 1e9 / (double)n_cancelled, n_cancelled);
+
+	start = now_sec ();
+	for (now = ADVANCE_STEP; timer_wheel_size (tw) > 0; now += ADVANCE_STEP)
+	{
+		timer_advance (tw, now);
+		++n_batches;
+	}
+	elapsed = now_sec () - start;
+	printf ("timer_advance: %6.1f ns/fired (%zu fired over %zu advances)\n",
+	        elapsed * 1e9 / (double)n_fired, n_fired, n_batches);
+
+	timer_wheel_destroy (tw);
+	free (timers);
+	return 0;
+}
@@ -0,0 +1,195 @@
+/**
+ * File: BenchUnrolledList.c
+ * ----------------------
+ * Runs the same mix of positional inserts, positional removes and full scans
+ * against the list, the vector and the unrolled_list.
+ */
+#include "UnrolledList.h"
+#include "Vector.h"
+#include "List.h"
+#include "BenchCommon.h"
+#include <stdio.h>
+
+#define N_INITIAL  (50000UL)
+#define N_UPDATES  (10000UL)
+#define N_SCANS    (100UL)
+
+typedef struct
+{
+	list_elem le;
+	uint64_t data;
+} bench_node;
+
+static uint64_t sink;
+
+static void
+node_destroy (void *addr)
+{
+	free (addr);
+}
+
+/**
+ * Function: list_walk
+ * ------------------------------------------------------
+ * A list has no positional access, so reaching index costs a walk.
+ */
+static bench_node *
+list_walk (list *l, size_t index)
+{
+	bench_node *node = list_front (l);
+
+	while (index-- > 0)
+	{
+		node = list_next (l, node);
+	}
+	return node;
+}
+
+static void
+bench_list (void)
+{
+	list *l = list_init (node_destroy);
+	bench_node *node, *at;
+	double start, elapsed;
+	size_t i, n = N_INITIAL, index;
+
+	start = now_sec ();
+	for (i = 0; i < N_INITIAL; i++)
+	{
+		node = malloc (sizeof (bench_node));
+		node->data = i;
+		list_push_back (l, node);
+	}
+
+	for (i = 0; i < N_UPDATES; i++)
+	{
+		index = rng_next () % n;
+		at = list_walk (l, index);
+		if (i & 1)
+		{
+			list_remove (l, at);
+			--n;
+		}
+		else
+		{
+			node = malloc (sizeof (bench_node));
+			node->data = i;
+			list_insert_after (l, at, node);
+			++n;
+		}
+	}
+
+	for (i = 0; i < N_SCANS; i++)
+	{
+		for (node = list_front (l); node != NULL; node = list_next (l, node))
+		{
+			sink += node->data;
+		}
+	}
+	elapsed = now_sec () - start;
+
+	printf ("list:          %8.2f ms\n", elapsed * 1e3);
+	list_destroy (l);
+}
+
+static void
+bench_vector (void)
+{
+	vector *v = vector_init (sizeof (uint64_t), 0, NULL);
+	double start, elapsed;
+	size_t i, j, n = N_INITIAL;
+	uint64_t data;
+
+	start = now_sec ();
+	for (i = 0; i < N_INITIAL; i++)
+	{
+		data = i;
+		vector_append (v, &data);
+	}
+
+	for (i = 0; i < N_UPDATES; i++)
+	{
+		if (i & 1)
+		{
+			vector_remove (v, (int)(rng_next () % n));
+			--n;
+		}
+		else
+		{
+			data = i;
+			vector_insert (v, &data, (int)(rng_next () % n));
+			++n;
+		}
+	}
+
+	for (i = 0; i < N_SCANS; i++)
+	{
+		for (j = 0; j < n; j++)
+		{
+			sink += *(uint64_t *)vector_access (v, (int)j);
+		}
+	}
+	elapsed = now_sec () - start;
+
+	printf ("vector:        %8.2f ms\n", elapsed * 1e3);
+	vector_destroy (v);
+}
+
+static void
+bench_unrolled_list (void)
+{
+	unrolled_list *ul = unrolled_list_init (sizeof (uint64_t), 0, 0, NULL);
+	double start, elapsed;
+	size_t i, j, n = N_INITIAL;
+	uint64_t data;
+
+	start = now_sec ();
+	for (i = 0; i < N_INITIAL; i++)
+	{
+		data = i;
+		unrolled_list_append (ul, &data);
+	}
+
+	for (i = 0; i < N_UPDATES; i++)
+	{
+		if (i & 1)
+		{
+			unrolled_list_remove (ul, rng_next () % n);
+			--n;
+		}
+		else
+		{
+			data = i;
+			unrolled_list_insert (ul, &data, rng_next () % n);
+			++n;
+		}
+	}
+
+	for (i = 0; i < N_SCANS; i++)
+	{
+		for (j = 0; j < n; j++)
+		{
+			sink += *(uint64_t *)unrolled_list_access (ul, j);
+		}
+	}
+	elapsed = now_sec () - start;
+
+	printf ("unrolled_list: %8.2f ms\n", elapsed * 1e3);
+	unrolled_list_destroy (ul);
+}
+
+int
+main (void)
+{
+	printf ("%lu initial elements, %lu random inserts/removes, %lu scans\n",
+	        N_INITIAL, N_UPDATES, N_SCANS);
+
+	rng_state = 0x2545f4914f6cdd1dULL;
+	bench_list ();
+	rng_state = 0x2545f4914f6cdd1dULL;
+	bench_vector ();
+	rng_state = 0x2545f4914f6cdd1dULL;
+	bench_unrolled_list ();
+
+	return (int)(sink & 0);
+}
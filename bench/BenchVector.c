@@ -0,0 +1,711 @@
+/**
+ * File: BenchVector.c
+ * ----------------------
+ * Times the sorted set kernels on vectors of random uint32_t ids against the
+ * hand written two pointer loop over vector_access they replace. Each
+ * operation runs once through a plain compare function, which takes the
+ * generic walk, and once through vector_compare_u32, which takes the integer
+ * kernels. The inputs are balanced, then skewed enough to gallop.
+ *
+ * Then picks the top k of N_RECORDS scored records with vector_top_k,
+ * vector_partial_sort and vector_nth_element, against a full vector_sort.
+ *
+ * Last, sorts records with few distinct scores stably by score, against
+ * vector_sort with the composite score then id compare that stands in for
+ * stability, on random, presorted and nearly sorted inputs.
+ *
+ * Finally grows an array of 8 byte elements to N_GROW, 1 GB, one append at a
+ * time, then reads it at random positions, four ways:
+ *
+ *   malloc+copy - doubling by allocating anew and copying, which is what
+ *                 realloc does under allocators that cannot remap
+ *   realloc     - doubling with realloc, the vector's path below 64 MB
+ *   mapped      - the vector, which moves to its own mapping and mremaps
+ *   mapped+huge - the vector with huge pages requested
+ *
+ * On Linux the random reads also count dTLB load misses, where perf events
+ * are permitted.
+ *
+ * Then writes and reads back N_STREAM 8 byte elements, 512 MB, with
+ * vector_write and vector_read, against the hand written loop of an fwrite
+ * and fread per element they replace, through a file on tmpfs, which costs
+ * no disk, and one in /tmp. The checksum alone is timed for comparison.
+ *
+ * Last of all, builds and destroys N_SHORT short lived vectors of
+ * SHORT_LEN ids with vector_init, vector_init_static and vector_init_buffer,
+ * which cost two, one and no allocations apiece.
+ */
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+#include "Vector.h"
+#include "ADT_stream.h"
+#include "BenchCommon.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#define N_LARGE  (4000000UL)
+#define N_REPS   (5)
+#define N_RECORDS (10000000UL)
+#define N_STABLE  (2000000UL)
+#define N_GROW    (128UL << 20)
+#define N_READS   (20000000UL)
+#define N_STREAM  (64UL << 20)
+#define N_SHORT   (10000000UL)
+#define SHORT_LEN (8)
+
+static int
+compare_u32 (const void *elem1, const void *elem2)
+{
+	const uint32_t *ptr1 = elem1;
+	const uint32_t *ptr2 = elem2;
+
+	return (*ptr1 > *ptr2) - (*ptr1 < *ptr2);
+}
+
+/**
+ * Builds a sorted, duplicate free vector of about n ids drawn from a range
+ * four times as large, so two such vectors share about a quarter of their ids.
+ */
+static vector *
+random_ids (size_t n)
+{
+	vector *v = vector_init (sizeof (uint32_t), n, NULL);
+	uint32_t id;
+	size_t i;
+
+	for (i = 0; i < n; i++)
+	{
+		id = (uint32_t)(rng_next () % (4 * N_LARGE));
+		vector_append (v, &id);
+	}
+	vector_sort (v, vector_compare_u32);
+	vector_unique (v, vector_compare_u32);
+
+	return v;
+}
+
+/**
+ * The loop the kernels replace: two indices walked with vector_access.
+ */
+static size_t
+hand_intersect (vector *out, vector *a, vector *b)
+{
+	size_t i = 0, j = 0, n = 0;
+	int c;
+
+	while (i < vector_size (a) && j < vector_size (b))
+	{
+		c = compare_u32 (vector_access (a, i), vector_access (b, j));
+		if (c < 0)
+		{
+			i++;
+		}
+		else if (c > 0)
+		{
+			j++;
+		}
+		else
+		{
+			vector_append (out, vector_access (a, i));
+			i++;
+			j++;
+			n++;
+		}
+	}
+
+	return n;
+}
+
+typedef struct
+{
+	double score;
+	uint64_t id;
+} record;
+
+static int
+compare_score_desc (const void *elem1, const void *elem2)
+{
+	const record *ptr1 = elem1;
+	const record *ptr2 = elem2;
+
+	return (ptr1->score < ptr2->score) - (ptr1->score > ptr2->score);
+}
+
+static int
+compare_score_id (const void *elem1, const void *elem2)
+{
+	const record *ptr1 = elem1;
+	const record *ptr2 = elem2;
+	int c = (ptr1->score > ptr2->score) - (ptr1->score < ptr2->score);
+
+	return (c != 0) ? c : (ptr1->id > ptr2->id) - (ptr1->id < ptr2->id);
+}
+
+static int
+compare_score (const void *elem1, const void *elem2)
+{
+	const record *ptr1 = elem1;
+	const record *ptr2 = elem2;
+
+	return (ptr1->score > ptr2->score) - (ptr1->score < ptr2->score);
+}
+
+typedef size_t (*set_op_fn) (vector *out, const vector *a, const vector *b,
+                             compare_fn fn);
+
+static double
+time_op (set_op_fn op, vector *out, vector *a, vector *b, compare_fn fn,
+         size_t *n)
+{
+	double start, best = 1e9, t;
+	int r;
+
+	for (r = 0; r < N_REPS; r++)
+	{
+		vector_clear (out);
+		start = now_sec ();
+		*n = (op != NULL) ? op (out, a, b, fn) : hand_intersect (out, a, b);
+		t = now_sec () - start;
+		best = (t < best) ? t : best;
+	}
+
+	return best;
+}
+
+static void
+bench_pair (size_t n_a, size_t n_b)
+{
+	static const struct { const char *name; set_op_fn op; } ops[] = {
+		{ "intersect",  vector_intersect_sorted },
+		{ "difference", vector_difference_sorted },
+		{ "union",      vector_union_sorted },
+		{ "merge",      vector_merge_sorted },
+	};
+	vector *a = random_ids (n_a), *b = random_ids (n_b);
+	vector *out = vector_init (sizeof (uint32_t), 0, NULL);
+	size_t k, n, n_check;
+	double t_generic, t_int;
+
+	printf ("%zu x %zu ids\n", vector_size (a), vector_size (b));
+	printf ("  %-10s  hand loop %8.2f ms\n", "intersect",
+	        time_op (NULL, out, a, b, NULL, &n) * 1e3);
+
+	for (k = 0; k < sizeof (ops) / sizeof (ops[0]); k++)
+	{
+		t_generic = time_op (ops[k].op, out, a, b, compare_u32, &n_check);
+		t_int = time_op (ops[k].op, out, a, b, vector_compare_u32, &n);
+		printf ("  %-10s  compare_fn %8.2f ms  u32 kernel %8.2f ms  (%zu%s)\n",
+		        ops[k].name, t_generic * 1e3, t_int * 1e3, n,
+		        (n == n_check) ? "" : ", MISMATCH");
+	}
+
+	vector_destroy (a);
+	vector_destroy (b);
+	vector_destroy (out);
+}
+
+/**
+ * Refills v with the same scored records each time, so every method starts
+ * from identical unsorted input.
+ */
+static void
+refill_records (vector *v)
+{
+	record r;
+	size_t i;
+
+	rng_state = 0x2545f4914f6cdd1dULL;
+	vector_clear (v);
+	for (i = 0; i < N_RECORDS; i++)
+	{
+		r.id = i;
+		r.score = (double)(rng_next () >> 11) * 0x1.0p-53;
+		vector_append (v, &r);
+	}
+}
+
+static void
+bench_top_k (void)
+{
+	static const size_t ks[] = { 10, 100, 10000, 1000000 };
+	vector *v = vector_init (sizeof (record), N_RECORDS, NULL);
+	vector *out = vector_init (sizeof (record), 0, NULL);
+	double start, t_sort, t_top, t_partial, t_nth;
+	size_t k;
+
+	refill_records (v);
+	start = now_sec ();
+	vector_sort (v, compare_score_desc);
+	t_sort = now_sec () - start;
+	printf ("top k of %lu records: full sort %8.2f ms\n", N_RECORDS, t_sort * 1e3);
+
+	for (k = 0; k < sizeof (ks) / sizeof (ks[0]); k++)
+	{
+		refill_records (v);
+		vector_clear (out);
+		start = now_sec ();
+		vector_top_k (v, ks[k], compare_score_desc, out);
+		t_top = now_sec () - start;
+
+		start = now_sec ();
+		vector_partial_sort (v, ks[k], compare_score_desc);
+		t_partial = now_sec () - start;
+
+		refill_records (v);
+		start = now_sec ();
+		vector_nth_element (v, ks[k], compare_score_desc);
+		t_nth = now_sec () - start;
+
+		printf ("  k %8zu  top_k %8.2f ms  partial_sort %8.2f ms  nth_element %8.2f ms\n",
+		        ks[k], t_top * 1e3, t_partial * 1e3, t_nth * 1e3);
+	}
+
+	vector_destroy (v);
+	vector_destroy (out);
+}
+
+/**
+ * Fills v with records scored 0 to 999 in one of four orders: random, sorted,
+ * sorted with the last 1% replaced by random scores, and reversed.
+ */
+static void
+fill_stable (vector *v, int order)
+{
+	record r;
+	size_t i;
+
+	vector_clear (v);
+	for (i = 0; i < N_STABLE; i++)
+	{
+		r.id = i;
+		switch (order)
+		{
+		case 0: r.score = (double)(rng_next () % 1000); break;
+		case 1: r.score = (double)(i * 1000 / N_STABLE); break;
+		case 2: r.score = (i < N_STABLE - N_STABLE / 100) ? (double)(i * 1000 / N_STABLE)
+		                                                  : (double)(rng_next () % 1000); break;
+		default: r.score = (double)((N_STABLE - i) * 1000 / N_STABLE); break;
+		}
+		vector_append (v, &r);
+	}
+}
+
+static void
+bench_stable (void)
+{
+	static const char *orders[] = { "random", "sorted", "sorted + 1%", "reversed" };
+	vector *v = vector_init (sizeof (record), N_STABLE, NULL);
+	double start, t_sort, t_stable;
+	int order;
+
+	printf ("sort %lu records:\n", N_STABLE);
+	for (order = 0; order < 4; order++)
+	{
+		fill_stable (v, order);
+		start = now_sec ();
+		vector_sort (v, compare_score_id);
+		t_sort = now_sec () - start;
+
+		fill_stable (v, order);
+		start = now_sec ();
+		vector_sort_stable (v, compare_score);
+		t_stable = now_sec () - start;
+
+		printf ("  %-12s  sort with composite compare %8.2f ms  sort_stable %8.2f ms\n",
+		        orders[order], t_sort * 1e3, t_stable * 1e3);
+	}
+
+	vector_destroy (v);
+}
+
+/**
+ * Opens a counter of user space dTLB load misses for this thread, or returns
+ * -1 if perf events are not permitted.
+ */
+static int
+open_tlb_counter (void)
+{
+#ifdef __linux__
+	struct perf_event_attr attr;
+
+	memset (&attr, 0, sizeof (attr));
+	attr.size = sizeof (attr);
+	attr.type = PERF_TYPE_HW_CACHE;
+	attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+	              (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+	attr.disabled = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+
+	return (int)syscall (SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+	return -1;
+#endif
+}
+
+/**
+ * Reads N_READS random elements, reporting the time and TLB misses taken.
+ */
+static void
+random_reads (const char *name, double grow, const uint64_t *elems, int counter)
+{
+	uint64_t sum = 0, misses = 0;
+	double start;
+	size_t i;
+
+#ifdef __linux__
+	if (counter >= 0)
+	{
+		ioctl (counter, PERF_EVENT_IOC_RESET, 0);
+		ioctl (counter, PERF_EVENT_IOC_ENABLE, 0);
+	}
+#endif
+	start = now_sec ();
+	for (i = 0; i < N_READS; i++)
+	{
+		sum += elems[rng_next () % N_GROW];
+	}
+	start = now_sec () - start;
+#ifdef __linux__
+	if (counter >= 0)
+	{
+		ioctl (counter, PERF_EVENT_IOC_DISABLE, 0);
+		if (read (counter, &misses, sizeof (misses)) != sizeof (misses))
+		{
+			misses = 0;
+		}
+	}
+#endif
+
+	printf ("  %-12s  grow %8.1f ms  random reads %6.1f ns", name, grow * 1e3,
+	        start * 1e9 / N_READS);
+	if (counter >= 0)
+	{
+		printf ("  dTLB misses/read %5.2f", (double)misses / N_READS);
+	}
+	printf ("  (%lu)\n", (unsigned long)(sum & 0xff));
+}
+
+/**
+ * A bare growable array for the baselines, appended to through an out of line
+ * call with a run time element size, as vector_append is, so the comparison
+ * is of the growth paths alone.
+ */
+typedef struct
+{
+	char *elems;
+	size_t capacity;
+	size_t elem_sz;
+	size_t n_elems;
+	bool copy;
+} plain_array;
+
+static void __attribute__ ((noinline))
+plain_append (plain_array *a, const void *elem)
+{
+	char *larger;
+
+	if (a->n_elems == a->capacity)
+	{
+		if (a->copy)
+		{
+			larger = malloc (2 * a->capacity * a->elem_sz);
+			memcpy (larger, a->elems, a->capacity * a->elem_sz);
+			free (a->elems);
+		}
+		else
+		{
+			larger = realloc (a->elems, 2 * a->capacity * a->elem_sz);
+		}
+		a->elems = larger;
+		a->capacity *= 2;
+	}
+	memcpy (a->elems + a->n_elems++ * a->elem_sz, elem, a->elem_sz);
+}
+
+static void
+bench_grow_array (bool copy, int counter)
+{
+	plain_array a = { malloc (16 * sizeof (uint64_t)), 16, sizeof (uint64_t), 0, copy };
+	double start = now_sec ();
+	uint64_t i;
+
+	for (i = 0; i < N_GROW; i++)
+	{
+		plain_append (&a, &i);
+	}
+
+	random_reads (copy ? "malloc+copy" : "realloc", now_sec () - start,
+	              (const uint64_t *)a.elems, counter);
+	free (a.elems);
+}
+
+static void
+bench_grow_vector (bool huge, int counter)
+{
+	vector *v = vector_init (sizeof (uint64_t), 0, NULL);
+	double start;
+	uint64_t i;
+
+	vector_set_huge_pages (v, huge);
+	start = now_sec ();
+	for (i = 0; i < N_GROW; i++)
+	{
+		vector_append (v, &i);
+	}
+
+	random_reads (huge ? "mapped+huge" : "mapped", now_sec () - start,
+	              vector_access (v, 0), counter);
+	vector_destroy (v);
+}
+
+static void
+bench_growth (void)
+{
+	int counter = open_tlb_counter ();
+
+	printf ("grow by %lu appends of 8 byte elements, then %lu random reads%s\n",
+	        N_GROW, N_READS, (counter < 0) ? " (perf events unavailable)" : "");
+	bench_grow_array (true, counter);
+	bench_grow_array (false, counter);
+	bench_grow_vector (false, counter);
+	bench_grow_vector (true, counter);
+}
+
+/**
+ * The loop vector_write and vector_read replace: one stdio call per element.
+ */
+static void
+hand_write (vector *v, FILE *f)
+{
+	size_t i, n = vector_size (v);
+
+	fwrite (&n, sizeof (n), 1, f);
+	for (i = 0; i < n; i++)
+	{
+		fwrite (vector_access (v, i), sizeof (uint64_t), 1, f);
+	}
+	fflush (f);
+}
+
+static vector *
+hand_read (FILE *f)
+{
+	vector *v;
+	size_t i, n;
+	uint64_t elem;
+
+	if (fread (&n, sizeof (n), 1, f) != 1)
+	{
+		return NULL;
+	}
+	v = vector_init (sizeof (uint64_t), n, NULL);
+	for (i = 0; i < n && fread (&elem, sizeof (elem), 1, f) == 1; i++)
+	{
+		vector_append (v, &elem);
+	}
+	return v;
+}
+
+static void
+bench_stream_dir (vector *v, const char *dir)
+{
+	char path[64];
+	double gb = (double)(N_STREAM * sizeof (uint64_t)) / 1e9, start, t_write, t_read, t_hwrite, t_hread;
+	vector *back;
+	FILE *f;
+	int fd;
+
+	snprintf (path, sizeof (path), "%s/BenchVectorXXXXXX", dir);
+	fd = mkstemp (path);
+	if (fd < 0)
+	{
+		printf ("stream %-8s unavailable\n", dir);
+		return;
+	}
+
+	start = now_sec ();
+	vector_write (v, fd);
+	t_write = now_sec () - start;
+	lseek (fd, 0, SEEK_SET);
+	start = now_sec ();
+	back = vector_read (fd);
+	t_read = now_sec () - start;
+	if (back == NULL || vector_size (back) != N_STREAM)
+	{
+		printf ("stream %-8s read back failed\n", dir);
+	}
+	if (back != NULL)
+	{
+		vector_destroy (back);
+	}
+
+	ftruncate (fd, 0);
+	lseek (fd, 0, SEEK_SET);
+	f = fdopen (fd, "w+");
+	start = now_sec ();
+	hand_write (v, f);
+	t_hwrite = now_sec () - start;
+	rewind (f);
+	start = now_sec ();
+	back = hand_read (f);
+	t_hread = now_sec () - start;
+	vector_destroy (back);
+	fclose (f);
+	unlink (path);
+
+	printf ("stream %-8s write %6.2f GB/s  read %6.2f GB/s   per element loop: write %6.2f GB/s  read %6.2f GB/s\n",
+	        dir, gb / t_write, gb / t_read, gb / t_hwrite, gb / t_hread);
+}
+
+static void
+bench_stream (void)
+{
+	vector *v = vector_init (sizeof (uint64_t), N_STREAM, NULL);
+	stream_checksum c;
+	double start, t_sum;
+	size_t i;
+	uint64_t elem;
+
+	for (i = 0; i < N_STREAM; i++)
+	{
+		elem = rng_next ();
+		vector_append (v, &elem);
+	}
+
+	start = now_sec ();
+	stream_checksum_init (&c);
+	stream_checksum_update (&c, vector_access (v, 0), N_STREAM * sizeof (uint64_t));
+	t_sum = now_sec () - start;
+	printf ("stream %lu 8 byte elements: checksum alone %6.2f GB/s (%016llx)\n", N_STREAM,
+	        (double)(N_STREAM * sizeof (uint64_t)) / 1e9 / t_sum,
+	        (unsigned long long)stream_checksum_final (&c));
+
+	bench_stream_dir (v, "/dev/shm");
+	bench_stream_dir (v, "/tmp");
+	vector_destroy (v);
+}
+
+/**
+ * Sums the ids so the compiler cannot drop the vector.
+ */
+static uint64_t
+short_sum (vector *v)
+{
+	uint64_t sum = 0;
+	size_t i;
+
+	for (i = 0; i < vector_size (v); i++)
+	{
+		sum += *(uint32_t *)vector_access (v, i);
+	}
+	return sum;
+}
+
+static void
+bench_short_lived (void)
+{
+	uint32_t first[SHORT_LEN], id;
+	double start, t_heap, t_static, t_buffer;
+	uint64_t sum = 0;
+	vector *v, local;
+	size_t i;
+
+	start = now_sec ();
+	for (i = 0; i < N_SHORT; i++)
+	{
+		v = vector_init (sizeof (uint32_t), SHORT_LEN, NULL);
+		for (id = 0; id < SHORT_LEN; id++)
+		{
+			vector_append (v, &id);
+		}
+		sum += short_sum (v);
+		vector_destroy (v);
+	}
+	t_heap = now_sec () - start;
+
+	start = now_sec ();
+	for (i = 0; i < N_SHORT; i++)
+	{
+		vector_init_static (&local, sizeof (uint32_t), SHORT_LEN, NULL);
+		for (id = 0; id < SHORT_LEN; id++)
+		{
+			vector_append (&local, &id);
+		}
+		sum += short_sum (&local);
+		vector_destroy (&local);
+	}
+	t_static = now_sec () - start;
+
+	start = now_sec ();
+	for (i = 0; i < N_SHORT; i++)
+	{
+		vector_init_buffer (&local, sizeof (uint32_t), first, sizeof (first), NULL);
+		for (id = 0; id < SHORT_LEN; id++)
+		{
+			vector_append (&local, &id);
+		}
+		sum += short_sum (&local);
+		vector_destroy (&local);
+	}
+	t_buffer = now_sec () - start;
+
+	printf ("%lu short lived vectors of %d ids (%llu): init %6.1f ns  init_static %6.1f ns  init_buffer %6.1f ns\n",
+	        N_SHORT, SHORT_LEN, (unsigned long long)sum, t_heap * 1e9 / N_SHORT,
+	        t_static * 1e9 / N_SHORT, t_buffer * 1e9 / N_SHORT);
+}
+
+int
+main (void)
+{
+	vector *v, *w;
+	double start, t_generic, t_int;
+	size_t i;
+	uint32_t id;
+
+	bench_pair (N_LARGE, N_LARGE);
+	bench_pair (N_LARGE / 10, N_LARGE);
+	bench_pair (N_LARGE / 100, N_LARGE);
+	bench_pair (N_LARGE / 1000, N_LARGE);
+
+	v = vector_init (sizeof (uint32_t), N_LARGE, NULL);
+	for (i = 0; i < N_LARGE; i++)
+	{
+		id = (uint32_t)(rng_next () % (N_LARGE / 2));
+		vector_append (v, &id);
+	}
+	vector_sort (v, vector_compare_u32);
+
+	w = vector_init (sizeof (uint32_t), N_LARGE, NULL);
+	for (i = 0; i < N_LARGE; i++)
+	{
+		vector_append (w, vector_access (v, i));
+	}
+	start = now_sec ();
+	vector_unique (v, compare_u32);
+	t_generic = now_sec () - start;
+	start = now_sec ();
+	vector_unique (w, vector_compare_u32);
+	t_int = now_sec () - start;
+	printf ("unique %lu ids: compare_fn %8.2f ms  u32 kernel %8.2f ms\n",
+	        N_LARGE, t_generic * 1e3, t_int * 1e3);
+
+	vector_destroy (v);
+	vector_destroy (w);
+
+	bench_top_k ();
+	bench_stable ();
+	bench_growth ();
+	bench_stream ();
+	bench_short_lived ();
+	return 0;
+}
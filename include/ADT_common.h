@@ -9,6 +9,8 @@
 
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
 
 /**
  * Type: elem_destroy_fn
@@ -27,4 +29,29 @@ typedef void (*elem_destroy_fn) (void *addr);
  */
 typedef int (*compare_fn) (const void *elem1, const void *elem2);
 
+/**
+ * Type: hash_fn
+ * ------------------------------------------------------
+ * Typedef for hash function used by the hashed containers. Keys that compare
+ * equal must hash to the same value. The containers mix the result before
+ * use, so a plain identity hash is acceptable for integer keys.
+ */
+typedef size_t (*hash_fn) (const void *key);
+
+/**
+ * Type: timer_fire_fn
+ * ------------------------------------------------------
+ * Typedef for the function called on each timer as it expires. The timer is
+ * no longer pending when this is called, so it may be re-armed or freed.
+ */
+typedef void (*timer_fire_fn) (void *timer);
+
+/**
+ * Macro: CACHE_LINE_SZ
+ * ------------------------------------------------------
+ * The assumed size of a cache line in bytes. Fields written by different
+ * threads are aligned to it so they do not share a line.
+ */
+#define CACHE_LINE_SZ (64)
+
 #endif /* ADT_COMMON_H */
\ No newline at end of file
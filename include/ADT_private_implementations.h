@@ -13,6 +13,40 @@
  * ------------------------------------------------------------------------- 
  */
 
+/**
+ * Enum: vector_storage
+ * ----------------------------------
+ * Where a vector's array of elements lives, which decides how it is grown
+ * and released.
+ *
+ * VECTOR_STORAGE_HEAP   - malloc'd, grown with realloc
+ * VECTOR_STORAGE_MAPPED - an anonymous mapping of its own, grown with mremap
+ * VECTOR_STORAGE_FILE   - a shared mapping of a file after its header, grown
+ *                         with ftruncate and mremap
+ * VECTOR_STORAGE_BUFFER - a buffer owned by the caller, left for the heap on
+ *                         the first growth
+ */
+typedef enum
+{
+	VECTOR_STORAGE_HEAP,
+	VECTOR_STORAGE_MAPPED,
+	VECTOR_STORAGE_FILE,
+	VECTOR_STORAGE_BUFFER
+} vector_storage;
+
+/**
+ * Struct: vector_share
+ * ----------------------------------
+ * The reference count on an array of elements shared by copy on write
+ * clones. The last vector to let go of the array frees it.
+ *
+ * field refs - the number of vectors sharing the array
+ */
+typedef struct
+{
+	atomic_size_t refs;
+} vector_share;
+
 /**
  * Struct: vector
  * ----------------------------------
@@ -22,6 +56,13 @@
  * field capacity     - the current number of elements the vector can hold
  * field elem_sz      - the size of elements in bytes the vector stores
  * field n_elems      - the current number of elements stored in the vector
+ * field storage      - where elems lives
+ * field huge_pages   - whether mapped storage is advised to use huge pages
+ * field read_only    - set for a file mapped read only; nothing may change it
+ * field fd           - the mapped file, -1 for other storage
+ * field alloc_static - set when the caller owns the vector object itself
+ * field share        - the reference count while elems is shared with clones,
+ *                      NULL while the vector owns elems alone
  * field elem_destroy - the function to call on the vector elements to destroy
  *                       on clean up
  */
@@ -32,9 +73,24 @@ typedef struct
 	size_t elem_sz;
 	size_t n_elems;
 	size_t magic;
+	vector_storage storage;
+	bool huge_pages;
+	bool read_only;
+	bool alloc_static;
+	int fd;
+	vector_share *share;
 	elem_destroy_fn elem_destroy;
 } vector;
 
+/**
+ * Function: vector_unshare
+ * ------------------------------------------------------
+ * Gives v a private copy of an array it shares with clones. Modules that
+ * change a vector's elements in place, rather than through the vector
+ * functions, call it first.
+ */
+void vector_unshare (vector *v);
+
 /* ------------------------------------------------------------------------- */
 
 /**
@@ -74,6 +130,44 @@ typedef struct
 
 /* ------------------------------------------------------------------------- */
 
+/**
+ * Bloom Filter Implementations
+ * ------------------------------------------------------------------------- 
+ */
+
+#define BLOOM_BLOCK_WORDS (16) /* the most words a block may have */
+
+/**
+ * Struct: bloom
+ * ----------------------------------
+ * The private bloom implementation, an array of blocks of 4, 8 or 16 32 bit
+ * words, each aligned to its size so it lies within one cache line. An
+ * element sets one bit in each word of the block its hash picks.
+ *
+ * field blocks      - the words of the blocks
+ * field n_blocks    - the number of blocks
+ * field block_words - the number of words in a block
+ * field capacity    - the number of elements the filter was sized for
+ * field n_added     - the number of additions since the filter was cleared
+ * field fp_rate     - the false positive rate asked for at capacity
+ * field elem_sz     - the size of elements, for the batch query
+ * field elem_hash   - the hash function for elements
+ */
+typedef struct
+{
+	uint32_t *blocks;
+	size_t n_blocks;
+	size_t block_words;
+	size_t capacity;
+	size_t n_added;
+	double fp_rate;
+	size_t elem_sz;
+	size_t magic;
+	hash_fn elem_hash;
+} bloom;
+
+/* ------------------------------------------------------------------------- */
+
 /**
  * Set Implementations
  * ------------------------------------------------------------------------- 
@@ -108,9 +202,816 @@ typedef struct
 	compare_fn elem_cmp;
 	elem_destroy_fn elem_destroy;
 	set_elem *root;
+	bloom *filter;
 } set;
 
+/* ------------------------------------------------------------------------- */
+
+/**
+ * LRU Cache Implementations
+ * ------------------------------------------------------------------------- 
+ */
+
+/**
+ * Struct: lru_elem
+ * ----------------------------------
+ * The private lru_elem implementation
+ *
+ * field le         - links the node into the recency list, most recent first
+ * field hash_next  - the next node in the same hash bucket
+ * field hash_pprev - the link that points at this node, either the bucket
+ *                    head or the hash_next field of the previous node
+ * field hash       - the cached hash of the node's key
+ */
+typedef struct lru_elem
+{
+	list_elem le;
+	struct lru_elem *hash_next;
+	struct lru_elem **hash_pprev;
+	size_t hash;
+} lru_elem;
+
+/**
+ * Struct: lru_cache
+ * ----------------------------------
+ * The private lru_cache implementation
+ *
+ * field recency      - list of the cached nodes, least recently used at back
+ * field buckets      - the hash index, a power of two array of chains
+ * field bucket_shift - shift applied to the mixed hash to select a bucket
+ * field capacity     - the number of nodes held before eviction begins
+ * field key_offset   - offset of the key within the client's node
+ * field hits         - number of lookups that found their key
+ * field misses       - number of lookups that did not find their key
+ * field key_hash     - the hash function for keys
+ * field key_cmp      - the equality function for keys, 0 on match
+ * field elem_destroy - the function to call on evicted or removed nodes
+ */
+typedef struct
+{
+	list recency;
+	lru_elem **buckets;
+	size_t bucket_shift;
+	size_t capacity;
+	size_t key_offset;
+	size_t hits;
+	size_t misses;
+	size_t magic;
+	hash_fn key_hash;
+	compare_fn key_cmp;
+	elem_destroy_fn elem_destroy;
+} lru_cache;
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * Timer Wheel Implementations
+ * ------------------------------------------------------------------------- 
+ */
+
+#define TIMER_WHEEL_BITS   (8)
+#define TIMER_WHEEL_SLOTS  (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_LEVELS (4)
+
+/**
+ * Struct: timer_elem
+ * ----------------------------------
+ * The private timer_elem implementation
+ *
+ * field le      - links the timer into its wheel slot
+ * field expires - the tick at which the timer fires
+ * field slot    - the slot the timer is linked into, NULL when not pending
+ */
+typedef struct
+{
+	list_elem le;
+	uint64_t expires;
+	list *slot;
+} timer_elem;
+
+/**
+ * Struct: timer_wheel
+ * ----------------------------------
+ * The private timer_wheel implementation. Level k holds timers due within
+ * 2^(8(k+1)) ticks, each slot covering 2^(8k) ticks. A slot is cascaded into
+ * the levels below when the wheel reaches the start of its range.
+ *
+ * field slots        - the slot lists of every level
+ * field now          - the last tick processed, every timer due by it fired
+ * field n_timers     - the number of pending timers
+ * field n_level      - the number of pending timers in each level
+ * field fire         - the function called on each expired timer
+ * field elem_destroy - the function to call on timers pending at destroy
+ */
+typedef struct
+{
+	list slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+	uint64_t now;
+	size_t n_timers;
+	size_t n_level[TIMER_WHEEL_LEVELS];
+	size_t magic;
+	timer_fire_fn fire;
+	elem_destroy_fn elem_destroy;
+} timer_wheel;
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * Unrolled List Implementations
+ * ------------------------------------------------------------------------- 
+ */
+
+/**
+ * Struct: unrolled_list_node
+ * ----------------------------------
+ * The private unrolled_list_node implementation
+ *
+ * field next    - the following node, NULL at the tail
+ * field prev    - the preceding node, NULL at the head
+ * field n_elems - the number of elements stored in this node
+ * field elems   - the elements, packed from the start of the array
+ */
+typedef struct unrolled_list_node
+{
+	struct unrolled_list_node *next;
+	struct unrolled_list_node *prev;
+	size_t n_elems;
+	uint8_t elems[];
+} unrolled_list_node;
+
+/**
+ * Struct: unrolled_list
+ * ----------------------------------
+ * The private unrolled_list implementation
+ *
+ * field head          - the first node, NULL when empty
+ * field tail          - the last node, NULL when empty
+ * field finger        - the node last located by index, speeds up nearby access
+ * field finger_base   - the index of the first element in finger
+ * field node_capacity - the number of elements each node can hold
+ * field split_at      - the number of elements a split leaves in the first node
+ * field min_fill      - the fewest elements a node but the last may hold, what
+ *                       a split leaves in the second node
+ * field elem_sz       - the size of elements in bytes the list stores
+ * field n_elems       - the current number of elements stored in the list
+ * field elem_destroy  - the function to call on the list elements to destroy
+ *                       on clean up
+ */
+typedef struct
+{
+	unrolled_list_node *head;
+	unrolled_list_node *tail;
+	unrolled_list_node *finger;
+	size_t finger_base;
+	size_t node_capacity;
+	size_t split_at;
+	size_t min_fill;
+	size_t elem_sz;
+	size_t n_elems;
+	size_t magic;
+	elem_destroy_fn elem_destroy;
+} unrolled_list;
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * Deque Implementations
+ * ------------------------------------------------------------------------- 
+ */
+
+/**
+ * Struct: deque
+ * ----------------------------------
+ * The private deque implementation. The elements live in a circular buffer
+ * whose capacity is a power of two, so a logical index maps to a slot with a
+ * mask rather than a division.
+ *
+ * field elems        - the start of the circular buffer of elements
+ * field mask         - the capacity of the buffer less one
+ * field head         - the slot of the front element
+ * field elem_sz      - the size of elements in bytes the deque stores
+ * field n_elems      - the current number of elements stored in the deque
+ * field elem_destroy - the function to call on the deque elements to destroy
+ *                       on clean up
+ */
+typedef struct
+{
+	void *elems;
+	size_t mask;
+	size_t head;
+	size_t elem_sz;
+	size_t n_elems;
+	size_t magic;
+	elem_destroy_fn elem_destroy;
+} deque;
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * Ring Buffer Implementations
+ * ------------------------------------------------------------------------- 
+ */
+
+/**
+ * Struct: spsc_ring
+ * ----------------------------------
+ * The private spsc_ring implementation. The consumer owns head and the
+ * producer owns tail, each on its own cache line. Each side keeps a cached
+ * copy of the other side's index next to its own and only reloads the shared
+ * one when the cached copy says the ring is full or empty.
+ *
+ * field head         - the position of the next element to dequeue
+ * field cached_tail  - the consumer's last view of tail
+ * field tail         - the position of the next slot to enqueue into
+ * field cached_head  - the producer's last view of head
+ * field elems        - the buffer of elements, a power of two long
+ * field mask         - the capacity of the buffer less one
+ * field elem_sz      - the size of elements in bytes the ring stores
+ * field elem_destroy - the function to call on elements left at destroy
+ */
+typedef struct
+{
+	_Alignas (CACHE_LINE_SZ) atomic_size_t head;
+	size_t cached_tail;
+	_Alignas (CACHE_LINE_SZ) atomic_size_t tail;
+	size_t cached_head;
+	_Alignas (CACHE_LINE_SZ) void *elems;
+	size_t mask;
+	size_t elem_sz;
+	size_t magic;
+	elem_destroy_fn elem_destroy;
+} spsc_ring;
+
+/**
+ * Struct: mpmc_ring
+ * ----------------------------------
+ * The private mpmc_ring implementation. Every cell carries a sequence number
+ * telling whether it is ready to be written for the lap at a position, or
+ * ready to be read for it. Producers and consumers claim positions with a
+ * compare and swap on their own counter and then publish through the cell.
+ *
+ * field enqueue_pos  - the next position producers claim
+ * field dequeue_pos  - the next position consumers claim
+ * field cells        - the cells, each a sequence number followed by an element
+ * field cell_sz      - the size of a cell in bytes
+ * field mask         - the number of cells less one
+ * field elem_sz      - the size of elements in bytes the ring stores
+ * field elem_destroy - the function to call on elements left at destroy
+ */
+typedef struct
+{
+	_Alignas (CACHE_LINE_SZ) atomic_size_t enqueue_pos;
+	_Alignas (CACHE_LINE_SZ) atomic_size_t dequeue_pos;
+	_Alignas (CACHE_LINE_SZ) uint8_t *cells;
+	size_t cell_sz;
+	size_t mask;
+	size_t elem_sz;
+	size_t magic;
+	elem_destroy_fn elem_destroy;
+} mpmc_ring;
+
+/* ------------------------------------------------------------------------- */
+
+#define HASHSET_GROUP_WIDTH (16)
+
+/**
+ * Struct: hashset
+ * ----------------------------------
+ * The private hashset implementation. Elements sit inline in a flat array of
+ * slots, with one control byte per slot saying whether it is empty, deleted
+ * or full. A full slot's control byte holds seven bits of the element's hash,
+ * so a probe rules out most slots without touching them. The first group of
+ * control bytes is repeated past the end so any group can be loaded whole.
+ *
+ * field ctrl         - the control bytes, capacity + HASHSET_GROUP_WIDTH long
+ * field slots        - the elements, capacity long
+ * field capacity     - the number of slots, a power of two
+ * field growth_left  - the number of empty slots that may still be filled
+ *                      before the table is rehashed
+ * field elem_sz      - the size of elements in bytes the set stores
+ * field n_elems      - the number of elements in the set
+ * field elem_hash    - the hash function for elements
+ * field elem_cmp     - the compare function, zero meaning equal
+ * field elem_destroy - the function to call on an element when removed
+ */
+typedef struct
+{
+	uint8_t *ctrl;
+	uint8_t *slots;
+	size_t capacity;
+	size_t growth_left;
+	size_t elem_sz;
+	size_t n_elems;
+	size_t magic;
+	hash_fn elem_hash;
+	compare_fn elem_cmp;
+	elem_destroy_fn elem_destroy;
+} hashset;
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * Hash Table Implementations
+ * ------------------------------------------------------------------------- 
+ */
+
+/**
+ * Struct: hash_elem
+ * ----------------------------------
+ * The private hash_elem implementation
+ *
+ * field next  - the next node in the same bucket
+ * field pprev - the link that points at this node, either the bucket head or
+ *               the next field of the previous node
+ * field hash  - the cached hash of the node's key
+ */
+typedef struct hash_elem
+{
+	struct hash_elem *next;
+	struct hash_elem **pprev;
+	size_t hash;
+} hash_elem;
+
+/**
+ * Struct: hash_table
+ * ----------------------------------
+ * The private hash_table implementation. While the table grows, nodes live
+ * in two bucket arrays at once. New nodes always go into the larger array,
+ * and every insert or remove moves a few of the old buckets across until the
+ * old array is empty and can be freed.
+ *
+ * field buckets      - the current bucket array, a power of two long
+ * field old_buckets  - the array being drained, or NULL when not growing
+ * field bucket_shift - shift applied to the mixed hash to select a bucket
+ * field n_old        - the length of old_buckets
+ * field rehash_idx   - the next bucket of old_buckets to move
+ * field n_elems      - the number of nodes in the table
+ * field link_offset  - offset of the hash_elem within the client's node
+ * field key_offset   - offset of the key within the client's node
+ * field key_hash     - the hash function for keys
+ * field key_cmp      - the equality function for keys, 0 on match
+ * field elem_destroy - the function to call on nodes left at destroy
+ */
+typedef struct
+{
+	hash_elem **buckets;
+	hash_elem **old_buckets;
+	size_t bucket_shift;
+	size_t n_old;
+	size_t rehash_idx;
+	size_t n_elems;
+	size_t link_offset;
+	size_t key_offset;
+	size_t magic;
+	hash_fn key_hash;
+	compare_fn key_cmp;
+	elem_destroy_fn elem_destroy;
+} hash_table;
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * Concurrent Map Implementations
+ * ------------------------------------------------------------------------- 
+ */
+
+#define CMAP_SEGMENT_BITS (6)
+#define CMAP_SEGMENTS     ((size_t)1 << CMAP_SEGMENT_BITS)
+
+/**
+ * Struct: cmap_segment
+ * ----------------------------------
+ * The private cmap_segment implementation. A concurrent_map is split into
+ * segments by the top bits of the hash, and each segment is a small open
+ * addressed table with its own writer lock and sequence count. Writers take
+ * the lock and make the count odd while they change slots. Readers take no
+ * lock; they copy what they need and retry if the count moved.
+ *
+ * field seq     - the sequence count, odd while a writer changes the slots
+ * field lock    - held by the one writer allowed in the segment
+ * field table   - the current slot array, preceded by its header
+ * field n_elems - the number of entries in the segment
+ */
+typedef struct
+{
+	_Alignas (CACHE_LINE_SZ) atomic_size_t seq;
+	atomic_flag lock;
+	_Atomic (uint8_t *) table;
+	atomic_size_t n_elems;
+} cmap_segment;
+
+/**
+ * Struct: concurrent_map
+ * ----------------------------------
+ * The private concurrent_map implementation
+ *
+ * field segments     - the CMAP_SEGMENTS segments
+ * field key_sz       - the size of keys in bytes
+ * field val_sz       - the size of values in bytes
+ * field val_offset   - the offset of the value within an entry
+ * field slot_sz      - the size of a slot, a hash tag followed by the entry
+ * field key_hash     - the hash function for keys
+ * field key_cmp      - the equality function for keys, 0 on match
+ * field elem_destroy - the function to call on an entry when it is removed
+ */
+typedef struct
+{
+	cmap_segment *segments;
+	size_t key_sz;
+	size_t val_sz;
+	size_t val_offset;
+	size_t slot_sz;
+	size_t magic;
+	hash_fn key_hash;
+	compare_fn key_cmp;
+	elem_destroy_fn elem_destroy;
+} concurrent_map;
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * Priority Queue Implementations
+ * ------------------------------------------------------------------------- 
+ */
+
+/**
+ * Struct: pqueue
+ * ----------------------------------
+ * The private pqueue implementation. The elements form an implicit d-ary
+ * heap in a vector: the children of index i are at arity * i + 1 through
+ * arity * i + arity.
+ *
+ * field heap      - the vector holding the heap
+ * field hole      - space for one element, used while sifting
+ * field arity     - the number of children per heap node
+ * field elem_cmp  - the compare function, smallest element on top
+ */
+typedef struct
+{
+	vector *heap;
+	void *hole;
+	size_t arity;
+	size_t magic;
+	compare_fn elem_cmp;
+} pqueue;
+
+/**
+ * Struct: ipqueue
+ * ----------------------------------
+ * The private ipqueue implementation. Each heap entry is a handle followed
+ * by its element, so sifting compares neighbouring entries rather than
+ * chasing handles. pos maps each handle back to its heap index, which is
+ * what lets a key change or a removal start from the right entry.
+ *
+ * field heap         - the implicit d-ary heap of entries
+ * field pos          - the heap index of each handle, SIZE_MAX if absent
+ * field hole         - space for one entry, used while sifting
+ * field n_handles    - the length of pos, and the capacity of heap
+ * field n_elems      - the number of entries in the heap
+ * field arity        - the number of children per heap node
+ * field elem_sz      - the size of elements in bytes the queue stores
+ * field entry_sz     - the size of a heap entry in bytes
+ * field elem_cmp     - the compare function, smallest element on top
+ * field elem_destroy - the function to call on elements when destroyed
+ */
+typedef struct
+{
+	uint8_t *heap;
+	size_t *pos;
+	uint8_t *hole;
+	size_t n_handles;
+	size_t n_elems;
+	size_t arity;
+	size_t elem_sz;
+	size_t entry_sz;
+	size_t magic;
+	compare_fn elem_cmp;
+	elem_destroy_fn elem_destroy;
+} ipqueue;
 
+/* ------------------------------------------------------------------------- */
+
+/**
+ * Flat Set Implementations
+ * ------------------------------------------------------------------------- 
+ */
+
+/**
+ * Struct: flat_set
+ * ----------------------------------
+ * The private flat_set implementation, a vector kept sorted and free of
+ * duplicates.
+ *
+ * field elems    - the sorted vector of elements
+ * field elem_cmp - the compare function giving the order
+ */
+typedef struct
+{
+	vector *elems;
+	size_t magic;
+	compare_fn elem_cmp;
+} flat_set;
+
+/**
+ * Struct: flat_map
+ * ----------------------------------
+ * The private flat_map implementation. Each entry is a key followed by its
+ * value, kept in a flat_set ordered by key.
+ *
+ * field entries    - the set of entries
+ * field scratch    - space to assemble one entry
+ * field key_sz     - the size of keys in bytes
+ * field val_sz     - the size of values in bytes
+ * field val_offset - the offset of the value within an entry
+ */
+typedef struct
+{
+	flat_set *entries;
+	uint8_t *scratch;
+	size_t key_sz;
+	size_t val_sz;
+	size_t val_offset;
+	size_t magic;
+} flat_map;
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * Segmented Vector Implementations
+ * ------------------------------------------------------------------------- 
+ */
+
+#define SEG_VECTOR_FIRST_SHIFT (4)
+#define SEG_VECTOR_MAX_CHUNKS  (60)
+
+/**
+ * Struct: seg_vector
+ * ----------------------------------
+ * The private seg_vector implementation. Chunk k holds
+ * 2^(SEG_VECTOR_FIRST_SHIFT + k) elements, so the first k chunks together
+ * hold 2^(SEG_VECTOR_FIRST_SHIFT + k) - 2^SEG_VECTOR_FIRST_SHIFT and an
+ * index finds its chunk from the position of its highest set bit once that
+ * offset is added. Chunks are never moved or freed before destroy.
+ *
+ * field chunks       - the chunk arrays, the first n_chunks allocated
+ * field n_chunks     - the number of chunks allocated
+ * field capacity     - the number of elements the allocated chunks hold
+ * field elem_sz      - the size of elements in bytes the vector stores
+ * field n_elems      - the current number of elements stored in the vector
+ * field elem_destroy - the function to call on the vector elements to destroy
+ *                       on clean up
+ */
+typedef struct
+{
+	uint8_t *chunks[SEG_VECTOR_MAX_CHUNKS];
+	size_t n_chunks;
+	size_t capacity;
+	size_t elem_sz;
+	size_t n_elems;
+	size_t magic;
+	elem_destroy_fn elem_destroy;
+} seg_vector;
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * Columns Implementations
+ * ------------------------------------------------------------------------- 
+ */
+
+/**
+ * Struct: columns
+ * ----------------------------------
+ * The private columns implementation. Field k of every row is stored in
+ * cols[k], an array of its own aligned to a cache line, so a scan of one
+ * field reads only that field's bytes. Rows are exchanged with callers in a
+ * row layout of row_sz bytes with field k at field_off[k].
+ *
+ * field cols      - one array per field, each with room for capacity values
+ * field field_sz  - the size of each field in bytes
+ * field field_off - the offset of each field within a row
+ * field n_fields  - the number of fields
+ * field row_sz    - the size in bytes of a row
+ * field n_rows    - the number of rows stored
+ * field capacity  - the number of rows the arrays can hold
+ */
+typedef struct
+{
+	uint8_t **cols;
+	size_t *field_sz;
+	size_t *field_off;
+	size_t n_fields;
+	size_t row_sz;
+	size_t n_rows;
+	size_t capacity;
+	size_t magic;
+} columns;
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * Packed Vector Implementations
+ * ------------------------------------------------------------------------- 
+ */
+
+#define PACKED_VECTOR_BLOCK (128)
+
+/**
+ * Struct: packed_vector
+ * ----------------------------------
+ * The private packed_vector implementation. Every full block of
+ * PACKED_VECTOR_BLOCK values is encoded into data, and the values that do
+ * not yet fill a block wait uncompressed in tail. Block k starts at byte
+ * offsets[k] of data and its first value is firsts[k], which together form
+ * the skip index a lookup searches before decoding one block.
+ *
+ * field data           - the encoded blocks, back to back
+ * field data_sz        - the number of bytes of data in use
+ * field data_capacity  - the number of bytes data can hold
+ * field firsts         - the first value of each block
+ * field offsets        - the offset in data of each block
+ * field n_blocks       - the number of encoded blocks
+ * field block_capacity - the number of blocks the index arrays can hold
+ * field n_elems        - the number of values stored
+ * field last           - the last value appended
+ * field tail           - the values after the last full block
+ */
+typedef struct
+{
+	uint8_t *data;
+	size_t data_sz;
+	size_t data_capacity;
+	uint64_t *firsts;
+	uint64_t *offsets;
+	size_t n_blocks;
+	size_t block_capacity;
+	size_t n_elems;
+	uint64_t last;
+	size_t magic;
+	uint64_t tail[PACKED_VECTOR_BLOCK];
+} packed_vector;
+
+/**
+ * Struct: packed_vector_iter
+ * ----------------------------------
+ * A position in a packed_vector, held by the caller. Each step decodes one
+ * block into buf.
+ *
+ * field pv    - the packed_vector iterated over
+ * field block - the block the next step returns, n_blocks for the tail
+ * field skip  - the number of values to pass over at the start of that block
+ * field buf   - the values of the block last decoded
+ */
+typedef struct
+{
+	const packed_vector *pv;
+	size_t block;
+	size_t skip;
+	uint64_t buf[PACKED_VECTOR_BLOCK];
+} packed_vector_iter;
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * Bitset Implementations
+ * ------------------------------------------------------------------------- 
+ */
+
+#define BITSET_SELECT_SAMPLE (1024)
+
+/**
+ * Struct: bitset
+ * ----------------------------------
+ * The private bitset implementation. Bit i is bit i % 64 of words[i / 64],
+ * and the bits of the last word past n_bits are kept clear. The rank index
+ * is built on demand and dropped by any change: ranks[k] counts the set bits
+ * before block k, a block being the eight words of one cache line, and
+ * samples[j] is the block holding set bit number j * BITSET_SELECT_SAMPLE.
+ *
+ * field words       - the bits, aligned to a cache line
+ * field n_bits      - the number of bits
+ * field n_words     - the number of words holding them
+ * field ranks       - the set bits before each block, and in all of them
+ * field samples     - the block holding every BITSET_SELECT_SAMPLE'th set bit
+ * field n_samples   - the number of samples
+ * field index_valid - whether ranks and samples describe the current bits
+ */
+typedef struct
+{
+	uint64_t *words;
+	size_t n_bits;
+	size_t n_words;
+	size_t *ranks;
+	size_t *samples;
+	size_t n_samples;
+	bool index_valid;
+	size_t magic;
+} bitset;
+
+/**
+ * Struct: bitset_iter
+ * ----------------------------------
+ * A position among the set bits of a bitset, held by the caller.
+ *
+ * field bs   - the bitset iterated over
+ * field word - the word being read
+ * field bits - the set bits of that word not yet returned
+ */
+typedef struct
+{
+	const bitset *bs;
+	size_t word;
+	uint64_t bits;
+} bitset_iter;
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * Roaring Bitmap Implementations
+ * ------------------------------------------------------------------------- 
+ */
+
+#define ROARING_ARRAY_MAX (4096)
+
+/**
+ * Enum: roaring_type
+ * ----------------------------------
+ * How a container holds the low 16 bits of its values.
+ *
+ * ROARING_ARRAY  - a sorted array of at most ROARING_ARRAY_MAX values
+ * ROARING_BITMAP - a bitset of 65536 bits, for more values than that
+ * ROARING_RUN    - a sorted array of runs, each a start and a length less
+ *                  one, for values that come in long consecutive stretches
+ */
+typedef enum
+{
+	ROARING_ARRAY,
+	ROARING_BITMAP,
+	ROARING_RUN
+} roaring_type;
+
+/**
+ * Struct: roaring_container
+ * ----------------------------------
+ * The values of a roaring bitmap that share their high 16 bits. A container
+ * is never empty.
+ *
+ * field data     - the uint16_t values or runs, or the bitset
+ * field card     - the number of values
+ * field n        - the number of values of an array or runs of a run
+ *                  container
+ * field capacity - the number of uint16_t an array or run container's data
+ *                  can hold
+ * field key      - the high 16 bits of the values
+ * field type     - the representation, a roaring_type
+ */
+typedef struct
+{
+	void *data;
+	uint32_t card;
+	uint32_t n;
+	uint32_t capacity;
+	uint16_t key;
+	uint8_t type;
+} roaring_container;
+
+/**
+ * Struct: roaring
+ * ----------------------------------
+ * The private roaring implementation. The 32 bit values are split by their
+ * high 16 bits among containers, which are kept sorted by key.
+ *
+ * field containers   - the containers, sorted by key
+ * field n_containers - the number of containers
+ * field capacity     - the number of containers the array can hold
+ */
+typedef struct
+{
+	roaring_container *containers;
+	size_t n_containers;
+	size_t capacity;
+	size_t magic;
+} roaring;
+
+/**
+ * Struct: roaring_iter
+ * ----------------------------------
+ * A position among the values of a roaring bitmap, held by the caller.
+ *
+ * field r         - the roaring bitmap iterated over
+ * field container - the container being read
+ * field pos       - the value, run or word of the container reached
+ * field offset    - the values of the current run already returned
+ * field bits      - the bits of the current word not yet returned
+ */
+typedef struct
+{
+	const roaring *r;
+	size_t container;
+	uint32_t pos;
+	uint32_t offset;
+	uint64_t bits;
+} roaring_iter;
 
 /* ------------------------------------------------------------------------- */
 
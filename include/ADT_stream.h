@@ -0,0 +1,318 @@
+/**
+ * File: ADT_stream.h
+ * ------------------------------------------------------
+ * Private helpers for the binary stream format shared by vector_write and
+ * set_write. A stream is a 32 byte header, the elements' bytes as they are in
+ * memory, and an 8 byte trailer holding a checksum of the header and the
+ * elements. Header and trailer fields are little-endian.
+ *
+ *   offset  0  magic     8 bytes, one per container type
+ *   offset  8  version   4 bytes
+ *   offset 12  elem_sz   4 bytes
+ *   offset 16  n_elems   8 bytes
+ *   offset 24  reserved  8 bytes, zero
+ *
+ * The checksum runs four independent 64 bit multiply rotate lanes over 32
+ * byte stripes, so it keeps up with memory bandwidth rather than with a chain
+ * of dependent multiplies.
+ */
+
+#ifndef ADT_STREAM_H
+#define ADT_STREAM_H
+
+#include "ADT_common.h"
+#include <errno.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#define STREAM_VERSION      (1)
+#define STREAM_HEADER_SZ    (32)
+#define STREAM_TRAILER_SZ   (8)
+#define STREAM_CHUNK_SZ     ((size_t)1 << 20) /* bytes per write, a multiple of 32 */
+#define STREAM_PRIME_1      (0x9e3779b185ebca87ULL)
+#define STREAM_PRIME_2      (0xc2b2ae3d27d4eb4fULL)
+
+/**
+ * Struct: stream_checksum
+ * ----------------------------------
+ * The running state of a checksum.
+ *
+ * field lane - the four accumulators, one per 8 bytes of a stripe
+ * field len  - the number of bytes checksummed so far
+ */
+typedef struct
+{
+	uint64_t lane[4];
+	uint64_t len;
+} stream_checksum;
+
+static inline uint64_t
+stream_load_le64 (const uint8_t *p)
+{
+	uint64_t x;
+
+	memcpy (&x, p, sizeof (x));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	x = __builtin_bswap64 (x);
+#endif
+	return x;
+}
+
+static inline void
+stream_store_le64 (uint8_t *p, uint64_t x)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	x = __builtin_bswap64 (x);
+#endif
+	memcpy (p, &x, sizeof (x));
+}
+
+static inline uint64_t
+stream_round (uint64_t acc, uint64_t word)
+{
+	acc += word * STREAM_PRIME_2;
+	acc = (acc << 31) | (acc >> 33);
+	return acc * STREAM_PRIME_1;
+}
+
+static inline void
+stream_checksum_init (stream_checksum *c)
+{
+	c->lane[0] = STREAM_PRIME_1 + STREAM_PRIME_2;
+	c->lane[1] = STREAM_PRIME_2;
+	c->lane[2] = 0;
+	c->lane[3] = 0 - STREAM_PRIME_1;
+	c->len = 0;
+}
+
+/**
+ * Function: stream_checksum_update
+ * ------------------------------------------------------
+ * Adds len bytes to the checksum. Every call but the last must pass a
+ * multiple of 32 bytes; the last may end in a partial stripe.
+ */
+static inline void
+stream_checksum_update (stream_checksum *c, const void *data, size_t len)
+{
+	const uint8_t *p = data, *end;
+	uint64_t tail;
+
+	if (len == 0)
+	{
+		return;
+	}
+
+	for (end = p + len / 32 * 32; p < end; p += 32)
+	{
+		c->lane[0] = stream_round (c->lane[0], stream_load_le64 (p));
+		c->lane[1] = stream_round (c->lane[1], stream_load_le64 (p + 8));
+		c->lane[2] = stream_round (c->lane[2], stream_load_le64 (p + 16));
+		c->lane[3] = stream_round (c->lane[3], stream_load_le64 (p + 24));
+	}
+
+	for (end = (const uint8_t *)data + len; p + 8 <= end; p += 8)
+	{
+		c->lane[0] = stream_round (c->lane[0], stream_load_le64 (p));
+	}
+	if (p < end)
+	{
+		tail = 0;
+		memcpy (&tail, p, (size_t)(end - p));
+		c->lane[1] = stream_round (c->lane[1], tail);
+	}
+
+	c->len += len;
+}
+
+static inline uint64_t
+stream_checksum_final (const stream_checksum *c)
+{
+	uint64_t h = c->len * STREAM_PRIME_1;
+	int i;
+
+	for (i = 0; i < 4; i++)
+	{
+		h = stream_round (h ^ c->lane[i], c->lane[i]);
+	}
+	h ^= h >> 29;
+	h *= STREAM_PRIME_2;
+	return h ^ (h >> 32);
+}
+
+/**
+ * Function: stream_header_encode
+ * ------------------------------------------------------
+ * Fills in a header and starts the checksum with it.
+ */
+static inline void
+stream_header_encode (uint8_t *header, uint64_t magic, size_t elem_sz,
+                      size_t n_elems, stream_checksum *c)
+{
+	memset (header, 0, STREAM_HEADER_SZ);
+	stream_store_le64 (header, magic);
+	stream_store_le64 (header + 8, (uint64_t)STREAM_VERSION | (uint64_t)elem_sz << 32);
+	stream_store_le64 (header + 16, n_elems);
+
+	stream_checksum_init (c);
+	stream_checksum_update (c, header, STREAM_HEADER_SZ);
+}
+
+/**
+ * Function: stream_header_decode
+ * ------------------------------------------------------
+ * Checks a header's magic, version and element size, starting the checksum
+ * with it.
+ *
+ * returns - false if the header does not describe a stream of this kind
+ */
+static inline bool
+stream_header_decode (const uint8_t *header, uint64_t magic, size_t *elem_sz,
+                      size_t *n_elems, stream_checksum *c)
+{
+	uint64_t version_sz = stream_load_le64 (header + 8);
+
+	if (stream_load_le64 (header) != magic || (uint32_t)version_sz != STREAM_VERSION ||
+	    (version_sz >> 32) == 0 || stream_load_le64 (header + 24) != 0)
+	{
+		return false;
+	}
+
+	*elem_sz = (size_t)(version_sz >> 32);
+	*n_elems = (size_t)stream_load_le64 (header + 16);
+
+	stream_checksum_init (c);
+	stream_checksum_update (c, header, STREAM_HEADER_SZ);
+	return true;
+}
+
+/**
+ * Function: stream_transfer
+ * ------------------------------------------------------
+ * Writes, or reads, every byte described by an array of buffers, calling
+ * writev or readv again after short transfers and interruptions. The array
+ * is consumed in the process.
+ *
+ * returns - false on an I/O error or, when reading, an early end of file
+ */
+static inline bool
+stream_transfer (int fd, struct iovec *iov, int n_iov, bool writing)
+{
+	ssize_t done;
+
+	while (n_iov > 0)
+	{
+		done = writing ? writev (fd, iov, n_iov) : readv (fd, iov, n_iov);
+		if (done < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if (done <= 0)
+		{
+			return false;
+		}
+
+		while (n_iov > 0 && (size_t)done >= iov->iov_len)
+		{
+			done -= (ssize_t)iov->iov_len;
+			iov++;
+			n_iov--;
+		}
+		if (n_iov > 0)
+		{
+			iov->iov_base = (uint8_t *)iov->iov_base + done;
+			iov->iov_len -= (size_t)done;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Function: stream_write_chunk
+ * ------------------------------------------------------
+ * Checksums len bytes of elements and writes them in one writev, preceded by
+ * the header if one is given and followed by the trailer if this is the last
+ * chunk. Chunks before the last must be multiples of 32 bytes long.
+ *
+ * returns - false on an I/O error
+ */
+static inline bool
+stream_write_chunk (int fd, stream_checksum *c, const uint8_t *header,
+                    const void *data, size_t len, bool last)
+{
+	uint8_t trailer[STREAM_TRAILER_SZ];
+	struct iovec iov[3];
+	int n_iov = 0;
+
+	stream_checksum_update (c, data, len);
+
+	if (header != NULL)
+	{
+		iov[n_iov++] = (struct iovec){ (void *)header, STREAM_HEADER_SZ };
+	}
+	if (len > 0)
+	{
+		iov[n_iov++] = (struct iovec){ (void *)data, len };
+	}
+	if (last)
+	{
+		stream_store_le64 (trailer, stream_checksum_final (c));
+		iov[n_iov++] = (struct iovec){ trailer, STREAM_TRAILER_SZ };
+	}
+
+	return stream_transfer (fd, iov, n_iov, true);
+}
+
+/**
+ * Function: stream_read_header
+ * ------------------------------------------------------
+ * Reads and decodes a header, starting the checksum with it.
+ *
+ * returns - false on an I/O error or a header of the wrong kind
+ */
+static inline bool
+stream_read_header (int fd, uint64_t magic, size_t *elem_sz, size_t *n_elems,
+                    stream_checksum *c)
+{
+	uint8_t header[STREAM_HEADER_SZ];
+	struct iovec iov = { header, STREAM_HEADER_SZ };
+
+	return stream_transfer (fd, &iov, 1, false) &&
+	       stream_header_decode (header, magic, elem_sz, n_elems, c);
+}
+
+/**
+ * Function: stream_read_chunk
+ * ------------------------------------------------------
+ * Reads len bytes of elements and checksums them. The last chunk is read
+ * together with the trailer, which must match the checksum. Exactly the
+ * bytes of the stream are consumed, so another stream may follow on fd.
+ *
+ * returns - false on an I/O error, an early end of file or a bad checksum
+ */
+static inline bool
+stream_read_chunk (int fd, stream_checksum *c, void *data, size_t len, bool last)
+{
+	uint8_t trailer[STREAM_TRAILER_SZ];
+	struct iovec iov[2];
+	int n_iov = 0;
+
+	if (len > 0)
+	{
+		iov[n_iov++] = (struct iovec){ data, len };
+	}
+	if (last)
+	{
+		iov[n_iov++] = (struct iovec){ trailer, STREAM_TRAILER_SZ };
+	}
+	if (!stream_transfer (fd, iov, n_iov, false))
+	{
+		return false;
+	}
+
+	stream_checksum_update (c, data, len);
+	return !last || stream_load_le64 (trailer) == stream_checksum_final (c);
+}
+
+#endif /* ADT_STREAM_H */
@@ -0,0 +1,187 @@
+/**
+ * File: Bitset.h
+ * ------------------------------------------------------
+ * Defines the interface for the bitset type. This is a fixed size array of
+ * bits, one per id in a dense range, where a set or vector of ids spends 8
+ * to 64 bytes an id. Whole bitsets are combined a word at a time, 256 bits
+ * per instruction on processors with AVX2, checked for at run time.
+ *
+ * Rank counts the set bits below a position and select finds the position
+ * of the k'th set bit. Both are answered from a sampled index of the counts
+ * per cache line, built on the first call after a change, so they suit a
+ * bitset that is built and then queried.
+ *
+ * bitset *seen = bitset_init (1 << 20);
+ * bitset_set (seen, id);
+ */
+
+#ifndef BITSET_H
+#define BITSET_H
+
+#include "ADT_common.h"
+#include "ADT_private_implementations.h"
+#include "Vector.h"
+
+/**
+ * Function: bitset_init
+ * Usage: bitset *bs = bitset_init (1 << 20)
+ * ------------------------------------------------------
+ * Creates a new bitset of n_bits bits, all clear.
+ *
+ * Asserts: allocation failure
+ */
+bitset *bitset_init (size_t n_bits);
+
+/**
+ * Function: bitset_destroy
+ * Usage: bitset_destroy (bs)
+ * ------------------------------------------------------
+ */
+void bitset_destroy (bitset *bs);
+
+/**
+ * Function: bitset_size
+ * Usage: size_t n_bits = bitset_size (bs)
+ * ------------------------------------------------------
+ */
+size_t bitset_size (const bitset *bs);
+
+/**
+ * Function: bitset_resize
+ * Usage: bitset_resize (bs, n_bits)
+ * ------------------------------------------------------
+ * Changes the number of bits. Bits added are clear, and bits below the new
+ * size keep their values.
+ *
+ * Asserts: allocation failure
+ */
+void bitset_resize (bitset *bs, size_t n_bits);
+
+/**
+ * Function: bitset_set
+ * Usage: bitset_set (bs, id)
+ * ------------------------------------------------------
+ * Asserts: position out of range
+ */
+void bitset_set (bitset *bs, size_t pos);
+
+/**
+ * Function: bitset_clear
+ * Usage: bitset_clear (bs, id)
+ * ------------------------------------------------------
+ * Asserts: position out of range
+ */
+void bitset_clear (bitset *bs, size_t pos);
+
+/**
+ * Function: bitset_test
+ * Usage: if (bitset_test (bs, id)) ...
+ * ------------------------------------------------------
+ * Asserts: position out of range
+ */
+bool bitset_test (const bitset *bs, size_t pos);
+
+/**
+ * Function: bitset_clear_all
+ * Usage: bitset_clear_all (bs)
+ * ------------------------------------------------------
+ */
+void bitset_clear_all (bitset *bs);
+
+/**
+ * Function: bitset_and
+ * Usage: bitset_and (dst, src)
+ * ------------------------------------------------------
+ * The bulk operations combine src into dst bit by bit: and keeps the bits set
+ * in both, or those set in either, xor those set in one only, and andnot the
+ * bits of dst not set in src.
+ *
+ * Asserts: bitsets of different sizes
+ */
+void bitset_and (bitset *dst, const bitset *src);
+void bitset_or (bitset *dst, const bitset *src);
+void bitset_xor (bitset *dst, const bitset *src);
+void bitset_andnot (bitset *dst, const bitset *src);
+
+/**
+ * Function: bitset_count
+ * Usage: size_t n = bitset_count (bs)
+ * ------------------------------------------------------
+ * Returns the number of set bits.
+ */
+size_t bitset_count (const bitset *bs);
+
+/**
+ * Function: bitset_rank
+ * Usage: size_t below = bitset_rank (bs, id)
+ * ------------------------------------------------------
+ * Returns the number of set bits at positions below pos, which may be the
+ * size. This is the index of pos among the set bits when it is set.
+ *
+ * Asserts: position out of range
+ */
+size_t bitset_rank (bitset *bs, size_t pos);
+
+/**
+ * Function: bitset_select
+ * Usage: size_t id = bitset_select (bs, k)
+ * ------------------------------------------------------
+ * Returns the position of set bit number k, counting from 0, the inverse of
+ * rank.
+ *
+ * Asserts: k not below the count
+ */
+size_t bitset_select (bitset *bs, size_t k);
+
+/**
+ * Function: bitset_iter_init
+ * Usage: bitset_iter_init (bs, &it, 0)
+ * ------------------------------------------------------
+ * Positions an iterator to return the set bits at and above start in
+ * order. The iterator sees changes to words it has not yet reached.
+ *
+ * Asserts: start past the size
+ */
+void bitset_iter_init (const bitset *bs, bitset_iter *it, size_t start);
+
+/**
+ * Function: bitset_iter_next
+ * Usage: while (bitset_iter_next (&it, &id)) ...
+ * ------------------------------------------------------
+ * Sets pos to the next set bit and returns true, or returns false once
+ * there are none left.
+ */
+bool bitset_iter_next (bitset_iter *it, size_t *pos);
+
+/**
+ * Function: bitset_iter_next_many
+ * Usage: while ((n = bitset_iter_next_many (&it, ids, 256)) > 0) ...
+ * ------------------------------------------------------
+ * Fills pos with up to max_n of the next set bits, in order, and returns how
+ * many it wrote, 0 once there are none left. This spares a call per bit.
+ */
+size_t bitset_iter_next_many (bitset_iter *it, size_t *pos, size_t max_n);
+
+/**
+ * Function: bitset_from_vector
+ * Usage: bitset *bs = bitset_from_vector (ids)
+ * ------------------------------------------------------
+ * Creates a bitset with a bit set for each id in a vector of uint32_t or
+ * uint64_t, in any order, sized one past the largest.
+ *
+ * Asserts: element size not 4 or 8
+ */
+bitset *bitset_from_vector (const vector *v);
+
+/**
+ * Function: bitset_to_vector
+ * Usage: vector *ids = bitset_to_vector (bs, sizeof(uint32_t))
+ * ------------------------------------------------------
+ * Creates a sorted vector of the positions of the set bits, as uint32_t or
+ * uint64_t by elem_sz.
+ *
+ * Asserts: elem_sz not 4 or 8, a position too large for uint32_t
+ */
+vector *bitset_to_vector (const bitset *bs, size_t elem_sz);
+
+#endif /* BITSET_H */
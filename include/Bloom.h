@@ -0,0 +1,101 @@
+/**
+ * File: Bloom.h
+ * ------------------------------------------------------
+ * Defines the interface for the bloom type, a blocked Bloom filter. It
+ * answers whether an element may have been added, with no false negatives
+ * and false positives at about the rate it was sized for, in a fraction of
+ * the memory of the elements themselves. Put in front of a slower lookup it
+ * turns most absent keys away early.
+ *
+ * Each element's bits all lie in one block of 16 to 64 bytes within a
+ * cache line, so a query costs a single cache miss where a plain Bloom
+ * filter spends one per bit. The bits of a block are tested together with
+ * SSE2, and the batch query works out the blocks of many keys and
+ * prefetches them before testing any, so the misses overlap; it uses AVX2
+ * where the processor has it.
+ *
+ * bloom *seen = bloom_init (sizeof(uint64_t), 1000000, 0.01, hash_u64);
+ * bloom_add (seen, &id);
+ */
+
+#ifndef BLOOM_H
+#define BLOOM_H
+
+#include "ADT_common.h"
+#include "ADT_private_implementations.h"
+
+/**
+ * Function: bloom_init
+ * Usage: bloom *b = bloom_init (sizeof(uint64_t), 1000000, 0.01, hash_u64)
+ * ------------------------------------------------------
+ * Creates an empty filter with false positives at fp_rate once capacity
+ * elements have been added. The number of blocks and their width, which
+ * is the number of bits per element, are the smallest filter meeting the
+ * rate, worked out exactly for blocks rather than from the formula for a
+ * plain Bloom filter, which blocking would miss.
+ *
+ * Asserts: zero elem_sz, NULL hash function, fp_rate not between 0 and 1,
+ *          allocation failure
+ */
+bloom *bloom_init (size_t elem_sz, size_t capacity, double fp_rate, hash_fn hash);
+
+/**
+ * Function: bloom_destroy
+ * Usage: bloom_destroy (b)
+ * ------------------------------------------------------
+ */
+void bloom_destroy (bloom *b);
+
+/**
+ * Function: bloom_add
+ * Usage: bloom_add (b, &id)
+ * ------------------------------------------------------
+ * Adds an element. Elements cannot be removed; adding past the capacity
+ * raises the false positive rate.
+ */
+void bloom_add (bloom *b, const void *key);
+
+/**
+ * Function: bloom_contains
+ * Usage: if (bloom_contains (b, &id)) ...
+ * ------------------------------------------------------
+ * Returns false if the element was certainly never added, and true if it
+ * was or, at about the false positive rate, if it was not.
+ */
+bool bloom_contains (const bloom *b, const void *key);
+
+/**
+ * Function: bloom_contains_many
+ * Usage: size_t n_maybe = bloom_contains_many (b, ids, n, maybe)
+ * ------------------------------------------------------
+ * Queries n elements laid out contiguously at keys, setting maybe[i] to
+ * what bloom_contains would return for element i, and returns how many
+ * were true.
+ */
+size_t bloom_contains_many (const bloom *b, const void *keys, size_t n, bool *maybe);
+
+/**
+ * Function: bloom_clear
+ * Usage: bloom_clear (b)
+ * ------------------------------------------------------
+ * Forgets every element, keeping the size.
+ */
+void bloom_clear (bloom *b);
+
+/**
+ * Function: bloom_bytes
+ * Usage: size_t bytes = bloom_bytes (b)
+ * ------------------------------------------------------
+ */
+size_t bloom_bytes (const bloom *b);
+
+/**
+ * Function: bloom_fp_rate
+ * Usage: double rate = bloom_fp_rate (b)
+ * ------------------------------------------------------
+ * Returns the expected false positive rate after the additions made so
+ * far, counting repeated additions of an element as distinct.
+ */
+double bloom_fp_rate (const bloom *b);
+
+#endif /* BLOOM_H */
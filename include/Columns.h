@@ -0,0 +1,144 @@
+/**
+ * File: Columns.h
+ * ------------------------------------------------------
+ * Defines the interface for the columns type. This holds records as a
+ * struct of arrays: each field of every row is kept in its own contiguous
+ * array, where a vector of structs keeps whole rows side by side. A scan
+ * that reads one field of every row then reads only that field's bytes, and
+ * does so from a plain array the compiler can vectorize.
+ *
+ * A columns is defined by the size of each field and where each sits in a
+ * row struct, so rows can be appended and fetched as structs and whole
+ * vectors of structs converted in either direction:
+ *
+ * typedef struct { uint64_t id; float price; uint32_t qty; } trade;
+ * size_t sz[] = { sizeof(uint64_t), sizeof(float), sizeof(uint32_t) };
+ * size_t off[] = { offsetof(trade, id), offsetof(trade, price),
+ *                  offsetof(trade, qty) };
+ * columns *c = columns_init (3, sz, off, sizeof(trade), 0);
+ *
+ * Fields are copied byte for byte and never destroyed, so they must own
+ * nothing.
+ */
+
+#ifndef COLUMNS_H
+#define COLUMNS_H
+
+#include "ADT_common.h"
+#include "ADT_private_implementations.h"
+#include "Vector.h"
+
+/**
+ * Function: columns_init
+ * Usage: columns *c = columns_init (3, sz, off, sizeof(trade), 0)
+ * ------------------------------------------------------
+ * Creates a new columns with no rows. field_sz gives the size of each of the
+ * n_fields fields, and field_off the offset of each within a row of row_sz
+ * bytes. If field_off is NULL the fields are packed in order with no gaps
+ * and row_sz must be their total.
+ *
+ * Asserts: no fields, a zero sized field, a field outside the row,
+ *          allocation failure
+ */
+columns *columns_init (size_t n_fields, const size_t *field_sz,
+                       const size_t *field_off, size_t row_sz,
+                       size_t capacity_hint);
+
+/**
+ * Function: columns_destroy
+ * Usage: columns_destroy (c)
+ * ------------------------------------------------------
+ */
+void columns_destroy (columns *c);
+
+/**
+ * Function: columns_size
+ * Usage: size_t n_rows = columns_size (c)
+ * ------------------------------------------------------
+ */
+size_t columns_size (const columns *c);
+
+/**
+ * Function: columns_column
+ * Usage: const float *price = columns_column (c, 1)
+ * ------------------------------------------------------
+ * Returns the array holding a field of every row, aligned to a cache line,
+ * with the field of row i at index i. The array moves when rows are
+ * appended past the capacity or the rows are sorted.
+ *
+ * Asserts: field out of range
+ */
+void *columns_column (columns *c, size_t field);
+
+/**
+ * Function: columns_at
+ * Usage: uint32_t *qty = columns_at (c, row, 2)
+ * ------------------------------------------------------
+ * Returns a pointer to one field of one row.
+ *
+ * Asserts: row or field out of range
+ */
+void *columns_at (columns *c, size_t row, size_t field);
+
+/**
+ * Function: columns_append
+ * Usage: columns_append (c, &t)
+ * ------------------------------------------------------
+ * Appends a row, copying each field out of a struct in the row layout.
+ */
+void columns_append (columns *c, const void *row);
+
+/**
+ * Function: columns_get
+ * Usage: columns_get (c, i, &t)
+ * ------------------------------------------------------
+ * Copies the fields of a row into a struct in the row layout. Bytes of the
+ * struct outside the fields are left as they are.
+ *
+ * Asserts: row out of range
+ */
+void columns_get (const columns *c, size_t row, void *out);
+
+/**
+ * Function: columns_sort
+ * Usage: columns_sort (c, 1, compare_float)
+ * ------------------------------------------------------
+ * Sorts the rows by one field, comparing with fn on pointers to that field.
+ * The permutation is found from the key column alone and then applied to
+ * each column in one pass. The sort is stable, so sorting by the minor key
+ * first and the major key last orders by both.
+ *
+ * Asserts: field out of range, null compare function
+ */
+void columns_sort (columns *c, size_t field, compare_fn fn);
+
+/**
+ * Function: columns_clear
+ * Usage: columns_clear (c)
+ * ------------------------------------------------------
+ * Removes every row, keeping the capacity.
+ */
+void columns_clear (columns *c);
+
+/**
+ * Function: columns_from_vector
+ * Usage: columns *c = columns_from_vector (trades, 3, sz, off)
+ * ------------------------------------------------------
+ * Creates a columns holding the rows of a vector of structs, whose element
+ * size is the row size.
+ *
+ * Asserts: as for columns_init
+ */
+columns *columns_from_vector (const vector *v, size_t n_fields,
+                              const size_t *field_sz, const size_t *field_off);
+
+/**
+ * Function: columns_to_vector
+ * Usage: vector *trades = columns_to_vector (c)
+ * ------------------------------------------------------
+ * Creates a vector of structs holding the rows. Bytes of each struct outside
+ * the fields are zero.
+ */
+vector *columns_to_vector (const columns *c);
+
+#endif /* COLUMNS_H */
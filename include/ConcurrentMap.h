@@ -0,0 +1,87 @@
+/**
+ * File: ConcurrentMap.h
+ * ------------------------------------------------------
+ * Defines the interface for the concurrent_map type. This is a hash map from
+ * fixed size keys to fixed size values that any number of threads may use at
+ * once without outside locking.
+ *
+ * The map is split into segments, each with its own lock, so writers to
+ * different segments never wait on each other. Readers take no lock at all:
+ * each segment carries a sequence count that writers bump around every
+ * change, and a reader whose copy overlapped a change simply retries. A
+ * segment that fills is resized on its own while the rest of the map carries
+ * on.
+ *
+ * Keys and values are copied in on put and values copied out on get. A
+ * reader may see a key's bytes while a writer is changing them, before it
+ * notices and retries, so the compare function must only look at the key's
+ * own bytes and never follow pointers stored in it.
+ */
+
+#ifndef CONCURRENT_MAP_H
+#define CONCURRENT_MAP_H
+
+#include "ADT_common.h"
+#include "ADT_private_implementations.h"
+
+/**
+ * Function: concurrent_map_init
+ * Usage: concurrent_map *m = concurrent_map_init (sizeof(uint64_t),
+ *                                                 sizeof(my_value),
+ *                                                 hash_fn, cmp_fn, NULL)
+ * ------------------------------------------------------
+ * Creates a new empty map. The destroy function, if any, is called with a
+ * pointer to the stored entry, the key immediately followed by the value at
+ * the next multiple of sizeof (size_t). It runs inside the segment's lock.
+ *
+ * Asserts: zero key_sz or val_sz, null hash or compare function, allocation
+ *          failure
+ */
+concurrent_map *concurrent_map_init (size_t key_sz, size_t val_sz, hash_fn hash,
+                                     compare_fn cmp, elem_destroy_fn fn);
+
+/**
+ * Function: concurrent_map_destroy
+ * Usage: concurrent_map_destroy (m)
+ * ------------------------------------------------------
+ * Destroys the map and every entry in it. No other thread may be using the
+ * map.
+ */
+void concurrent_map_destroy (concurrent_map *m);
+
+/**
+ * Function: concurrent_map_size
+ * Usage: size_t size = concurrent_map_size (m)
+ * ------------------------------------------------------
+ * Returns the number of entries. While other threads are writing this is
+ * only a snapshot.
+ */
+size_t concurrent_map_size (const concurrent_map *m);
+
+/**
+ * Function: concurrent_map_get
+ * Usage: bool found = concurrent_map_get (m, &key, &value)
+ * ------------------------------------------------------
+ * Copies the value stored under key into out and returns true, or returns
+ * false if the key is absent. out may be NULL to only test for the key.
+ */
+bool concurrent_map_get (const concurrent_map *m, const void *key, void *out);
+
+/**
+ * Function: concurrent_map_put
+ * Usage: bool added = concurrent_map_put (m, &key, &value)
+ * ------------------------------------------------------
+ * Stores a copy of the key and value. If the key was already present its old
+ * entry is destroyed and replaced, and false is returned.
+ */
+bool concurrent_map_put (concurrent_map *m, const void *key, const void *value);
+
+/**
+ * Function: concurrent_map_remove
+ * Usage: bool removed = concurrent_map_remove (m, &key)
+ * ------------------------------------------------------
+ * Removes and destroys the entry for key. Returns false if there is none.
+ */
+bool concurrent_map_remove (concurrent_map *m, const void *key);
+
+#endif /* CONCURRENT_MAP_H */
@@ -0,0 +1,164 @@
+/**
+ * File: Deque.h
+ * ------------------------------------------------------
+ * Defines the interface for the deque type. This implements a double ended
+ * queue over a circular buffer, so elements are pushed and popped at either
+ * end in constant amortized time while remaining randomly accessible.
+ *
+ * Elements are stored by copy, as in the vector.
+ */
+
+#ifndef DEQUE_H
+#define DEQUE_H
+
+#include "ADT_common.h"
+#include "ADT_private_implementations.h"
+
+/**
+ * Function: deque_init
+ * Usage: deque *d = deque_init (sizeof(int), 10, NULL)
+ * ------------------------------------------------------
+ * Creates a new empty deque and returns a pointer to it. The capacity hint is
+ * rounded up to a power of two.
+ *
+ * Asserts: zero elemsz, allocation failure
+ * Assumes: cleanup fn is valid
+ */
+deque *deque_init (size_t elem_sz, size_t capacity_hint, elem_destroy_fn fn);
+
+/**
+ * Function: deque_destroy
+ * Usage: deque_destroy (d)
+ * ------------------------------------------------------
+ * Destroys and frees all memory associated with deque
+ *
+ * Asserts: null pointer
+ * Assumes: valid initialized deque pointer
+ */
+void deque_destroy (deque *d);
+
+/**
+ * Function: deque_size
+ * Usage: size_t size = deque_size (d)
+ * ------------------------------------------------------
+ * Returns the number of elements in the deque.
+ */
+size_t deque_size (const deque *d);
+
+/**
+ * Function: deque_access
+ * Usage: void *elem = deque_access (d, 0)
+ * ------------------------------------------------------
+ * Returns a pointer to the element index places from the front. The pointer
+ * is invalidated by any push.
+ *
+ * Asserts: null pointer
+ * Assumes: valid index (index checking is left to the client's responsibility)
+ */
+void *deque_access (deque *d, size_t index);
+
+/**
+ * Function: deque_front
+ * Usage: void *elem = deque_front (d)
+ * ------------------------------------------------------
+ * Returns a pointer to the front element, or NULL if the deque is empty.
+ */
+void *deque_front (deque *d);
+
+/**
+ * Function: deque_back
+ * Usage: void *elem = deque_back (d)
+ * ------------------------------------------------------
+ * Returns a pointer to the back element, or NULL if the deque is empty.
+ */
+void *deque_back (deque *d);
+
+/**
+ * Function: deque_push_front
+ * Usage: deque_push_front (d, &elem)
+ * ------------------------------------------------------
+ * Pushes the data pointed to by elem onto the front by copy.
+ */
+void deque_push_front (deque *d, const void *elem);
+
+/**
+ * Function: deque_push_back
+ * Usage: deque_push_back (d, &elem)
+ * ------------------------------------------------------
+ * Pushes the data pointed to by elem onto the back by copy.
+ */
+void deque_push_back (deque *d, const void *elem);
+
+/**
+ * Function: deque_pop_front
+ * Usage: deque_pop_front (d, &elem)
+ * ------------------------------------------------------
+ * Removes the front element. If out is not NULL the element is copied there
+ * and ownership passes to the client, otherwise it is destroyed.
+ *
+ * Asserts: empty deque
+ */
+void deque_pop_front (deque *d, void *out);
+
+/**
+ * Function: deque_pop_back
+ * Usage: deque_pop_back (d, &elem)
+ * ------------------------------------------------------
+ * Removes the back element. If out is not NULL the element is copied there
+ * and ownership passes to the client, otherwise it is destroyed.
+ *
+ * Asserts: empty deque
+ */
+void deque_pop_back (deque *d, void *out);
+
+/**
+ * Function: deque_push_front_many
+ * Usage: deque_push_front_many (d, elems, n)
+ * ------------------------------------------------------
+ * Pushes an array of n elements onto the front by copy, keeping their order,
+ * so elems[0] becomes the front element.
+ */
+void deque_push_front_many (deque *d, const void *elems, size_t n);
+
+/**
+ * Function: deque_push_back_many
+ * Usage: deque_push_back_many (d, elems, n)
+ * ------------------------------------------------------
+ * Pushes an array of n elements onto the back by copy, keeping their order,
+ * so elems[n - 1] becomes the back element.
+ */
+void deque_push_back_many (deque *d, const void *elems, size_t n);
+
+/**
+ * Function: deque_pop_front_many
+ * Usage: deque_pop_front_many (d, out, n)
+ * ------------------------------------------------------
+ * Removes the n front elements. If out is not NULL they are copied there in
+ * deque order and ownership passes to the client, otherwise they are
+ * destroyed.
+ *
+ * Asserts: fewer than n elements
+ */
+void deque_pop_front_many (deque *d, void *out, size_t n);
+
+/**
+ * Function: deque_pop_back_many
+ * Usage: deque_pop_back_many (d, out, n)
+ * ------------------------------------------------------
+ * Removes the n back elements. If out is not NULL they are copied there in
+ * deque order and ownership passes to the client, otherwise they are
+ * destroyed.
+ *
+ * Asserts: fewer than n elements
+ */
+void deque_pop_back_many (deque *d, void *out, size_t n);
+
+/**
+ * Function: deque_clear
+ * Usage: deque_clear (d)
+ * ------------------------------------------------------
+ * Clears the deque and destroys all internal contents
+ */
+void deque_clear (deque *d);
+
+#endif /* DEQUE_H */
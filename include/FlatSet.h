@@ -0,0 +1,233 @@
+/**
+ * File: FlatSet.h
+ * ------------------------------------------------------
+ * Defines the interface for the flat_set and flat_map types. Both keep their
+ * elements sorted and unique in one contiguous vector, so a lookup is a
+ * binary search over an array and a full scan walks memory in order. They
+ * suit tables that are built once, or in batches, and then read many times.
+ *
+ * A single insert or remove shifts the elements after it, so it costs O(n).
+ * Build a large table with insert_many, which sorts the batch and merges it
+ * in with one pass over the existing elements.
+ *
+ * Indices returned by lower_bound are positions in sorted order and are
+ * invalidated by any insert or removal.
+ */
+
+#ifndef FLAT_SET_H
+#define FLAT_SET_H
+
+#include "ADT_common.h"
+#include "ADT_private_implementations.h"
+#include "Vector.h"
+
+/**
+ * Function: flat_set_init
+ * Usage: flat_set *s = flat_set_init (sizeof(int), compare_int, NULL)
+ * ------------------------------------------------------
+ * Creates a new empty flat_set.
+ *
+ * Asserts: zero elem_sz, null compare function, allocation failure
+ */
+flat_set *flat_set_init (size_t elem_sz, compare_fn cmp, elem_destroy_fn fn);
+
+/**
+ * Function: flat_set_destroy
+ * Usage: flat_set_destroy (s)
+ * ------------------------------------------------------
+ * Destroys the flat_set and every element in it.
+ */
+void flat_set_destroy (flat_set *s);
+
+/**
+ * Function: flat_set_size
+ * Usage: size_t size = flat_set_size (s)
+ * ------------------------------------------------------
+ */
+size_t flat_set_size (const flat_set *s);
+
+/**
+ * Function: flat_set_at
+ * Usage: int *smallest = flat_set_at (s, 0)
+ * ------------------------------------------------------
+ * Returns a pointer to the element at a position in sorted order. The
+ * element must not be changed in a way that alters its order.
+ *
+ * Asserts: index out of range
+ */
+void *flat_set_at (flat_set *s, size_t index);
+
+/**
+ * Function: flat_set_find
+ * Usage: my_row *row = flat_set_find (s, &key)
+ * ------------------------------------------------------
+ * Returns a pointer to the element equal to key, or NULL if there is none.
+ */
+void *flat_set_find (flat_set *s, const void *key);
+
+/**
+ * Function: flat_set_contains
+ * Usage: if (flat_set_contains (s, &key))
+ * ------------------------------------------------------
+ */
+bool flat_set_contains (const flat_set *s, const void *key);
+
+/**
+ * Function: flat_set_lower_bound
+ * Usage: size_t first = flat_set_lower_bound (s, &from)
+ * ------------------------------------------------------
+ * Returns the position of the first element not less than key, or the size
+ * of the set if every element is less.
+ */
+size_t flat_set_lower_bound (const flat_set *s, const void *key);
+
+/**
+ * Function: flat_set_insert
+ * Usage: bool added = flat_set_insert (s, &elem)
+ * ------------------------------------------------------
+ * Adds a copy of elem in order. Returns false, leaving the set unchanged, if
+ * an equal element is already present.
+ */
+bool flat_set_insert (flat_set *s, const void *elem);
+
+/**
+ * Function: flat_set_insert_many
+ * Usage: size_t n_added = flat_set_insert_many (s, elems, n)
+ * ------------------------------------------------------
+ * Adds copies of n elements from a flat array, which need not be sorted, in
+ * O(n log n + size). Elements equal to one already present are skipped, and
+ * of elements equal to each other in the batch only the first is added.
+ * The set takes ownership of what it adds, and the caller keeps ownership of
+ * the skipped elements. Returns the number added.
+ */
+size_t flat_set_insert_many (flat_set *s, const void *elems, size_t n);
+
+/**
+ * Function: flat_set_remove
+ * Usage: bool removed = flat_set_remove (s, &key)
+ * ------------------------------------------------------
+ * Removes and destroys the element equal to key. Returns false if there is
+ * no such element.
+ */
+bool flat_set_remove (flat_set *s, const void *key);
+
+/**
+ * Function: flat_set_erase_range
+ * Usage: flat_set_erase_range (s, flat_set_lower_bound (s, &from),
+ *                              flat_set_lower_bound (s, &to))
+ * ------------------------------------------------------
+ * Removes and destroys the elements at positions first up to but not
+ * including last, closing the gap with a single move.
+ *
+ * Asserts: first after last, last out of range
+ */
+void flat_set_erase_range (flat_set *s, size_t first, size_t last);
+
+/**
+ * Function: flat_set_clear
+ * Usage: flat_set_clear (s)
+ * ------------------------------------------------------
+ * Destroys every element, keeping the storage.
+ */
+void flat_set_clear (flat_set *s);
+
+/**
+ * Function: flat_map_init
+ * Usage: flat_map *m = flat_map_init (sizeof(uint32_t), sizeof(my_row),
+ *                                     compare_u32, NULL)
+ * ------------------------------------------------------
+ * Creates a new empty flat_map. Each entry stores the key followed by the
+ * value at the next multiple of sizeof (size_t). The compare function is
+ * called on keys. The destroy function, if any, is called on whole entries.
+ *
+ * Asserts: zero key_sz or val_sz, null compare function, allocation failure
+ */
+flat_map *flat_map_init (size_t key_sz, size_t val_sz, compare_fn cmp,
+                         elem_destroy_fn fn);
+
+/**
+ * Function: flat_map_destroy
+ * Usage: flat_map_destroy (m)
+ * ------------------------------------------------------
+ */
+void flat_map_destroy (flat_map *m);
+
+/**
+ * Function: flat_map_size
+ * Usage: size_t size = flat_map_size (m)
+ * ------------------------------------------------------
+ */
+size_t flat_map_size (const flat_map *m);
+
+/**
+ * Function: flat_map_find
+ * Usage: my_row *row = flat_map_find (m, &key)
+ * ------------------------------------------------------
+ * Returns a pointer to the value stored under key, or NULL if the key is
+ * absent. The value may be changed in place through the pointer.
+ */
+void *flat_map_find (flat_map *m, const void *key);
+
+/**
+ * Function: flat_map_lower_bound
+ * Usage: size_t first = flat_map_lower_bound (m, &from)
+ * ------------------------------------------------------
+ * Returns the position of the first entry whose key is not less than key.
+ */
+size_t flat_map_lower_bound (const flat_map *m, const void *key);
+
+/**
+ * Function: flat_map_key_at
+ * Usage: uint32_t *key = flat_map_key_at (m, i)
+ * ------------------------------------------------------
+ * Returns a pointer to the key of the entry at a position in key order.
+ */
+void *flat_map_key_at (flat_map *m, size_t index);
+
+/**
+ * Function: flat_map_value_at
+ * Usage: my_row *row = flat_map_value_at (m, i)
+ * ------------------------------------------------------
+ * Returns a pointer to the value of the entry at a position in key order.
+ */
+void *flat_map_value_at (flat_map *m, size_t index);
+
+/**
+ * Function: flat_map_insert
+ * Usage: bool added = flat_map_insert (m, &key, &row)
+ * ------------------------------------------------------
+ * Adds copies of the key and value. Returns false, leaving the map
+ * unchanged, if the key is already present.
+ */
+bool flat_map_insert (flat_map *m, const void *key, const void *value);
+
+/**
+ * Function: flat_map_insert_many
+ * Usage: size_t n_added = flat_map_insert_many (m, keys, rows, n)
+ * ------------------------------------------------------
+ * Adds copies of n keys and their values from two parallel flat arrays,
+ * skipping keys already present. Of equal keys in the batch only the first
+ * is added. The caller keeps ownership of skipped entries. Returns the
+ * number added.
+ */
+size_t flat_map_insert_many (flat_map *m, const void *keys, const void *values,
+                             size_t n);
+
+/**
+ * Function: flat_map_remove
+ * Usage: bool removed = flat_map_remove (m, &key)
+ * ------------------------------------------------------
+ * Removes and destroys the entry for key. Returns false if there is none.
+ */
+bool flat_map_remove (flat_map *m, const void *key);
+
+/**
+ * Function: flat_map_erase_range
+ * Usage: flat_map_erase_range (m, first, last)
+ * ------------------------------------------------------
+ * Removes and destroys the entries at positions first up to but not
+ * including last.
+ */
+void flat_map_erase_range (flat_map *m, size_t first, size_t last);
+
+#endif /* FLAT_SET_H */
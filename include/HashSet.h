@@ -0,0 +1,95 @@
+/**
+ * File: HashSet.h
+ * ------------------------------------------------------
+ * Defines the interface for the hashset type. This is an unordered set that
+ * stores copies of its elements inline in an open addressed table, so a
+ * lookup costs a hash, a scan of sixteen control bytes and usually a single
+ * compare, whatever the size of the set.
+ *
+ * Use set instead when elements must be visited in order.
+ */
+
+#ifndef HASH_SET_H
+#define HASH_SET_H
+
+#include "ADT_common.h"
+#include "ADT_private_implementations.h"
+
+/**
+ * Function: hashset_init
+ * Usage: hashset *h = hashset_init (sizeof(int), hash_int, compare_int, NULL)
+ * ------------------------------------------------------
+ * Creates a new empty hashset. The compare function need only return zero
+ * for equal elements and non-zero otherwise.
+ *
+ * Asserts: zero elem_sz, NULL hash or compare function, allocation failure
+ */
+hashset *hashset_init (size_t elem_sz, hash_fn hash, compare_fn cmp,
+                       elem_destroy_fn fn);
+
+/**
+ * Function: hashset_destroy
+ * Usage: hashset_destroy (h)
+ * ------------------------------------------------------
+ * Destroys the hashset, calling the destroy function on every element.
+ */
+void hashset_destroy (hashset *h);
+
+/**
+ * Function: hashset_is_empty
+ * Usage: if (hashset_is_empty (h))
+ * ------------------------------------------------------
+ */
+bool hashset_is_empty (const hashset *h);
+
+/**
+ * Function: hashset_size
+ * Usage: size_t size = hashset_size (h)
+ * ------------------------------------------------------
+ */
+size_t hashset_size (const hashset *h);
+
+/**
+ * Function: hashset_contains
+ * Usage: if (hashset_contains (h, &key))
+ * ------------------------------------------------------
+ * Returns true if an element equal to key is in the hashset.
+ */
+bool hashset_contains (const hashset *h, const void *key);
+
+/**
+ * Function: hashset_add
+ * Usage: bool added = hashset_add (h, &key)
+ * ------------------------------------------------------
+ * Adds a copy of the data pointed to by key. Returns false, leaving the
+ * hashset unchanged, if an equal element is already present.
+ */
+bool hashset_add (hashset *h, const void *key);
+
+/**
+ * Function: hashset_remove
+ * Usage: bool removed = hashset_remove (h, &key)
+ * ------------------------------------------------------
+ * Removes and destroys the element equal to key. Returns false if there is
+ * no such element. The slot is left as a tombstone and reclaimed on the next
+ * rehash.
+ */
+bool hashset_remove (hashset *h, const void *key);
+
+/**
+ * Function: hashset_reserve
+ * Usage: hashset_reserve (h, 1000000)
+ * ------------------------------------------------------
+ * Grows the table so that n elements fit without a rehash.
+ */
+void hashset_reserve (hashset *h, size_t n);
+
+/**
+ * Function: hashset_clear
+ * Usage: hashset_clear (h)
+ * ------------------------------------------------------
+ * Destroys every element, keeping the table's capacity.
+ */
+void hashset_clear (hashset *h);
+
+#endif /* HASH_SET_H */
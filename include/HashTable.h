@@ -0,0 +1,117 @@
+/**
+ * File: HashTable.h
+ * ------------------------------------------------------
+ * Defines the interface for the hash_table type. This implements an
+ * intrusive, chained hash table that indexes client nodes by a key stored
+ * inside them, without allocating anything per node.
+ *
+ * The table grows incrementally. When it passes one node per bucket it
+ * allocates a bucket array twice as long, and from then on each insert or
+ * remove moves a few buckets from the old array to the new one. No single
+ * call pays for rehashing the whole table.
+ */
+
+#ifndef HASH_TABLE_H
+#define HASH_TABLE_H
+
+#include "ADT_common.h"
+#include "ADT_private_implementations.h"
+
+/**
+ * The client embeds a hash_elem object anywhere in the struct to be indexed
+ * and tells the table where it and the key live. Unlike the list, the link
+ * need not be the first field, so a node can sit in a list and a hash_table
+ * at the same time.
+ *
+ * For example, to index a list of sessions by id:
+ *
+ * typedef struct
+ * {
+ *  	list_elem le;
+ *  	hash_elem he;
+ *  	unsigned id;
+ *  	char *user;
+ * } session;
+ *
+ * hash_table *t = hash_table_init (offsetof (session, he),
+ *                                  offsetof (session, id), hash_unsigned,
+ *                                  compare_unsigned, NULL);
+ * hash_table_insert (t, new_session);
+ * session *s = hash_table_find (t, &id);
+ */
+
+/**
+ * Function: hash_table_init
+ * Usage: hash_table *t = hash_table_init (offsetof (session, he),
+ *                                         offsetof (session, id),
+ *                                         hash_fn, cmp_fn, destroy_fn)
+ * ------------------------------------------------------
+ * Creates a new empty table.
+ *
+ * Asserts: null hash or compare function, allocation failure
+ * Assumes: link_offset and key_offset are offsets within the client's node
+ */
+hash_table *hash_table_init (size_t link_offset, size_t key_offset,
+                             hash_fn hash, compare_fn cmp, elem_destroy_fn fn);
+
+/**
+ * Function: hash_table_destroy
+ * Usage: hash_table_destroy (t)
+ * ------------------------------------------------------
+ * Destroys the table, calling the destroy function on every node still
+ * indexed in it.
+ */
+void hash_table_destroy (hash_table *t);
+
+/**
+ * Function: hash_table_is_empty
+ * Usage: if (hash_table_is_empty (t))
+ * ------------------------------------------------------
+ */
+bool hash_table_is_empty (const hash_table *t);
+
+/**
+ * Function: hash_table_size
+ * Usage: size_t size = hash_table_size (t)
+ * ------------------------------------------------------
+ */
+size_t hash_table_size (const hash_table *t);
+
+/**
+ * Function: hash_table_find
+ * Usage: session *s = hash_table_find (t, &id)
+ * ------------------------------------------------------
+ * Returns the node whose key equals key, or NULL if there is none.
+ */
+void *hash_table_find (const hash_table *t, const void *key);
+
+/**
+ * Function: hash_table_insert
+ * Usage: bool added = hash_table_insert (t, new_session)
+ * ------------------------------------------------------
+ * Links the node into the table. Returns false, leaving the table unchanged
+ * and the node unlinked, if a node with an equal key is already present.
+ */
+bool hash_table_insert (hash_table *t, void *node);
+
+/**
+ * Function: hash_table_remove
+ * Usage: hash_table_remove (t, s)
+ * ------------------------------------------------------
+ * Unlinks the node from the table in constant time. The node is handed back
+ * to the client and is not destroyed.
+ *
+ * Assumes: the node is linked into this table
+ */
+void hash_table_remove (hash_table *t, void *node);
+
+/**
+ * Function: hash_table_remove_key
+ * Usage: session *s = hash_table_remove_key (t, &id)
+ * ------------------------------------------------------
+ * Unlinks the node whose key equals key and returns it, or returns NULL if
+ * there is none. The node is not destroyed.
+ */
+void *hash_table_remove_key (hash_table *t, const void *key);
+
+#endif /* HASH_TABLE_H */
@@ -0,0 +1,139 @@
+/**
+ * File: IndexedPQueue.h
+ * ------------------------------------------------------
+ * Defines the interface for the ipqueue type. This is a priority queue in
+ * which every element is named by a handle the client chooses, a small
+ * integer such as a vertex or flow id. Through the handle an element already
+ * in the queue can have its key lowered or raised, or be removed, in
+ * O(log n), so the queue never holds more than one element per handle.
+ *
+ * Handles index arrays inside the queue, so they should be dense: the queue
+ * grows to the largest handle pushed.
+ */
+
+#ifndef INDEXED_PQUEUE_H
+#define INDEXED_PQUEUE_H
+
+#include "ADT_common.h"
+#include "ADT_private_implementations.h"
+
+/**
+ * Function: ipqueue_init
+ * Usage: ipqueue *q = ipqueue_init (sizeof(uint64_t), 4, n_vertices,
+ *                                   compare_u64, NULL)
+ * ------------------------------------------------------
+ * Creates a new empty queue with room for handles below n_handles_hint.
+ *
+ * Asserts: zero elem_sz, arity below 2, null compare function, allocation
+ *          failure
+ */
+ipqueue *ipqueue_init (size_t elem_sz, size_t arity, size_t n_handles_hint,
+                       compare_fn cmp, elem_destroy_fn fn);
+
+/**
+ * Function: ipqueue_destroy
+ * Usage: ipqueue_destroy (q)
+ * ------------------------------------------------------
+ * Destroys the queue and every element still in it.
+ */
+void ipqueue_destroy (ipqueue *q);
+
+/**
+ * Function: ipqueue_is_empty
+ * Usage: if (ipqueue_is_empty (q))
+ * ------------------------------------------------------
+ */
+bool ipqueue_is_empty (const ipqueue *q);
+
+/**
+ * Function: ipqueue_size
+ * Usage: size_t size = ipqueue_size (q)
+ * ------------------------------------------------------
+ */
+size_t ipqueue_size (const ipqueue *q);
+
+/**
+ * Function: ipqueue_contains
+ * Usage: if (ipqueue_contains (q, vertex))
+ * ------------------------------------------------------
+ * Returns true if an element with the handle is in the queue.
+ */
+bool ipqueue_contains (const ipqueue *q, size_t handle);
+
+/**
+ * Function: ipqueue_access
+ * Usage: uint64_t *dist = ipqueue_access (q, vertex)
+ * ------------------------------------------------------
+ * Returns a pointer to the element with the handle. The element must not be
+ * changed through the pointer; use the key functions instead. The pointer is
+ * invalidated by the next push, pop, key change or removal.
+ *
+ * Asserts: handle not in the queue
+ */
+void *ipqueue_access (ipqueue *q, size_t handle);
+
+/**
+ * Function: ipqueue_top
+ * Usage: size_t vertex = ipqueue_top (q)
+ * ------------------------------------------------------
+ * Returns the handle of the smallest element without removing it.
+ *
+ * Asserts: empty queue
+ */
+size_t ipqueue_top (const ipqueue *q);
+
+/**
+ * Function: ipqueue_push
+ * Usage: ipqueue_push (q, vertex, &dist)
+ * ------------------------------------------------------
+ * Adds a copy of the element under the handle.
+ *
+ * Asserts: handle already in the queue
+ */
+void ipqueue_push (ipqueue *q, size_t handle, const void *elem);
+
+/**
+ * Function: ipqueue_pop
+ * Usage: size_t vertex = ipqueue_pop (q, &dist)
+ * ------------------------------------------------------
+ * Removes the smallest element, copying it to out, and returns its handle.
+ * If out is NULL the element is destroyed instead.
+ *
+ * Asserts: empty queue
+ */
+size_t ipqueue_pop (ipqueue *q, void *out);
+
+/**
+ * Function: ipqueue_decrease_key
+ * Usage: ipqueue_decrease_key (q, vertex, &shorter)
+ * ------------------------------------------------------
+ * Replaces the element under the handle with a copy of one that compares no
+ * greater, destroying the old one, and moves it toward the top.
+ *
+ * Asserts: handle not in the queue, new element compares greater
+ */
+void ipqueue_decrease_key (ipqueue *q, size_t handle, const void *elem);
+
+/**
+ * Function: ipqueue_increase_key
+ * Usage: ipqueue_increase_key (q, flow, &later)
+ * ------------------------------------------------------
+ * Replaces the element under the handle with a copy of one that compares no
+ * smaller, destroying the old one, and moves it away from the top.
+ *
+ * Asserts: handle not in the queue, new element compares smaller
+ */
+void ipqueue_increase_key (ipqueue *q, size_t handle, const void *elem);
+
+/**
+ * Function: ipqueue_remove
+ * Usage: ipqueue_remove (q, flow, NULL)
+ * ------------------------------------------------------
+ * Removes the element under the handle from anywhere in the queue, copying
+ * it to out. If out is NULL the element is destroyed instead.
+ *
+ * Asserts: handle not in the queue
+ */
+void ipqueue_remove (ipqueue *q, size_t handle, void *out);
+
+#endif /* INDEXED_PQUEUE_H */
@@ -0,0 +1,131 @@
+/**
+ * File: LRUCache.h
+ * ------------------------------------------------------
+ * Defines the interface for the lru_cache type. This implements a bounded
+ * cache that evicts its least recently used node once it holds more than
+ * its capacity.
+ */
+
+#ifndef LRU_CACHE_H
+#define LRU_CACHE_H
+
+#include "ADT_common.h"
+#include "ADT_private_implementations.h"
+#include "List.h"
+
+/**
+ * Like the list, the cache is intrusive. The client embeds the lru_elem
+ * object as the FIRST FIELD of the struct that will be cached, and tells the
+ * cache where the key lives inside that struct.
+ *
+ * For example, to cache strings by an integer id:
+ *
+ * typedef struct
+ * {
+ *  	lru_elem le;
+ *  	unsigned id;
+ *  	char *value;
+ * } my_entry;
+ *
+ * lru_cache *c = lru_cache_init (1024, offsetof (my_entry, id), hash_unsigned,
+ *                                compare_unsigned, my_entry_destroy);
+ * lru_cache_insert (c, new_entry);
+ * my_entry *hit = lru_cache_get (c, &id);
+ */
+
+/**
+ * Function: lru_cache_init
+ * Usage: lru_cache *c = lru_cache_init (1024, offsetof (my_entry, id),
+ *                                       hash_fn, cmp_fn, destroy_fn)
+ * ------------------------------------------------------
+ * Creates a new empty cache holding at most capacity nodes.
+ *
+ * Asserts: zero capacity, null hash or compare function, allocation failure
+ * Assumes: key_offset is the offset of the key within the client's node
+ */
+lru_cache *lru_cache_init (size_t capacity, size_t key_offset, hash_fn hash,
+                           compare_fn cmp, elem_destroy_fn fn);
+
+/**
+ * Function: lru_cache_destroy
+ * Usage: lru_cache_destroy (c)
+ * ------------------------------------------------------
+ * Destroys the cache and every node still held in it.
+ */
+void lru_cache_destroy (lru_cache *c);
+
+/**
+ * Function: lru_cache_size
+ * Usage: size_t size = lru_cache_size (c)
+ * ------------------------------------------------------
+ * Returns the number of nodes held in the cache.
+ */
+size_t lru_cache_size (const lru_cache *c);
+
+/**
+ * Function: lru_cache_capacity
+ * Usage: size_t capacity = lru_cache_capacity (c)
+ * ------------------------------------------------------
+ * Returns the number of nodes the cache holds before it begins evicting.
+ */
+size_t lru_cache_capacity (const lru_cache *c);
+
+/**
+ * Function: lru_cache_set_capacity
+ * Usage: lru_cache_set_capacity (c, 512)
+ * ------------------------------------------------------
+ * Changes the capacity of the cache. Shrinking evicts least recently used
+ * nodes until the cache fits.
+ *
+ * Asserts: zero capacity
+ */
+void lru_cache_set_capacity (lru_cache *c, size_t capacity);
+
+/**
+ * Function: lru_cache_get
+ * Usage: my_entry *e = lru_cache_get (c, &key)
+ * ------------------------------------------------------
+ * Returns the node matching key and marks it as the most recently used, or
+ * NULL if the key is not cached. Updates the hit and miss counters.
+ */
+void *lru_cache_get (lru_cache *c, const void *key);
+
+/**
+ * Function: lru_cache_insert
+ * Usage: lru_cache_insert (c, new_entry)
+ * ------------------------------------------------------
+ * Inserts the node as the most recently used. Ownership of the node passes
+ * to the cache. A node already cached under the same key is destroyed, and
+ * the least recently used nodes are destroyed while over capacity.
+ * Inserting a node that is already in the cache, after changing its value
+ * in place, just makes it the most recently used; its key must not change.
+ *
+ * Asserts: null pointer
+ */
+void lru_cache_insert (lru_cache *c, void *new_node);
+
+/**
+ * Function: lru_cache_remove
+ * Usage: bool removed = lru_cache_remove (c, &key)
+ * ------------------------------------------------------
+ * Removes and destroys the node matching key. Returns whether it was found.
+ */
+bool lru_cache_remove (lru_cache *c, const void *key);
+
+/**
+ * Function: lru_cache_hits
+ * Usage: size_t hits = lru_cache_hits (c)
+ * ------------------------------------------------------
+ * Returns the number of calls to lru_cache_get that found their key.
+ */
+size_t lru_cache_hits (const lru_cache *c);
+
+/**
+ * Function: lru_cache_misses
+ * Usage: size_t misses = lru_cache_misses (c)
+ * ------------------------------------------------------
+ * Returns the number of calls to lru_cache_get that did not find their key.
+ */
+size_t lru_cache_misses (const lru_cache *c);
+
+#endif /* LRU_CACHE_H */
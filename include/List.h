@@ -95,6 +95,33 @@ void *list_front (const list *l);
  */
 void *list_back (const list *l);
 
+/**
+ * Function: list_next
+ * Usage: my_node_t *next = list_next (l, node)
+ * ------------------------------------------------------
+ * Returns the node after node, or NULL if node is at the back of the list.
+ */
+void *list_next (const list *l, const void *node);
+
+/**
+ * Function: list_prev
+ * Usage: my_node_t *prev = list_prev (l, node)
+ * ------------------------------------------------------
+ * Returns the node before node, or NULL if node is at the front of the list.
+ */
+void *list_prev (const list *l, const void *node);
+
+/**
+ * Function: list_insert_after
+ * Usage: list_insert_after (l, node, &new_node)
+ * ------------------------------------------------------
+ * Links new_node into the list directly after node in constant time.
+ *
+ * Asserts: null pointer
+ * Assumes: node is currently linked into l
+ */
+void list_insert_after (list *l, void *node, void *new_node);
+
 /**
  * Function: list_pop_front
  * Usage: list_pop_front (l)
@@ -109,4 +136,27 @@ void list_pop_front (list *l);
  */
 void list_pop_back (list *l);
 
+/**
+ * Function: list_remove
+ * Usage: list_remove (l, &node)
+ * ------------------------------------------------------
+ * Unlinks the node from anywhere in the list in constant time. The node is
+ * destroyed with the list's destroy function, if one was provided.
+ *
+ * Asserts: null pointer, empty list
+ * Assumes: node is currently linked into l
+ */
+void list_remove (list *l, void *node);
+
+/**
+ * Function: list_splice
+ * Usage: list_splice (l, other)
+ * ------------------------------------------------------
+ * Moves every node of other onto the back of l in constant time, keeping
+ * their order. other is left empty.
+ *
+ * Asserts: null pointer
+ */
+void list_splice (list *l, list *other);
+
 #endif /* LIST_H */
\ No newline at end of file
@@ -0,0 +1,115 @@
+/**
+ * File: PQueue.h
+ * ------------------------------------------------------
+ * Defines the interface for the pqueue type. This implements a priority
+ * queue as an implicit heap stored in a vector. The element that compares
+ * smallest is always on top; pass a reversed compare function for a max
+ * queue.
+ *
+ * The arity sets how many children each heap node has. A binary heap does
+ * the fewest compares per push. A 4-ary heap is shallower and keeps the
+ * children of a node within one or two cache lines, which usually makes
+ * pops faster once the heap outgrows the cache.
+ */
+
+#ifndef PQUEUE_H
+#define PQUEUE_H
+
+#include "ADT_common.h"
+#include "ADT_private_implementations.h"
+#include "Vector.h"
+
+/**
+ * Function: pqueue_init
+ * Usage: pqueue *q = pqueue_init (sizeof(my_task), 4, compare_deadline, NULL)
+ * ------------------------------------------------------
+ * Creates a new empty priority queue.
+ *
+ * Asserts: zero elem_sz, arity below 2, null compare function, allocation
+ *          failure
+ */
+pqueue *pqueue_init (size_t elem_sz, size_t arity, compare_fn cmp,
+                     elem_destroy_fn fn);
+
+/**
+ * Function: pqueue_heapify
+ * Usage: pqueue *q = pqueue_heapify (tasks, 2, compare_deadline)
+ * ------------------------------------------------------
+ * Creates a priority queue from the elements of an existing vector in O(n),
+ * reordering them in place. The queue takes ownership of the vector, which
+ * the caller must no longer use, and keeps its destroy function.
+ *
+ * Asserts: null vector, arity below 2, null compare function
+ */
+pqueue *pqueue_heapify (vector *v, size_t arity, compare_fn cmp);
+
+/**
+ * Function: pqueue_destroy
+ * Usage: pqueue_destroy (q)
+ * ------------------------------------------------------
+ * Destroys the queue and every element still in it.
+ */
+void pqueue_destroy (pqueue *q);
+
+/**
+ * Function: pqueue_is_empty
+ * Usage: if (pqueue_is_empty (q))
+ * ------------------------------------------------------
+ */
+bool pqueue_is_empty (const pqueue *q);
+
+/**
+ * Function: pqueue_size
+ * Usage: size_t size = pqueue_size (q)
+ * ------------------------------------------------------
+ */
+size_t pqueue_size (const pqueue *q);
+
+/**
+ * Function: pqueue_top
+ * Usage: my_task *next = pqueue_top (q)
+ * ------------------------------------------------------
+ * Returns a pointer to the smallest element without removing it, or NULL
+ * if the queue is empty. The pointer is invalidated by the next push or pop.
+ */
+void *pqueue_top (pqueue *q);
+
+/**
+ * Function: pqueue_push
+ * Usage: pqueue_push (q, &task)
+ * ------------------------------------------------------
+ * Adds a copy of the element to the queue in O(log n).
+ */
+void pqueue_push (pqueue *q, const void *elem);
+
+/**
+ * Function: pqueue_pop
+ * Usage: pqueue_pop (q, &task)
+ * ------------------------------------------------------
+ * Removes the smallest element, copying it to out. If out is NULL the
+ * element is destroyed instead.
+ *
+ * Asserts: empty queue
+ */
+void pqueue_pop (pqueue *q, void *out);
+
+/**
+ * Function: pqueue_push_many
+ * Usage: pqueue_push_many (q, tasks, n)
+ * ------------------------------------------------------
+ * Adds copies of n elements from a flat array. A batch at least as large as
+ * the queue is added by rebuilding the heap in O(n) rather than sifting
+ * each element up.
+ */
+void pqueue_push_many (pqueue *q, const void *elems, size_t n);
+
+/**
+ * Function: pqueue_pop_many
+ * Usage: size_t n_done = pqueue_pop_many (q, tasks, n)
+ * ------------------------------------------------------
+ * Removes up to n of the smallest elements, copying them to out in order.
+ * Returns the number removed, less than n only if the queue emptied.
+ */
+size_t pqueue_pop_many (pqueue *q, void *out, size_t n);
+
+#endif /* PQUEUE_H */
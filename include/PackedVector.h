@@ -0,0 +1,115 @@
+/**
+ * File: PackedVector.h
+ * ------------------------------------------------------
+ * Defines the interface for the packed_vector type. This stores a
+ * nondecreasing sequence of 64 bit integers, such as sorted ids, compressed
+ * in blocks of 128. Each block keeps the differences between values four
+ * apart, less the smallest of them, bit packed at the width most of them
+ * need; the few that need more are patched in from a list of exceptions.
+ * Ids with small gaps take one or two bytes each rather than eight.
+ *
+ * A block is decoded whole, four values per SSE2 instruction, so values are
+ * read a block at a time through an iterator. Random access and search go
+ * through a skip index holding the first value of each block, and decode
+ * one block.
+ *
+ * packed_vector *ids = packed_vector_init ();
+ * packed_vector_append (ids, 1000);
+ * packed_vector_append (ids, 1003);
+ */
+
+#ifndef PACKED_VECTOR_H
+#define PACKED_VECTOR_H
+
+#include "ADT_common.h"
+#include "ADT_private_implementations.h"
+
+/**
+ * Function: packed_vector_init
+ * Usage: packed_vector *pv = packed_vector_init ()
+ * ------------------------------------------------------
+ * Creates a new empty packed_vector.
+ *
+ * Asserts: allocation failure
+ */
+packed_vector *packed_vector_init (void);
+
+/**
+ * Function: packed_vector_destroy
+ * Usage: packed_vector_destroy (pv)
+ * ------------------------------------------------------
+ */
+void packed_vector_destroy (packed_vector *pv);
+
+/**
+ * Function: packed_vector_size
+ * Usage: size_t n = packed_vector_size (pv)
+ * ------------------------------------------------------
+ */
+size_t packed_vector_size (const packed_vector *pv);
+
+/**
+ * Function: packed_vector_bytes
+ * Usage: size_t bytes = packed_vector_bytes (pv)
+ * ------------------------------------------------------
+ * Returns the number of bytes the values take: the encoded blocks, the skip
+ * index and the values not yet in a block. Spare capacity is not counted.
+ */
+size_t packed_vector_bytes (const packed_vector *pv);
+
+/**
+ * Function: packed_vector_append
+ * Usage: packed_vector_append (pv, id)
+ * ------------------------------------------------------
+ * Appends a value, which must be no smaller than the last. Every 128th
+ * append encodes a block.
+ *
+ * Asserts: value smaller than the last, allocation failure
+ */
+void packed_vector_append (packed_vector *pv, uint64_t value);
+
+/**
+ * Function: packed_vector_get
+ * Usage: uint64_t id = packed_vector_get (pv, i)
+ * ------------------------------------------------------
+ * Returns the value at an index, decoding the block that holds it.
+ *
+ * Asserts: index out of range
+ */
+uint64_t packed_vector_get (const packed_vector *pv, size_t index);
+
+/**
+ * Function: packed_vector_search
+ * Usage: bool found = packed_vector_search (pv, id, &index)
+ * ------------------------------------------------------
+ * Returns whether a value is stored. If index is not NULL it is set to the
+ * position of the first value no smaller than the one searched for, which is
+ * the size when there is none. The skip index is binary searched and one
+ * block decoded.
+ */
+bool packed_vector_search (const packed_vector *pv, uint64_t value,
+                           size_t *index);
+
+/**
+ * Function: packed_vector_iter_init
+ * Usage: packed_vector_iter_init (pv, &it, 0)
+ * ------------------------------------------------------
+ * Positions an iterator at an index. The iterator is invalidated by an
+ * append.
+ *
+ * Asserts: start past the size
+ */
+void packed_vector_iter_init (const packed_vector *pv, packed_vector_iter *it,
+                              size_t start);
+
+/**
+ * Function: packed_vector_iter_next
+ * Usage: while ((n = packed_vector_iter_next (&it, &values)) > 0)
+ * ------------------------------------------------------
+ * Decodes the next run of values, up to the end of a block, and points
+ * values at them. Returns the number in the run, or 0 once every value has
+ * been returned. The run stays valid until the next call.
+ */
+size_t packed_vector_iter_next (packed_vector_iter *it, const uint64_t **values);
+
+#endif /* PACKED_VECTOR_H */
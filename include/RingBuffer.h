@@ -0,0 +1,151 @@
+/**
+ * File: RingBuffer.h
+ * ------------------------------------------------------
+ * Defines the interface for the bounded lock-free ring buffer types used to
+ * hand fixed size records between threads. The spsc_ring serves exactly one
+ * producer thread and one consumer thread. The mpmc_ring serves any number
+ * of each.
+ *
+ * Elements are copied in on enqueue and copied out on dequeue. Neither ring
+ * grows: an enqueue into a full ring or a dequeue from an empty one fails
+ * and returns straight away, and the caller decides whether to spin, yield
+ * or drop.
+ */
+
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include "ADT_common.h"
+#include "ADT_private_implementations.h"
+
+/**
+ * Function: spsc_ring_init
+ * Usage: spsc_ring *r = spsc_ring_init (sizeof(my_record), 1024, NULL)
+ * ------------------------------------------------------
+ * Creates a new empty ring. The capacity is rounded up to a power of two.
+ *
+ * Asserts: zero elem_sz, zero capacity, allocation failure
+ */
+spsc_ring *spsc_ring_init (size_t elem_sz, size_t capacity, elem_destroy_fn fn);
+
+/**
+ * Function: spsc_ring_destroy
+ * Usage: spsc_ring_destroy (r)
+ * ------------------------------------------------------
+ * Destroys the ring and any elements still in it. No other thread may be
+ * using the ring.
+ */
+void spsc_ring_destroy (spsc_ring *r);
+
+/**
+ * Function: spsc_ring_size
+ * Usage: size_t size = spsc_ring_size (r)
+ * ------------------------------------------------------
+ * Returns the number of elements in the ring. While the other thread is
+ * active this is a snapshot that may already be stale.
+ */
+size_t spsc_ring_size (const spsc_ring *r);
+
+/**
+ * Function: spsc_ring_enqueue
+ * Usage: bool ok = spsc_ring_enqueue (r, &record)
+ * ------------------------------------------------------
+ * Copies the element into the ring. Returns false if the ring is full.
+ * Only the producer thread may call this.
+ */
+bool spsc_ring_enqueue (spsc_ring *r, const void *elem);
+
+/**
+ * Function: spsc_ring_dequeue
+ * Usage: bool ok = spsc_ring_dequeue (r, &record)
+ * ------------------------------------------------------
+ * Copies the oldest element out of the ring. Returns false if the ring is
+ * empty. Only the consumer thread may call this.
+ */
+bool spsc_ring_dequeue (spsc_ring *r, void *out);
+
+/**
+ * Function: spsc_ring_enqueue_many
+ * Usage: size_t n_done = spsc_ring_enqueue_many (r, records, n)
+ * ------------------------------------------------------
+ * Copies up to n elements into the ring and publishes them together. Returns
+ * the number enqueued, which is less than n only if the ring filled.
+ */
+size_t spsc_ring_enqueue_many (spsc_ring *r, const void *elems, size_t n);
+
+/**
+ * Function: spsc_ring_dequeue_many
+ * Usage: size_t n_done = spsc_ring_dequeue_many (r, records, n)
+ * ------------------------------------------------------
+ * Copies up to n of the oldest elements out of the ring. Returns the number
+ * dequeued, which is less than n only if the ring emptied.
+ */
+size_t spsc_ring_dequeue_many (spsc_ring *r, void *out, size_t n);
+
+/**
+ * Function: mpmc_ring_init
+ * Usage: mpmc_ring *r = mpmc_ring_init (sizeof(my_record), 1024, NULL)
+ * ------------------------------------------------------
+ * Creates a new empty ring. The capacity is rounded up to a power of two and
+ * is at least 2.
+ *
+ * Asserts: zero elem_sz, zero capacity, allocation failure
+ */
+mpmc_ring *mpmc_ring_init (size_t elem_sz, size_t capacity, elem_destroy_fn fn);
+
+/**
+ * Function: mpmc_ring_destroy
+ * Usage: mpmc_ring_destroy (r)
+ * ------------------------------------------------------
+ * Destroys the ring and any elements still in it. No other thread may be
+ * using the ring.
+ */
+void mpmc_ring_destroy (mpmc_ring *r);
+
+/**
+ * Function: mpmc_ring_size
+ * Usage: size_t size = mpmc_ring_size (r)
+ * ------------------------------------------------------
+ * Returns the number of positions claimed by producers and not yet claimed
+ * by consumers. While other threads are active this is only a snapshot.
+ */
+size_t mpmc_ring_size (const mpmc_ring *r);
+
+/**
+ * Function: mpmc_ring_enqueue
+ * Usage: bool ok = mpmc_ring_enqueue (r, &record)
+ * ------------------------------------------------------
+ * Copies the element into the ring. Returns false if the ring is full.
+ */
+bool mpmc_ring_enqueue (mpmc_ring *r, const void *elem);
+
+/**
+ * Function: mpmc_ring_dequeue
+ * Usage: bool ok = mpmc_ring_dequeue (r, &record)
+ * ------------------------------------------------------
+ * Copies the oldest available element out of the ring. Returns false if the
+ * ring is empty.
+ */
+bool mpmc_ring_dequeue (mpmc_ring *r, void *out);
+
+/**
+ * Function: mpmc_ring_enqueue_many
+ * Usage: size_t n_done = mpmc_ring_enqueue_many (r, records, n)
+ * ------------------------------------------------------
+ * Claims a run of up to n consecutive positions with one compare and swap
+ * and copies the elements into them. Returns the number enqueued. The run is
+ * contiguous, so consumers see the batch in order, although elements from
+ * other producers may come before or after it.
+ */
+size_t mpmc_ring_enqueue_many (mpmc_ring *r, const void *elems, size_t n);
+
+/**
+ * Function: mpmc_ring_dequeue_many
+ * Usage: size_t n_done = mpmc_ring_dequeue_many (r, records, n)
+ * ------------------------------------------------------
+ * Claims a run of up to n consecutive ready positions with one compare and
+ * swap and copies their elements out. Returns the number dequeued.
+ */
+size_t mpmc_ring_dequeue_many (mpmc_ring *r, void *out, size_t n);
+
+#endif /* RING_BUFFER_H */
@@ -0,0 +1,185 @@
+/**
+ * File: Roaring.h
+ * ------------------------------------------------------
+ * Defines the interface for the roaring type, a compressed set of 32 bit
+ * ids. The ids are split by their high 16 bits into chunks of 65536, and
+ * each chunk holding any ids is kept in whichever container suits it: a
+ * sorted array of up to 4096 ids, a bitmap of 65536 bits beyond that, or
+ * a list of runs for ids that come in long consecutive stretches. A handful
+ * of ids costs a few bytes each and a dense range well under a bit each,
+ * where a set or vector pays the same per id however they are spread and a
+ * flat bitset pays for the whole range.
+ *
+ * Union and intersection work a container pair at a time, in the way that
+ * suits the pair: merging arrays, testing array values against a bitmap,
+ * combining bitmaps a word at a time, or merging runs.
+ *
+ * roaring *ids = roaring_init ();
+ * roaring_add (ids, 42);
+ * roaring_add_range (ids, 1000, 1999);
+ */
+
+#ifndef ROARING_H
+#define ROARING_H
+
+#include "ADT_common.h"
+#include "ADT_private_implementations.h"
+#include "Bitset.h"
+#include "Vector.h"
+
+/**
+ * Function: roaring_init
+ * Usage: roaring *r = roaring_init ()
+ * ------------------------------------------------------
+ * Creates a new empty roaring bitmap.
+ *
+ * Asserts: allocation failure
+ */
+roaring *roaring_init (void);
+
+/**
+ * Function: roaring_destroy
+ * Usage: roaring_destroy (r)
+ * ------------------------------------------------------
+ */
+void roaring_destroy (roaring *r);
+
+/**
+ * Function: roaring_add
+ * Usage: bool added = roaring_add (r, id)
+ * ------------------------------------------------------
+ * Adds an id, returning false if it was already present.
+ */
+bool roaring_add (roaring *r, uint32_t value);
+
+/**
+ * Function: roaring_add_range
+ * Usage: roaring_add_range (r, 1000, 1999)
+ * ------------------------------------------------------
+ * Adds every id from first to last inclusive. Chunks the range only touches
+ * part of, or which held no ids, take it as a single run.
+ *
+ * Asserts: first above last
+ */
+void roaring_add_range (roaring *r, uint32_t first, uint32_t last);
+
+/**
+ * Function: roaring_remove
+ * Usage: bool removed = roaring_remove (r, id)
+ * ------------------------------------------------------
+ * Removes an id, returning false if it was not present.
+ */
+bool roaring_remove (roaring *r, uint32_t value);
+
+/**
+ * Function: roaring_contains
+ * Usage: if (roaring_contains (r, id)) ...
+ * ------------------------------------------------------
+ */
+bool roaring_contains (const roaring *r, uint32_t value);
+
+/**
+ * Function: roaring_cardinality
+ * Usage: size_t n = roaring_cardinality (r)
+ * ------------------------------------------------------
+ * Returns the number of ids, from the count each container keeps.
+ */
+size_t roaring_cardinality (const roaring *r);
+
+/**
+ * Function: roaring_bytes
+ * Usage: size_t bytes = roaring_bytes (r)
+ * ------------------------------------------------------
+ * Returns the number of bytes the containers and their ids take. Spare
+ * capacity is not counted.
+ */
+size_t roaring_bytes (const roaring *r);
+
+/**
+ * Function: roaring_optimize
+ * Usage: roaring_optimize (r)
+ * ------------------------------------------------------
+ * Converts each container holding long stretches of consecutive ids to runs
+ * where that is smaller, and each run container to an array or bitmap where
+ * that is smaller. Call it once a bitmap has been built.
+ */
+void roaring_optimize (roaring *r);
+
+/**
+ * Function: roaring_union
+ * Usage: roaring *either = roaring_union (a, b)
+ * ------------------------------------------------------
+ * Creates a roaring bitmap of the ids in either a or b.
+ */
+roaring *roaring_union (const roaring *a, const roaring *b);
+
+/**
+ * Function: roaring_intersect
+ * Usage: roaring *both = roaring_intersect (a, b)
+ * ------------------------------------------------------
+ * Creates a roaring bitmap of the ids in both a and b.
+ */
+roaring *roaring_intersect (const roaring *a, const roaring *b);
+
+/**
+ * Function: roaring_iter_init
+ * Usage: roaring_iter_init (r, &it)
+ * ------------------------------------------------------
+ * Positions an iterator before the smallest id. The iterator is invalidated
+ * by any change to the bitmap.
+ */
+void roaring_iter_init (const roaring *r, roaring_iter *it);
+
+/**
+ * Function: roaring_iter_next
+ * Usage: while (roaring_iter_next (&it, &id)) ...
+ * ------------------------------------------------------
+ * Sets value to the next id in increasing order and returns true, or
+ * returns false once there are none left.
+ */
+bool roaring_iter_next (roaring_iter *it, uint32_t *value);
+
+/**
+ * Function: roaring_write
+ * Usage: if (!roaring_write (r, fd))
+ * ------------------------------------------------------
+ * Writes the containers to a file descriptor in the format vector_write
+ * uses, under a header marking the stream as a roaring bitmap. Its elements
+ * are little-endian 16 bit words: the number of containers, the key, type
+ * and size of each, then each container's ids, runs or bitmap. Returns
+ * false on an I/O error.
+ */
+bool roaring_write (const roaring *r, int fd);
+
+/**
+ * Function: roaring_read
+ * Usage: roaring *r = roaring_read (fd)
+ * ------------------------------------------------------
+ * Reads a roaring bitmap written by roaring_write, consuming exactly its
+ * stream from fd. Returns NULL on an I/O error, an early end of file, a
+ * stream that is not a roaring bitmap, a checksum mismatch, or containers
+ * that are out of order or inconsistent.
+ */
+roaring *roaring_read (int fd);
+
+/**
+ * Function: roaring_from_vector
+ * Usage: roaring *r = roaring_from_vector (ids)
+ * ------------------------------------------------------
+ * Creates a roaring bitmap of the ids in a vector of uint32_t. A sorted
+ * vector is taken a chunk at a time, each container built whole; any other
+ * is added an id at a time. Repeated ids are kept once.
+ *
+ * Asserts: element size not 4
+ */
+roaring *roaring_from_vector (const vector *v);
+
+/**
+ * Function: roaring_to_vector
+ * Usage: vector *ids = roaring_to_vector (r)
+ * ------------------------------------------------------
+ * Creates a sorted vector of uint32_t holding the ids.
+ */
+vector *roaring_to_vector (const roaring *r);
+
+#endif /* ROARING_H */
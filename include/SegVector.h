@@ -0,0 +1,110 @@
+/**
+ * File: SegVector.h
+ * ------------------------------------------------------
+ * Defines the interface for the seg_vector type. This is a resizeable array
+ * stored as a list of chunks that double in size, instead of one block that
+ * is reallocated. Growing allocates the next chunk and never copies or moves
+ * an element, so a pointer to an element stays valid until the element is
+ * removed, and growth never needs the old and new blocks at once.
+ *
+ * Access by index is O(1): the chunk is found from the highest set bit of
+ * the index. Elements are stored by copy, as in the vector.
+ */
+
+#ifndef SEG_VECTOR_H
+#define SEG_VECTOR_H
+
+#include "ADT_common.h"
+#include "ADT_private_implementations.h"
+
+/**
+ * Function: seg_vector_init
+ * Usage: seg_vector *sv = seg_vector_init (sizeof(int), 0, NULL)
+ * ------------------------------------------------------
+ * Creates a new empty seg_vector with chunks allocated for at least
+ * capacity_hint elements.
+ *
+ * Asserts: zero elem_sz, allocation failure
+ */
+seg_vector *seg_vector_init (size_t elem_sz, size_t capacity_hint,
+                             elem_destroy_fn fn);
+
+/**
+ * Function: seg_vector_destroy
+ * Usage: seg_vector_destroy (sv)
+ * ------------------------------------------------------
+ * Destroys every element and frees all memory associated with the vector.
+ */
+void seg_vector_destroy (seg_vector *sv);
+
+/**
+ * Function: seg_vector_size
+ * Usage: size_t size = seg_vector_size (sv)
+ * ------------------------------------------------------
+ */
+size_t seg_vector_size (const seg_vector *sv);
+
+/**
+ * Function: seg_vector_access
+ * Usage: int *elem = seg_vector_access (sv, 0)
+ * ------------------------------------------------------
+ * Returns a pointer to the element at index. The pointer stays valid across
+ * appends.
+ *
+ * Asserts: null pointer, index out of range
+ */
+void *seg_vector_access (seg_vector *sv, size_t index);
+
+/**
+ * Function: seg_vector_span
+ * Usage: int *run = seg_vector_span (sv, i, &n_run)
+ * ------------------------------------------------------
+ * Returns a pointer to the element at index and stores in n_run how many
+ * elements from there on are contiguous in memory, to the end of its chunk
+ * or of the vector. Loops over many elements can walk each span as a plain
+ * array.
+ *
+ * Asserts: null pointer, index out of range
+ */
+void *seg_vector_span (seg_vector *sv, size_t index, size_t *n_run);
+
+/**
+ * Function: seg_vector_append
+ * Usage: int *elem = seg_vector_append (sv, &elem)
+ * ------------------------------------------------------
+ * Appends a copy of elem at the end, allocating a new chunk twice the size
+ * of the last when full. Returns a pointer to the stored copy.
+ *
+ * Asserts: null pointer, allocation failure
+ */
+void *seg_vector_append (seg_vector *sv, const void *elem);
+
+/**
+ * Function: seg_vector_replace
+ * Usage: seg_vector_replace (sv, &elem, 0)
+ * ------------------------------------------------------
+ * Destroys the element at index and copies elem into its place.
+ *
+ * Asserts: null pointer, index out of range
+ */
+void seg_vector_replace (seg_vector *sv, const void *elem, size_t index);
+
+/**
+ * Function: seg_vector_remove_last
+ * Usage: seg_vector_remove_last (sv)
+ * ------------------------------------------------------
+ * Removes and destroys the last element. Chunks are kept for reuse.
+ *
+ * Asserts: null pointer, empty vector
+ */
+void seg_vector_remove_last (seg_vector *sv);
+
+/**
+ * Function: seg_vector_clear
+ * Usage: seg_vector_clear (sv)
+ * ------------------------------------------------------
+ * Destroys every element, keeping the chunks for reuse.
+ */
+void seg_vector_clear (seg_vector *sv);
+
+#endif /* SEG_VECTOR_H */
@@ -49,16 +49,62 @@ bool set_contains (const set *s, const void *key);
 
 /**
  * Function: set_add
- * Usage: 
+ * Usage: bool added = set_add (s, &key)
  * ------------------------------------------------------
+ * Adds a copy of the data pointed to by key. Returns false, leaving the set
+ * unchanged, if an equal element is already present.
  */
-void set_add (set *s, const void *key);
+bool set_add (set *s, const void *key);
 
 /**
  * Function: set_remove
- * Usage: 
+ * Usage: bool removed = set_remove (s, &key)
  * ------------------------------------------------------
+ * Removes and destroys the element equal to key. Returns whether one was
+ * found.
  */
 bool set_remove (set *s, const void *key);
 
+/**
+ * Function: set_use_filter
+ * Usage: set_use_filter (s, hash_u64, 0.01)
+ * ------------------------------------------------------
+ * Puts a Bloom filter of the elements in front of set_contains, so most
+ * absent keys are turned away after one cache miss rather than a walk down
+ * the tree. set_add keeps the filter up to date, rebuilding it with room
+ * for twice the elements once it has taken as many additions as it was
+ * sized for. Removed elements stay in the filter until then, which only
+ * costs false positives. Elements equal under the compare function must
+ * hash alike. A NULL hash removes the filter.
+ *
+ * Asserts: fp_rate not between 0 and 1
+ */
+void set_use_filter (set *s, hash_fn hash, double fp_rate);
+
+/**
+ * Function: set_write
+ * Usage: if (!set_write (s, fd))
+ * ------------------------------------------------------
+ * Writes the elements to a file descriptor in sorted order, in the format
+ * vector_write uses under a header marking the stream as a set. Returns
+ * false on an I/O error.
+ */
+bool set_write (const set *s, int fd);
+
+/**
+ * Function: set_read
+ * Usage: set *s = set_read (fd, compare_int, NULL)
+ * ------------------------------------------------------
+ * Reads a set written by set_write, consuming exactly its stream from fd.
+ * Because the elements arrive sorted the tree is built in O(n), with no
+ * searching or rebalancing. cmp must order them as the writer's did.
+ *
+ * Returns NULL on an I/O error, an early end of file, a stream that is not a
+ * set, a checksum mismatch, or elements that are not strictly increasing
+ * under cmp.
+ *
+ * Asserts: null compare function
+ */
+set *set_read (int fd, compare_fn cmp_fn, elem_destroy_fn destroy_fn);
+
 #endif /* SET_H */
\ No newline at end of file
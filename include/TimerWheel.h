@@ -0,0 +1,120 @@
+/**
+ * File: TimerWheel.h
+ * ------------------------------------------------------
+ * Defines the interface for the timer_wheel type. This implements a hashed
+ * hierarchical timing wheel, where arming and cancelling a timer are
+ * constant time regardless of how many timers are pending.
+ */
+
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include "ADT_common.h"
+#include "ADT_private_implementations.h"
+#include "List.h"
+
+/**
+ * Like the list, the wheel is intrusive. The client embeds the timer_elem
+ * object as the FIRST FIELD of the struct that represents a timer. Time is
+ * counted in ticks, and the length of a tick is up to the client.
+ *
+ * For example, to time out connections:
+ *
+ * typedef struct
+ * {
+ *  	timer_elem te;
+ *  	int fd;
+ * } my_conn;
+ *
+ * timer_wheel *tw = timer_wheel_init (now_ms (), close_conn, NULL);
+ * timer_init (&conn->te);
+ * timer_add (tw, conn, now_ms () + 30000);
+ * ...
+ * timer_advance (tw, now_ms ());
+ */
+
+/**
+ * Function: timer_wheel_init
+ * Usage: timer_wheel *tw = timer_wheel_init (0, fire_fn, NULL)
+ * ------------------------------------------------------
+ * Creates a new wheel with no pending timers whose current tick is now.
+ *
+ * Asserts: null fire function, allocation failure
+ */
+timer_wheel *timer_wheel_init (uint64_t now, timer_fire_fn fire,
+                               elem_destroy_fn fn);
+
+/**
+ * Function: timer_wheel_destroy
+ * Usage: timer_wheel_destroy (tw)
+ * ------------------------------------------------------
+ * Destroys the wheel. Timers still pending are destroyed with the provided
+ * destroy function, if any.
+ */
+void timer_wheel_destroy (timer_wheel *tw);
+
+/**
+ * Function: timer_wheel_size
+ * Usage: size_t pending = timer_wheel_size (tw)
+ * ------------------------------------------------------
+ * Returns the number of pending timers.
+ */
+size_t timer_wheel_size (const timer_wheel *tw);
+
+/**
+ * Function: timer_wheel_now
+ * Usage: uint64_t now = timer_wheel_now (tw)
+ * ------------------------------------------------------
+ * Returns the last tick the wheel was advanced to.
+ */
+uint64_t timer_wheel_now (const timer_wheel *tw);
+
+/**
+ * Function: timer_init
+ * Usage: timer_init (&conn->te)
+ * ------------------------------------------------------
+ * Marks a timer as not pending. Must be called once before a timer is first
+ * used.
+ */
+void timer_init (void *timer);
+
+/**
+ * Function: timer_pending
+ * Usage: if (timer_pending (&conn->te))
+ * ------------------------------------------------------
+ * Returns whether the timer is armed and has not yet fired.
+ */
+bool timer_pending (const void *timer);
+
+/**
+ * Function: timer_add
+ * Usage: timer_add (tw, conn, now + 30000)
+ * ------------------------------------------------------
+ * Arms the timer to fire once the wheel is advanced to expires. A pending
+ * timer is re-armed. A timer whose expiry has already passed fires on the
+ * next advance.
+ *
+ * Asserts: null pointer
+ * Assumes: timer was initialized with timer_init
+ */
+void timer_add (timer_wheel *tw, void *timer, uint64_t expires);
+
+/**
+ * Function: timer_cancel
+ * Usage: timer_cancel (tw, conn)
+ * ------------------------------------------------------
+ * Disarms a pending timer in constant time. Returns whether it was pending.
+ */
+bool timer_cancel (timer_wheel *tw, void *timer);
+
+/**
+ * Function: timer_advance
+ * Usage: size_t fired = timer_advance (tw, now)
+ * ------------------------------------------------------
+ * Moves the wheel forward to now, firing every timer due by then. Timers due
+ * on the same tick fire together in the order they were armed. Returns the
+ * number of timers fired.
+ */
+size_t timer_advance (timer_wheel *tw, uint64_t now);
+
+#endif /* TIMER_WHEEL_H */
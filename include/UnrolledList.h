@@ -0,0 +1,114 @@
+/**
+ * File: UnrolledList.h
+ * ------------------------------------------------------
+ * Defines the interface for the unrolled_list type. This implements an
+ * ordered sequence stored as a linked list of small arrays, so that inserts
+ * and removes in the middle only shift the elements of one node while
+ * sequential traversal still walks mostly contiguous memory.
+ *
+ * Elements are stored by copy, as in the vector.
+ */
+
+#ifndef UNROLLED_LIST_H
+#define UNROLLED_LIST_H
+
+#include "ADT_common.h"
+#include "ADT_private_implementations.h"
+
+/**
+ * Function: unrolled_list_init
+ * Usage: unrolled_list *ul = unrolled_list_init (sizeof(int), 0, 0, NULL)
+ * ------------------------------------------------------
+ * Creates a new empty unrolled list and returns a pointer to it. Each node
+ * holds up to node_capacity elements. A full node is split so that the
+ * first node keeps the fraction fill of them, and every node but the last
+ * is kept at least as full as a split leaves the second node, a fraction
+ * 1 - fill. A fill of a half splits evenly and keeps nodes half full; a
+ * higher fill packs nodes built by inserts tighter but lets them run
+ * emptier on removes. A node_capacity of 0 picks a size that spans a few
+ * cache lines, and a fill of 0 picks a half.
+ *
+ * Asserts: zero elem_sz, node_capacity of 1, fill neither 0 nor in [0.5, 1),
+ *          allocation failure
+ * Assumes: cleanup fn is valid
+ */
+unrolled_list *unrolled_list_init (size_t elem_sz, size_t node_capacity,
+                                   double fill, elem_destroy_fn fn);
+
+/**
+ * Function: unrolled_list_destroy
+ * Usage: unrolled_list_destroy (ul)
+ * ------------------------------------------------------
+ * Destroys and frees all memory associated with the list
+ */
+void unrolled_list_destroy (unrolled_list *ul);
+
+/**
+ * Function: unrolled_list_size
+ * Usage: size_t size = unrolled_list_size (ul)
+ * ------------------------------------------------------
+ * Returns the number of elements in the list.
+ */
+size_t unrolled_list_size (const unrolled_list *ul);
+
+/**
+ * Function: unrolled_list_access
+ * Usage: void *elem = unrolled_list_access (ul, 0)
+ * ------------------------------------------------------
+ * Returns a pointer to the element at index. The node of the last access is
+ * remembered, so walking the list by consecutive indexes costs constant time
+ * per step. The pointer is invalidated by any insert or remove.
+ *
+ * Asserts: null pointer, valid index
+ */
+void *unrolled_list_access (unrolled_list *ul, size_t index);
+
+/**
+ * Function: unrolled_list_insert
+ * Usage: unrolled_list_insert (ul, &elem, 0)
+ * ------------------------------------------------------
+ * Inserts the data pointed to by elem at index by copy. A full node is split
+ * in two rather than shifting the rest of the list.
+ *
+ * Asserts: null pointer (ul, or elem), valid index
+ */
+void unrolled_list_insert (unrolled_list *ul, const void *elem, size_t index);
+
+/**
+ * Function: unrolled_list_append
+ * Usage: unrolled_list_append (ul, &elem)
+ * ------------------------------------------------------
+ * Appends the data pointed to by elem at the end by copy.
+ */
+void unrolled_list_append (unrolled_list *ul, const void *elem);
+
+/**
+ * Function: unrolled_list_remove
+ * Usage: unrolled_list_remove (ul, 0)
+ * ------------------------------------------------------
+ * Removes and destroys the element at index. A node left with fewer than the
+ * 1 - fill share of node_capacity given to unrolled_list_init borrows from
+ * or merges with its neighbour.
+ *
+ * Asserts: null pointer, valid index
+ */
+void unrolled_list_remove (unrolled_list *ul, size_t index);
+
+/**
+ * Function: unrolled_list_replace
+ * Usage: unrolled_list_replace (ul, &elem, 0)
+ * ------------------------------------------------------
+ * Replaces the data at index with the data pointed to by elem by copy. The
+ * old element is destroyed.
+ */
+void unrolled_list_replace (unrolled_list *ul, const void *elem, size_t index);
+
+/**
+ * Function: unrolled_list_clear
+ * Usage: unrolled_list_clear (ul)
+ * ------------------------------------------------------
+ * Destroys every element and releases every node.
+ */
+void unrolled_list_clear (unrolled_list *ul);
+
+#endif /* UNROLLED_LIST_H */
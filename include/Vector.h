@@ -3,6 +3,11 @@
  * ------------------------------------------------------
  * Defines the interface for the vector type. This implements the standard
  * ADT vector that acts as a resizeable array.
+ *
+ * On Linux, once a vector's storage reaches 64 MB it moves into an anonymous
+ * mapping of its own and from then on grows with mremap, which moves pages
+ * rather than copying bytes. Clearing a mapped vector returns its pages to
+ * the system while keeping the address range.
  */
 
 #ifndef VECTOR_H
@@ -11,6 +16,11 @@
 #include "ADT_common.h"
 #include "ADT_private_implementations.h"
 
+/* flags for vector_map_file */
+#define VECTOR_MAP_RDONLY (0x0)
+#define VECTOR_MAP_RDWR   (0x1)
+#define VECTOR_MAP_CREATE (0x2) /* with RDWR, create the file if missing */
+
 /**
  * Function: vector_init
  * Usage: vector *v = vector_init (sizeof(int), 10, NULL)
@@ -22,11 +32,63 @@
  */
 vector *vector_init (size_t elem_sz, size_t capacity_hint, elem_destroy_fn fn);
 
+/**
+ * Function: vector_init_static
+ * Usage: vector v;
+ *        vector_init_static (&v, sizeof(int), 10, NULL);
+ * ------------------------------------------------------
+ * Creates a new empty vector in space for the vector object allocated by the
+ * caller, on the stack or inside another struct. Only the elements are
+ * allocated. vector_destroy frees them and leaves the object to the caller.
+ *
+ * Asserts: null pointer, zero elem_sz, allocation failure
+ */
+void vector_init_static (vector *v, size_t elem_sz, size_t capacity_hint,
+                         elem_destroy_fn fn);
+
+/**
+ * Function: vector_init_buffer
+ * Usage: vector ids;
+ *        uint32_t first[16];
+ *        vector_init_buffer (&ids, sizeof(uint32_t), first, sizeof(first), NULL);
+ * ------------------------------------------------------
+ * Creates a new empty vector that stores its first elements in a buffer the
+ * caller provides, so a vector that never outgrows the buffer costs no
+ * allocation at all. The first growth past the buffer moves the elements to
+ * the heap and the buffer is no longer used. The buffer must outlive the
+ * vector, and the vector object is the caller's as with vector_init_static.
+ *
+ * Asserts: null pointer, zero elem_sz, buffer smaller than one element
+ */
+void vector_init_buffer (vector *v, size_t elem_sz, void *buf, size_t buf_sz,
+                         elem_destroy_fn fn);
+
+/**
+ * Function: vector_clone_cow
+ * Usage: vector *snapshot = vector_clone_cow (config)
+ * ------------------------------------------------------
+ * Returns a copy of the vector in O(1): the clone shares the original's
+ * elements until either of them changes, and only then does the one that
+ * changes copy them. Any number of clones may share one array, and each may
+ * be handed to another thread; the count of sharers is atomic. Each vector
+ * object, as always, is used by one thread at a time.
+ *
+ * Writing through vector_access bypasses the copy and changes every sharer,
+ * so clones must be changed only through the vector functions. Vectors over
+ * a caller's buffer or a file are copied at once.
+ *
+ * Asserts: null pointer, a destroy function, since shared elements can only
+ *          be copied byte for byte
+ */
+vector *vector_clone_cow (vector *v);
+
 /**
  * Function: vector_destroy
  * Usage: vector_destroy (v)
  * ------------------------------------------------------
- * Destroys and frees all memory associated with vector
+ * Destroys and frees all memory associated with vector. For a vector made
+ * by vector_init_static or vector_init_buffer the object itself, and any
+ * buffer, are left to the caller.
  *
  * Asserts: null pointer
  * Assumes: valid initialized vector pointer
@@ -101,6 +163,17 @@ void vector_append (vector *v, const void *elem);
  */
 void vector_replace (vector *v, const void *elem, int index);
 
+/**
+ * Function: vector_reserve
+ * Usage: vector_reserve (v, n)
+ * ------------------------------------------------------
+ * Makes room for n more elements than the vector holds, so that adding them
+ * moves the storage at most once.
+ *
+ * Asserts: null pointer, read only mapped vector, allocation failure
+ */
+void vector_reserve (vector *v, size_t n);
+
 /**
  * Function: vector_clear
  * Usage: vector_clear (v)
@@ -109,6 +182,97 @@ void vector_replace (vector *v, const void *elem, int index);
  */
 void vector_clear (vector *v);
 
+/**
+ * Function: vector_set_huge_pages
+ * Usage: vector_set_huge_pages (v, true)
+ * ------------------------------------------------------
+ * Asks for transparent huge pages once the storage is mapped, cutting TLB
+ * misses on random access to a very large vector. Takes effect immediately if
+ * the storage is mapped already. The kernel may decline the advice. Has no
+ * effect on small vectors or on systems without mremap.
+ *
+ * Asserts: null pointer
+ */
+void vector_set_huge_pages (vector *v, bool enabled);
+
+/**
+ * Function: vector_is_mapped
+ * Usage: if (vector_is_mapped (v))
+ * ------------------------------------------------------
+ * Returns true if the storage has moved into its own mapping.
+ */
+bool vector_is_mapped (const vector *v);
+
+/**
+ * Function: vector_map_file
+ * Usage: vector *table = vector_map_file ("ids.vec", sizeof(uint64_t),
+ *                                         VECTOR_MAP_RDONLY)
+ * ------------------------------------------------------
+ * Opens a vector kept in a file: a 64 byte header followed by the raw
+ * elements. The file is mapped shared rather than read, so opening costs no
+ * copy however large the file, and processes mapping the same file share
+ * its pages in the page cache.
+ *
+ * With VECTOR_MAP_RDWR changes go to the file, and growth extends the file
+ * and remaps it, which moves the elements as growth always can. Add
+ * VECTOR_MAP_CREATE to create an empty vector file if the path is missing or
+ * empty. The element count is written to the header by vector_sync and by
+ * vector_destroy, which unmaps and closes the file. A read only vector must
+ * not be changed.
+ *
+ * Elements are stored raw, so they must not contain pointers, and the file
+ * is in the byte order of the machine that wrote it.
+ *
+ * Returns NULL if the file cannot be opened or mapped, or does not hold a
+ * vector of elem_sz elements. Always NULL on systems without mremap.
+ *
+ * Asserts: null path, zero elem_sz
+ */
+vector *vector_map_file (const char *path, size_t elem_sz, int flags);
+
+/**
+ * Function: vector_sync
+ * Usage: if (!vector_sync (table))
+ * ------------------------------------------------------
+ * Flushes a writable file backed vector: records the element count in the
+ * header and waits until the changes are on disk. Returns false on an I/O
+ * error. Does nothing and returns true for other vectors.
+ *
+ * Asserts: null pointer
+ */
+bool vector_sync (vector *v);
+
+/**
+ * Function: vector_write
+ * Usage: if (!vector_write (v, fd))
+ * ------------------------------------------------------
+ * Writes the vector to a file descriptor: a 32 byte little-endian header
+ * giving the format version, element size and count, the raw elements, and
+ * a checksum. The elements go out in megabyte writev calls straight from the
+ * vector's storage. Works on files, pipes and sockets; fd is left just past
+ * the stream, so several streams can follow one another.
+ *
+ * Elements are written as they are in memory, so they must not contain
+ * pointers, and multi byte fields inside them keep the writer's byte order.
+ *
+ * Returns false on an I/O error, after which fd holds a partial stream.
+ *
+ * Asserts: null pointer
+ */
+bool vector_write (const vector *v, int fd);
+
+/**
+ * Function: vector_read
+ * Usage: vector *v = vector_read (fd)
+ * ------------------------------------------------------
+ * Reads a vector written by vector_write, consuming exactly its stream from
+ * fd. The new vector has no destroy function.
+ *
+ * Returns NULL on an I/O error, an early end of file, a stream that is not a
+ * vector or is of another format version, or a checksum mismatch.
+ */
+vector *vector_read (int fd);
+
 /**
  * Function: vector_search
  * Usage: void *ptr = vector_search (v, &elem, cmp_func)
@@ -129,4 +293,109 @@ void *vector_search (const vector *v, const void *key, compare_fn fn, bool sorte
  */
 void vector_sort (vector *v, compare_fn fn);
 
+/**
+ * Function: vector_sort_stable
+ * Usage: vector_sort_stable (v, cmp_func)
+ * ------------------------------------------------------
+ * Sorts the vector so that elements comparing equal keep their relative
+ * order, which lets records be sorted by a secondary key and then by the
+ * primary one. Finds the ascending and descending runs already in the data
+ * and merges them, so nearly sorted input sorts in close to linear time.
+ * Uses one scratch buffer of up to half the vector for the merges.
+ *
+ * Asserts: null pointer, allocation failure
+ */
+void vector_sort_stable (vector *v, compare_fn fn);
+
+/**
+ * Function: vector_nth_element
+ * Usage: vector_nth_element (v, vector_size (v) / 2, cmp_func)
+ * ------------------------------------------------------
+ * Reorders the vector so the element at index n is the one a full sort would
+ * put there, with no element before it comparing greater and none after it
+ * comparing less. Runs in O(size) on average with quickselect and falls back
+ * to median of medians pivots if the partitions stop shrinking, so the worst
+ * case is also linear.
+ *
+ * Asserts: null pointer, n out of range
+ */
+void vector_nth_element (vector *v, size_t n, compare_fn fn);
+
+/**
+ * Function: vector_partial_sort
+ * Usage: vector_partial_sort (v, 100, cmp_func)
+ * ------------------------------------------------------
+ * Sorts only the k smallest elements into the first k places, in
+ * O(size + k log k). The order of the remaining elements is unspecified.
+ *
+ * Asserts: null pointer, k greater than the size
+ */
+void vector_partial_sort (vector *v, size_t k, compare_fn fn);
+
+/**
+ * Function: vector_top_k
+ * Usage: size_t n = vector_top_k (v, 100, by_score_desc, out)
+ * ------------------------------------------------------
+ * Appends copies of the k elements that sort first under fn to out, in
+ * sorted order, leaving v untouched. Pass a descending compare function to
+ * get the largest. When k is small next to the size a bounded heap of k
+ * elements is kept in out and v is scanned once; otherwise v is copied and
+ * partially sorted. Elements are copied bit for bit, as for the sorted set
+ * operations. Returns the number appended, which is less than k only if v
+ * holds fewer elements.
+ *
+ * Asserts: null pointer, out aliasing v, differing element sizes
+ */
+size_t vector_top_k (const vector *v, size_t k, compare_fn fn, vector *out);
+
+/**
+ * Function: vector_compare_u32
+ * Usage: vector_sort (ids, vector_compare_u32)
+ * ------------------------------------------------------
+ * Compare functions for unsigned 32 and 64 bit integers. Passing one of these
+ * to vector_unique or to the sorted set operations, on a vector with elements
+ * of the matching size, selects kernels that compare the integers directly.
+ */
+int vector_compare_u32 (const void *elem1, const void *elem2);
+int vector_compare_u64 (const void *elem1, const void *elem2);
+
+/**
+ * Function: vector_unique
+ * Usage: size_t n_removed = vector_unique (v, cmp_func)
+ * ------------------------------------------------------
+ * Removes every element that compares equal to the one before it, keeping the
+ * first of each run, in one pass. On a sorted vector this leaves each value
+ * once. Removed elements are destroyed. Returns the number removed.
+ *
+ * Asserts: null pointer
+ */
+size_t vector_unique (vector *v, compare_fn fn);
+
+/**
+ * Function: vector_merge_sorted
+ * Usage: vector_merge_sorted (out, a, b, cmp_func)
+ * ------------------------------------------------------
+ * The sorted set operations read two vectors sorted by fn and append the
+ * result, also sorted, to out. Elements are copied bit for bit, so out should
+ * not destroy elements that a or b still own.
+ *
+ * merge keeps every element of both, taking a's first among equals. union,
+ * intersect and difference treat a and b as sets: they assume neither holds
+ * an element twice (see vector_unique), emit common elements once, from a,
+ * and for difference emit the elements of a that are not in b.
+ *
+ * When one input is much smaller than the other, the larger one is galloped
+ * through rather than walked. Each returns the number of elements appended.
+ *
+ * Asserts: null pointer, out aliasing an input, differing element sizes
+ */
+size_t vector_merge_sorted (vector *out, const vector *a, const vector *b,
+                            compare_fn fn);
+size_t vector_union_sorted (vector *out, const vector *a, const vector *b,
+                            compare_fn fn);
+size_t vector_intersect_sorted (vector *out, const vector *a, const vector *b,
+                                compare_fn fn);
+size_t vector_difference_sorted (vector *out, const vector *a, const vector *b,
+                                 compare_fn fn);
+
 #endif /* VECTOR_H */
\ No newline at end of file
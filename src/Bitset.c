@@ -0,0 +1,736 @@
+/**
+ * File: Bitset.c
+ * Author: Seth Charles
+ * ----------------------
+ */
+#include "Bitset.h"
+#include <assert.h>
+#include <string.h>
+
+/*
+ * The library is built for the baseline instruction set, so the AVX2 and
+ * POPCNT code is compiled per function and chosen at run time: the bulk
+ * loops check __builtin_cpu_supports, and the popcount helpers are cloned
+ * by the compiler, which picks a clone when the program is loaded.
+ */
+#if defined(__GNUC__) && defined(__x86_64__)
+#define BITSET_X86
+#include <immintrin.h>
+#define POPCNT_CLONES __attribute__ ((target_clones ("popcnt", "default")))
+#else
+#define POPCNT_CLONES
+#endif
+
+#define MAGIC_INIT_VALUE (0x71c5a2e04b9d38f6)
+#define WORD_BITS        (64)
+#define BLOCK_WORDS      (CACHE_LINE_SZ / sizeof (uint64_t))
+#define BLOCK_BITS       (BLOCK_WORDS * WORD_BITS)
+#define N_WORDS(N)       (((N) + WORD_BITS - 1) / WORD_BITS)
+#define N_BLOCKS(BS)     (((BS)->n_words + BLOCK_WORDS - 1) / BLOCK_WORDS)
+#define ROUND_UP(N, A)   (((N) + (A) - 1) / (A) * (A))
+#define BIT(POS)         (1ULL << ((POS) % WORD_BITS))
+
+typedef enum
+{
+	OP_AND,
+	OP_OR,
+	OP_XOR,
+	OP_ANDNOT
+} bitset_op;
+
+/**
+ * Function: bitset_alloc
+ * ------------------------------------------------------
+ * Allocates n_words clear words, aligned so that each block of the rank
+ * index is one cache line.
+ */
+static uint64_t *
+bitset_alloc (size_t n_words)
+{
+	size_t sz = ROUND_UP (n_words * sizeof (uint64_t), CACHE_LINE_SZ);
+	uint64_t *words;
+
+	sz = (sz == 0) ? CACHE_LINE_SZ : sz;
+	words = aligned_alloc (CACHE_LINE_SZ, sz);
+	assert (words != NULL);
+	memset (words, 0, sz);
+
+	return words;
+}
+
+/**
+ * Function: bitset_count_bits
+ * ------------------------------------------------------
+ * Counts the set bits among the first n_bits of an array of words.
+ */
+static POPCNT_CLONES size_t
+bitset_count_bits (const uint64_t *words, size_t n_bits)
+{
+	size_t i, n = 0;
+
+	for (i = 0; i < n_bits / WORD_BITS; i++)
+	{
+		n += (size_t)__builtin_popcountll (words[i]);
+	}
+	if (n_bits % WORD_BITS != 0)
+	{
+		n += (size_t)__builtin_popcountll (words[i] & (BIT (n_bits) - 1));
+	}
+	return n;
+}
+
+/**
+ * Function: bitset_select_word
+ * ------------------------------------------------------
+ * Returns the position of set bit number k of a word, which has more than k
+ * set bits. The bytes are counted all at once, and their running totals
+ * summed by one multiply, so the byte holding the bit is found in at most
+ * eight steps and the bit within it in at most seven.
+ */
+static inline unsigned
+bitset_select_word (uint64_t w, unsigned k)
+{
+	uint64_t counts = w - ((w >> 1) & 0x5555555555555555ULL), byte;
+	unsigned shift = 0;
+
+	counts = (counts & 0x3333333333333333ULL) + ((counts >> 2) & 0x3333333333333333ULL);
+	counts = (counts + (counts >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+	counts *= 0x0101010101010101ULL;
+
+	while (((counts >> shift) & 0xff) <= k)
+	{
+		shift += 8;
+	}
+	k -= (shift == 0) ? 0 : (unsigned)((counts >> (shift - 8)) & 0xff);
+	byte = (w >> shift) & 0xff;
+	while (k-- > 0)
+	{
+		byte &= byte - 1;
+	}
+	return shift + (unsigned)__builtin_ctzll (byte);
+}
+
+/**
+ * Function: bitset_select_block
+ * ------------------------------------------------------
+ * Returns the position of set bit number k from the start of an array of
+ * words that holds more than k set bits.
+ */
+static POPCNT_CLONES size_t
+bitset_select_block (const uint64_t *words, size_t k)
+{
+	size_t i = 0, n;
+
+	while ((n = (size_t)__builtin_popcountll (words[i])) <= k)
+	{
+		k -= n;
+		i++;
+	}
+	return i * WORD_BITS + bitset_select_word (words[i], (unsigned)k);
+}
+
+/**
+ * Function: bitset_decode_word
+ * ------------------------------------------------------
+ * Writes the positions of the set bits of a word, base plus each bit,
+ * and returns how many there are. The count is known up front, so the
+ * positions are taken four per step with no branch on each bit. The steps
+ * past the last bit write unused slots, up to 64 in all, and keep bit 63
+ * set so the count of trailing zeros never sees a zero word.
+ */
+static POPCNT_CLONES size_t
+bitset_decode_word (size_t *pos, size_t base, uint64_t bits)
+{
+	const uint64_t guard = 1ULL << (WORD_BITS - 1);
+	size_t n = (size_t)__builtin_popcountll (bits), i;
+
+	for (i = 0; i < n; i += 4)
+	{
+		pos[i] = base + (size_t)__builtin_ctzll (bits | guard);
+		bits &= bits - 1;
+		pos[i + 1] = base + (size_t)__builtin_ctzll (bits | guard);
+		bits &= bits - 1;
+		pos[i + 2] = base + (size_t)__builtin_ctzll (bits | guard);
+		bits &= bits - 1;
+		pos[i + 3] = base + (size_t)__builtin_ctzll (bits | guard);
+		bits &= bits - 1;
+	}
+	return n;
+}
+
+/**
+ * Function: bitset_build_index
+ * ------------------------------------------------------
+ * Counts the set bits of each block into ranks, and records in samples the
+ * block each BITSET_SELECT_SAMPLE'th set bit falls in, so a select only
+ * searches the blocks between two samples.
+ */
+static void
+bitset_build_index (bitset *bs)
+{
+	size_t n_blocks = N_BLOCKS (bs), b, j = 0, n_words;
+
+	bs->ranks = realloc (bs->ranks, (n_blocks + 1) * sizeof (size_t));
+	assert (bs->ranks != NULL);
+	bs->ranks[0] = 0;
+	for (b = 0; b < n_blocks; b++)
+	{
+		n_words = bs->n_words - b * BLOCK_WORDS;
+		n_words = (n_words < BLOCK_WORDS) ? n_words : BLOCK_WORDS;
+		bs->ranks[b + 1] = bs->ranks[b] + bitset_count_bits (bs->words + b * BLOCK_WORDS, n_words * WORD_BITS);
+	}
+
+	bs->n_samples = (bs->ranks[n_blocks] + BITSET_SELECT_SAMPLE - 1) / BITSET_SELECT_SAMPLE;
+	bs->samples = realloc (bs->samples, (bs->n_samples + 1) * sizeof (size_t));
+	assert (bs->samples != NULL);
+	for (b = 0; b < n_blocks; b++)
+	{
+		while (j < bs->n_samples && j * BITSET_SELECT_SAMPLE < bs->ranks[b + 1])
+		{
+			bs->samples[j++] = b;
+		}
+	}
+	bs->index_valid = true;
+}
+
+/**
+ * Function: bitset_apply_words
+ * ------------------------------------------------------
+ * Combines n words of src into dst with op, one word at a time. A loop per
+ * op keeps the switch out of the loop so the compiler can vectorise each.
+ */
+static void
+bitset_apply_words (uint64_t *dst, const uint64_t *src, size_t n, bitset_op op)
+{
+	size_t i;
+
+	switch (op)
+	{
+	case OP_AND:
+		for (i = 0; i < n; i++) dst[i] &= src[i];
+		break;
+	case OP_OR:
+		for (i = 0; i < n; i++) dst[i] |= src[i];
+		break;
+	case OP_XOR:
+		for (i = 0; i < n; i++) dst[i] ^= src[i];
+		break;
+	case OP_ANDNOT:
+		for (i = 0; i < n; i++) dst[i] &= ~src[i];
+		break;
+	}
+}
+
+#ifdef BITSET_X86
+
+/**
+ * Function: bitset_apply_avx2
+ * ------------------------------------------------------
+ * Combines n words of src into dst with op four words at a time, leaving
+ * the last n % 4 to bitset_apply_words.
+ */
+static __attribute__ ((target ("avx2"))) void
+bitset_apply_avx2 (uint64_t *dst, const uint64_t *src, size_t n, bitset_op op)
+{
+	size_t i, end = n - n % 4;
+	__m256i a, b;
+
+	for (i = 0; i < end; i += 4)
+	{
+		a = _mm256_loadu_si256 ((const __m256i *)(dst + i));
+		b = _mm256_loadu_si256 ((const __m256i *)(src + i));
+		switch (op)
+		{
+		case OP_AND: a = _mm256_and_si256 (a, b); break;
+		case OP_OR: a = _mm256_or_si256 (a, b); break;
+		case OP_XOR: a = _mm256_xor_si256 (a, b); break;
+		case OP_ANDNOT: a = _mm256_andnot_si256 (b, a); break;
+		}
+		_mm256_storeu_si256 ((__m256i *)(dst + i), a);
+	}
+	bitset_apply_words (dst + end, src + end, n - end, op);
+}
+
+/**
+ * Function: bitset_count_avx2
+ * ------------------------------------------------------
+ * Counts set bits 256 at a time. Each byte's count is the sum of its two
+ * nibbles' counts, looked up in a 16 entry table by a byte shuffle, and the
+ * byte counts are summed into four 64 bit totals by a sum of absolute
+ * differences against zero.
+ */
+static __attribute__ ((target ("avx2"))) size_t
+bitset_count_avx2 (const uint64_t *words, size_t n)
+{
+	const __m256i table = _mm256_setr_epi8 (0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+	                                        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+	const __m256i low = _mm256_set1_epi8 (0x0f), zero = _mm256_setzero_si256 ();
+	__m256i sum = zero, v, counts;
+	size_t i, end = n - n % 4;
+	uint64_t lanes[4];
+
+	for (i = 0; i < end; i += 4)
+	{
+		v = _mm256_loadu_si256 ((const __m256i *)(words + i));
+		counts = _mm256_add_epi8 (_mm256_shuffle_epi8 (table, _mm256_and_si256 (v, low)),
+		                          _mm256_shuffle_epi8 (table, _mm256_and_si256 (_mm256_srli_epi16 (v, 4), low)));
+		sum = _mm256_add_epi64 (sum, _mm256_sad_epu8 (counts, zero));
+	}
+	_mm256_storeu_si256 ((__m256i *)lanes, sum);
+	return (size_t)(lanes[0] + lanes[1] + lanes[2] + lanes[3])
+	       + bitset_count_bits (words + end, (n - end) * WORD_BITS);
+}
+
+#endif
+
+/**
+ * Function: bitset_apply
+ * ------------------------------------------------------
+ * Combines src into dst with op, 256 bits at a time where AVX2 is available.
+ */
+static void
+bitset_apply (bitset *dst, const bitset *src, bitset_op op)
+{
+	assert (dst != NULL);
+	assert (src != NULL);
+	assert (dst->magic == MAGIC_INIT_VALUE && src->magic == MAGIC_INIT_VALUE);
+	assert (dst->n_bits == src->n_bits);
+
+#ifdef BITSET_X86
+	if (__builtin_cpu_supports ("avx2"))
+	{
+		bitset_apply_avx2 (dst->words, src->words, dst->n_words, op);
+	}
+	else
+#endif
+	{
+		bitset_apply_words (dst->words, src->words, dst->n_words, op);
+	}
+	dst->index_valid = false;
+}
+
+/**
+ * Function: bitset_init
+ * ------------------------------------------------------
+ * Public function to perform bitset initialization
+ *
+ * param n_bits - the number of bits
+ *
+ * returns - a pointer to the bitset object
+ */
+bitset *
+bitset_init (size_t n_bits)
+{
+	bitset *bs = calloc (1, sizeof (bitset));
+	assert (bs != NULL);
+
+	bs->n_bits = n_bits;
+	bs->n_words = N_WORDS (n_bits);
+	bs->words = bitset_alloc (bs->n_words);
+	bs->magic = MAGIC_INIT_VALUE;
+
+	return bs;
+}
+
+/**
+ * Function: bitset_destroy
+ * ------------------------------------------------------
+ * Frees the words, the rank and select index and the bitset.
+ */
+void
+bitset_destroy (bitset *bs)
+{
+	assert (bs != NULL);
+	assert (bs->magic == MAGIC_INIT_VALUE);
+
+	free (bs->words);
+	free (bs->ranks);
+	free (bs->samples);
+	free (bs);
+}
+
+/**
+ * Function: bitset_size
+ * ------------------------------------------------------
+ * Gets the number of bits in the bitset.
+ */
+size_t
+bitset_size (const bitset *bs)
+{
+	assert (bs != NULL);
+	assert (bs->magic == MAGIC_INIT_VALUE);
+
+	return bs->n_bits;
+}
+
+/**
+ * Function: bitset_resize
+ * ------------------------------------------------------
+ * Moves the bits to clear words of the new size, then clears any bits of
+ * the last word past the new size, which shrinking can leave set.
+ */
+void
+bitset_resize (bitset *bs, size_t n_bits)
+{
+	assert (bs != NULL);
+	assert (bs->magic == MAGIC_INIT_VALUE);
+	size_t n_words = N_WORDS (n_bits);
+	uint64_t *words = bitset_alloc (n_words);
+
+	memcpy (words, bs->words, ((n_words < bs->n_words) ? n_words : bs->n_words) * sizeof (uint64_t));
+	if (n_bits % WORD_BITS != 0)
+	{
+		words[n_words - 1] &= BIT (n_bits) - 1;
+	}
+	free (bs->words);
+	bs->words = words;
+	bs->n_bits = n_bits;
+	bs->n_words = n_words;
+	bs->index_valid = false;
+}
+
+/**
+ * Function: bitset_set
+ * ------------------------------------------------------
+ * Sets the bit at pos.
+ */
+void
+bitset_set (bitset *bs, size_t pos)
+{
+	assert (bs != NULL);
+	assert (bs->magic == MAGIC_INIT_VALUE);
+	assert (pos < bs->n_bits);
+
+	bs->words[pos / WORD_BITS] |= BIT (pos);
+	bs->index_valid = false;
+}
+
+/**
+ * Function: bitset_clear
+ * ------------------------------------------------------
+ * Clears the bit at pos.
+ */
+void
+bitset_clear (bitset *bs, size_t pos)
+{
+	assert (bs != NULL);
+	assert (bs->magic == MAGIC_INIT_VALUE);
+	assert (pos < bs->n_bits);
+
+	bs->words[pos / WORD_BITS] &= ~BIT (pos);
+	bs->index_valid = false;
+}
+
+/**
+ * Function: bitset_test
+ * ------------------------------------------------------
+ * Tests whether the bit at pos is set.
+ */
+bool
+bitset_test (const bitset *bs, size_t pos)
+{
+	assert (bs != NULL);
+	assert (bs->magic == MAGIC_INIT_VALUE);
+	assert (pos < bs->n_bits);
+
+	return (bs->words[pos / WORD_BITS] & BIT (pos)) != 0;
+}
+
+/**
+ * Function: bitset_clear_all
+ * ------------------------------------------------------
+ * Clears every bit, keeping the size.
+ */
+void
+bitset_clear_all (bitset *bs)
+{
+	assert (bs != NULL);
+	assert (bs->magic == MAGIC_INIT_VALUE);
+
+	memset (bs->words, 0, bs->n_words * sizeof (uint64_t));
+	bs->index_valid = false;
+}
+
+/**
+ * Function: bitset_and
+ * ------------------------------------------------------
+ * Keeps in dst only the bits also set in src.
+ */
+void
+bitset_and (bitset *dst, const bitset *src)
+{
+	bitset_apply (dst, src, OP_AND);
+}
+
+/**
+ * Function: bitset_or
+ * ------------------------------------------------------
+ * Sets in dst every bit set in src.
+ */
+void
+bitset_or (bitset *dst, const bitset *src)
+{
+	bitset_apply (dst, src, OP_OR);
+}
+
+/**
+ * Function: bitset_xor
+ * ------------------------------------------------------
+ * Flips in dst every bit set in src.
+ */
+void
+bitset_xor (bitset *dst, const bitset *src)
+{
+	bitset_apply (dst, src, OP_XOR);
+}
+
+/**
+ * Function: bitset_andnot
+ * ------------------------------------------------------
+ * Clears in dst every bit set in src.
+ */
+void
+bitset_andnot (bitset *dst, const bitset *src)
+{
+	bitset_apply (dst, src, OP_ANDNOT);
+}
+
+/**
+ * Function: bitset_count
+ * ------------------------------------------------------
+ * Read off the rank index when it is current, and counted otherwise.
+ */
+size_t
+bitset_count (const bitset *bs)
+{
+	assert (bs != NULL);
+	assert (bs->magic == MAGIC_INIT_VALUE);
+
+	if (bs->index_valid)
+	{
+		return bs->ranks[N_BLOCKS (bs)];
+	}
+#ifdef BITSET_X86
+	if (__builtin_cpu_supports ("avx2"))
+	{
+		return bitset_count_avx2 (bs->words, bs->n_words);
+	}
+#endif
+	return bitset_count_bits (bs->words, bs->n_words * WORD_BITS);
+}
+
+/**
+ * Function: bitset_rank
+ * ------------------------------------------------------
+ * The count before the block holding pos, plus the set bits of that block
+ * below pos, at most eight words all in one cache line.
+ */
+size_t
+bitset_rank (bitset *bs, size_t pos)
+{
+	assert (bs != NULL);
+	assert (bs->magic == MAGIC_INIT_VALUE);
+	assert (pos <= bs->n_bits);
+	size_t block = pos / BLOCK_BITS;
+
+	if (!bs->index_valid)
+	{
+		bitset_build_index (bs);
+	}
+	return bs->ranks[block] + bitset_count_bits (bs->words + block * BLOCK_WORDS, pos % BLOCK_BITS);
+}
+
+/**
+ * Function: bitset_select
+ * ------------------------------------------------------
+ * The samples either side of k bound the blocks that can hold it. Among
+ * those, the block holding it is the last whose count before it is at most
+ * k, found by binary search of ranks.
+ */
+size_t
+bitset_select (bitset *bs, size_t k)
+{
+	assert (bs != NULL);
+	assert (bs->magic == MAGIC_INIT_VALUE);
+	size_t j, lo, hi, mid;
+
+	if (!bs->index_valid)
+	{
+		bitset_build_index (bs);
+	}
+	assert (k < bs->ranks[N_BLOCKS (bs)]);
+
+	j = k / BITSET_SELECT_SAMPLE;
+	lo = bs->samples[j];
+	hi = (j + 1 < bs->n_samples) ? bs->samples[j + 1] : N_BLOCKS (bs) - 1;
+	while (lo < hi)
+	{
+		mid = lo + (hi - lo + 1) / 2;
+		if (bs->ranks[mid] <= k)
+		{
+			lo = mid;
+		}
+		else
+		{
+			hi = mid - 1;
+		}
+	}
+	return lo * BLOCK_BITS + bitset_select_block (bs->words + lo * BLOCK_WORDS, k - bs->ranks[lo]);
+}
+
+/**
+ * Function: bitset_iter_init
+ * ------------------------------------------------------
+ * Points the iterator at the word holding start, with the bits of that word
+ * below start masked off.
+ */
+void
+bitset_iter_init (const bitset *bs, bitset_iter *it, size_t start)
+{
+	assert (bs != NULL);
+	assert (it != NULL);
+	assert (bs->magic == MAGIC_INIT_VALUE);
+	assert (start <= bs->n_bits);
+
+	it->bs = bs;
+	it->word = start / WORD_BITS;
+	it->bits = (it->word < bs->n_words) ? bs->words[it->word] & ~(BIT (start) - 1) : 0;
+}
+
+/**
+ * Function: bitset_iter_next
+ * ------------------------------------------------------
+ * Takes the lowest remaining bit of the current word with a count of
+ * trailing zeros (tzcnt), and clears it, moving on to the next word with
+ * any set bits once the current one is used up.
+ */
+bool
+bitset_iter_next (bitset_iter *it, size_t *pos)
+{
+	assert (it != NULL);
+	assert (pos != NULL);
+	assert (it->bs != NULL && it->bs->magic == MAGIC_INIT_VALUE);
+	const bitset *bs = it->bs;
+
+	while (it->bits == 0)
+	{
+		if (it->word + 1 >= bs->n_words)
+		{
+			return false;
+		}
+		it->bits = bs->words[++it->word];
+	}
+	*pos = it->word * WORD_BITS + (size_t)__builtin_ctzll (it->bits);
+	it->bits &= it->bits - 1;
+	return true;
+}
+
+/**
+ * Function: bitset_iter_next_many
+ * ------------------------------------------------------
+ * While pos has room for a whole word, each word is decoded at once. Near
+ * the end of pos, bits are taken one at a time, so a word can be left part
+ * way through for the next call.
+ */
+size_t
+bitset_iter_next_many (bitset_iter *it, size_t *pos, size_t max_n)
+{
+	assert (it != NULL);
+	assert (pos != NULL);
+	assert (it->bs != NULL && it->bs->magic == MAGIC_INIT_VALUE);
+	const bitset *bs = it->bs;
+	size_t n = 0, base = it->word * WORD_BITS;
+	uint64_t bits = it->bits;
+
+	while (n < max_n)
+	{
+		if (bits == 0)
+		{
+			if (it->word + 1 >= bs->n_words)
+			{
+				break;
+			}
+			bits = bs->words[++it->word];
+			base += WORD_BITS;
+		}
+		else if (max_n - n >= WORD_BITS)
+		{
+			n += bitset_decode_word (pos + n, base, bits);
+			bits = 0;
+		}
+		else
+		{
+			pos[n++] = base + (size_t)__builtin_ctzll (bits);
+			bits &= bits - 1;
+		}
+	}
+	it->bits = bits;
+	return n;
+}
+
+/**
+ * Function: bitset_from_vector
+ * ------------------------------------------------------
+ * Finds the largest id to size the bitset, then sets a bit per id.
+ */
+bitset *
+bitset_from_vector (const vector *v)
+{
+	assert (v != NULL);
+	assert (v->elem_sz == sizeof (uint32_t) || v->elem_sz == sizeof (uint64_t));
+	size_t n = vector_size (v), i;
+	uint64_t id, max = 0;
+	bitset *bs;
+
+	for (i = 0; i < n; i++)
+	{
+		id = (v->elem_sz == sizeof (uint32_t)) ? ((const uint32_t *)v->elems)[i] : ((const uint64_t *)v->elems)[i];
+		max = (id > max) ? id : max;
+	}
+	assert (max < SIZE_MAX);
+
+	bs = bitset_init ((n == 0) ? 0 : (size_t)max + 1);
+	for (i = 0; i < n; i++)
+	{
+		id = (v->elem_sz == sizeof (uint32_t)) ? ((const uint32_t *)v->elems)[i] : ((const uint64_t *)v->elems)[i];
+		bs->words[id / WORD_BITS] |= BIT (id);
+	}
+	return bs;
+}
+
+/**
+ * Function: bitset_to_vector
+ * ------------------------------------------------------
+ * Sizes the vector from the count, then writes the positions straight into
+ * its array, taking the set bits of each word lowest first.
+ */
+vector *
+bitset_to_vector (const bitset *bs, size_t elem_sz)
+{
+	assert (bs != NULL);
+	assert (bs->magic == MAGIC_INIT_VALUE);
+	assert (elem_sz == sizeof (uint32_t) || elem_sz == sizeof (uint64_t));
+	size_t n = bitset_count (bs), w, pos, i = 0;
+	vector *v = vector_init (elem_sz, n, NULL);
+	uint64_t bits;
+
+	for (w = 0; w < bs->n_words; w++)
+	{
+		for (bits = bs->words[w]; bits != 0; bits &= bits - 1)
+		{
+			pos = w * WORD_BITS + (size_t)__builtin_ctzll (bits);
+			if (elem_sz == sizeof (uint32_t))
+			{
+				assert (pos <= UINT32_MAX);
+				((uint32_t *)v->elems)[i++] = (uint32_t)pos;
+			}
+			else
+			{
+				((uint64_t *)v->elems)[i++] = pos;
+			}
+		}
+	}
+	v->n_elems = n;
+
+	return v;
+}
@@ -0,0 +1,458 @@
+/**
+ * File: Bloom.c
+ * Author: Seth Charles
+ * ----------------------
+ * A split block Bloom filter. The hash picks a block with its high half,
+ * and its low half, multiplied by a different odd constant per word, picks
+ * one bit in each of the block's words by the top five bits of the product.
+ * Keeping to one bit per word lets a whole block be tested as one or a few
+ * vector compares. Wider blocks set more bits per element, which pays at
+ * lower false positive rates, so the block width is chosen with the size.
+ */
+#include "Bloom.h"
+#include <assert.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/*
+ * The library is built for the baseline instruction set, so the AVX2 batch
+ * test is compiled for its own function and chosen at run time.
+ */
+#if defined(__GNUC__) && defined(__x86_64__)
+#define BLOOM_X86
+#include <immintrin.h>
+#endif
+
+#define MAGIC_INIT_VALUE (0xc453b92e79219369)
+#define HASH_MULTIPLIER  (0x9e3779b97f4a7c15ULL)
+#define MIN_BLOCK_WORDS  (4)
+#define BATCH            (16) /* keys whose blocks are prefetched together */
+#define MAX_MEAN_LOAD    (600) /* past this many elements a block, use the mean alone */
+
+static const uint32_t bloom_salts[BLOOM_BLOCK_WORDS] = {
+	0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU, 0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U,
+	0x7f5e8e61U, 0xdb0eda41U, 0x4423f60dU, 0x5d357fffU, 0xa32d60b1U, 0xe40c58c9U, 0x3e13272fU, 0xb14a81b5U
+};
+
+/**
+ * Function: bloom_mix
+ * ------------------------------------------------------
+ * Folds the high and low halves of a wide multiply of the client hash, as
+ * the hashset does, so both halves of the result depend on every input bit.
+ */
+static inline uint64_t
+bloom_mix (size_t hash)
+{
+#ifdef __SIZEOF_INT128__
+	unsigned __int128 m = (unsigned __int128)hash * HASH_MULTIPLIER;
+	return (uint64_t)m ^ (uint64_t)(m >> 64);
+#else
+	uint64_t m = (uint64_t)hash * HASH_MULTIPLIER;
+	return m ^ (m >> 32);
+#endif
+}
+
+/**
+ * Function: bloom_block
+ * ------------------------------------------------------
+ * Picks a block from the high half of the mixed hash by multiplying and
+ * shifting, which spreads it over n_blocks without a division.
+ */
+static inline uint32_t *
+bloom_block (const bloom *b, uint64_t h)
+{
+	return b->blocks + (size_t)(((h >> 32) * (uint64_t)b->n_blocks) >> 32) * b->block_words;
+}
+
+/**
+ * Function: bloom_masks
+ * ------------------------------------------------------
+ * Fills in the bit each of a block's words must have for an element whose
+ * hash has low half x.
+ */
+static inline void
+bloom_masks (uint32_t x, size_t block_words, uint32_t *mask)
+{
+	size_t i;
+
+	for (i = 0; i < block_words; i++)
+	{
+		mask[i] = 1U << ((x * bloom_salts[i]) >> 27);
+	}
+}
+
+/**
+ * Function: bloom_test_block
+ * ------------------------------------------------------
+ * Returns whether a block has every bit of the masks set.
+ */
+static inline bool
+bloom_test_block (const uint32_t *block, const uint32_t *mask, size_t block_words)
+{
+#ifdef __SSE2__
+	__m128i all = _mm_set1_epi32 (-1), m, v;
+	size_t i;
+
+	for (i = 0; i < block_words; i += 4)
+	{
+		m = _mm_loadu_si128 ((const __m128i *)(mask + i));
+		v = _mm_load_si128 ((const __m128i *)(block + i));
+		all = _mm_and_si128 (all, _mm_cmpeq_epi32 (_mm_and_si128 (v, m), m));
+	}
+	return _mm_movemask_epi8 (all) == 0xffff;
+#else
+	uint32_t missing = 0;
+	size_t i;
+
+	for (i = 0; i < block_words; i++)
+	{
+		missing |= mask[i] & ~block[i];
+	}
+	return missing == 0;
+#endif
+}
+
+/**
+ * Function: bloom_test_group
+ * ------------------------------------------------------
+ * Tests n elements whose blocks and low hash halves have been worked out,
+ * setting maybe for each and returning how many passed.
+ */
+static size_t
+bloom_test_group (const bloom *b, uint32_t *const *blocks, const uint32_t *xs, size_t n, bool *maybe)
+{
+	uint32_t mask[BLOOM_BLOCK_WORDS];
+	size_t i, count = 0;
+
+	for (i = 0; i < n; i++)
+	{
+		bloom_masks (xs[i], b->block_words, mask);
+		maybe[i] = bloom_test_block (blocks[i], mask, b->block_words);
+		count += maybe[i];
+	}
+	return count;
+}
+
+#ifdef BLOOM_X86
+
+/**
+ * Function: bloom_test_group_avx2
+ * ------------------------------------------------------
+ * bloom_test_group for blocks of 8 or 16 words, with the masks made eight
+ * words at a time by a vector multiply, shift and variable shift, and each
+ * eight words of the block tested at once.
+ */
+__attribute__ ((target ("avx2"))) static size_t
+bloom_test_group_avx2 (const bloom *b, uint32_t *const *blocks, const uint32_t *xs, size_t n, bool *maybe)
+{
+	const __m256i salts_lo = _mm256_loadu_si256 ((const __m256i *)bloom_salts);
+	const __m256i salts_hi = _mm256_loadu_si256 ((const __m256i *)(bloom_salts + 8));
+	const __m256i one = _mm256_set1_epi32 (1);
+	bool wide = (b->block_words == BLOOM_BLOCK_WORDS);
+	__m256i x, m;
+	size_t i, count = 0;
+
+	for (i = 0; i < n; i++)
+	{
+		x = _mm256_set1_epi32 ((int)xs[i]);
+		m = _mm256_sllv_epi32 (one, _mm256_srli_epi32 (_mm256_mullo_epi32 (x, salts_lo), 27));
+		maybe[i] = _mm256_testc_si256 (_mm256_load_si256 ((const __m256i *)blocks[i]), m);
+		if (wide)
+		{
+			m = _mm256_sllv_epi32 (one, _mm256_srli_epi32 (_mm256_mullo_epi32 (x, salts_hi), 27));
+			maybe[i] &= _mm256_testc_si256 (_mm256_load_si256 ((const __m256i *)(blocks[i] + 8)), m);
+		}
+		count += maybe[i];
+	}
+	return count;
+}
+
+#endif
+
+/**
+ * Function: bloom_pow
+ * ------------------------------------------------------
+ * Raises x to a whole power by squaring, sparing a dependence on libm.
+ */
+static double
+bloom_pow (double x, size_t n)
+{
+	double result = 1.0;
+
+	for (; n > 0; n >>= 1)
+	{
+		if (n & 1)
+		{
+			result *= x;
+		}
+		x *= x;
+	}
+	return result;
+}
+
+/**
+ * Function: bloom_expected_fp
+ * ------------------------------------------------------
+ * Returns the false positive rate of a filter of n_blocks blocks of
+ * block_words words holding n elements. The elements in the block a query
+ * lands in are binomially distributed; with j of them a word has the bit
+ * asked for set with probability 1 - (31/32)^j, and every word must. The
+ * terms are summed from j = 0 until they are past the mean and negligible.
+ */
+static double
+bloom_expected_fp (size_t n, size_t n_blocks, size_t block_words)
+{
+	double p = 1.0 / (double)n_blocks, mean = (double)n * p;
+	double term, fill = 1.0, fp = 0.0;
+	size_t j;
+
+	if (n_blocks == 1 || mean > MAX_MEAN_LOAD)
+	{
+		return bloom_pow (1.0 - bloom_pow (31.0 / 32.0, (size_t)mean), block_words);
+	}
+
+	term = bloom_pow (1.0 - p, n);
+	for (j = 0; j <= n; j++)
+	{
+		fp += term * bloom_pow (1.0 - fill, block_words);
+		if ((double)j > mean && term < 1e-18)
+		{
+			break;
+		}
+		term *= (double)(n - j) / (double)(j + 1) * p / (1.0 - p);
+		fill *= 31.0 / 32.0;
+	}
+	return fp;
+}
+
+/**
+ * Function: bloom_size
+ * ------------------------------------------------------
+ * Finds the smallest filter that holds capacity elements at fp_rate, trying
+ * each block width: the block count is doubled until the rate is met, then
+ * narrowed by bisection. Ties go to the narrower block.
+ */
+static void
+bloom_size (size_t capacity, double fp_rate, size_t *n_blocks, size_t *block_words)
+{
+	size_t best = SIZE_MAX, words, lo, hi, mid;
+
+	for (words = MIN_BLOCK_WORDS; words <= BLOOM_BLOCK_WORDS; words *= 2)
+	{
+		for (hi = 1; bloom_expected_fp (capacity, hi, words) > fp_rate; hi *= 2)
+			;
+
+		lo = hi / 2 + 1;
+		while (lo < hi)
+		{
+			mid = lo + (hi - lo) / 2;
+			if (bloom_expected_fp (capacity, mid, words) <= fp_rate)
+			{
+				hi = mid;
+			}
+			else
+			{
+				lo = mid + 1;
+			}
+		}
+		if (hi * words < best)
+		{
+			best = hi * words;
+			*n_blocks = hi;
+			*block_words = words;
+		}
+	}
+}
+
+/**
+ * Function: bloom_alloc
+ * ------------------------------------------------------
+ * Allocates the blocks cache line aligned and clear, rounding the size up
+ * to whole cache lines as aligned_alloc requires.
+ */
+static uint32_t *
+bloom_alloc (size_t n_words)
+{
+	size_t bytes = (n_words * sizeof (uint32_t) + CACHE_LINE_SZ - 1) / CACHE_LINE_SZ * CACHE_LINE_SZ;
+	uint32_t *words = aligned_alloc (CACHE_LINE_SZ, bytes);
+
+	assert (words != NULL);
+	memset (words, 0, bytes);
+	return words;
+}
+
+/**
+ * Function: bloom_init
+ * ------------------------------------------------------
+ * Sizes the filter for capacity keys at fp_rate with bloom_size and
+ * allocates its blocks clear. A capacity of 0 is taken as 1.
+ */
+bloom *
+bloom_init (size_t elem_sz, size_t capacity, double fp_rate, hash_fn hash)
+{
+	assert (elem_sz > 0);
+	assert (hash != NULL);
+	assert (fp_rate > 0.0 && fp_rate < 1.0);
+
+	bloom *b = calloc (1, sizeof (bloom));
+	assert (b != NULL);
+
+	b->capacity = (capacity > 0) ? capacity : 1;
+	bloom_size (b->capacity, fp_rate, &b->n_blocks, &b->block_words);
+	assert (b->n_blocks <= UINT32_MAX);
+	b->blocks = bloom_alloc (b->n_blocks * b->block_words);
+
+	b->fp_rate = fp_rate;
+	b->elem_sz = elem_sz;
+	b->elem_hash = hash;
+	b->magic = MAGIC_INIT_VALUE;
+	return b;
+}
+
+/**
+ * Function: bloom_destroy
+ * ------------------------------------------------------
+ * Frees the blocks and the filter. The keys were never stored, so there is
+ * nothing else to clean up.
+ */
+void
+bloom_destroy (bloom *b)
+{
+	assert (b != NULL);
+	assert (b->magic == MAGIC_INIT_VALUE);
+
+	free (b->blocks);
+	free (b);
+}
+
+/**
+ * Function: bloom_add
+ * ------------------------------------------------------
+ * Sets in the key's block the one bit per word that its hash selects.
+ */
+void
+bloom_add (bloom *b, const void *key)
+{
+	assert (b != NULL && key != NULL);
+	assert (b->magic == MAGIC_INIT_VALUE);
+
+	uint64_t h = bloom_mix (b->elem_hash (key));
+	uint32_t *block = bloom_block (b, h);
+	size_t i;
+
+	for (i = 0; i < b->block_words; i++)
+	{
+		block[i] |= 1U << (((uint32_t)h * bloom_salts[i]) >> 27);
+	}
+	b->n_added++;
+}
+
+/**
+ * Function: bloom_contains
+ * ------------------------------------------------------
+ * Tests one key: true if every bit bloom_add would set is already set,
+ * which may be a false positive, and false only if the key was never added.
+ */
+bool
+bloom_contains (const bloom *b, const void *key)
+{
+	assert (b != NULL && key != NULL);
+	assert (b->magic == MAGIC_INIT_VALUE);
+
+	uint64_t h = bloom_mix (b->elem_hash (key));
+	uint32_t mask[BLOOM_BLOCK_WORDS];
+
+	bloom_masks ((uint32_t)h, b->block_words, mask);
+	return bloom_test_block (bloom_block (b, h), mask, b->block_words);
+}
+
+/**
+ * Function: bloom_contains_many
+ * ------------------------------------------------------
+ * Takes the keys BATCH at a time: hashes each and prefetches its block,
+ * then tests the batch, by which time the first blocks have arrived and
+ * the rest are on their way together.
+ */
+size_t
+bloom_contains_many (const bloom *b, const void *keys, size_t n, bool *maybe)
+{
+	assert (b != NULL && (n == 0 || (keys != NULL && maybe != NULL)));
+	assert (b->magic == MAGIC_INIT_VALUE);
+
+	const uint8_t *key = keys;
+	uint32_t *blocks[BATCH], xs[BATCH];
+	size_t i, j, m, count = 0;
+	uint64_t h;
+#ifdef BLOOM_X86
+	bool avx2 = b->block_words >= 8 && __builtin_cpu_supports ("avx2");
+#endif
+
+	for (i = 0; i < n; i += m)
+	{
+		m = (n - i < BATCH) ? n - i : BATCH;
+		for (j = 0; j < m; j++, key += b->elem_sz)
+		{
+			h = bloom_mix (b->elem_hash (key));
+			blocks[j] = bloom_block (b, h);
+			xs[j] = (uint32_t)h;
+			__builtin_prefetch (blocks[j]);
+		}
+
+#ifdef BLOOM_X86
+		if (avx2)
+		{
+			count += bloom_test_group_avx2 (b, blocks, xs, m, maybe + i);
+			continue;
+		}
+#endif
+		count += bloom_test_group (b, blocks, xs, m, maybe + i);
+	}
+	return count;
+}
+
+/**
+ * Function: bloom_clear
+ * ------------------------------------------------------
+ * Clears every bit and the count of added keys, keeping the size.
+ */
+void
+bloom_clear (bloom *b)
+{
+	assert (b != NULL);
+	assert (b->magic == MAGIC_INIT_VALUE);
+
+	memset (b->blocks, 0, b->n_blocks * b->block_words * sizeof (uint32_t));
+	b->n_added = 0;
+}
+
+/**
+ * Function: bloom_bytes
+ * ------------------------------------------------------
+ * Counts the bytes the filter holds, the struct and its blocks.
+ */
+size_t
+bloom_bytes (const bloom *b)
+{
+	assert (b != NULL);
+	assert (b->magic == MAGIC_INIT_VALUE);
+
+	return sizeof (bloom) + b->n_blocks * b->block_words * sizeof (uint32_t);
+}
+
+/**
+ * Function: bloom_fp_rate
+ * ------------------------------------------------------
+ * Estimates the false positive rate from the keys added so far, which
+ * passes the rate asked of bloom_init once more than capacity are added.
+ */
+double
+bloom_fp_rate (const bloom *b)
+{
+	assert (b != NULL);
+	assert (b->magic == MAGIC_INIT_VALUE);
+
+	return (b->n_added == 0) ? 0.0 : bloom_expected_fp (b->n_added, b->n_blocks, b->block_words);
+}
@@ -0,0 +1,376 @@
+/**
+ * File: Columns.c
+ * Author: Seth Charles
+ * ----------------------
+ */
+#include "Columns.h"
+#include <assert.h>
+#include <string.h>
+
+#define MAGIC_INIT_VALUE     (0x6e1f3a94c85b07d2)
+#define DEFAULT_CAPACITY     (16UL)
+#define CELL(C, F, I)        ((C)->cols[F] + (I) * (C)->field_sz[F])
+#define ROUND_UP(N, A)       (((N) + (A) - 1) / (A) * (A))
+
+/**
+ * Function: columns_copy
+ * ------------------------------------------------------
+ * Copies one field. The common sizes are spelled out so that the loops over
+ * a whole column compile to plain loads and stores rather than a call to
+ * memcpy per value.
+ */
+static inline void
+columns_copy (void *dst, const void *src, size_t sz)
+{
+	switch (sz)
+	{
+	case 1: memcpy (dst, src, 1); break;
+	case 2: memcpy (dst, src, 2); break;
+	case 4: memcpy (dst, src, 4); break;
+	case 8: memcpy (dst, src, 8); break;
+	default: memcpy (dst, src, sz); break;
+	}
+}
+
+/**
+ * Function: columns_alloc
+ * ------------------------------------------------------
+ * Allocates an array for capacity values of one field, aligned to a cache
+ * line so that vector loads over it never split a line.
+ */
+static uint8_t *
+columns_alloc (size_t capacity, size_t field_sz)
+{
+	uint8_t *col = aligned_alloc (CACHE_LINE_SZ, ROUND_UP (capacity * field_sz, CACHE_LINE_SZ));
+	assert (col != NULL);
+
+	return col;
+}
+
+/**
+ * Function: columns_set_capacity
+ * ------------------------------------------------------
+ * Moves every column to an array of the new capacity. aligned_alloc has no
+ * realloc, so the values are copied.
+ */
+static void
+columns_set_capacity (columns *c, size_t capacity)
+{
+	uint8_t *col;
+	size_t f;
+
+	for (f = 0; f < c->n_fields; f++)
+	{
+		col = columns_alloc (capacity, c->field_sz[f]);
+		if (c->cols[f] != NULL)
+		{
+			memcpy (col, c->cols[f], c->n_rows * c->field_sz[f]);
+			free (c->cols[f]);
+		}
+		c->cols[f] = col;
+	}
+	c->capacity = capacity;
+}
+
+/**
+ * Function: columns_init
+ * ------------------------------------------------------
+ * Public function to perform columns initialization
+ *
+ * param n_fields      - the number of fields in a row
+ * param field_sz      - the size of each field in bytes
+ * param field_off     - the offset of each field in a row, or NULL for rows
+ *                       of packed fields
+ * param row_sz        - the size of a row in bytes
+ * param capacity_hint - a capacity suggestion for initialization
+ *
+ * returns - a pointer to the columns object
+ */
+columns *
+columns_init (size_t n_fields, const size_t *field_sz, const size_t *field_off,
+              size_t row_sz, size_t capacity_hint)
+{
+	assert (n_fields > 0);
+	assert (field_sz != NULL);
+	columns *c;
+	size_t f, off = 0;
+
+	c = calloc (1, sizeof (columns));
+	assert (c != NULL);
+
+	c->cols = calloc (n_fields, sizeof (uint8_t *));
+	c->field_sz = malloc (n_fields * sizeof (size_t));
+	c->field_off = malloc (n_fields * sizeof (size_t));
+	assert (c->cols != NULL && c->field_sz != NULL && c->field_off != NULL);
+
+	for (f = 0; f < n_fields; f++)
+	{
+		assert (field_sz[f] > 0);
+		c->field_sz[f] = field_sz[f];
+		c->field_off[f] = (field_off != NULL) ? field_off[f] : off;
+		off += field_sz[f];
+		assert (c->field_off[f] + field_sz[f] <= row_sz);
+	}
+
+	c->n_fields = n_fields;
+	c->row_sz = row_sz;
+	c->magic = MAGIC_INIT_VALUE;
+
+	columns_set_capacity (c, (capacity_hint == 0) ? DEFAULT_CAPACITY : capacity_hint);
+
+	return c;
+}
+
+/**
+ * Function: columns_destroy
+ * ------------------------------------------------------
+ * Frees every column array along with the field layout and the object.
+ *
+ * param c - the columns to destroy
+ */
+void
+columns_destroy (columns *c)
+{
+	assert (c != NULL);
+	assert (c->magic == MAGIC_INIT_VALUE);
+	size_t f;
+
+	for (f = 0; f < c->n_fields; f++)
+	{
+		free (c->cols[f]);
+	}
+	free (c->cols);
+	free (c->field_sz);
+	free (c->field_off);
+	free (c);
+}
+
+/**
+ * Function: columns_size
+ * ------------------------------------------------------
+ * Returns the number of rows.
+ *
+ * param c - initialized columns
+ */
+size_t
+columns_size (const columns *c)
+{
+	assert (c != NULL);
+	assert (c->magic == MAGIC_INIT_VALUE);
+
+	return c->n_rows;
+}
+
+/**
+ * Function: columns_column
+ * ------------------------------------------------------
+ * Returns the start of a field's column, which holds that field of every
+ * row packed together. The pointer is good until the next append.
+ *
+ * param c     - initialized columns
+ * param field - the index of the field
+ */
+void *
+columns_column (columns *c, size_t field)
+{
+	assert (c != NULL);
+	assert (c->magic == MAGIC_INIT_VALUE);
+	assert (field < c->n_fields);
+
+	return c->cols[field];
+}
+
+/**
+ * Function: columns_at
+ * ------------------------------------------------------
+ * Returns one field of one row.
+ *
+ * param c     - initialized columns
+ * param row   - the index of the row, less than the size
+ * param field - the index of the field
+ */
+void *
+columns_at (columns *c, size_t row, size_t field)
+{
+	assert (c != NULL);
+	assert (c->magic == MAGIC_INIT_VALUE);
+	assert (row < c->n_rows && field < c->n_fields);
+
+	return CELL (c, field, row);
+}
+
+/**
+ * Function: columns_append
+ * ------------------------------------------------------
+ * Scatters the fields of a row struct to the ends of their columns.
+ */
+void
+columns_append (columns *c, const void *row)
+{
+	assert (c != NULL);
+	assert (row != NULL);
+	assert (c->magic == MAGIC_INIT_VALUE);
+	size_t f;
+
+	if (c->n_rows == c->capacity)
+	{
+		columns_set_capacity (c, c->capacity * 2);
+	}
+
+	for (f = 0; f < c->n_fields; f++)
+	{
+		columns_copy (CELL (c, f, c->n_rows), (const uint8_t *)row + c->field_off[f], c->field_sz[f]);
+	}
+	++c->n_rows;
+}
+
+/**
+ * Function: columns_get
+ * ------------------------------------------------------
+ * Gathers the fields of a row into a row struct.
+ */
+void
+columns_get (const columns *c, size_t row, void *out)
+{
+	assert (c != NULL);
+	assert (out != NULL);
+	assert (c->magic == MAGIC_INIT_VALUE);
+	assert (row < c->n_rows);
+	size_t f;
+
+	for (f = 0; f < c->n_fields; f++)
+	{
+		columns_copy ((uint8_t *)out + c->field_off[f], CELL (c, f, row), c->field_sz[f]);
+	}
+}
+
+/**
+ * Function: columns_sort
+ * ------------------------------------------------------
+ * Sorts entries of a copy of the key and its row number, with the key first
+ * so the compare function can be called on an entry as it is. The sorted row
+ * numbers are the permutation, which each column then gathers through into
+ * a fresh array. Only the key column is moved during the sort itself, rather
+ * than whole rows.
+ *
+ * param c     - initialized columns
+ * param field - the field to sort by
+ * param fn    - the compare function for that field
+ */
+void
+columns_sort (columns *c, size_t field, compare_fn fn)
+{
+	assert (c != NULL);
+	assert (fn != NULL);
+	assert (c->magic == MAGIC_INIT_VALUE);
+	assert (field < c->n_fields);
+	size_t key_sz = ROUND_UP (c->field_sz[field], sizeof (size_t));
+	size_t entry_sz = key_sz + sizeof (size_t), f, i, sz;
+	uint8_t *entry, *col;
+	size_t *perm;
+	vector *entries;
+
+	entries = vector_init (entry_sz, c->n_rows, NULL);
+	entry = calloc (1, entry_sz);
+	assert (entry != NULL);
+	for (i = 0; i < c->n_rows; i++)
+	{
+		memcpy (entry, CELL (c, field, i), c->field_sz[field]);
+		memcpy (entry + key_sz, &i, sizeof (size_t));
+		vector_append (entries, entry);
+	}
+	free (entry);
+	vector_sort_stable (entries, fn);
+
+	/* pull the row numbers together so every column reads them in order */
+	perm = malloc ((c->n_rows + 1) * sizeof (size_t));
+	assert (perm != NULL);
+	for (i = 0; i < c->n_rows; i++)
+	{
+		memcpy (&perm[i], (uint8_t *)vector_access (entries, i) + key_sz, sizeof (size_t));
+	}
+	vector_destroy (entries);
+
+	for (f = 0; f < c->n_fields; f++)
+	{
+		sz = c->field_sz[f];
+		col = columns_alloc (c->capacity, sz);
+		for (i = 0; i < c->n_rows; i++)
+		{
+			columns_copy (col + i * sz, CELL (c, f, perm[i]), sz);
+		}
+		free (c->cols[f]);
+		c->cols[f] = col;
+	}
+	free (perm);
+}
+
+/**
+ * Function: columns_clear
+ * ------------------------------------------------------
+ * Forgets every row, keeping the columns' storage.
+ *
+ * param c - initialized columns
+ */
+void
+columns_clear (columns *c)
+{
+	assert (c != NULL);
+	assert (c->magic == MAGIC_INIT_VALUE);
+
+	c->n_rows = 0;
+}
+
+/**
+ * Function: columns_from_vector
+ * ------------------------------------------------------
+ * Transposes a vector of row structs a row at a time, so the rows are read
+ * once and every column is written sequentially alongside the others.
+ */
+columns *
+columns_from_vector (const vector *v, size_t n_fields, const size_t *field_sz,
+                     const size_t *field_off)
+{
+	assert (v != NULL);
+	size_t n_rows = vector_size (v), f, i; /* vector_size checks v's magic value */
+	columns *c = columns_init (n_fields, field_sz, field_off, v->elem_sz, n_rows);
+	const uint8_t *rows = v->elems;
+
+	for (i = 0; i < n_rows; i++)
+	{
+		for (f = 0; f < n_fields; f++)
+		{
+			columns_copy (CELL (c, f, i), rows + i * v->elem_sz + c->field_off[f], c->field_sz[f]);
+		}
+	}
+	c->n_rows = n_rows;
+
+	return c;
+}
+
+/**
+ * Function: columns_to_vector
+ * ------------------------------------------------------
+ * Transposes the columns back into zeroed row structs a row at a time.
+ */
+vector *
+columns_to_vector (const columns *c)
+{
+	assert (c != NULL);
+	assert (c->magic == MAGIC_INIT_VALUE);
+	vector *v = vector_init (c->row_sz, c->n_rows, NULL);
+	uint8_t *rows = v->elems;
+	size_t f, i;
+
+	memset (rows, 0, c->n_rows * c->row_sz);
+	for (i = 0; i < c->n_rows; i++)
+	{
+		for (f = 0; f < c->n_fields; f++)
+		{
+			columns_copy (rows + i * c->row_sz + c->field_off[f], CELL (c, f, i), c->field_sz[f]);
+		}
+	}
+	v->n_elems = c->n_rows;
+
+	return v;
+}
@@ -0,0 +1,499 @@
+/**
+ * File: ConcurrentMap.c
+ * Author: Seth Charles
+ * ----------------------
+ */
+#include "ConcurrentMap.h"
+#include <assert.h>
+#include <sched.h>
+#include <string.h>
+
+#define MAGIC_INIT_VALUE       (0x1d6a8f35c07e92b4)
+#define HASH_MULTIPLIER        (0x9e3779b97f4a7c15ULL)
+#define MIN_SEGMENT_SLOTS      (16)
+#define SPINS_BEFORE_YIELD     (64)
+#define ROUND_UP(N)            (((N) + sizeof (size_t) - 1) & ~(sizeof (size_t) - 1))
+
+/*
+ * A table is a header of two words, the slot mask and a link to the table it
+ * replaced, followed by the slots. Each slot is a tag word, zero when the
+ * slot is empty, followed by the entry.
+ */
+#define TABLE_HDR_SZ           (2 * sizeof (size_t))
+#define TABLE_MASK(T)          (*(size_t *)(T))
+#define TABLE_RETIRED(T)       (*(uint8_t **)((T) + sizeof (size_t)))
+#define TABLE_SLOT(M, T, I)    ((T) + TABLE_HDR_SZ + (I) * (M)->slot_sz)
+#define SLOT_TAG(S)            ((atomic_size_t *)(S))
+#define SLOT_ENTRY(S)          ((S) + sizeof (size_t))
+#define SLOT_VAL(M, S)         (SLOT_ENTRY (S) + (M)->val_offset)
+#define TAG_HOME(TAG, MASK)    (((TAG) >> 1) & (MASK))
+
+/**
+ * Function: cmap_mix
+ * ------------------------------------------------------
+ * Folds a wide multiply of the client hash so that both the top bits, which
+ * pick the segment, and the low bits, which pick the slot, depend on every
+ * input bit.
+ */
+static uint64_t
+cmap_mix (size_t hash)
+{
+#ifdef __SIZEOF_INT128__
+	unsigned __int128 m = (unsigned __int128)hash * HASH_MULTIPLIER;
+	return (uint64_t)m ^ (uint64_t)(m >> 64);
+#else
+	uint64_t m = (uint64_t)hash * HASH_MULTIPLIER;
+	return m ^ (m >> 32);
+#endif
+}
+
+/**
+ * Function: cmap_segment_of
+ * ------------------------------------------------------
+ * Returns the segment for a mixed hash.
+ */
+static cmap_segment *
+cmap_segment_of (const concurrent_map *m, uint64_t mixed)
+{
+	return &m->segments[mixed >> (64 - CMAP_SEGMENT_BITS)];
+}
+
+/**
+ * Function: cmap_backoff
+ * ------------------------------------------------------
+ * Gives up the processor every so many spins, so that a thread waiting on
+ * a preempted writer lets that writer run.
+ */
+static void
+cmap_backoff (unsigned *spins)
+{
+	if (++*spins >= SPINS_BEFORE_YIELD)
+	{
+		sched_yield ();
+		*spins = 0;
+	}
+}
+
+static void
+cmap_lock (cmap_segment *seg)
+{
+	unsigned spins = 0;
+
+	while (atomic_flag_test_and_set_explicit (&seg->lock, memory_order_acquire))
+	{
+		cmap_backoff (&spins);
+	}
+}
+
+static void
+cmap_unlock (cmap_segment *seg)
+{
+	atomic_flag_clear_explicit (&seg->lock, memory_order_release);
+}
+
+/**
+ * Function: cmap_write_begin
+ * ------------------------------------------------------
+ * Makes the sequence count odd. The fence keeps the writer's slot stores
+ * from becoming visible before the odd count does. Only the lock holder
+ * calls this.
+ */
+static void
+cmap_write_begin (cmap_segment *seg)
+{
+	size_t seq = atomic_load_explicit (&seg->seq, memory_order_relaxed);
+
+	atomic_store_explicit (&seg->seq, seq + 1, memory_order_relaxed);
+	atomic_thread_fence (memory_order_release);
+}
+
+/**
+ * Function: cmap_write_end
+ * ------------------------------------------------------
+ * Makes the sequence count even again, publishing the writer's changes.
+ */
+static void
+cmap_write_end (cmap_segment *seg)
+{
+	size_t seq = atomic_load_explicit (&seg->seq, memory_order_relaxed);
+
+	atomic_store_explicit (&seg->seq, seq + 1, memory_order_release);
+}
+
+/**
+ * Function: cmap_table_new
+ * ------------------------------------------------------
+ * Allocates an empty table of n_slots slots, a power of two.
+ */
+static uint8_t *
+cmap_table_new (const concurrent_map *m, size_t n_slots)
+{
+	uint8_t *table = calloc (1, TABLE_HDR_SZ + n_slots * m->slot_sz);
+	assert (table != NULL);
+
+	TABLE_MASK (table) = n_slots - 1;
+	return table;
+}
+
+/**
+ * Function: cmap_find_slot
+ * ------------------------------------------------------
+ * Probes linearly from the tag's home slot for key. A reader may be racing
+ * a writer here, so the probe is bounded by the table length rather than
+ * trusting that an empty slot will turn up.
+ *
+ * returns - the slot holding key or NULL
+ */
+static uint8_t *
+cmap_find_slot (const concurrent_map *m, uint8_t *table, const void *key,
+                size_t tag)
+{
+	size_t mask = TABLE_MASK (table), i = TAG_HOME (tag, mask), n, t;
+	uint8_t *slot;
+
+	for (n = 0; n <= mask; n++)
+	{
+		slot = TABLE_SLOT (m, table, i);
+		t = atomic_load_explicit (SLOT_TAG (slot), memory_order_relaxed);
+		if (t == 0)
+		{
+			break;
+		}
+		if (t == tag && m->key_cmp (SLOT_ENTRY (slot), key) == 0)
+		{
+			return slot;
+		}
+		i = (i + 1) & mask;
+	}
+
+	return NULL;
+}
+
+/**
+ * Function: cmap_find_empty
+ * ------------------------------------------------------
+ * Returns the first empty slot on the probe sequence of tag. Called only by
+ * the lock holder, on a table that is never full.
+ */
+static uint8_t *
+cmap_find_empty (const concurrent_map *m, uint8_t *table, size_t tag)
+{
+	size_t mask = TABLE_MASK (table), i = TAG_HOME (tag, mask);
+
+	while (atomic_load_explicit (SLOT_TAG (TABLE_SLOT (m, table, i)), memory_order_relaxed))
+	{
+		i = (i + 1) & mask;
+	}
+
+	return TABLE_SLOT (m, table, i);
+}
+
+/**
+ * Function: cmap_grow
+ * ------------------------------------------------------
+ * Copies the segment into a table twice as long while readers carry on with
+ * the old one, then swaps it in. Readers that started on the old table see
+ * the sequence count move and retry on the new one. The old table is kept,
+ * linked from the new one, until the map is destroyed, because a reader may
+ * still be partway through it.
+ */
+static void
+cmap_grow (concurrent_map *m, cmap_segment *seg)
+{
+	uint8_t *old = atomic_load_explicit (&seg->table, memory_order_relaxed);
+	uint8_t *table = cmap_table_new (m, (TABLE_MASK (old) + 1) * 2);
+	uint8_t *src, *dst;
+	size_t i, tag;
+
+	for (i = 0; i <= TABLE_MASK (old); i++)
+	{
+		src = TABLE_SLOT (m, old, i);
+		tag = atomic_load_explicit (SLOT_TAG (src), memory_order_relaxed);
+		if (tag != 0)
+		{
+			dst = cmap_find_empty (m, table, tag);
+			memcpy (dst, src, m->slot_sz);
+		}
+	}
+	TABLE_RETIRED (table) = old;
+
+	cmap_write_begin (seg);
+	atomic_store_explicit (&seg->table, table, memory_order_release);
+	cmap_write_end (seg);
+}
+
+/**
+ * Function: concurrent_map_init
+ * ------------------------------------------------------
+ * Public function to perform map initialization
+ *
+ * param key_sz - the size of keys in bytes
+ * param val_sz - the size of values in bytes
+ * param hash   - the hash function for keys
+ * param cmp    - the compare function for keys, zero meaning equal
+ * param fn     - the cleanup function to call on a removed entry
+ *
+ * returns - a pointer to the map object
+ */
+concurrent_map *
+concurrent_map_init (size_t key_sz, size_t val_sz, hash_fn hash, compare_fn cmp,
+                     elem_destroy_fn fn)
+{
+	assert (key_sz > 0);
+	assert (val_sz > 0);
+	assert (hash != NULL);
+	assert (cmp != NULL);
+	concurrent_map *m;
+	size_t i;
+
+	m = calloc (1, sizeof (concurrent_map));
+	assert (m != NULL);
+
+	m->key_sz = key_sz;
+	m->val_sz = val_sz;
+	m->val_offset = ROUND_UP (key_sz);
+	m->slot_sz = sizeof (size_t) + m->val_offset + ROUND_UP (val_sz);
+	m->key_hash = hash;
+	m->key_cmp = cmp;
+	m->elem_destroy = fn;
+	m->magic = MAGIC_INIT_VALUE;
+
+	m->segments = aligned_alloc (CACHE_LINE_SZ, CMAP_SEGMENTS * sizeof (cmap_segment));
+	assert (m->segments != NULL);
+
+	for (i = 0; i < CMAP_SEGMENTS; i++)
+	{
+		atomic_init (&m->segments[i].seq, 0);
+		atomic_flag_clear (&m->segments[i].lock);
+		atomic_init (&m->segments[i].table, cmap_table_new (m, MIN_SEGMENT_SLOTS));
+		atomic_init (&m->segments[i].n_elems, 0);
+	}
+
+	return m;
+}
+
+/**
+ * Function: concurrent_map_destroy
+ * ------------------------------------------------------
+ * Destroys every entry, then frees each segment's table along with every
+ * table it replaced.
+ */
+void
+concurrent_map_destroy (concurrent_map *m)
+{
+	assert (m != NULL);
+	assert (m->magic == MAGIC_INIT_VALUE);
+	uint8_t *table, *retired, *slot;
+	size_t i, j;
+
+	for (i = 0; i < CMAP_SEGMENTS; i++)
+	{
+		table = atomic_load (&m->segments[i].table);
+
+		for (j = 0; m->elem_destroy && j <= TABLE_MASK (table); j++)
+		{
+			slot = TABLE_SLOT (m, table, j);
+			if (atomic_load_explicit (SLOT_TAG (slot), memory_order_relaxed))
+			{
+				m->elem_destroy (SLOT_ENTRY (slot));
+			}
+		}
+
+		for (; table != NULL; table = retired)
+		{
+			retired = TABLE_RETIRED (table);
+			free (table);
+		}
+	}
+
+	free (m->segments);
+	free (m);
+}
+
+/**
+ * Function: concurrent_map_size
+ * ------------------------------------------------------
+ * Sums the segments' counts without locking them, so while writers run the
+ * result is only approximate.
+ */
+size_t
+concurrent_map_size (const concurrent_map *m)
+{
+	assert (m != NULL);
+	assert (m->magic == MAGIC_INIT_VALUE);
+	size_t i, n = 0;
+
+	for (i = 0; i < CMAP_SEGMENTS; i++)
+	{
+		n += atomic_load_explicit (&m->segments[i].n_elems, memory_order_relaxed);
+	}
+
+	return n;
+}
+
+/**
+ * Function: concurrent_map_get
+ * ------------------------------------------------------
+ * Reads the segment optimistically. If the sequence count was odd at the
+ * start, or differs at the end, a writer overlapped the read and it is
+ * retried.
+ */
+bool
+concurrent_map_get (const concurrent_map *m, const void *key, void *out)
+{
+	assert (m != NULL);
+	assert (key != NULL);
+	assert (m->magic == MAGIC_INIT_VALUE);
+	uint64_t mixed = cmap_mix (m->key_hash (key));
+	cmap_segment *seg = cmap_segment_of (m, mixed);
+	uint8_t *table, *slot;
+	size_t seq;
+	unsigned spins = 0;
+
+	for (;;)
+	{
+		seq = atomic_load_explicit (&seg->seq, memory_order_acquire);
+		if (seq & 1)
+		{
+			cmap_backoff (&spins);
+			continue;
+		}
+
+		table = atomic_load_explicit (&seg->table, memory_order_acquire);
+		slot = cmap_find_slot (m, table, key, mixed | 1);
+		if (slot != NULL && out != NULL)
+		{
+			memcpy (out, SLOT_VAL (m, slot), m->val_sz);
+		}
+
+		atomic_thread_fence (memory_order_acquire);
+		if (atomic_load_explicit (&seg->seq, memory_order_relaxed) == seq)
+		{
+			return slot != NULL;
+		}
+	}
+}
+
+/**
+ * Function: concurrent_map_put
+ * ------------------------------------------------------
+ * Inserts or overwrites under the segment's lock. A new key first grows the
+ * segment if it would pass three quarters full. The entry is written inside
+ * the sequence count so that optimistic readers retry rather than see it
+ * half written.
+ */
+bool
+concurrent_map_put (concurrent_map *m, const void *key, const void *value)
+{
+	assert (m != NULL);
+	assert (key != NULL);
+	assert (value != NULL);
+	assert (m->magic == MAGIC_INIT_VALUE);
+	uint64_t mixed = cmap_mix (m->key_hash (key));
+	cmap_segment *seg = cmap_segment_of (m, mixed);
+	size_t tag = mixed | 1, n_slots;
+	uint8_t *table, *slot;
+	bool added;
+
+	cmap_lock (seg);
+
+	table = atomic_load_explicit (&seg->table, memory_order_relaxed);
+	slot = cmap_find_slot (m, table, key, tag);
+	added = (slot == NULL);
+
+	if (added)
+	{
+		/* segments are kept at most three quarters full */
+		n_slots = TABLE_MASK (table) + 1;
+		if (atomic_load_explicit (&seg->n_elems, memory_order_relaxed) + 1 > n_slots - n_slots / 4)
+		{
+			cmap_grow (m, seg);
+			table = atomic_load_explicit (&seg->table, memory_order_relaxed);
+		}
+		slot = cmap_find_empty (m, table, tag);
+	}
+
+	cmap_write_begin (seg);
+	if (!added && m->elem_destroy)
+	{
+		m->elem_destroy (SLOT_ENTRY (slot));
+	}
+	memcpy (SLOT_ENTRY (slot), key, m->key_sz);
+	memcpy (SLOT_VAL (m, slot), value, m->val_sz);
+	atomic_store_explicit (SLOT_TAG (slot), tag, memory_order_relaxed);
+	cmap_write_end (seg);
+
+	if (added)
+	{
+		atomic_fetch_add_explicit (&seg->n_elems, 1, memory_order_relaxed);
+	}
+
+	cmap_unlock (seg);
+
+	return added;
+}
+
+/**
+ * Function: concurrent_map_remove
+ * ------------------------------------------------------
+ * Removes with backward shift deletion: entries after the hole that would
+ * still be found from their home slot if moved back are shifted into it, so
+ * the table never holds tombstones.
+ */
+bool
+concurrent_map_remove (concurrent_map *m, const void *key)
+{
+	assert (m != NULL);
+	assert (key != NULL);
+	assert (m->magic == MAGIC_INIT_VALUE);
+	uint64_t mixed = cmap_mix (m->key_hash (key));
+	cmap_segment *seg = cmap_segment_of (m, mixed);
+	uint8_t *table, *slot, *next;
+	size_t mask, hole, i, home, tag;
+
+	cmap_lock (seg);
+
+	table = atomic_load_explicit (&seg->table, memory_order_relaxed);
+	slot = cmap_find_slot (m, table, key, mixed | 1);
+	if (slot == NULL)
+	{
+		cmap_unlock (seg);
+		return false;
+	}
+
+	mask = TABLE_MASK (table);
+	hole = (size_t)(slot - TABLE_SLOT (m, table, 0)) / m->slot_sz;
+
+	cmap_write_begin (seg);
+	if (m->elem_destroy)
+	{
+		m->elem_destroy (SLOT_ENTRY (slot));
+	}
+
+	for (i = (hole + 1) & mask; ; i = (i + 1) & mask)
+	{
+		next = TABLE_SLOT (m, table, i);
+		tag = atomic_load_explicit (SLOT_TAG (next), memory_order_relaxed);
+		if (tag == 0)
+		{
+			break;
+		}
+
+		/* an entry whose home lies cyclically in (hole, i] must stay put */
+		home = TAG_HOME (tag, mask);
+		if ((hole <= i) ? (hole < home && home <= i) : (hole < home || home <= i))
+		{
+			continue;
+		}
+
+		memcpy (TABLE_SLOT (m, table, hole), next, m->slot_sz);
+		hole = i;
+	}
+	atomic_store_explicit (SLOT_TAG (TABLE_SLOT (m, table, hole)), 0, memory_order_relaxed);
+	cmap_write_end (seg);
+
+	atomic_fetch_sub_explicit (&seg->n_elems, 1, memory_order_relaxed);
+	cmap_unlock (seg);
+
+	return true;
+}
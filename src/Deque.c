@@ -0,0 +1,435 @@
+/**
+ * File: Deque.c
+ * Author: Seth Charles
+ * ----------------------
+ */
+#include "Deque.h"
+#include <assert.h>
+#include <string.h>
+#include <stdio.h>
+
+#define DEFAULT_CAPACITY       (16UL)
+#define GET_PTR_SLOT(D, SLOT)  ((char *)(D->elems) + ((SLOT) * (D->elem_sz)))
+#define SLOT_OF(D, INDEX)      (((D)->head + (INDEX)) & (D)->mask)
+#define MAGIC_INIT_VALUE       (0x739caf14a2d9e85f)
+
+/**
+ * Function: deque_copy_in
+ * ------------------------------------------------------
+ * Copies n elements from a flat array into the circular buffer starting at
+ * slot. A run that wraps past the end of the buffer takes two copies.
+ */
+static void
+deque_copy_in (deque *d, size_t slot, const void *src, size_t n)
+{
+	size_t first = d->mask + 1 - slot;
+
+	if (first > n)
+	{
+		first = n;
+	}
+
+	memcpy (GET_PTR_SLOT (d, slot), src, first * d->elem_sz);
+	memcpy (d->elems, (const char *)src + first * d->elem_sz, (n - first) * d->elem_sz);
+}
+
+/**
+ * Function: deque_copy_out
+ * ------------------------------------------------------
+ * Copies n elements starting at slot out of the circular buffer into a flat
+ * array. A run that wraps past the end of the buffer takes two copies.
+ */
+static void
+deque_copy_out (const deque *d, size_t slot, void *dst, size_t n)
+{
+	size_t first = d->mask + 1 - slot;
+
+	if (first > n)
+	{
+		first = n;
+	}
+
+	memcpy (dst, GET_PTR_SLOT (d, slot), first * d->elem_sz);
+	memcpy ((char *)dst + first * d->elem_sz, d->elems, (n - first) * d->elem_sz);
+}
+
+/**
+ * Function: deque_destroy_range
+ * ------------------------------------------------------
+ * Calls the destroy function on n elements starting at logical index.
+ */
+static void
+deque_destroy_range (deque *d, size_t index, size_t n)
+{
+	size_t i;
+
+	if (d->elem_destroy)
+	{
+		for (i = 0; i < n; i++)
+		{
+			d->elem_destroy (GET_PTR_SLOT (d, SLOT_OF (d, index + i)));
+		}
+	}
+}
+
+/**
+ * Function: deque_reserve
+ * ------------------------------------------------------
+ * Module function to grow the buffer until it holds n_needed elements. The
+ * contents are unwrapped into the new buffer so that the front element lands
+ * in slot 0.
+ *
+ * param d        - a pointer to the deque to resize
+ * param n_needed - the number of elements the deque must be able to hold
+ */
+static void
+deque_reserve (deque *d, size_t n_needed)
+{
+	size_t new_capacity = d->mask + 1;
+	void *larger;
+
+	if (n_needed <= new_capacity)
+	{
+		return;
+	}
+
+	while (new_capacity < n_needed)
+	{
+		new_capacity *= 2;
+	}
+
+	larger = malloc (new_capacity * d->elem_sz);
+	assert (larger != NULL);
+
+	deque_copy_out (d, d->head, larger, d->n_elems);
+	free (d->elems);
+
+	d->elems = larger;
+	d->mask = new_capacity - 1;
+	d->head = 0;
+}
+
+/**
+ * Function: deque_init
+ * ------------------------------------------------------
+ * Public function to perform deque initialization
+ *
+ * param elem_sz       - the size of elements in bytes that are stored
+ * param capacity_hint - a capacity suggestion for initialization
+ * param fn            - the cleanup function to call when an element is destroyed
+ *
+ * returns - a pointer to the deque object
+ */
+deque *
+deque_init (size_t elem_sz, size_t capacity_hint, elem_destroy_fn fn)
+{
+	assert (elem_sz > 0);
+	deque *d;
+	size_t capacity = 1;
+
+	d = (deque *)malloc (sizeof (deque));
+	assert (d != NULL);
+
+	if (capacity_hint == 0)
+	{
+		capacity_hint = DEFAULT_CAPACITY;
+	}
+
+	while (capacity < capacity_hint)
+	{
+		capacity *= 2;
+	}
+
+	d->elems = malloc (capacity * elem_sz);
+	assert (d->elems != NULL);
+
+	d->mask = capacity - 1;
+	d->head = 0;
+	d->elem_sz = elem_sz;
+	d->n_elems = 0;
+	d->elem_destroy = fn;
+	d->magic = MAGIC_INIT_VALUE;
+
+	return d;
+}
+
+/**
+ * Function: deque_destroy
+ * ------------------------------------------------------
+ * Destroys the deque and deallocates all the memory used for it. Also calls
+ * the provided element destroy function on individual elements.
+ *
+ * param d - the deque to destroy
+ */
+void
+deque_destroy (deque *d)
+{
+	assert (d != NULL);
+	assert (d->magic == MAGIC_INIT_VALUE);
+
+	deque_clear (d);
+	free (d->elems);
+	free (d);
+}
+
+/**
+ * Function: deque_size
+ * ------------------------------------------------------
+ */
+size_t
+deque_size (const deque *d)
+{
+	assert (d != NULL);
+	assert (d->magic == MAGIC_INIT_VALUE);
+
+	return d->n_elems;
+}
+
+/**
+ * Function: deque_access
+ * ------------------------------------------------------
+ * Provides a pointer to the element index places from the front
+ *
+ * param d     - initialized deque
+ * param index - the index to access
+ *
+ * returns     - a pointer to the element
+ */
+void *
+deque_access (deque *d, size_t index)
+{
+	assert (d != NULL);
+	assert (d->magic == MAGIC_INIT_VALUE);
+
+	return GET_PTR_SLOT (d, SLOT_OF (d, index));
+}
+
+/**
+ * Function: deque_front
+ * ------------------------------------------------------
+ */
+void *
+deque_front (deque *d)
+{
+	assert (d != NULL);
+	assert (d->magic == MAGIC_INIT_VALUE);
+
+	return (d->n_elems == 0) ? NULL : GET_PTR_SLOT (d, d->head);
+}
+
+/**
+ * Function: deque_back
+ * ------------------------------------------------------
+ */
+void *
+deque_back (deque *d)
+{
+	assert (d != NULL);
+	assert (d->magic == MAGIC_INIT_VALUE);
+
+	return (d->n_elems == 0) ? NULL : GET_PTR_SLOT (d, SLOT_OF (d, d->n_elems - 1));
+}
+
+/**
+ * Function: deque_push_front
+ * ------------------------------------------------------
+ * Steps the head back one slot, wrapping through the mask, and copies the
+ * element there.
+ *
+ * param d    - initialized deque
+ * param elem - a pointer to the new element data to push by copy
+ */
+void
+deque_push_front (deque *d, const void *elem)
+{
+	assert (d != NULL);
+	assert (elem != NULL);
+	assert (d->magic == MAGIC_INIT_VALUE);
+
+	deque_reserve (d, d->n_elems + 1);
+
+	d->head = (d->head - 1) & d->mask;
+	memcpy (GET_PTR_SLOT (d, d->head), elem, d->elem_sz);
+	++d->n_elems;
+}
+
+/**
+ * Function: deque_push_back
+ * ------------------------------------------------------
+ * Copies the element into the slot after the back element.
+ *
+ * param d    - initialized deque
+ * param elem - a pointer to the new element data to push by copy
+ */
+void
+deque_push_back (deque *d, const void *elem)
+{
+	assert (d != NULL);
+	assert (elem != NULL);
+	assert (d->magic == MAGIC_INIT_VALUE);
+
+	deque_reserve (d, d->n_elems + 1);
+
+	memcpy (GET_PTR_SLOT (d, SLOT_OF (d, d->n_elems)), elem, d->elem_sz);
+	++d->n_elems;
+}
+
+/**
+ * Function: deque_pop_front
+ * ------------------------------------------------------
+ * Removes the front element, handing it to the client or destroying it.
+ *
+ * param d   - initialized non empty deque
+ * param out - where to copy the element, or NULL to destroy it
+ */
+void
+deque_pop_front (deque *d, void *out)
+{
+	assert (d != NULL);
+	assert (d->magic == MAGIC_INIT_VALUE);
+	assert (d->n_elems > 0);
+
+	deque_pop_front_many (d, out, 1);
+}
+
+/**
+ * Function: deque_pop_back
+ * ------------------------------------------------------
+ * Removes the back element, handing it to the client or destroying it.
+ *
+ * param d   - initialized non empty deque
+ * param out - where to copy the element, or NULL to destroy it
+ */
+void
+deque_pop_back (deque *d, void *out)
+{
+	assert (d != NULL);
+	assert (d->magic == MAGIC_INIT_VALUE);
+	assert (d->n_elems > 0);
+
+	deque_pop_back_many (d, out, 1);
+}
+
+/**
+ * Function: deque_push_front_many
+ * ------------------------------------------------------
+ * Grows at most once, then copies the whole array in ahead of the head.
+ *
+ * param d     - initialized deque
+ * param elems - the array of elements to push by copy
+ * param n     - the number of elements in the array
+ */
+void
+deque_push_front_many (deque *d, const void *elems, size_t n)
+{
+	assert (d != NULL);
+	assert (elems != NULL || n == 0);
+	assert (d->magic == MAGIC_INIT_VALUE);
+
+	deque_reserve (d, d->n_elems + n);
+
+	d->head = (d->head - n) & d->mask;
+	deque_copy_in (d, d->head, elems, n);
+	d->n_elems += n;
+}
+
+/**
+ * Function: deque_push_back_many
+ * ------------------------------------------------------
+ * Grows at most once, then copies the whole array in after the back.
+ *
+ * param d     - initialized deque
+ * param elems - the array of elements to push by copy
+ * param n     - the number of elements in the array
+ */
+void
+deque_push_back_many (deque *d, const void *elems, size_t n)
+{
+	assert (d != NULL);
+	assert (elems != NULL || n == 0);
+	assert (d->magic == MAGIC_INIT_VALUE);
+
+	deque_reserve (d, d->n_elems + n);
+
+	deque_copy_in (d, SLOT_OF (d, d->n_elems), elems, n);
+	d->n_elems += n;
+}
+
+/**
+ * Function: deque_pop_front_many
+ * ------------------------------------------------------
+ * Removes the n front elements, handing them to the client or destroying
+ * them.
+ *
+ * param d   - initialized deque
+ * param out - where to copy the elements, or NULL to destroy them
+ * param n   - the number of elements to remove
+ */
+void
+deque_pop_front_many (deque *d, void *out, size_t n)
+{
+	assert (d != NULL);
+	assert (d->magic == MAGIC_INIT_VALUE);
+	assert (n <= d->n_elems);
+
+	if (out != NULL)
+	{
+		deque_copy_out (d, d->head, out, n);
+	}
+	else
+	{
+		deque_destroy_range (d, 0, n);
+	}
+
+	d->head = (d->head + n) & d->mask;
+	d->n_elems -= n;
+}
+
+/**
+ * Function: deque_pop_back_many
+ * ------------------------------------------------------
+ * Removes the n back elements, handing them to the client or destroying
+ * them.
+ *
+ * param d   - initialized deque
+ * param out - where to copy the elements, or NULL to destroy them
+ * param n   - the number of elements to remove
+ */
+void
+deque_pop_back_many (deque *d, void *out, size_t n)
+{
+	assert (d != NULL);
+	assert (d->magic == MAGIC_INIT_VALUE);
+	assert (n <= d->n_elems);
+
+	if (out != NULL)
+	{
+		deque_copy_out (d, SLOT_OF (d, d->n_elems - n), out, n);
+	}
+	else
+	{
+		deque_destroy_range (d, d->n_elems - n, n);
+	}
+
+	d->n_elems -= n;
+}
+
+/**
+ * Function: deque_clear
+ * ------------------------------------------------------
+ * Internally clears the entire deque and calls the provided destroy fuction
+ * on each element. Its previous storage capacity is not modified.
+ *
+ * param d - initialized deque
+ */
+void
+deque_clear (deque *d)
+{
+	assert (d != NULL);
+	assert (d->magic == MAGIC_INIT_VALUE);
+
+	deque_destroy_range (d, 0, d->n_elems);
+
+	d->head = 0;
+	d->n_elems = 0;
+}
@@ -0,0 +1,600 @@
+/**
+ * File: FlatSet.c
+ * Author: Seth Charles
+ * ----------------------
+ */
+#include "FlatSet.h"
+#include <assert.h>
+#include <string.h>
+
+#define MAGIC_INIT_VALUE       (0x2c7e91b5f04a8d63)
+#define ROUND_UP(N)            (((N) + sizeof (size_t) - 1) & ~(sizeof (size_t) - 1))
+#define GET_PTR_ELEM(S, INDEX) ((char *)((S)->elems->elems) + ((INDEX) * (S)->elems->elem_sz))
+
+/**
+ * Function: flat_set_search
+ * ------------------------------------------------------
+ * Binary searches the positions from lo up to hi for the first element not
+ * less than key. Each step halves the range by moving the base or not, with
+ * no early exit, so the compiler can choose the base without a branch and a
+ * lookup does not pay a misprediction at every level.
+ */
+static size_t
+flat_set_search (const flat_set *s, const void *key, size_t lo, size_t hi)
+{
+	size_t n = hi - lo, half;
+
+	if (n == 0)
+	{
+		return lo;
+	}
+
+	while (n > 1)
+	{
+		half = n / 2;
+		lo = (s->elem_cmp (GET_PTR_ELEM (s, lo + half - 1), key) < 0) ? lo + half : lo;
+		n -= half;
+	}
+
+	return lo + (s->elem_cmp (GET_PTR_ELEM (s, lo), key) < 0);
+}
+
+/**
+ * Function: flat_set_init
+ * ------------------------------------------------------
+ * Public function to perform flat_set initialization
+ *
+ * param elem_sz - the size of elements in bytes that are stored
+ * param cmp     - the compare function giving the order
+ * param fn      - the cleanup function to call when an element is destroyed
+ *
+ * returns - a pointer to the flat_set object
+ */
+flat_set *
+flat_set_init (size_t elem_sz, compare_fn cmp, elem_destroy_fn fn)
+{
+	assert (elem_sz > 0);
+	assert (cmp != NULL);
+	flat_set *s;
+
+	s = malloc (sizeof (flat_set));
+	assert (s != NULL);
+
+	s->elems = vector_init (elem_sz, 0, fn);
+	s->elem_cmp = cmp;
+	s->magic = MAGIC_INIT_VALUE;
+
+	return s;
+}
+
+/**
+ * Function: flat_set_destroy
+ * ------------------------------------------------------
+ * Destroys every element and frees the flat_set.
+ *
+ * param s - the flat_set to destroy
+ */
+void
+flat_set_destroy (flat_set *s)
+{
+	assert (s != NULL);
+	assert (s->magic == MAGIC_INIT_VALUE);
+
+	vector_destroy (s->elems);
+	free (s);
+}
+
+/**
+ * Function: flat_set_size
+ * ------------------------------------------------------
+ * Returns the number of elements in the flat_set.
+ *
+ * param s - initialized flat_set
+ */
+size_t
+flat_set_size (const flat_set *s)
+{
+	assert (s != NULL);
+	assert (s->magic == MAGIC_INIT_VALUE);
+
+	return s->elems->n_elems;
+}
+
+/**
+ * Function: flat_set_at
+ * ------------------------------------------------------
+ * Returns the element at a position in sorted order.
+ *
+ * param s     - initialized flat_set
+ * param index - the position, less than the size
+ *
+ * returns - a pointer to the element in the flat_set's storage
+ */
+void *
+flat_set_at (flat_set *s, size_t index)
+{
+	assert (s != NULL);
+	assert (s->magic == MAGIC_INIT_VALUE);
+	assert (index < s->elems->n_elems);
+
+	return GET_PTR_ELEM (s, index);
+}
+
+/**
+ * Function: flat_set_find
+ * ------------------------------------------------------
+ * Binary searches for the element equal to key.
+ *
+ * param s   - initialized flat_set
+ * param key - a pointer to an element comparing equal to the one wanted
+ *
+ * returns - a pointer to the element, or NULL if there is none
+ */
+void *
+flat_set_find (flat_set *s, const void *key)
+{
+	assert (s != NULL);
+	assert (key != NULL);
+	assert (s->magic == MAGIC_INIT_VALUE);
+	size_t i = flat_set_search (s, key, 0, s->elems->n_elems);
+
+	if (i == s->elems->n_elems || s->elem_cmp (GET_PTR_ELEM (s, i), key) != 0)
+	{
+		return NULL;
+	}
+
+	return GET_PTR_ELEM (s, i);
+}
+
+/**
+ * Function: flat_set_contains
+ * ------------------------------------------------------
+ * Returns whether an element equal to key is present.
+ *
+ * param s   - initialized flat_set
+ * param key - a pointer to the element to look for
+ */
+bool
+flat_set_contains (const flat_set *s, const void *key)
+{
+	return flat_set_find ((flat_set *)s, key) != NULL;
+}
+
+/**
+ * Function: flat_set_lower_bound
+ * ------------------------------------------------------
+ * Returns the position of the first element not less than key, or the size
+ * if every element is less.
+ *
+ * param s   - initialized flat_set
+ * param key - a pointer to the element to compare against
+ */
+size_t
+flat_set_lower_bound (const flat_set *s, const void *key)
+{
+	assert (s != NULL);
+	assert (key != NULL);
+	assert (s->magic == MAGIC_INIT_VALUE);
+
+	return flat_set_search (s, key, 0, s->elems->n_elems);
+}
+
+/**
+ * Function: flat_set_insert
+ * ------------------------------------------------------
+ * Finds the position of elem, then shifts the elements after it back one
+ * place and copies elem in, growing the vector if it is full.
+ *
+ * param s    - initialized flat_set
+ * param elem - a pointer to the element to copy in
+ *
+ * returns - false if an equal element was already present
+ */
+bool
+flat_set_insert (flat_set *s, const void *elem)
+{
+	assert (s != NULL);
+	assert (elem != NULL);
+	assert (s->magic == MAGIC_INIT_VALUE);
+	size_t n = s->elems->n_elems, i = flat_set_search (s, elem, 0, n);
+
+	if (i < n && s->elem_cmp (GET_PTR_ELEM (s, i), elem) == 0)
+	{
+		return false;
+	}
+
+	vector_reserve (s->elems, 1);
+	memmove (GET_PTR_ELEM (s, i + 1), GET_PTR_ELEM (s, i), (n - i) * s->elems->elem_sz);
+	memcpy (GET_PTR_ELEM (s, i), elem, s->elems->elem_sz);
+	++s->elems->n_elems;
+
+	return true;
+}
+
+/**
+ * Function: flat_set_insert_many
+ * ------------------------------------------------------
+ * Sorts a copy of the batch, then builds the merged array in a new vector.
+ * For each batch element the existing elements before it are found by a
+ * binary search over what remains and copied across as one run, so a small
+ * batch costs O(k log n) compares and a single pass of copying. The sort is
+ * stable, so of equal batch elements the first in elems is the one added,
+ * as a run of flat_set_insert calls would do. Skipped elements are left to
+ * the caller.
+ *
+ * param s     - initialized flat_set
+ * param elems - a flat array of n elements, in any order
+ * param n     - the number of elements in the batch
+ *
+ * returns - the number of elements added
+ */
+size_t
+flat_set_insert_many (flat_set *s, const void *elems, size_t n)
+{
+	assert (s != NULL);
+	assert (elems != NULL || n == 0);
+	assert (s->magic == MAGIC_INIT_VALUE);
+	size_t sz = s->elems->elem_sz, n_old = s->elems->n_elems;
+	size_t i = 0, j, run_end, k = 0;
+	char *dst, *elem;
+	vector batch, *merged;
+
+	if (n == 0)
+	{
+		return 0;
+	}
+
+	/* no cleanup function, the batch only holds copies */
+	vector_init_static (&batch, sz, n, NULL);
+	memcpy (batch.elems, elems, n * sz);
+	batch.n_elems = n;
+	vector_sort_stable (&batch, s->elem_cmp);
+
+	merged = vector_init (sz, n_old + n, s->elems->elem_destroy);
+	dst = merged->elems;
+
+	for (j = 0; j < n; j++)
+	{
+		elem = (char *)batch.elems + j * sz;
+		/* keeps the first of a run of equal elements, the earliest in elems */
+		if (j > 0 && s->elem_cmp (elem - sz, elem) == 0)
+		{
+			continue;
+		}
+
+		run_end = flat_set_search (s, elem, i, n_old);
+		memcpy (dst + k * sz, GET_PTR_ELEM (s, i), (run_end - i) * sz);
+		k += run_end - i;
+		i = run_end;
+
+		if (i < n_old && s->elem_cmp (GET_PTR_ELEM (s, i), elem) == 0)
+		{
+			continue;
+		}
+		memcpy (dst + k++ * sz, elem, sz);
+	}
+	memcpy (dst + k * sz, GET_PTR_ELEM (s, i), (n_old - i) * sz);
+	k += n_old - i;
+
+	vector_destroy (&batch);
+	merged->n_elems = k;
+
+	/* the elements moved to merged, so the old vector must not destroy them */
+	s->elems->n_elems = 0;
+	vector_destroy (s->elems);
+	s->elems = merged;
+
+	return k - n_old;
+}
+
+/**
+ * Function: flat_set_remove
+ * ------------------------------------------------------
+ * Destroys the element equal to key and closes the gap it leaves.
+ *
+ * param s   - initialized flat_set
+ * param key - a pointer to an element comparing equal to the one to remove
+ *
+ * returns - false if there was no such element
+ */
+bool
+flat_set_remove (flat_set *s, const void *key)
+{
+	assert (s != NULL);
+	assert (key != NULL);
+	assert (s->magic == MAGIC_INIT_VALUE);
+	size_t i = flat_set_search (s, key, 0, s->elems->n_elems);
+
+	if (i == s->elems->n_elems || s->elem_cmp (GET_PTR_ELEM (s, i), key) != 0)
+	{
+		return false;
+	}
+
+	flat_set_erase_range (s, i, i + 1);
+
+	return true;
+}
+
+/**
+ * Function: flat_set_erase_range
+ * ------------------------------------------------------
+ * Destroys the elements at positions first up to but not including last,
+ * then moves the elements after them forward with one memmove.
+ *
+ * param s     - initialized flat_set
+ * param first - the position of the first element to remove
+ * param last  - the position past the last element to remove
+ */
+void
+flat_set_erase_range (flat_set *s, size_t first, size_t last)
+{
+	assert (s != NULL);
+	assert (s->magic == MAGIC_INIT_VALUE);
+	assert (first <= last);
+	assert (last <= s->elems->n_elems);
+	size_t i;
+
+	if (s->elems->elem_destroy)
+	{
+		for (i = first; i < last; i++)
+		{
+			s->elems->elem_destroy (GET_PTR_ELEM (s, i));
+		}
+	}
+
+	memmove (GET_PTR_ELEM (s, first), GET_PTR_ELEM (s, last),
+	         (s->elems->n_elems - last) * s->elems->elem_sz);
+	s->elems->n_elems -= last - first;
+}
+
+/**
+ * Function: flat_set_clear
+ * ------------------------------------------------------
+ * Destroys every element, keeping the storage.
+ *
+ * param s - initialized flat_set
+ */
+void
+flat_set_clear (flat_set *s)
+{
+	assert (s != NULL);
+	assert (s->magic == MAGIC_INIT_VALUE);
+
+	vector_clear (s->elems);
+}
+
+/**
+ * Function: flat_map_init
+ * ------------------------------------------------------
+ * Public function to perform flat_map initialization. The entries live in a
+ * flat_set whose compare function sees whole entries; since each entry
+ * starts with its key, the client's key compare works on them unchanged.
+ *
+ * param key_sz - the size of keys in bytes
+ * param val_sz - the size of values in bytes
+ * param cmp    - the compare function for keys
+ * param fn     - the cleanup function to call on a destroyed entry
+ *
+ * returns - a pointer to the flat_map object
+ */
+flat_map *
+flat_map_init (size_t key_sz, size_t val_sz, compare_fn cmp, elem_destroy_fn fn)
+{
+	assert (key_sz > 0);
+	assert (val_sz > 0);
+	flat_map *m;
+
+	m = malloc (sizeof (flat_map));
+	assert (m != NULL);
+
+	m->key_sz = key_sz;
+	m->val_sz = val_sz;
+	m->val_offset = ROUND_UP (key_sz);
+	m->entries = flat_set_init (ROUND_UP (m->val_offset + val_sz), cmp, fn);
+	m->scratch = calloc (1, m->entries->elems->elem_sz);
+	assert (m->scratch != NULL);
+	m->magic = MAGIC_INIT_VALUE;
+
+	return m;
+}
+
+/**
+ * Function: flat_map_destroy
+ * ------------------------------------------------------
+ * Destroys every entry and frees the flat_map.
+ *
+ * param m - the flat_map to destroy
+ */
+void
+flat_map_destroy (flat_map *m)
+{
+	assert (m != NULL);
+	assert (m->magic == MAGIC_INIT_VALUE);
+
+	flat_set_destroy (m->entries);
+	free (m->scratch);
+	free (m);
+}
+
+/**
+ * Function: flat_map_size
+ * ------------------------------------------------------
+ * Returns the number of entries in the flat_map.
+ *
+ * param m - initialized flat_map
+ */
+size_t
+flat_map_size (const flat_map *m)
+{
+	assert (m != NULL);
+	assert (m->magic == MAGIC_INIT_VALUE);
+
+	return flat_set_size (m->entries);
+}
+
+/**
+ * Function: flat_map_find
+ * ------------------------------------------------------
+ * Looks the key up among the entries, which compare by their leading key.
+ *
+ * param m   - initialized flat_map
+ * param key - a pointer to the key
+ *
+ * returns - a pointer to the value stored under key, or NULL
+ */
+void *
+flat_map_find (flat_map *m, const void *key)
+{
+	assert (m != NULL);
+	assert (key != NULL);
+	assert (m->magic == MAGIC_INIT_VALUE);
+	char *entry = flat_set_find (m->entries, key);
+
+	return entry ? entry + m->val_offset : NULL;
+}
+
+/**
+ * Function: flat_map_lower_bound
+ * ------------------------------------------------------
+ * Returns the position of the first entry whose key is not less than key.
+ *
+ * param m   - initialized flat_map
+ * param key - a pointer to the key to compare against
+ */
+size_t
+flat_map_lower_bound (const flat_map *m, const void *key)
+{
+	assert (m != NULL);
+	assert (key != NULL);
+	assert (m->magic == MAGIC_INIT_VALUE);
+
+	return flat_set_lower_bound (m->entries, key);
+}
+
+/**
+ * Function: flat_map_key_at
+ * ------------------------------------------------------
+ * Returns the key of the entry at a position in key order.
+ *
+ * param m     - initialized flat_map
+ * param index - the position, less than the size
+ */
+void *
+flat_map_key_at (flat_map *m, size_t index)
+{
+	assert (m != NULL);
+	assert (m->magic == MAGIC_INIT_VALUE);
+
+	return flat_set_at (m->entries, index);
+}
+
+/**
+ * Function: flat_map_value_at
+ * ------------------------------------------------------
+ * Returns the value of the entry at a position in key order.
+ *
+ * param m     - initialized flat_map
+ * param index - the position, less than the size
+ */
+void *
+flat_map_value_at (flat_map *m, size_t index)
+{
+	assert (m != NULL);
+	assert (m->magic == MAGIC_INIT_VALUE);
+
+	return (char *)flat_set_at (m->entries, index) + m->val_offset;
+}
+
+/**
+ * Function: flat_map_insert
+ * ------------------------------------------------------
+ * Builds the entry in the scratch space and inserts it into the set.
+ *
+ * param m     - initialized flat_map
+ * param key   - a pointer to the key to copy in
+ * param value - a pointer to the value to copy in
+ *
+ * returns - false, leaving the map unchanged, if the key was present
+ */
+bool
+flat_map_insert (flat_map *m, const void *key, const void *value)
+{
+	assert (m != NULL);
+	assert (key != NULL);
+	assert (value != NULL);
+	assert (m->magic == MAGIC_INIT_VALUE);
+
+	memcpy (m->scratch, key, m->key_sz);
+	memcpy (m->scratch + m->val_offset, value, m->val_sz);
+
+	return flat_set_insert (m->entries, m->scratch);
+}
+
+/**
+ * Function: flat_map_insert_many
+ * ------------------------------------------------------
+ * Interleaves the parallel key and value arrays into entries, then merges
+ * them in as one flat_set batch.
+ */
+size_t
+flat_map_insert_many (flat_map *m, const void *keys, const void *values, size_t n)
+{
+	assert (m != NULL);
+	assert ((keys != NULL && values != NULL) || n == 0);
+	assert (m->magic == MAGIC_INIT_VALUE);
+	size_t entry_sz = m->entries->elems->elem_sz, i, n_added;
+	uint8_t *batch;
+
+	batch = calloc (n ? n : 1, entry_sz);
+	assert (batch != NULL);
+
+	for (i = 0; i < n; i++)
+	{
+		memcpy (batch + i * entry_sz, (const char *)keys + i * m->key_sz, m->key_sz);
+		memcpy (batch + i * entry_sz + m->val_offset,
+		        (const char *)values + i * m->val_sz, m->val_sz);
+	}
+
+	n_added = flat_set_insert_many (m->entries, batch, n);
+	free (batch);
+
+	return n_added;
+}
+
+/**
+ * Function: flat_map_remove
+ * ------------------------------------------------------
+ * Destroys the entry under key.
+ *
+ * param m   - initialized flat_map
+ * param key - a pointer to the key
+ *
+ * returns - false if there was no such entry
+ */
+bool
+flat_map_remove (flat_map *m, const void *key)
+{
+	assert (m != NULL);
+	assert (key != NULL);
+	assert (m->magic == MAGIC_INIT_VALUE);
+
+	return flat_set_remove (m->entries, key);
+}
+
+/**
+ * Function: flat_map_erase_range
+ * ------------------------------------------------------
+ * Destroys the entries at positions first up to but not including last.
+ *
+ * param m     - initialized flat_map
+ * param first - the position of the first entry to remove
+ * param last  - the position past the last entry to remove
+ */
+void
+flat_map_erase_range (flat_map *m, size_t first, size_t last)
+{
+	assert (m != NULL);
+	assert (m->magic == MAGIC_INIT_VALUE);
+
+	flat_set_erase_range (m->entries, first, last);
+}
@@ -0,0 +1,480 @@
+/**
+ * File: HashSet.c
+ * Author: Seth Charles
+ * ----------------------
+ */
+#include "HashSet.h"
+#include <assert.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define MAGIC_INIT_VALUE       (0x52e1b7c06d94a3f8)
+#define HASH_MULTIPLIER        (0x9e3779b97f4a7c15ULL)
+#define MIN_CAPACITY           (HASHSET_GROUP_WIDTH)
+#define CTRL_EMPTY             ((uint8_t)0x80)
+#define CTRL_DELETED           ((uint8_t)0xfe)
+#define H1(HASH)               ((HASH) >> 7)
+#define H2(HASH)               ((uint8_t)((HASH) & 0x7f))
+#define SLOT_PTR(H, I)         ((H)->slots + (I) * (H)->elem_sz)
+
+/* the table is rehashed once it is seven eighths full */
+#define MAX_LOAD(CAP)          ((CAP) - (CAP) / 8)
+
+/**
+ * Function: hashset_mix
+ * ------------------------------------------------------
+ * Folds the high and low halves of a wide multiply of the client hash, so
+ * every input bit reaches both the probe start and the seven stored bits.
+ */
+static uint64_t
+hashset_mix (size_t hash)
+{
+#ifdef __SIZEOF_INT128__
+	unsigned __int128 m = (unsigned __int128)hash * HASH_MULTIPLIER;
+	return (uint64_t)m ^ (uint64_t)(m >> 64);
+#else
+	uint64_t m = (uint64_t)hash * HASH_MULTIPLIER;
+	return m ^ (m >> 32);
+#endif
+}
+
+/*
+ * The group functions each return a bitmask with bit i set when control byte
+ * i of the group matches. SSE2 compares all sixteen bytes at once.
+ */
+#ifdef __SSE2__
+
+static uint32_t
+group_match (const uint8_t *g, uint8_t h2)
+{
+	__m128i ctrl = _mm_loadu_si128 ((const __m128i *)g);
+	return (uint32_t)_mm_movemask_epi8 (_mm_cmpeq_epi8 (ctrl, _mm_set1_epi8 ((char)h2)));
+}
+
+static uint32_t
+group_match_empty (const uint8_t *g)
+{
+	return group_match (g, CTRL_EMPTY);
+}
+
+static uint32_t
+group_match_empty_or_deleted (const uint8_t *g)
+{
+	/* empty and deleted are the only control bytes with the top bit set */
+	return (uint32_t)_mm_movemask_epi8 (_mm_loadu_si128 ((const __m128i *)g));
+}
+
+#else
+
+static uint32_t
+group_match (const uint8_t *g, uint8_t h2)
+{
+	uint32_t mask = 0;
+	int i;
+
+	for (i = 0; i < HASHSET_GROUP_WIDTH; i++)
+	{
+		mask |= (uint32_t)(g[i] == h2) << i;
+	}
+	return mask;
+}
+
+static uint32_t
+group_match_empty (const uint8_t *g)
+{
+	return group_match (g, CTRL_EMPTY);
+}
+
+static uint32_t
+group_match_empty_or_deleted (const uint8_t *g)
+{
+	uint32_t mask = 0;
+	int i;
+
+	for (i = 0; i < HASHSET_GROUP_WIDTH; i++)
+	{
+		mask |= (uint32_t)(g[i] >> 7) << i;
+	}
+	return mask;
+}
+
+#endif
+
+/**
+ * Function: hashset_set_ctrl
+ * ------------------------------------------------------
+ * Writes a control byte, mirroring it past the end when it lies in the first
+ * group.
+ */
+static void
+hashset_set_ctrl (hashset *h, size_t i, uint8_t ctrl)
+{
+	h->ctrl[i] = ctrl;
+	if (i < HASHSET_GROUP_WIDTH)
+	{
+		h->ctrl[h->capacity + i] = ctrl;
+	}
+}
+
+/**
+ * Function: hashset_find
+ * ------------------------------------------------------
+ * Probes group by group for an element equal to key. The probe advances by
+ * one more group each step, which over a power of two table visits every
+ * group, and stops at the first group holding an empty slot.
+ *
+ * returns - the slot index of the element or SIZE_MAX
+ */
+static size_t
+hashset_find (const hashset *h, const void *key, uint64_t hash)
+{
+	size_t mask = h->capacity - 1, pos = H1 (hash) & mask, stride = 0, i;
+	uint8_t h2 = H2 (hash);
+	uint32_t match;
+
+	for (;;)
+	{
+		match = group_match (h->ctrl + pos, h2);
+		while (match)
+		{
+			i = (pos + (size_t)__builtin_ctz (match)) & mask;
+			if (h->elem_cmp (SLOT_PTR (h, i), key) == 0)
+			{
+				return i;
+			}
+			match &= match - 1;
+		}
+
+		if (group_match_empty (h->ctrl + pos))
+		{
+			return SIZE_MAX;
+		}
+
+		stride += HASHSET_GROUP_WIDTH;
+		pos = (pos + stride) & mask;
+	}
+}
+
+/**
+ * Function: hashset_find_free
+ * ------------------------------------------------------
+ * Returns the first empty or deleted slot on the probe sequence for hash.
+ */
+static size_t
+hashset_find_free (const hashset *h, uint64_t hash)
+{
+	size_t mask = h->capacity - 1, pos = H1 (hash) & mask, stride = 0;
+	uint32_t match;
+
+	while ((match = group_match_empty_or_deleted (h->ctrl + pos)) == 0)
+	{
+		stride += HASHSET_GROUP_WIDTH;
+		pos = (pos + stride) & mask;
+	}
+
+	return (pos + (size_t)__builtin_ctz (match)) & mask;
+}
+
+/**
+ * Function: hashset_alloc
+ * ------------------------------------------------------
+ * Gives the hashset fresh, empty arrays for capacity slots.
+ */
+static void
+hashset_alloc (hashset *h, size_t capacity)
+{
+	h->ctrl = malloc (capacity + HASHSET_GROUP_WIDTH);
+	h->slots = malloc (capacity * h->elem_sz);
+	assert (h->ctrl != NULL && h->slots != NULL);
+
+	memset (h->ctrl, CTRL_EMPTY, capacity + HASHSET_GROUP_WIDTH);
+	h->capacity = capacity;
+	h->growth_left = MAX_LOAD (capacity) - h->n_elems;
+}
+
+/**
+ * Function: hashset_rehash
+ * ------------------------------------------------------
+ * Moves every element into new arrays for capacity slots, which also drops
+ * all tombstones.
+ */
+static void
+hashset_rehash (hashset *h, size_t capacity)
+{
+	uint8_t *old_ctrl = h->ctrl, *old_slots = h->slots;
+	size_t old_capacity = h->capacity, i, j;
+	uint64_t hash;
+
+	hashset_alloc (h, capacity);
+
+	for (i = 0; i < old_capacity; i++)
+	{
+		if (old_ctrl[i] & 0x80)
+		{
+			continue;
+		}
+
+		hash = hashset_mix (h->elem_hash (old_slots + i * h->elem_sz));
+		j = hashset_find_free (h, hash);
+		hashset_set_ctrl (h, j, H2 (hash));
+		memcpy (SLOT_PTR (h, j), old_slots + i * h->elem_sz, h->elem_sz);
+	}
+
+	free (old_ctrl);
+	free (old_slots);
+}
+
+/**
+ * Function: hashset_init
+ * ------------------------------------------------------
+ * Public function to perform hashset initialization
+ *
+ * param elem_sz - the size of elements in bytes
+ * param hash    - the hash function for elements
+ * param cmp     - the compare function, returning zero for equal elements
+ * param fn      - the cleanup function to call when an element is destroyed
+ *
+ * returns - a pointer to the hashset object
+ */
+hashset *
+hashset_init (size_t elem_sz, hash_fn hash, compare_fn cmp, elem_destroy_fn fn)
+{
+	assert (elem_sz > 0);
+	assert (hash != NULL);
+	assert (cmp != NULL);
+	hashset *h;
+
+	h = calloc (1, sizeof (hashset));
+	assert (h != NULL);
+
+	h->elem_sz = elem_sz;
+	h->elem_hash = hash;
+	h->elem_cmp = cmp;
+	h->elem_destroy = fn;
+	h->magic = MAGIC_INIT_VALUE;
+
+	hashset_alloc (h, MIN_CAPACITY);
+
+	return h;
+}
+
+/**
+ * Function: hashset_destroy
+ * ------------------------------------------------------
+ * Destroys the hashset and every element in it.
+ *
+ * param h - the hashset to destroy
+ */
+void
+hashset_destroy (hashset *h)
+{
+	assert (h != NULL);
+	assert (h->magic == MAGIC_INIT_VALUE);
+
+	hashset_clear (h);
+	free (h->ctrl);
+	free (h->slots);
+	free (h);
+}
+
+/**
+ * Function: hashset_is_empty
+ * ------------------------------------------------------
+ * Returns whether the hashset holds no elements.
+ *
+ * param h - initialized hashset
+ */
+bool
+hashset_is_empty (const hashset *h)
+{
+	assert (h != NULL);
+	assert (h->magic == MAGIC_INIT_VALUE);
+
+	return h->n_elems == 0;
+}
+
+/**
+ * Function: hashset_size
+ * ------------------------------------------------------
+ * Returns the number of elements in the hashset.
+ *
+ * param h - initialized hashset
+ */
+size_t
+hashset_size (const hashset *h)
+{
+	assert (h != NULL);
+	assert (h->magic == MAGIC_INIT_VALUE);
+
+	return h->n_elems;
+}
+
+/**
+ * Function: hashset_contains
+ * ------------------------------------------------------
+ * Probes the groups on key's sequence for a slot whose control byte matches
+ * and whose element compares equal.
+ *
+ * param h   - initialized hashset
+ * param key - a pointer to the element to look for
+ *
+ * returns - true if an equal element is present
+ */
+bool
+hashset_contains (const hashset *h, const void *key)
+{
+	assert (h != NULL);
+	assert (h->magic == MAGIC_INIT_VALUE);
+	assert (key != NULL);
+
+	return hashset_find (h, key, hashset_mix (h->elem_hash (key))) != SIZE_MAX;
+}
+
+/**
+ * Function: hashset_add
+ * ------------------------------------------------------
+ * Copies key into the first free slot on its probe sequence. A tombstone is
+ * reused for free; taking an empty slot uses up growth, and once none is
+ * left the table is rehashed first, doubling unless at least half of the
+ * growth was lost to tombstones.
+ *
+ * param h   - initialized hashset
+ * param key - a pointer to the element to copy in
+ *
+ * returns - false, leaving the hashset unchanged, if an equal element is present
+ */
+bool
+hashset_add (hashset *h, const void *key)
+{
+	assert (h != NULL);
+	assert (h->magic == MAGIC_INIT_VALUE);
+	assert (key != NULL);
+	uint64_t hash = hashset_mix (h->elem_hash (key));
+	size_t i;
+
+	if (hashset_find (h, key, hash) != SIZE_MAX)
+	{
+		return false;
+	}
+
+	i = hashset_find_free (h, hash);
+	if (h->ctrl[i] == CTRL_EMPTY && h->growth_left == 0)
+	{
+		if (h->n_elems <= MAX_LOAD (h->capacity) / 2)
+		{
+			hashset_rehash (h, h->capacity);
+		}
+		else
+		{
+			hashset_rehash (h, h->capacity * 2);
+		}
+		i = hashset_find_free (h, hash);
+	}
+
+	if (h->ctrl[i] == CTRL_EMPTY)
+	{
+		--h->growth_left;
+	}
+
+	hashset_set_ctrl (h, i, H2 (hash));
+	memcpy (SLOT_PTR (h, i), key, h->elem_sz);
+	++h->n_elems;
+
+	return true;
+}
+
+/**
+ * Function: hashset_remove
+ * ------------------------------------------------------
+ * Destroys the element equal to key and marks its slot deleted, so probe
+ * sequences that pass through it still reach the elements beyond.
+ *
+ * param h   - initialized hashset
+ * param key - a pointer to an element equal to the one to remove
+ *
+ * returns - false if there was no such element
+ */
+bool
+hashset_remove (hashset *h, const void *key)
+{
+	assert (h != NULL);
+	assert (h->magic == MAGIC_INIT_VALUE);
+	assert (key != NULL);
+	size_t i = hashset_find (h, key, hashset_mix (h->elem_hash (key)));
+
+	if (i == SIZE_MAX)
+	{
+		return false;
+	}
+
+	if (h->elem_destroy)
+	{
+		h->elem_destroy (SLOT_PTR (h, i));
+	}
+
+	hashset_set_ctrl (h, i, CTRL_DELETED);
+	--h->n_elems;
+
+	return true;
+}
+
+/**
+ * Function: hashset_reserve
+ * ------------------------------------------------------
+ * Doubles the capacity until n elements fit under the maximum load, then
+ * rehashes once into that capacity.
+ *
+ * param h - initialized hashset
+ * param n - the number of elements to make room for
+ */
+void
+hashset_reserve (hashset *h, size_t n)
+{
+	assert (h != NULL);
+	assert (h->magic == MAGIC_INIT_VALUE);
+	size_t capacity = h->capacity;
+
+	while (MAX_LOAD (capacity) < n)
+	{
+		capacity *= 2;
+	}
+
+	if (capacity != h->capacity)
+	{
+		hashset_rehash (h, capacity);
+	}
+}
+
+/**
+ * Function: hashset_clear
+ * ------------------------------------------------------
+ * Destroys every element and resets every control byte to empty, which
+ * clears the tombstones too. The capacity is kept.
+ *
+ * param h - initialized hashset
+ */
+void
+hashset_clear (hashset *h)
+{
+	assert (h != NULL);
+	assert (h->magic == MAGIC_INIT_VALUE);
+	size_t i;
+
+	if (h->elem_destroy)
+	{
+		for (i = 0; i < h->capacity; i++)
+		{
+			if (!(h->ctrl[i] & 0x80))
+			{
+				h->elem_destroy (SLOT_PTR (h, i));
+			}
+		}
+	}
+
+	memset (h->ctrl, CTRL_EMPTY, h->capacity + HASHSET_GROUP_WIDTH);
+	h->n_elems = 0;
+	h->growth_left = MAX_LOAD (h->capacity);
+}
@@ -0,0 +1,391 @@
+/**
+ * File: HashTable.c
+ * Author: Seth Charles
+ * ----------------------
+ */
+#include "HashTable.h"
+#include <assert.h>
+#include <string.h>
+
+#define MAGIC_INIT_VALUE       (0x4be07d2c93a1f6e5)
+#define HASH_MULTIPLIER        (0x9e3779b97f4a7c15ULL)
+#define MIN_BUCKET_BITS        (4)
+#define KEY_PTR(T, E)          ((char *)(E) - (T)->link_offset + (T)->key_offset)
+#define NODE_PTR(T, E)         ((void *)((char *)(E) - (T)->link_offset))
+#define LINK_PTR(T, N)         ((hash_elem *)((char *)(N) + (T)->link_offset))
+
+/*
+ * Old buckets moved per insert or remove while growing. The table starts
+ * growing at one node per bucket and the new array is twice as long, so any
+ * step of at least one bucket finishes the move before the new array fills.
+ */
+#define REHASH_STEP            (4)
+
+/**
+ * Function: hash_table_bucket
+ * ------------------------------------------------------
+ * Mixes the hash with a multiplicative step and keeps the top bits. Since
+ * the top bits are kept, the nodes of old bucket i land in buckets 2i and
+ * 2i + 1 of the doubled array.
+ *
+ * param hash  - the key hash
+ * param shift - 64 less the number of bucket bits
+ *
+ * returns - the index of the bucket for the hash
+ */
+static size_t
+hash_table_bucket (size_t hash, size_t shift)
+{
+	return (size_t)(((uint64_t)hash * HASH_MULTIPLIER) >> shift);
+}
+
+/**
+ * Function: hash_table_link
+ * ------------------------------------------------------
+ * Links a node at the head of a bucket.
+ */
+static void
+hash_table_link (hash_elem **head, hash_elem *e)
+{
+	e->next = *head;
+	if (e->next)
+	{
+		e->next->pprev = &e->next;
+	}
+
+	*head = e;
+	e->pprev = head;
+}
+
+/**
+ * Function: hash_table_unlink
+ * ------------------------------------------------------
+ * Unlinks a node from whichever bucket array it is in.
+ */
+static void
+hash_table_unlink (hash_elem *e)
+{
+	*e->pprev = e->next;
+	if (e->next)
+	{
+		e->next->pprev = e->pprev;
+	}
+}
+
+/**
+ * Function: hash_table_chain_find
+ * ------------------------------------------------------
+ * Walks one chain for a node matching key.
+ */
+static hash_elem *
+hash_table_chain_find (const hash_table *t, hash_elem *e, const void *key,
+                       size_t hash)
+{
+	while (e != NULL)
+	{
+		if (e->hash == hash && t->key_cmp (KEY_PTR (t, e), key) == 0)
+		{
+			break;
+		}
+		e = e->next;
+	}
+
+	return e;
+}
+
+/**
+ * Function: hash_table_lookup
+ * ------------------------------------------------------
+ * Finds the node matching key, looking in the old bucket array too while the
+ * table is growing.
+ *
+ * returns - the matching link or NULL
+ */
+static hash_elem *
+hash_table_lookup (const hash_table *t, const void *key, size_t hash)
+{
+	hash_elem *e;
+	size_t i;
+
+	e = hash_table_chain_find (t, t->buckets[hash_table_bucket (hash, t->bucket_shift)],
+	                           key, hash);
+	if (e == NULL && t->old_buckets != NULL)
+	{
+		i = hash_table_bucket (hash, t->bucket_shift + 1);
+		if (i >= t->rehash_idx)
+		{
+			e = hash_table_chain_find (t, t->old_buckets[i], key, hash);
+		}
+	}
+
+	return e;
+}
+
+/**
+ * Function: hash_table_rehash_step
+ * ------------------------------------------------------
+ * Moves up to REHASH_STEP buckets from the old array to the current one,
+ * freeing the old array once it is drained.
+ */
+static void
+hash_table_rehash_step (hash_table *t)
+{
+	hash_elem *e, *next;
+	size_t n;
+
+	if (t->old_buckets == NULL)
+	{
+		return;
+	}
+
+	for (n = 0; n < REHASH_STEP && t->rehash_idx < t->n_old; n++)
+	{
+		for (e = t->old_buckets[t->rehash_idx]; e != NULL; e = next)
+		{
+			next = e->next;
+			hash_table_link (&t->buckets[hash_table_bucket (e->hash, t->bucket_shift)], e);
+		}
+		t->old_buckets[t->rehash_idx++] = NULL;
+	}
+
+	if (t->rehash_idx == t->n_old)
+	{
+		free (t->old_buckets);
+		t->old_buckets = NULL;
+	}
+}
+
+/**
+ * Function: hash_table_grow
+ * ------------------------------------------------------
+ * Starts moving the table into a bucket array twice as long.
+ */
+static void
+hash_table_grow (hash_table *t)
+{
+	assert (t->old_buckets == NULL);
+
+	t->n_old = (size_t)1 << (64 - t->bucket_shift);
+	t->old_buckets = t->buckets;
+	t->rehash_idx = 0;
+
+	t->buckets = calloc (t->n_old * 2, sizeof (hash_elem *));
+	assert (t->buckets != NULL);
+	--t->bucket_shift;
+}
+
+/**
+ * Function: hash_table_init
+ * ------------------------------------------------------
+ * Public function to perform table initialization
+ *
+ * param link_offset - the offset of the hash_elem within the client's node
+ * param key_offset  - the offset of the key within the client's node
+ * param hash        - the hash function for keys
+ * param cmp         - the compare function for keys
+ * param fn          - the cleanup function to call on nodes left at destroy
+ *
+ * returns - a pointer to the table object
+ */
+hash_table *
+hash_table_init (size_t link_offset, size_t key_offset, hash_fn hash,
+                 compare_fn cmp, elem_destroy_fn fn)
+{
+	assert (hash != NULL);
+	assert (cmp != NULL);
+	hash_table *t;
+
+	t = calloc (1, sizeof (hash_table));
+	assert (t != NULL);
+
+	t->buckets = calloc ((size_t)1 << MIN_BUCKET_BITS, sizeof (hash_elem *));
+	assert (t->buckets != NULL);
+
+	t->bucket_shift = 64 - MIN_BUCKET_BITS;
+	t->link_offset = link_offset;
+	t->key_offset = key_offset;
+	t->key_hash = hash;
+	t->key_cmp = cmp;
+	t->elem_destroy = fn;
+	t->magic = MAGIC_INIT_VALUE;
+
+	return t;
+}
+
+/**
+ * Function: hash_table_destroy
+ * ------------------------------------------------------
+ * Destroys the table, calling the destroy function on every node held.
+ *
+ * param t - the table to destroy
+ */
+void
+hash_table_destroy (hash_table *t)
+{
+	assert (t != NULL);
+	assert (t->magic == MAGIC_INIT_VALUE);
+
+	hash_elem *e, *next;
+	size_t i, n = (size_t)1 << (64 - t->bucket_shift);
+
+	if (t->elem_destroy)
+	{
+		for (i = 0; i < n; i++)
+		{
+			for (e = t->buckets[i]; e != NULL; e = next)
+			{
+				next = e->next;
+				t->elem_destroy (NODE_PTR (t, e));
+			}
+		}
+
+		for (i = t->rehash_idx; t->old_buckets && i < t->n_old; i++)
+		{
+			for (e = t->old_buckets[i]; e != NULL; e = next)
+			{
+				next = e->next;
+				t->elem_destroy (NODE_PTR (t, e));
+			}
+		}
+	}
+
+	free (t->old_buckets);
+	free (t->buckets);
+	free (t);
+}
+
+/**
+ * Function: hash_table_is_empty
+ * ------------------------------------------------------
+ */
+bool
+hash_table_is_empty (const hash_table *t)
+{
+	assert (t != NULL);
+	assert (t->magic == MAGIC_INIT_VALUE);
+
+	return t->n_elems == 0;
+}
+
+/**
+ * Function: hash_table_size
+ * ------------------------------------------------------
+ */
+size_t
+hash_table_size (const hash_table *t)
+{
+	assert (t != NULL);
+	assert (t->magic == MAGIC_INIT_VALUE);
+
+	return t->n_elems;
+}
+
+/**
+ * Function: hash_table_find
+ * ------------------------------------------------------
+ * param t   - initialized table
+ * param key - a pointer to the key to find
+ *
+ * returns - the matching node or NULL
+ */
+void *
+hash_table_find (const hash_table *t, const void *key)
+{
+	assert (t != NULL);
+	assert (key != NULL);
+	assert (t->magic == MAGIC_INIT_VALUE);
+
+	hash_elem *e = hash_table_lookup (t, key, t->key_hash (key));
+
+	return e ? NODE_PTR (t, e) : NULL;
+}
+
+/**
+ * Function: hash_table_insert
+ * ------------------------------------------------------
+ * Links the node into the current bucket array, first moving a step of old
+ * buckets if the table is growing, or starting to grow if the table has
+ * reached one node per bucket.
+ *
+ * param t    - initialized table
+ * param node - the client node
+ *
+ * returns - false if a node with an equal key is already linked
+ */
+bool
+hash_table_insert (hash_table *t, void *node)
+{
+	assert (t != NULL);
+	assert (node != NULL);
+	assert (t->magic == MAGIC_INIT_VALUE);
+
+	hash_elem *e = LINK_PTR (t, node);
+
+	e->hash = t->key_hash (KEY_PTR (t, e));
+	if (hash_table_lookup (t, KEY_PTR (t, e), e->hash) != NULL)
+	{
+		return false;
+	}
+
+	if (t->old_buckets != NULL)
+	{
+		hash_table_rehash_step (t);
+	}
+	else if (t->n_elems >= ((size_t)1 << (64 - t->bucket_shift)))
+	{
+		hash_table_grow (t);
+		hash_table_rehash_step (t);
+	}
+
+	hash_table_link (&t->buckets[hash_table_bucket (e->hash, t->bucket_shift)], e);
+	++t->n_elems;
+
+	return true;
+}
+
+/**
+ * Function: hash_table_remove
+ * ------------------------------------------------------
+ * param t    - initialized table
+ * param node - a node linked into the table
+ */
+void
+hash_table_remove (hash_table *t, void *node)
+{
+	assert (t != NULL);
+	assert (node != NULL);
+	assert (t->magic == MAGIC_INIT_VALUE);
+	assert (t->n_elems > 0);
+
+	hash_table_unlink (LINK_PTR (t, node));
+	--t->n_elems;
+
+	hash_table_rehash_step (t);
+}
+
+/**
+ * Function: hash_table_remove_key
+ * ------------------------------------------------------
+ * param t   - initialized table
+ * param key - a pointer to the key of the node to unlink
+ *
+ * returns - the unlinked node or NULL
+ */
+void *
+hash_table_remove_key (hash_table *t, const void *key)
+{
+	assert (t != NULL);
+	assert (key != NULL);
+	assert (t->magic == MAGIC_INIT_VALUE);
+
+	hash_elem *e = hash_table_lookup (t, key, t->key_hash (key));
+
+	if (e == NULL)
+	{
+		return NULL;
+	}
+
+	hash_table_remove (t, NODE_PTR (t, e));
+
+	return NODE_PTR (t, e);
+}
@@ -0,0 +1,454 @@
+/**
+ * File: IndexedPQueue.c
+ * Author: Seth Charles
+ * ----------------------
+ */
+#include "IndexedPQueue.h"
+#include <assert.h>
+#include <string.h>
+
+#define MAGIC_INIT_VALUE       (0x38d5a1f7c2e0964b)
+#define DEFAULT_HANDLES        (16UL)
+#define NOT_QUEUED             (SIZE_MAX)
+#define GET_PTR_ENTRY(Q, I)    ((Q)->heap + (I) * (Q)->entry_sz)
+#define ENTRY_HANDLE(E)        (*(size_t *)(E))
+#define ENTRY_ELEM(E)          ((E) + sizeof (size_t))
+#define ELEM_AT(Q, I)          (ENTRY_ELEM (GET_PTR_ENTRY (Q, I)))
+
+/**
+ * Function: ipqueue_grow_handles
+ * ------------------------------------------------------
+ * Doubles the handle capacity until handle fits. New handles start absent.
+ */
+static void
+ipqueue_grow_handles (ipqueue *q, size_t handle)
+{
+	size_t n = (q->n_handles > 0) ? q->n_handles : 1, i;
+
+	while (n <= handle)
+	{
+		n *= 2;
+	}
+
+	q->heap = realloc (q->heap, n * q->entry_sz);
+	q->pos = realloc (q->pos, n * sizeof (size_t));
+	assert (q->heap != NULL && q->pos != NULL);
+
+	for (i = q->n_handles; i < n; i++)
+	{
+		q->pos[i] = NOT_QUEUED;
+	}
+	q->n_handles = n;
+}
+
+/**
+ * Function: ipqueue_place
+ * ------------------------------------------------------
+ * Copies an entry to heap index i and records where its handle went.
+ */
+static void
+ipqueue_place (ipqueue *q, size_t i, const uint8_t *entry)
+{
+	memcpy (GET_PTR_ENTRY (q, i), entry, q->entry_sz);
+	q->pos[ENTRY_HANDLE (entry)] = i;
+}
+
+/**
+ * Function: ipqueue_sift_up
+ * ------------------------------------------------------
+ * Moves the entry at heap index i up past every parent with a greater
+ * element. The entry waits in the hole while parents are shifted down.
+ */
+static void
+ipqueue_sift_up (ipqueue *q, size_t i)
+{
+	size_t parent;
+
+	memcpy (q->hole, GET_PTR_ENTRY (q, i), q->entry_sz);
+
+	while (i > 0)
+	{
+		parent = (i - 1) / q->arity;
+		if (q->elem_cmp (ENTRY_ELEM (q->hole), ELEM_AT (q, parent)) >= 0)
+		{
+			break;
+		}
+		ipqueue_place (q, i, GET_PTR_ENTRY (q, parent));
+		i = parent;
+	}
+
+	ipqueue_place (q, i, q->hole);
+}
+
+/**
+ * Function: ipqueue_sift_down
+ * ------------------------------------------------------
+ * Moves the entry at heap index i down below every child with a smaller
+ * element.
+ */
+static void
+ipqueue_sift_down (ipqueue *q, size_t i)
+{
+	size_t first, last, best, c;
+
+	memcpy (q->hole, GET_PTR_ENTRY (q, i), q->entry_sz);
+
+	for (;;)
+	{
+		first = q->arity * i + 1;
+		if (first >= q->n_elems)
+		{
+			break;
+		}
+
+		last = (first + q->arity < q->n_elems) ? first + q->arity : q->n_elems;
+		best = first;
+		for (c = first + 1; c < last; c++)
+		{
+			if (q->elem_cmp (ELEM_AT (q, c), ELEM_AT (q, best)) < 0)
+			{
+				best = c;
+			}
+		}
+
+		if (q->elem_cmp (ELEM_AT (q, best), ENTRY_ELEM (q->hole)) >= 0)
+		{
+			break;
+		}
+		ipqueue_place (q, i, GET_PTR_ENTRY (q, best));
+		i = best;
+	}
+
+	ipqueue_place (q, i, q->hole);
+}
+
+/**
+ * Function: ipqueue_take
+ * ------------------------------------------------------
+ * Copies out or destroys the element under a queued handle, then fills its
+ * heap slot with the last entry and sifts that whichever way it needs.
+ */
+static void
+ipqueue_take (ipqueue *q, size_t handle, void *out)
+{
+	size_t i = q->pos[handle];
+
+	if (out != NULL)
+	{
+		memcpy (out, ELEM_AT (q, i), q->elem_sz);
+	}
+	else if (q->elem_destroy)
+	{
+		q->elem_destroy (ELEM_AT (q, i));
+	}
+
+	q->pos[handle] = NOT_QUEUED;
+	if (i == --q->n_elems)
+	{
+		return;
+	}
+
+	ipqueue_place (q, i, GET_PTR_ENTRY (q, q->n_elems));
+	if (i > 0 && q->elem_cmp (ELEM_AT (q, i), ELEM_AT (q, (i - 1) / q->arity)) < 0)
+	{
+		ipqueue_sift_up (q, i);
+	}
+	else
+	{
+		ipqueue_sift_down (q, i);
+	}
+}
+
+/**
+ * Function: ipqueue_replace
+ * ------------------------------------------------------
+ * Destroys the element under a queued handle and copies a new one in.
+ *
+ * returns - the heap index of the handle
+ */
+static size_t
+ipqueue_replace (ipqueue *q, size_t handle, const void *elem)
+{
+	size_t i = q->pos[handle];
+
+	if (q->elem_destroy)
+	{
+		q->elem_destroy (ELEM_AT (q, i));
+	}
+	memcpy (ELEM_AT (q, i), elem, q->elem_sz);
+
+	return i;
+}
+
+/**
+ * Function: ipqueue_init
+ * ------------------------------------------------------
+ * Public function to perform queue initialization
+ *
+ * param elem_sz        - the size of elements in bytes that are stored
+ * param arity          - the number of children per heap node
+ * param n_handles_hint - the expected bound on handles, 0 for a default
+ * param cmp            - the compare function, smallest element on top
+ * param fn             - the cleanup function to call when an element is
+ *                        destroyed
+ *
+ * returns - a pointer to the queue object
+ */
+ipqueue *
+ipqueue_init (size_t elem_sz, size_t arity, size_t n_handles_hint,
+              compare_fn cmp, elem_destroy_fn fn)
+{
+	assert (elem_sz > 0);
+	assert (arity >= 2);
+	assert (cmp != NULL);
+	ipqueue *q;
+
+	q = calloc (1, sizeof (ipqueue));
+	assert (q != NULL);
+
+	/* entries stay size_t aligned so the handle can be read in place */
+	q->entry_sz = sizeof (size_t) + (elem_sz + sizeof (size_t) - 1) / sizeof (size_t) * sizeof (size_t);
+	q->hole = malloc (q->entry_sz);
+	assert (q->hole != NULL);
+
+	q->elem_sz = elem_sz;
+	q->arity = arity;
+	q->elem_cmp = cmp;
+	q->elem_destroy = fn;
+	q->magic = MAGIC_INIT_VALUE;
+
+	ipqueue_grow_handles (q, (n_handles_hint == 0) ? DEFAULT_HANDLES - 1 : n_handles_hint - 1);
+
+	return q;
+}
+
+/**
+ * Function: ipqueue_destroy
+ * ------------------------------------------------------
+ * Destroys the queue and every element still in it.
+ *
+ * param q - the queue to destroy
+ */
+void
+ipqueue_destroy (ipqueue *q)
+{
+	assert (q != NULL);
+	assert (q->magic == MAGIC_INIT_VALUE);
+	size_t i;
+
+	if (q->elem_destroy)
+	{
+		for (i = 0; i < q->n_elems; i++)
+		{
+			q->elem_destroy (ELEM_AT (q, i));
+		}
+	}
+
+	free (q->heap);
+	free (q->pos);
+	free (q->hole);
+	free (q);
+}
+
+/**
+ * Function: ipqueue_is_empty
+ * ------------------------------------------------------
+ * Returns whether no handle is queued.
+ *
+ * param q - initialized queue
+ */
+bool
+ipqueue_is_empty (const ipqueue *q)
+{
+	assert (q != NULL);
+	assert (q->magic == MAGIC_INIT_VALUE);
+
+	return q->n_elems == 0;
+}
+
+/**
+ * Function: ipqueue_size
+ * ------------------------------------------------------
+ * Returns the number of queued handles.
+ *
+ * param q - initialized queue
+ */
+size_t
+ipqueue_size (const ipqueue *q)
+{
+	assert (q != NULL);
+	assert (q->magic == MAGIC_INIT_VALUE);
+
+	return q->n_elems;
+}
+
+/**
+ * Function: ipqueue_contains
+ * ------------------------------------------------------
+ * Returns whether a handle is queued. Handles past the position array have
+ * never been pushed.
+ *
+ * param q      - initialized queue
+ * param handle - the handle to look up
+ */
+bool
+ipqueue_contains (const ipqueue *q, size_t handle)
+{
+	assert (q != NULL);
+	assert (q->magic == MAGIC_INIT_VALUE);
+
+	return handle < q->n_handles && q->pos[handle] != NOT_QUEUED;
+}
+
+/**
+ * Function: ipqueue_access
+ * ------------------------------------------------------
+ * Returns the element under a queued handle, found through the position
+ * array in O(1).
+ *
+ * param q      - initialized queue
+ * param handle - a queued handle
+ */
+void *
+ipqueue_access (ipqueue *q, size_t handle)
+{
+	assert (q != NULL);
+	assert (q->magic == MAGIC_INIT_VALUE);
+	assert (ipqueue_contains (q, handle));
+
+	return ELEM_AT (q, q->pos[handle]);
+}
+
+/**
+ * Function: ipqueue_top
+ * ------------------------------------------------------
+ * Returns the handle of the smallest element, at the root of the heap.
+ *
+ * param q - initialized, non empty queue
+ */
+size_t
+ipqueue_top (const ipqueue *q)
+{
+	assert (q != NULL);
+	assert (q->magic == MAGIC_INIT_VALUE);
+	assert (q->n_elems > 0);
+
+	return ENTRY_HANDLE (q->heap);
+}
+
+/**
+ * Function: ipqueue_push
+ * ------------------------------------------------------
+ * Appends an entry for the handle and sifts it up, first growing the
+ * position array if the handle lies past it.
+ *
+ * param q      - initialized queue
+ * param handle - a handle not already queued
+ * param elem   - a pointer to the element to copy in
+ */
+void
+ipqueue_push (ipqueue *q, size_t handle, const void *elem)
+{
+	assert (q != NULL);
+	assert (elem != NULL);
+	assert (q->magic == MAGIC_INIT_VALUE);
+	assert (!ipqueue_contains (q, handle));
+	uint8_t *entry;
+
+	if (handle >= q->n_handles)
+	{
+		ipqueue_grow_handles (q, handle);
+	}
+
+	entry = GET_PTR_ENTRY (q, q->n_elems);
+	ENTRY_HANDLE (entry) = handle;
+	memcpy (ENTRY_ELEM (entry), elem, q->elem_sz);
+	ipqueue_sift_up (q, q->n_elems++);
+}
+
+/**
+ * Function: ipqueue_pop
+ * ------------------------------------------------------
+ * Takes the smallest element out of the queue.
+ *
+ * param q   - initialized, non empty queue
+ * param out - where to copy the element, or NULL to destroy it
+ *
+ * returns - the handle the element was queued under
+ */
+size_t
+ipqueue_pop (ipqueue *q, void *out)
+{
+	assert (q != NULL);
+	assert (q->magic == MAGIC_INIT_VALUE);
+	assert (q->n_elems > 0);
+	size_t handle = ipqueue_top (q);
+
+	ipqueue_take (q, handle, out);
+
+	return handle;
+}
+
+/**
+ * Function: ipqueue_decrease_key
+ * ------------------------------------------------------
+ * Replaces the element under a queued handle with one no larger and sifts
+ * it up.
+ *
+ * param q      - initialized queue
+ * param handle - a queued handle
+ * param elem   - a pointer to the new element, not larger than the old
+ */
+void
+ipqueue_decrease_key (ipqueue *q, size_t handle, const void *elem)
+{
+	assert (q != NULL);
+	assert (elem != NULL);
+	assert (q->magic == MAGIC_INIT_VALUE);
+	assert (ipqueue_contains (q, handle));
+	assert (q->elem_cmp (elem, ipqueue_access (q, handle)) <= 0);
+
+	ipqueue_sift_up (q, ipqueue_replace (q, handle, elem));
+}
+
+/**
+ * Function: ipqueue_increase_key
+ * ------------------------------------------------------
+ * Replaces the element under a queued handle with one no smaller and sifts
+ * it down.
+ *
+ * param q      - initialized queue
+ * param handle - a queued handle
+ * param elem   - a pointer to the new element, not smaller than the old
+ */
+void
+ipqueue_increase_key (ipqueue *q, size_t handle, const void *elem)
+{
+	assert (q != NULL);
+	assert (elem != NULL);
+	assert (q->magic == MAGIC_INIT_VALUE);
+	assert (ipqueue_contains (q, handle));
+	assert (q->elem_cmp (elem, ipqueue_access (q, handle)) >= 0);
+
+	ipqueue_sift_down (q, ipqueue_replace (q, handle, elem));
+}
+
+/**
+ * Function: ipqueue_remove
+ * ------------------------------------------------------
+ * Takes the element under a queued handle out of the queue, wherever it is
+ * in the heap.
+ *
+ * param q      - initialized queue
+ * param handle - a queued handle
+ * param out    - where to copy the element, or NULL to destroy it
+ */
+void
+ipqueue_remove (ipqueue *q, size_t handle, void *out)
+{
+	assert (q != NULL);
+	assert (q->magic == MAGIC_INIT_VALUE);
+	assert (ipqueue_contains (q, handle));
+
+	ipqueue_take (q, handle, out);
+}
@@ -0,0 +1,411 @@
+/**
+ * File: LRUCache.c
+ * Author: Seth Charles
+ * ----------------------
+ */
+#include "LRUCache.h"
+#include <assert.h>
+#include <string.h>
+#include <stdio.h>
+
+#define MAGIC_INIT_VALUE       (0x739caf14a2d9e85f)
+#define HASH_MULTIPLIER        (0x9e3779b97f4a7c15ULL)
+#define KEY_PTR(C, E)          ((char *)(E) + (C)->key_offset)
+
+/**
+ * Function: lru_cache_bucket
+ * ------------------------------------------------------
+ * Mixes the hash with a multiplicative step and keeps the top bits, so that
+ * weak client hashes still spread across the buckets.
+ *
+ * param c    - initialized cache
+ * param hash - the key hash
+ *
+ * returns - the index of the bucket for the hash
+ */
+static size_t
+lru_cache_bucket (const lru_cache *c, size_t hash)
+{
+	return (size_t)(((uint64_t)hash * HASH_MULTIPLIER) >> c->bucket_shift);
+}
+
+/**
+ * Function: lru_cache_hash_link
+ * ------------------------------------------------------
+ * Links a node at the head of its hash bucket.
+ */
+static void
+lru_cache_hash_link (lru_cache *c, lru_elem *e)
+{
+	lru_elem **head = &c->buckets[lru_cache_bucket (c, e->hash)];
+
+	e->hash_next = *head;
+	if (e->hash_next)
+	{
+		e->hash_next->hash_pprev = &e->hash_next;
+	}
+
+	*head = e;
+	e->hash_pprev = head;
+}
+
+/**
+ * Function: lru_cache_hash_unlink
+ * ------------------------------------------------------
+ * Unlinks a node from its hash bucket in constant time.
+ */
+static void
+lru_cache_hash_unlink (lru_elem *e)
+{
+	*e->hash_pprev = e->hash_next;
+	if (e->hash_next)
+	{
+		e->hash_next->hash_pprev = e->hash_pprev;
+	}
+}
+
+/**
+ * Function: lru_cache_lookup
+ * ------------------------------------------------------
+ * Finds the node matching key without touching recency or the counters.
+ *
+ * returns - the matching node or NULL
+ */
+static lru_elem *
+lru_cache_lookup (const lru_cache *c, const void *key, size_t hash)
+{
+	lru_elem *e = c->buckets[lru_cache_bucket (c, hash)];
+
+	while (e != NULL)
+	{
+		if (e->hash == hash && c->key_cmp (KEY_PTR (c, e), key) == 0)
+		{
+			break;
+		}
+		e = e->hash_next;
+	}
+
+	return e;
+}
+
+/**
+ * Function: lru_cache_rebuild_index
+ * ------------------------------------------------------
+ * Sizes the hash index to the smallest power of two holding capacity nodes
+ * and relinks every cached node into it.
+ */
+static void
+lru_cache_rebuild_index (lru_cache *c)
+{
+	lru_elem **old = c->buckets, *e, *next;
+	size_t bits = 1, n_old = 0, i;
+
+	if (old != NULL)
+	{
+		n_old = (size_t)1 << (64 - c->bucket_shift);
+	}
+
+	while (((size_t)1 << bits) < c->capacity)
+	{
+		++bits;
+	}
+
+	c->buckets = calloc ((size_t)1 << bits, sizeof (lru_elem *));
+	assert (c->buckets != NULL);
+	c->bucket_shift = 64 - bits;
+
+	for (i = 0; i < n_old; i++)
+	{
+		for (e = old[i]; e != NULL; e = next)
+		{
+			next = e->hash_next;
+			lru_cache_hash_link (c, e);
+		}
+	}
+
+	free (old);
+}
+
+/**
+ * Function: lru_cache_evict
+ * ------------------------------------------------------
+ * Destroys least recently used nodes until the cache is within capacity.
+ */
+static void
+lru_cache_evict (lru_cache *c)
+{
+	lru_elem *victim;
+
+	while (list_size (&c->recency) > c->capacity)
+	{
+		victim = list_back (&c->recency);
+		lru_cache_hash_unlink (victim);
+		list_pop_back (&c->recency);
+
+		if (c->elem_destroy)
+		{
+			c->elem_destroy (victim);
+		}
+	}
+}
+
+/**
+ * Function: lru_cache_init
+ * ------------------------------------------------------
+ * Public function to perform cache initialization
+ *
+ * param capacity   - the number of nodes held before eviction begins
+ * param key_offset - the offset of the key within the client's node
+ * param hash       - the hash function for keys
+ * param cmp        - the compare function for keys
+ * param fn         - the cleanup function to call when a node is destroyed
+ *
+ * returns - a pointer to the cache object
+ */
+lru_cache *
+lru_cache_init (size_t capacity, size_t key_offset, hash_fn hash,
+                compare_fn cmp, elem_destroy_fn fn)
+{
+	assert (capacity > 0);
+	assert (hash != NULL);
+	assert (cmp != NULL);
+	lru_cache *c;
+
+	c = calloc (1, sizeof (lru_cache));
+	assert (c != NULL);
+
+	/* the recency list never destroys, nodes are handed back on eviction */
+	list_init_static (&c->recency, NULL);
+
+	c->capacity = capacity;
+	c->key_offset = key_offset;
+	c->key_hash = hash;
+	c->key_cmp = cmp;
+	c->elem_destroy = fn;
+	c->magic = MAGIC_INIT_VALUE;
+
+	lru_cache_rebuild_index (c);
+
+	return c;
+}
+
+/**
+ * Function: lru_cache_destroy
+ * ------------------------------------------------------
+ * Destroys the cache, calling the destroy function on every node held.
+ *
+ * param c - the cache to destroy
+ */
+void
+lru_cache_destroy (lru_cache *c)
+{
+	assert (c != NULL);
+	assert (c->magic == MAGIC_INIT_VALUE);
+
+	lru_elem *e;
+
+	while ((e = list_front (&c->recency)) != NULL)
+	{
+		list_pop_front (&c->recency);
+		if (c->elem_destroy)
+		{
+			c->elem_destroy (e);
+		}
+	}
+
+	list_destroy (&c->recency);
+	free (c->buckets);
+	free (c);
+}
+
+/**
+ * Function: lru_cache_size
+ * ------------------------------------------------------
+ */
+size_t
+lru_cache_size (const lru_cache *c)
+{
+	assert (c != NULL);
+	assert (c->magic == MAGIC_INIT_VALUE);
+
+	return list_size (&c->recency);
+}
+
+/**
+ * Function: lru_cache_capacity
+ * ------------------------------------------------------
+ */
+size_t
+lru_cache_capacity (const lru_cache *c)
+{
+	assert (c != NULL);
+	assert (c->magic == MAGIC_INIT_VALUE);
+
+	return c->capacity;
+}
+
+/**
+ * Function: lru_cache_set_capacity
+ * ------------------------------------------------------
+ * Evicts down to the new capacity before resizing the index, so that the
+ * rebuild only relinks the nodes that survive.
+ *
+ * param c        - initialized cache
+ * param capacity - the new capacity
+ */
+void
+lru_cache_set_capacity (lru_cache *c, size_t capacity)
+{
+	assert (c != NULL);
+	assert (c->magic == MAGIC_INIT_VALUE);
+	assert (capacity > 0);
+
+	c->capacity = capacity;
+	lru_cache_evict (c);
+	lru_cache_rebuild_index (c);
+}
+
+/**
+ * Function: lru_cache_get
+ * ------------------------------------------------------
+ * Looks up a key and moves a hit to the front of the recency list.
+ *
+ * param c   - initialized cache
+ * param key - a pointer to the key to find
+ *
+ * returns - the matching node or NULL if the key is not cached
+ */
+void *
+lru_cache_get (lru_cache *c, const void *key)
+{
+	assert (c != NULL);
+	assert (key != NULL);
+	assert (c->magic == MAGIC_INIT_VALUE);
+
+	lru_elem *e;
+
+	e = lru_cache_lookup (c, key, c->key_hash (key));
+	if (e == NULL)
+	{
+		++c->misses;
+		return NULL;
+	}
+
+	++c->hits;
+	if (list_front (&c->recency) != e)
+	{
+		list_remove (&c->recency, e);
+		list_push_front (&c->recency, e);
+	}
+
+	return e;
+}
+
+/**
+ * Function: lru_cache_insert
+ * ------------------------------------------------------
+ * Inserts a node as the most recently used, replacing any node with an equal
+ * key, then evicts down to capacity. A node that is itself already cached is
+ * only moved to the front.
+ *
+ * param c        - initialized cache
+ * param new_node - the client node, with lru_elem as its first field
+ */
+void
+lru_cache_insert (lru_cache *c, void *new_node)
+{
+	assert (c != NULL);
+	assert (new_node != NULL);
+	assert (c->magic == MAGIC_INIT_VALUE);
+
+	lru_elem *e = new_node, *old;
+
+	e->hash = c->key_hash (KEY_PTR (c, e));
+
+	old = lru_cache_lookup (c, KEY_PTR (c, e), e->hash);
+	if (old == e)
+	{
+		/* reinserting a cached node, say after changing its value, refreshes it */
+		if (list_front (&c->recency) != e)
+		{
+			list_remove (&c->recency, e);
+			list_push_front (&c->recency, e);
+		}
+		return;
+	}
+	if (old != NULL)
+	{
+		lru_cache_hash_unlink (old);
+		list_remove (&c->recency, old);
+		if (c->elem_destroy)
+		{
+			c->elem_destroy (old);
+		}
+	}
+
+	lru_cache_hash_link (c, e);
+	list_push_front (&c->recency, e);
+
+	lru_cache_evict (c);
+}
+
+/**
+ * Function: lru_cache_remove
+ * ------------------------------------------------------
+ * Removes the node matching key and destroys it.
+ *
+ * param c   - initialized cache
+ * param key - a pointer to the key to remove
+ *
+ * returns - true if a node was removed
+ */
+bool
+lru_cache_remove (lru_cache *c, const void *key)
+{
+	assert (c != NULL);
+	assert (key != NULL);
+	assert (c->magic == MAGIC_INIT_VALUE);
+
+	lru_elem *e;
+
+	e = lru_cache_lookup (c, key, c->key_hash (key));
+	if (e == NULL)
+	{
+		return false;
+	}
+
+	lru_cache_hash_unlink (e);
+	list_remove (&c->recency, e);
+	if (c->elem_destroy)
+	{
+		c->elem_destroy (e);
+	}
+
+	return true;
+}
+
+/**
+ * Function: lru_cache_hits
+ * ------------------------------------------------------
+ */
+size_t
+lru_cache_hits (const lru_cache *c)
+{
+	assert (c != NULL);
+	assert (c->magic == MAGIC_INIT_VALUE);
+
+	return c->hits;
+}
+
+/**
+ * Function: lru_cache_misses
+ * ------------------------------------------------------
+ */
+size_t
+lru_cache_misses (const lru_cache *c)
+{
+	assert (c != NULL);
+	assert (c->magic == MAGIC_INIT_VALUE);
+
+	return c->misses;
+}
@@ -68,8 +68,8 @@ list_destroy (list *l)
 	{
 		while (cur != (void **)&l->tail)
 		{
-			next = NEXT_PTR_FROM_PREV (*cur);
-			l->elem_destroy (ELEM_PTR_FROM_PREV (*cur));
+			next = *NEXT_PTR_FROM_PREV (cur);
+			l->elem_destroy (ELEM_PTR_FROM_PREV (cur));
 			cur = next;
 		}
 	}
@@ -165,6 +165,58 @@ list_back (const list *l)
 	return (l->tail == (void **)&l->head) ? NULL : to_return;
 }
 
+/**
+ * Function: list_next
+ * ------------------------------------------------------
+ */
+void *
+list_next (const list *l, const void *node)
+{
+	assert (l != NULL);
+	assert (node != NULL);
+	assert (l->magic == MAGIC_INIT_VALUE);
+
+	const list_elem *cur = node;
+	return (cur->next == (void **)&l->tail) ? NULL : ELEM_PTR_FROM_PREV (cur->next);
+}
+
+/**
+ * Function: list_prev
+ * ------------------------------------------------------
+ */
+void *
+list_prev (const list *l, const void *node)
+{
+	assert (l != NULL);
+	assert (node != NULL);
+	assert (l->magic == MAGIC_INIT_VALUE);
+
+	const list_elem *cur = node;
+	return (cur->prev == (void **)&l->head) ? NULL : ELEM_PTR_FROM_NEXT (cur->prev);
+}
+
+/**
+ * Function: list_insert_after
+ * ------------------------------------------------------
+ */
+void
+list_insert_after (list *l, void *node, void *new_node)
+{
+	assert (l != NULL);
+	assert (node != NULL);
+	assert (new_node != NULL);
+	assert (l->magic == MAGIC_INIT_VALUE);
+
+	list_elem *cur = node, *to_insert = new_node;
+
+	to_insert->next = cur->next;
+	to_insert->prev = (void **)&cur->next;
+	*to_insert->next = (void *)&to_insert->next;
+	cur->next = (void **)&to_insert->prev;
+
+	++l->n_elems;
+}
+
 /**
  * Function: list_pop_front
  * ------------------------------------------------------
@@ -213,4 +265,62 @@ list_pop_back (list *l)
 	}
 
 	--l->n_elems;
+}
+
+/**
+ * Function: list_remove
+ * ------------------------------------------------------
+ * The neighbours of a node are reached through its own link fields, so no
+ * traversal is required. The head and tail of the list behave as the links
+ * of a sentinel node, which removes any special casing of the ends.
+ */
+void
+list_remove (list *l, void *node)
+{
+	assert (l != NULL);
+	assert (node != NULL);
+	assert (l->magic == MAGIC_INIT_VALUE);
+	assert (l->n_elems > 0);
+
+	list_elem *to_remove = node;
+
+	*to_remove->prev = (void *)to_remove->next;
+	*to_remove->next = (void *)to_remove->prev;
+
+	if (l->elem_destroy)
+	{
+		l->elem_destroy (to_remove);
+	}
+
+	--l->n_elems;
+}
+
+/**
+ * Function: list_splice
+ * ------------------------------------------------------
+ * Links the first node of other after the last node of l, then resets other
+ * to the empty state.
+ */
+void
+list_splice (list *l, list *other)
+{
+	assert (l != NULL);
+	assert (other != NULL);
+	assert (l->magic == MAGIC_INIT_VALUE);
+	assert (other->magic == MAGIC_INIT_VALUE);
+
+	if (other->n_elems == 0)
+	{
+		return;
+	}
+
+	*l->tail = (void *)other->head;
+	*other->head = (void *)l->tail;
+	*other->tail = (void *)&l->tail;
+	l->tail = other->tail;
+	l->n_elems += other->n_elems;
+
+	other->head = (void **)&other->tail;
+	other->tail = (void **)&other->head;
+	other->n_elems = 0;
 }
\ No newline at end of file
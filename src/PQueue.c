@@ -0,0 +1,369 @@
+/**
+ * File: PQueue.c
+ * Author: Seth Charles
+ * ----------------------
+ */
+#include "PQueue.h"
+#include <assert.h>
+#include <string.h>
+
+#define MAGIC_INIT_VALUE       (0x6f0c4e9a2b85d713)
+#define GET_PTR_ELEM(Q, INDEX) ((char *)((Q)->heap->elems) + ((INDEX) * ((Q)->heap->elem_sz)))
+#define ELEM_CMP(Q, A, B)      ((Q)->elem_cmp (GET_PTR_ELEM (Q, A), GET_PTR_ELEM (Q, B)))
+
+/**
+ * Function: pqueue_move
+ * ------------------------------------------------------
+ * Copies the element at index src over the one at index dst.
+ */
+static void
+pqueue_move (pqueue *q, size_t dst, size_t src)
+{
+	memcpy (GET_PTR_ELEM (q, dst), GET_PTR_ELEM (q, src), q->heap->elem_sz);
+}
+
+/**
+ * Function: pqueue_sift_up
+ * ------------------------------------------------------
+ * Moves the element at index i up past every parent greater than it. The
+ * element waits in the hole while parents are shifted down, so each level
+ * costs one copy rather than a swap.
+ */
+static void
+pqueue_sift_up (pqueue *q, size_t i)
+{
+	size_t parent;
+
+	memcpy (q->hole, GET_PTR_ELEM (q, i), q->heap->elem_sz);
+
+	while (i > 0)
+	{
+		parent = (i - 1) / q->arity;
+		if (q->elem_cmp (q->hole, GET_PTR_ELEM (q, parent)) >= 0)
+		{
+			break;
+		}
+		pqueue_move (q, i, parent);
+		i = parent;
+	}
+
+	memcpy (GET_PTR_ELEM (q, i), q->hole, q->heap->elem_sz);
+}
+
+/**
+ * Function: pqueue_sift_down
+ * ------------------------------------------------------
+ * Moves the element at index i down below every child smaller than it,
+ * among the first n elements.
+ */
+static void
+pqueue_sift_down (pqueue *q, size_t i, size_t n)
+{
+	size_t first, last, best, c;
+
+	memcpy (q->hole, GET_PTR_ELEM (q, i), q->heap->elem_sz);
+
+	for (;;)
+	{
+		first = q->arity * i + 1;
+		if (first >= n)
+		{
+			break;
+		}
+
+		last = (first + q->arity < n) ? first + q->arity : n;
+		best = first;
+		for (c = first + 1; c < last; c++)
+		{
+			if (ELEM_CMP (q, c, best) < 0)
+			{
+				best = c;
+			}
+		}
+
+		if (q->elem_cmp (GET_PTR_ELEM (q, best), q->hole) >= 0)
+		{
+			break;
+		}
+		pqueue_move (q, i, best);
+		i = best;
+	}
+
+	memcpy (GET_PTR_ELEM (q, i), q->hole, q->heap->elem_sz);
+}
+
+/**
+ * Function: pqueue_build
+ * ------------------------------------------------------
+ * Restores the heap order over the whole vector bottom up, sifting down
+ * every node that has children. This is O(n) since most nodes are near the
+ * bottom and sift only a short way.
+ */
+static void
+pqueue_build (pqueue *q)
+{
+	size_t n = q->heap->n_elems, i;
+
+	if (n < 2)
+	{
+		return;
+	}
+
+	for (i = (n - 2) / q->arity + 1; i-- > 0; )
+	{
+		pqueue_sift_down (q, i, n);
+	}
+}
+
+/**
+ * Function: pqueue_heapify
+ * ------------------------------------------------------
+ * Public function to build a queue around an existing vector
+ *
+ * param v     - the vector of elements, owned by the queue from now on
+ * param arity - the number of children per heap node
+ * param cmp   - the compare function, smallest element on top
+ *
+ * returns - a pointer to the queue object
+ */
+pqueue *
+pqueue_heapify (vector *v, size_t arity, compare_fn cmp)
+{
+	assert (v != NULL);
+	assert (arity >= 2);
+	assert (cmp != NULL);
+	assert (!v->read_only);
+	pqueue *q;
+
+	q = malloc (sizeof (pqueue));
+	assert (q != NULL);
+
+	q->hole = malloc (v->elem_sz);
+	assert (q->hole != NULL);
+
+	q->heap = v;
+	q->arity = arity;
+	q->elem_cmp = cmp;
+	q->magic = MAGIC_INIT_VALUE;
+
+	/* the heap is built in place, so a clone of v must keep the old order */
+	vector_unshare (v);
+	pqueue_build (q);
+
+	return q;
+}
+
+/**
+ * Function: pqueue_init
+ * ------------------------------------------------------
+ * Public function to perform queue initialization
+ *
+ * param elem_sz - the size of elements in bytes that are stored
+ * param arity   - the number of children per heap node
+ * param cmp     - the compare function, smallest element on top
+ * param fn      - the cleanup function to call when an element is destroyed
+ *
+ * returns - a pointer to the queue object
+ */
+pqueue *
+pqueue_init (size_t elem_sz, size_t arity, compare_fn cmp, elem_destroy_fn fn)
+{
+	assert (elem_sz > 0);
+
+	return pqueue_heapify (vector_init (elem_sz, 0, fn), arity, cmp);
+}
+
+/**
+ * Function: pqueue_destroy
+ * ------------------------------------------------------
+ * Destroys the queue along with its vector and every element in it.
+ */
+void
+pqueue_destroy (pqueue *q)
+{
+	assert (q != NULL);
+	assert (q->magic == MAGIC_INIT_VALUE);
+
+	vector_destroy (q->heap);
+	free (q->hole);
+	free (q);
+}
+
+/**
+ * Function: pqueue_is_empty
+ * ------------------------------------------------------
+ * Checks whether the queue holds no elements.
+ *
+ * param q - initialized queue
+ *
+ * returns - true if the queue is empty
+ */
+bool
+pqueue_is_empty (const pqueue *q)
+{
+	assert (q != NULL);
+	assert (q->magic == MAGIC_INIT_VALUE);
+
+	return q->heap->n_elems == 0;
+}
+
+/**
+ * Function: pqueue_size
+ * ------------------------------------------------------
+ * Gets the number of elements in the queue.
+ *
+ * param q - initialized queue
+ *
+ * returns - the number of elements
+ */
+size_t
+pqueue_size (const pqueue *q)
+{
+	assert (q != NULL);
+	assert (q->magic == MAGIC_INIT_VALUE);
+
+	return q->heap->n_elems;
+}
+
+/**
+ * Function: pqueue_top
+ * ------------------------------------------------------
+ * Gets the smallest element without removing it. The pointer is valid until
+ * the next change to the queue.
+ *
+ * param q - initialized queue
+ *
+ * returns - a pointer to the top element, or NULL if the queue is empty
+ */
+void *
+pqueue_top (pqueue *q)
+{
+	assert (q != NULL);
+	assert (q->magic == MAGIC_INIT_VALUE);
+
+	return (q->heap->n_elems > 0) ? GET_PTR_ELEM (q, 0) : NULL;
+}
+
+/**
+ * Function: pqueue_push
+ * ------------------------------------------------------
+ * Appends a copy of elem as the last leaf and sifts it up.
+ *
+ * param q    - initialized queue
+ * param elem - a pointer to the element to add
+ */
+void
+pqueue_push (pqueue *q, const void *elem)
+{
+	assert (q != NULL);
+	assert (elem != NULL);
+	assert (q->magic == MAGIC_INIT_VALUE);
+
+	vector_append (q->heap, elem);
+	pqueue_sift_up (q, q->heap->n_elems - 1);
+}
+
+/**
+ * Function: pqueue_pop
+ * ------------------------------------------------------
+ * Takes the top element, moves the last element into its place and sifts it
+ * down.
+ *
+ * param q   - initialized queue
+ * param out - where to copy the top element, or NULL to destroy it
+ */
+void
+pqueue_pop (pqueue *q, void *out)
+{
+	assert (q != NULL);
+	assert (q->magic == MAGIC_INIT_VALUE);
+	assert (q->heap->n_elems > 0);
+	size_t n;
+
+	vector_unshare (q->heap);
+	if (out != NULL)
+	{
+		memcpy (out, GET_PTR_ELEM (q, 0), q->heap->elem_sz);
+	}
+	else if (q->heap->elem_destroy)
+	{
+		q->heap->elem_destroy (GET_PTR_ELEM (q, 0));
+	}
+
+	n = --q->heap->n_elems;
+	if (n > 0)
+	{
+		pqueue_move (q, 0, n);
+		pqueue_sift_down (q, 0, n);
+	}
+}
+
+/**
+ * Function: pqueue_push_many
+ * ------------------------------------------------------
+ * Appends the whole batch, then either sifts each new element up, costing
+ * O(k log n), or rebuilds the heap, costing O(n + k), whichever is cheaper
+ * for the batch size.
+ *
+ * param q     - initialized queue
+ * param elems - a flat array of n elements
+ * param n     - the number of elements to add
+ */
+void
+pqueue_push_many (pqueue *q, const void *elems, size_t n)
+{
+	assert (q != NULL);
+	assert (elems != NULL || n == 0);
+	assert (q->magic == MAGIC_INIT_VALUE);
+	size_t old_n = q->heap->n_elems, i;
+
+	for (i = 0; i < n; i++)
+	{
+		vector_append (q->heap, (const char *)elems + i * q->heap->elem_sz);
+	}
+
+	if (n >= old_n)
+	{
+		pqueue_build (q);
+		return;
+	}
+
+	for (i = old_n; i < old_n + n; i++)
+	{
+		pqueue_sift_up (q, i);
+	}
+}
+
+/**
+ * Function: pqueue_pop_many
+ * ------------------------------------------------------
+ * Pops up to n elements in order into out, unsharing the heap once rather
+ * than on every pop.
+ *
+ * param q   - initialized queue
+ * param out - room for n elements
+ * param n   - the most elements to take
+ *
+ * returns - the number of elements taken, fewer than n if the queue ran out
+ */
+size_t
+pqueue_pop_many (pqueue *q, void *out, size_t n)
+{
+	assert (q != NULL);
+	assert (out != NULL || n == 0);
+	assert (q->magic == MAGIC_INIT_VALUE);
+	size_t i;
+
+	if (n > q->heap->n_elems)
+	{
+		n = q->heap->n_elems;
+	}
+
+	vector_unshare (q->heap);
+	for (i = 0; i < n; i++)
+	{
+		pqueue_pop (q, (char *)out + i * q->heap->elem_sz);
+	}
+
+	return n;
+}
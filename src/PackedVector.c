@@ -0,0 +1,635 @@
+/**
+ * File: PackedVector.c
+ * Author: Seth Charles
+ * ----------------------
+ */
+#include "PackedVector.h"
+#include <assert.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define MAGIC_INIT_VALUE     (0x3b94d07e52a16fc8)
+#define BLOCK                (PACKED_VECTOR_BLOCK)
+#define LANES                (4)
+#define HEADER_SZ            (8)
+#define EXCEPTION_SZ         (1 + sizeof (uint32_t))
+#define RAW_WIDTH            (64)
+#define MAX_BLOCK_SZ         (HEADER_SZ + BLOCK * sizeof (uint64_t))
+#define WIDTH_MASK(B)        (((B) == 32) ? UINT32_MAX : (1U << (B)) - 1)
+
+/*
+ * An encoded block is an eight byte header followed by its body:
+ *
+ *   byte 0     the bit width b, or RAW_WIDTH for a block stored as it is
+ *   byte 1     the number of exceptions
+ *   bytes 4-7  m, the smallest difference between values four apart
+ *
+ * Value i of the block is stored as the offset o[i] = v[i] - v[0], which must
+ * fit in 32 bits, by way of the residual
+ *
+ *   r[i] = o[i] - o[i - 4] - m     for i >= 4
+ *   r[i] = o[i]                    for i < 4
+ *
+ * Differences four apart rather than one apart let four lanes add up the
+ * offsets at once, each lane carrying its own running sum. The low b bits of
+ * each residual are packed into 4 * b words of 32 bits: residual i goes in
+ * lane i % 4, at bit (i / 4) * b of the lane, where word w of a lane is word
+ * 4 * w + lane of the array, so a 16 byte load fetches the same word of
+ * every lane. After the 16 * b bytes of packed words comes the position of
+ * each exception, a byte each, and then the bits of its residual above the
+ * low b, four bytes each.
+ *
+ * A block whose values span 2^32 or more is stored raw, as 128 values of
+ * eight bytes.
+ */
+
+/**
+ * Function: packed_vector_reserve
+ * ------------------------------------------------------
+ * Makes room for one more block, in both the data and the skip index.
+ */
+static void
+packed_vector_reserve (packed_vector *pv)
+{
+	if (pv->data_sz + MAX_BLOCK_SZ > pv->data_capacity)
+	{
+		pv->data_capacity = 2 * pv->data_capacity + MAX_BLOCK_SZ;
+		pv->data = realloc (pv->data, pv->data_capacity);
+		assert (pv->data != NULL);
+	}
+	if (pv->n_blocks == pv->block_capacity)
+	{
+		pv->block_capacity = 2 * pv->block_capacity + 16;
+		pv->firsts = realloc (pv->firsts, pv->block_capacity * sizeof (uint64_t));
+		pv->offsets = realloc (pv->offsets, pv->block_capacity * sizeof (uint64_t));
+		assert (pv->firsts != NULL && pv->offsets != NULL);
+	}
+}
+
+/**
+ * Function: bit_length
+ * ------------------------------------------------------
+ * Counts the bits needed to hold x, 0 for 0.
+ */
+static inline unsigned
+bit_length (uint32_t x)
+{
+	return (x == 0) ? 0 : 32 - (unsigned)__builtin_clz (x);
+}
+
+/**
+ * Function: packed_vector_width
+ * ------------------------------------------------------
+ * Picks the bit width that makes the block smallest. Each residual wider
+ * than b costs an exception on top of its b packed bits, so b is traded off
+ * against how many residuals overflow it, counted from a histogram of their
+ * bit lengths.
+ */
+static unsigned
+packed_vector_width (const uint32_t *res, unsigned *n_exceptions)
+{
+	size_t lengths[33] = { 0 }, exceptions = 0, cost, best_cost = SIZE_MAX;
+	unsigned b, best = 32;
+	size_t i;
+
+	for (i = 0; i < BLOCK; i++)
+	{
+		lengths[bit_length (res[i])]++;
+	}
+	for (b = 32; ; b--)
+	{
+		cost = 16 * b + EXCEPTION_SZ * exceptions;
+		if (cost < best_cost)
+		{
+			best_cost = cost;
+			best = b;
+			*n_exceptions = (unsigned)exceptions;
+		}
+		if (b == 0)
+		{
+			break;
+		}
+		exceptions += lengths[b];
+	}
+	return best;
+}
+
+/**
+ * Function: packed_vector_encode
+ * ------------------------------------------------------
+ * Encodes the full tail as a new block at the end of data and records it in
+ * the skip index.
+ */
+static void
+packed_vector_encode (packed_vector *pv)
+{
+	const uint64_t *v = pv->tail;
+	uint32_t res[BLOCK], words[LANES * 32], m = UINT32_MAX, d, low, mask;
+	uint8_t *out;
+	unsigned b, n_exceptions = 0, lane, shift;
+	size_t i, word;
+
+	packed_vector_reserve (pv);
+	out = pv->data + pv->data_sz;
+	pv->firsts[pv->n_blocks] = v[0];
+	pv->offsets[pv->n_blocks] = pv->data_sz;
+	pv->n_blocks++;
+
+	memset (out, 0, HEADER_SZ);
+	if (v[BLOCK - 1] - v[0] > UINT32_MAX)
+	{
+		out[0] = RAW_WIDTH;
+		memcpy (out + HEADER_SZ, v, BLOCK * sizeof (uint64_t));
+		pv->data_sz += HEADER_SZ + BLOCK * sizeof (uint64_t);
+		return;
+	}
+
+	for (i = LANES; i < BLOCK; i++)
+	{
+		d = (uint32_t)(v[i] - v[i - LANES]);
+		m = (d < m) ? d : m;
+	}
+	for (i = 0; i < BLOCK; i++)
+	{
+		res[i] = (i < LANES) ? (uint32_t)(v[i] - v[0]) : (uint32_t)(v[i] - v[i - LANES]) - m;
+	}
+
+	b = packed_vector_width (res, &n_exceptions);
+	mask = WIDTH_MASK (b);
+	out[0] = (uint8_t)b;
+	out[1] = (uint8_t)n_exceptions;
+	memcpy (out + 4, &m, sizeof (uint32_t));
+	out += HEADER_SZ;
+
+	if (b > 0)
+	{
+		memset (words, 0, LANES * b * sizeof (uint32_t));
+		for (i = 0; i < BLOCK; i++)
+		{
+			lane = (unsigned)(i % LANES);
+			word = (i / LANES) * b / 32;
+			shift = (unsigned)((i / LANES) * b % 32);
+			low = res[i] & mask;
+			words[word * LANES + lane] |= low << shift;
+			if (shift + b > 32)
+			{
+				words[(word + 1) * LANES + lane] |= low >> (32 - shift);
+			}
+		}
+		memcpy (out, words, LANES * b * sizeof (uint32_t));
+		out += LANES * b * sizeof (uint32_t);
+	}
+
+	if (n_exceptions > 0)
+	{
+		uint8_t *positions = out;
+		uint8_t *highs = out + n_exceptions;
+
+		for (i = 0; i < BLOCK; i++)
+		{
+			if (bit_length (res[i]) > b)
+			{
+				d = res[i] >> b;
+				*positions++ = (uint8_t)i;
+				memcpy (highs, &d, sizeof (uint32_t));
+				highs += sizeof (uint32_t);
+			}
+		}
+		out = highs;
+	}
+	pv->data_sz = (size_t)(out - pv->data);
+}
+
+#ifdef __SSE2__
+
+/**
+ * Function: packed_vector_unpack_width
+ * ------------------------------------------------------
+ * Unpacks the residuals of a block packed at width b, four lanes per step.
+ * Inlined with b a constant, the loop unrolls into fixed shifts, with a
+ * second load and merge only at the steps where a value crosses into the
+ * next word.
+ */
+static inline __attribute__ ((always_inline)) void
+packed_vector_unpack_width (const uint8_t *in, uint32_t *res, const unsigned b)
+{
+	const __m128i *words = (const __m128i *)in;
+	const __m128i mask = _mm_set1_epi32 ((int)WIDTH_MASK (b));
+	__m128i w = _mm_loadu_si128 (words), x;
+	unsigned k, word = 0, shift = 0;
+
+#pragma GCC unroll 32
+	for (k = 0; k < 32; k++)
+	{
+		x = _mm_srli_epi32 (w, (int)shift);
+		if (shift + b >= 32 && ++word < b)
+		{
+			w = _mm_loadu_si128 (words + word);
+			if (shift + b > 32)
+			{
+				x = _mm_or_si128 (x, _mm_slli_epi32 (w, (int)(32 - shift)));
+			}
+		}
+		shift = (shift + b) % 32;
+		_mm_storeu_si128 ((__m128i *)(res + LANES * k), _mm_and_si128 (x, mask));
+	}
+}
+
+#define UNPACK_CASE(B) case B: packed_vector_unpack_width (in, res, B); break;
+
+/**
+ * Function: packed_vector_unpack
+ * ------------------------------------------------------
+ * Unpacks the residuals of a block packed at width b, dispatching to a copy
+ * of packed_vector_unpack_width specialised for that width. A width of 32
+ * is stored unpacked and a width of 0 holds only zeros.
+ */
+static void
+packed_vector_unpack (const uint8_t *in, uint32_t *res, unsigned b)
+{
+	switch (b)
+	{
+	UNPACK_CASE (1)  UNPACK_CASE (2)  UNPACK_CASE (3)  UNPACK_CASE (4)
+	UNPACK_CASE (5)  UNPACK_CASE (6)  UNPACK_CASE (7)  UNPACK_CASE (8)
+	UNPACK_CASE (9)  UNPACK_CASE (10) UNPACK_CASE (11) UNPACK_CASE (12)
+	UNPACK_CASE (13) UNPACK_CASE (14) UNPACK_CASE (15) UNPACK_CASE (16)
+	UNPACK_CASE (17) UNPACK_CASE (18) UNPACK_CASE (19) UNPACK_CASE (20)
+	UNPACK_CASE (21) UNPACK_CASE (22) UNPACK_CASE (23) UNPACK_CASE (24)
+	UNPACK_CASE (25) UNPACK_CASE (26) UNPACK_CASE (27) UNPACK_CASE (28)
+	UNPACK_CASE (29) UNPACK_CASE (30) UNPACK_CASE (31)
+	case 32: memcpy (res, in, BLOCK * sizeof (uint32_t)); break;
+	default: memset (res, 0, BLOCK * sizeof (uint32_t)); break;
+	}
+}
+
+/**
+ * Function: packed_vector_prefix
+ * ------------------------------------------------------
+ * Turns residuals back into values. Each lane adds m and its residual to
+ * the offset four back, then the offsets are widened to 64 bits and the
+ * first value added.
+ */
+static void
+packed_vector_prefix (const uint32_t *res, uint32_t m, uint64_t first, uint64_t *out)
+{
+	const __m128i step = _mm_set1_epi32 ((int)m), zero = _mm_setzero_si128 ();
+	const __m128i base = _mm_set1_epi64x ((long long)first);
+	__m128i sum = _mm_sub_epi32 (zero, step), r;
+	size_t k;
+
+	for (k = 0; k < BLOCK; k += LANES)
+	{
+		r = _mm_loadu_si128 ((const __m128i *)(res + k));
+		sum = _mm_add_epi32 (sum, _mm_add_epi32 (r, step));
+		_mm_storeu_si128 ((__m128i *)(out + k), _mm_add_epi64 (_mm_unpacklo_epi32 (sum, zero), base));
+		_mm_storeu_si128 ((__m128i *)(out + k + 2), _mm_add_epi64 (_mm_unpackhi_epi32 (sum, zero), base));
+	}
+}
+
+#else
+
+/**
+ * Function: packed_vector_unpack
+ * ------------------------------------------------------
+ * Unpacks the residuals of a block packed at width b one value at a time,
+ * from the same interleaved layout of four lanes.
+ */
+static void
+packed_vector_unpack (const uint8_t *in, uint32_t *res, unsigned b)
+{
+	uint32_t words[LANES * 32], mask = WIDTH_MASK (b), x;
+	size_t i, word;
+	unsigned shift;
+
+	if (b == 0)
+	{
+		memset (res, 0, BLOCK * sizeof (uint32_t));
+		return;
+	}
+	memcpy (words, in, LANES * b * sizeof (uint32_t));
+	for (i = 0; i < BLOCK; i++)
+	{
+		word = (i / LANES) * b / 32;
+		shift = (unsigned)((i / LANES) * b % 32);
+		x = words[word * LANES + i % LANES] >> shift;
+		if (shift + b > 32)
+		{
+			x |= words[(word + 1) * LANES + i % LANES] << (32 - shift);
+		}
+		res[i] = x & mask;
+	}
+}
+
+/**
+ * Function: packed_vector_prefix
+ * ------------------------------------------------------
+ * Turns residuals back into values, keeping a running offset per lane as
+ * the vector version does.
+ */
+static void
+packed_vector_prefix (const uint32_t *res, uint32_t m, uint64_t first, uint64_t *out)
+{
+	uint32_t sum[LANES];
+	size_t i;
+
+	for (i = 0; i < LANES; i++)
+	{
+		sum[i] = 0 - m;
+	}
+	for (i = 0; i < BLOCK; i++)
+	{
+		sum[i % LANES] += res[i] + m;
+		out[i] = first + sum[i % LANES];
+	}
+}
+
+#endif
+
+/**
+ * Function: packed_vector_decode
+ * ------------------------------------------------------
+ * Decodes every value of a block into out. A block spans a few cache lines
+ * that would otherwise miss one after another as the header, the packed
+ * words and the exceptions are reached, so for a block read out of order
+ * all of them are prefetched at once.
+ */
+static void
+packed_vector_decode (const packed_vector *pv, size_t block, uint64_t *out)
+{
+	const uint8_t *in = pv->data + pv->offsets[block];
+	const uint8_t *end = (block + 1 < pv->n_blocks) ? pv->data + pv->offsets[block + 1]
+	                                                : pv->data + pv->data_sz;
+	const uint8_t *positions, *highs, *line;
+	uint32_t res[BLOCK], m, high;
+	unsigned b, n_exceptions, i;
+
+	for (line = in; line < end; line += CACHE_LINE_SZ)
+	{
+		__builtin_prefetch (line);
+	}
+	b = in[0];
+	n_exceptions = in[1];
+
+	if (b == RAW_WIDTH)
+	{
+		memcpy (out, in + HEADER_SZ, BLOCK * sizeof (uint64_t));
+		return;
+	}
+	memcpy (&m, in + 4, sizeof (uint32_t));
+	in += HEADER_SZ;
+
+	packed_vector_unpack (in, res, b);
+	positions = in + LANES * b * sizeof (uint32_t);
+	highs = positions + n_exceptions;
+	for (i = 0; i < n_exceptions; i++)
+	{
+		memcpy (&high, highs + i * sizeof (uint32_t), sizeof (uint32_t));
+		res[positions[i]] |= high << b;
+	}
+	packed_vector_prefix (res, m, pv->firsts[block], out);
+}
+
+/**
+ * Function: packed_vector_lower_bound
+ * ------------------------------------------------------
+ * Returns the number of values in a sorted run below value, by a binary
+ * search whose steps do not branch on the comparisons.
+ */
+static size_t
+packed_vector_lower_bound (const uint64_t *values, size_t n, uint64_t value)
+{
+	const uint64_t *base = values;
+	size_t half;
+
+	if (n == 0)
+	{
+		return 0;
+	}
+	while (n > 1)
+	{
+		half = n / 2;
+		base = (base[half - 1] < value) ? base + half : base;
+		n -= half;
+	}
+	return (size_t)(base - values) + (*base < value);
+}
+
+/**
+ * Function: packed_vector_init
+ * ------------------------------------------------------
+ * Public function to perform packed_vector initialization
+ *
+ * returns - a pointer to the packed_vector object
+ */
+packed_vector *
+packed_vector_init (void)
+{
+	packed_vector *pv = calloc (1, sizeof (packed_vector));
+	assert (pv != NULL);
+
+	pv->magic = MAGIC_INIT_VALUE;
+	return pv;
+}
+
+/**
+ * Function: packed_vector_destroy
+ * ------------------------------------------------------
+ * Frees the packed blocks, the skip index and the packed_vector.
+ */
+void
+packed_vector_destroy (packed_vector *pv)
+{
+	assert (pv != NULL);
+	assert (pv->magic == MAGIC_INIT_VALUE);
+
+	free (pv->data);
+	free (pv->firsts);
+	free (pv->offsets);
+	free (pv);
+}
+
+/**
+ * Function: packed_vector_size
+ * ------------------------------------------------------
+ * Gets the number of values appended.
+ */
+size_t
+packed_vector_size (const packed_vector *pv)
+{
+	assert (pv != NULL);
+	assert (pv->magic == MAGIC_INIT_VALUE);
+
+	return pv->n_elems;
+}
+
+/**
+ * Function: packed_vector_bytes
+ * ------------------------------------------------------
+ * Counts the bytes the values take: the packed blocks, the skip index of
+ * two words per block and the raw values of the tail.
+ */
+size_t
+packed_vector_bytes (const packed_vector *pv)
+{
+	assert (pv != NULL);
+	assert (pv->magic == MAGIC_INIT_VALUE);
+
+	return pv->data_sz + pv->n_blocks * 2 * sizeof (uint64_t)
+	       + (pv->n_elems % BLOCK) * sizeof (uint64_t);
+}
+
+/**
+ * Function: packed_vector_append
+ * ------------------------------------------------------
+ * Adds the value to the tail, which is encoded as a block once full.
+ */
+void
+packed_vector_append (packed_vector *pv, uint64_t value)
+{
+	assert (pv != NULL);
+	assert (pv->magic == MAGIC_INIT_VALUE);
+	assert (pv->n_elems == 0 || value >= pv->last);
+
+	pv->tail[pv->n_elems % BLOCK] = value;
+	pv->last = value;
+	if (++pv->n_elems % BLOCK == 0)
+	{
+		packed_vector_encode (pv);
+	}
+}
+
+/**
+ * Function: packed_vector_get
+ * ------------------------------------------------------
+ * Reads the value at index from the tail, or else by decoding its block,
+ * so reading a run is cheaper through an iterator.
+ */
+uint64_t
+packed_vector_get (const packed_vector *pv, size_t index)
+{
+	assert (pv != NULL);
+	assert (pv->magic == MAGIC_INIT_VALUE);
+	assert (index < pv->n_elems);
+	uint64_t values[BLOCK];
+
+	if (index / BLOCK == pv->n_blocks)
+	{
+		return pv->tail[index % BLOCK];
+	}
+	packed_vector_decode (pv, index / BLOCK, values);
+	return values[index % BLOCK];
+}
+
+/**
+ * Function: packed_vector_search
+ * ------------------------------------------------------
+ * Every block before lo in the skip index starts below value, and every
+ * block from lo on starts at or above it. So the first value no smaller
+ * than it lies in block lo - 1, or failing that is the first of block lo,
+ * and at most one block is decoded.
+ */
+bool
+packed_vector_search (const packed_vector *pv, uint64_t value, size_t *index)
+{
+	assert (pv != NULL);
+	assert (pv->magic == MAGIC_INIT_VALUE);
+	uint64_t values[BLOCK];
+	size_t lo = 0, hi = pv->n_blocks, mid, pos, at;
+	bool found;
+
+	while (lo < hi)
+	{
+		mid = lo + (hi - lo) / 2;
+		if (pv->firsts[mid] < value)
+		{
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+
+	pos = BLOCK;
+	if (lo > 0)
+	{
+		packed_vector_decode (pv, lo - 1, values);
+		pos = packed_vector_lower_bound (values, BLOCK, value);
+	}
+	if (pos < BLOCK)
+	{
+		at = (lo - 1) * BLOCK + pos;
+		found = values[pos] == value;
+	}
+	else if (lo < pv->n_blocks)
+	{
+		at = lo * BLOCK;
+		found = pv->firsts[lo] == value;
+	}
+	else
+	{
+		pos = packed_vector_lower_bound (pv->tail, pv->n_elems % BLOCK, value);
+		at = lo * BLOCK + pos;
+		found = at < pv->n_elems && pv->tail[pos] == value;
+	}
+
+	if (index != NULL)
+	{
+		*index = at;
+	}
+	return found;
+}
+
+/**
+ * Function: packed_vector_iter_init
+ * ------------------------------------------------------
+ * Points the iterator at the block holding start and skips the values of
+ * that block before it. Nothing is decoded until the first call to next.
+ */
+void
+packed_vector_iter_init (const packed_vector *pv, packed_vector_iter *it, size_t start)
+{
+	assert (pv != NULL);
+	assert (it != NULL);
+	assert (pv->magic == MAGIC_INIT_VALUE);
+	assert (start <= pv->n_elems);
+
+	it->pv = pv;
+	it->block = start / BLOCK;
+	it->skip = start % BLOCK;
+}
+
+/**
+ * Function: packed_vector_iter_next
+ * ------------------------------------------------------
+ * Full blocks are decoded into the iterator's buffer, while the tail is
+ * returned where it lies.
+ */
+size_t
+packed_vector_iter_next (packed_vector_iter *it, const uint64_t **values)
+{
+	assert (it != NULL);
+	assert (values != NULL);
+	assert (it->pv != NULL && it->pv->magic == MAGIC_INIT_VALUE);
+	const packed_vector *pv = it->pv;
+	size_t skip = it->skip, n;
+
+	it->skip = 0;
+	if (it->block < pv->n_blocks)
+	{
+		packed_vector_decode (pv, it->block++, it->buf);
+		*values = it->buf + skip;
+		return BLOCK - skip;
+	}
+	if (it->block == pv->n_blocks)
+	{
+		it->block++;
+		n = pv->n_elems % BLOCK;
+		*values = pv->tail + skip;
+		return n - skip;
+	}
+	return 0;
+}
@@ -0,0 +1,498 @@
+/**
+ * File: RingBuffer.c
+ * Author: Seth Charles
+ * ----------------------
+ */
+#include "RingBuffer.h"
+#include <assert.h>
+#include <string.h>
+#include <stdio.h>
+
+#define MAGIC_INIT_VALUE       (0x739caf14a2d9e85f)
+#define GET_PTR_SLOT(R, SLOT)  ((char *)(R)->elems + ((SLOT) * (R)->elem_sz))
+#define GET_PTR_CELL(R, POS)   ((R)->cells + (((POS) & (R)->mask) * (R)->cell_sz))
+#define CELL_SEQ(CELL)         ((atomic_size_t *)(CELL))
+#define CELL_DATA(CELL)        ((CELL) + sizeof (atomic_size_t))
+
+/**
+ * Function: ring_capacity
+ * ------------------------------------------------------
+ * Rounds a requested capacity up to a power of two.
+ */
+static size_t
+ring_capacity (size_t requested)
+{
+	size_t capacity = 1;
+
+	while (capacity < requested)
+	{
+		capacity *= 2;
+	}
+	return capacity;
+}
+
+/**
+ * Function: spsc_ring_copy_in
+ * ------------------------------------------------------
+ * Copies n elements from a flat array into the buffer starting at slot, in
+ * two pieces if the run wraps.
+ */
+static void
+spsc_ring_copy_in (spsc_ring *r, size_t slot, const void *src, size_t n)
+{
+	size_t first = r->mask + 1 - slot;
+
+	if (first > n)
+	{
+		first = n;
+	}
+
+	memcpy (GET_PTR_SLOT (r, slot), src, first * r->elem_sz);
+	memcpy (r->elems, (const char *)src + first * r->elem_sz, (n - first) * r->elem_sz);
+}
+
+/**
+ * Function: spsc_ring_copy_out
+ * ------------------------------------------------------
+ * Copies n elements starting at slot out to a flat array, in two pieces if
+ * the run wraps.
+ */
+static void
+spsc_ring_copy_out (const spsc_ring *r, size_t slot, void *dst, size_t n)
+{
+	size_t first = r->mask + 1 - slot;
+
+	if (first > n)
+	{
+		first = n;
+	}
+
+	memcpy (dst, GET_PTR_SLOT (r, slot), first * r->elem_sz);
+	memcpy ((char *)dst + first * r->elem_sz, r->elems, (n - first) * r->elem_sz);
+}
+
+/**
+ * Function: spsc_ring_init
+ * ------------------------------------------------------
+ * Public function to perform ring initialization. The ring is allocated on
+ * a cache line boundary so that the alignment of its index fields holds.
+ *
+ * param elem_sz  - the size of elements in bytes that are stored
+ * param capacity - the minimum number of elements the ring holds
+ * param fn       - the cleanup function to call on elements left at destroy
+ *
+ * returns - a pointer to the ring object
+ */
+spsc_ring *
+spsc_ring_init (size_t elem_sz, size_t capacity, elem_destroy_fn fn)
+{
+	assert (elem_sz > 0);
+	assert (capacity > 0);
+	spsc_ring *r;
+
+	r = aligned_alloc (CACHE_LINE_SZ, sizeof (spsc_ring));
+	assert (r != NULL);
+
+	capacity = ring_capacity (capacity);
+	r->elems = malloc (capacity * elem_sz);
+	assert (r->elems != NULL);
+
+	atomic_init (&r->head, 0);
+	atomic_init (&r->tail, 0);
+	r->cached_head = 0;
+	r->cached_tail = 0;
+	r->mask = capacity - 1;
+	r->elem_sz = elem_sz;
+	r->elem_destroy = fn;
+	r->magic = MAGIC_INIT_VALUE;
+
+	return r;
+}
+
+/**
+ * Function: spsc_ring_destroy
+ * ------------------------------------------------------
+ * Destroys the ring, calling the destroy function on elements not dequeued.
+ *
+ * param r - the ring to destroy
+ */
+void
+spsc_ring_destroy (spsc_ring *r)
+{
+	assert (r != NULL);
+	assert (r->magic == MAGIC_INIT_VALUE);
+
+	size_t pos, tail = atomic_load (&r->tail);
+
+	if (r->elem_destroy)
+	{
+		for (pos = atomic_load (&r->head); pos != tail; pos++)
+		{
+			r->elem_destroy (GET_PTR_SLOT (r, pos & r->mask));
+		}
+	}
+
+	free (r->elems);
+	free (r);
+}
+
+/**
+ * Function: spsc_ring_size
+ * ------------------------------------------------------
+ */
+size_t
+spsc_ring_size (const spsc_ring *r)
+{
+	assert (r != NULL);
+	assert (r->magic == MAGIC_INIT_VALUE);
+
+	/* head first, so the later view of tail can only be further ahead */
+	size_t head = atomic_load_explicit (&r->head, memory_order_acquire);
+	return atomic_load_explicit (&r->tail, memory_order_acquire) - head;
+}
+
+/**
+ * Function: spsc_ring_enqueue
+ * ------------------------------------------------------
+ */
+bool
+spsc_ring_enqueue (spsc_ring *r, const void *elem)
+{
+	return spsc_ring_enqueue_many (r, elem, 1) == 1;
+}
+
+/**
+ * Function: spsc_ring_dequeue
+ * ------------------------------------------------------
+ */
+bool
+spsc_ring_dequeue (spsc_ring *r, void *out)
+{
+	return spsc_ring_dequeue_many (r, out, 1) == 1;
+}
+
+/**
+ * Function: spsc_ring_enqueue_many
+ * ------------------------------------------------------
+ * Free space is first judged from the cached head, which only ever
+ * understates it. The consumer's line is touched only when the cached view
+ * is too small for the batch. The release store of tail publishes the
+ * copied elements.
+ *
+ * param r     - initialized ring
+ * param elems - the array of elements to enqueue by copy
+ * param n     - the number of elements in the array
+ *
+ * returns - the number of elements enqueued
+ */
+size_t
+spsc_ring_enqueue_many (spsc_ring *r, const void *elems, size_t n)
+{
+	assert (r != NULL);
+	assert (elems != NULL);
+	assert (r->magic == MAGIC_INIT_VALUE);
+
+	size_t tail = atomic_load_explicit (&r->tail, memory_order_relaxed);
+	size_t space = r->mask + 1 - (tail - r->cached_head);
+
+	if (space < n)
+	{
+		r->cached_head = atomic_load_explicit (&r->head, memory_order_acquire);
+		space = r->mask + 1 - (tail - r->cached_head);
+	}
+
+	if (n > space)
+	{
+		n = space;
+	}
+
+	if (n > 0)
+	{
+		spsc_ring_copy_in (r, tail & r->mask, elems, n);
+		atomic_store_explicit (&r->tail, tail + n, memory_order_release);
+	}
+
+	return n;
+}
+
+/**
+ * Function: spsc_ring_dequeue_many
+ * ------------------------------------------------------
+ * Mirror of the enqueue. The release store of head hands the slots back to
+ * the producer only after the elements have been copied out.
+ *
+ * param r   - initialized ring
+ * param out - where to copy the dequeued elements
+ * param n   - the maximum number of elements to dequeue
+ *
+ * returns - the number of elements dequeued
+ */
+size_t
+spsc_ring_dequeue_many (spsc_ring *r, void *out, size_t n)
+{
+	assert (r != NULL);
+	assert (out != NULL);
+	assert (r->magic == MAGIC_INIT_VALUE);
+
+	size_t head = atomic_load_explicit (&r->head, memory_order_relaxed);
+	size_t avail = r->cached_tail - head;
+
+	if (avail < n)
+	{
+		r->cached_tail = atomic_load_explicit (&r->tail, memory_order_acquire);
+		avail = r->cached_tail - head;
+	}
+
+	if (n > avail)
+	{
+		n = avail;
+	}
+
+	if (n > 0)
+	{
+		spsc_ring_copy_out (r, head & r->mask, out, n);
+		atomic_store_explicit (&r->head, head + n, memory_order_release);
+	}
+
+	return n;
+}
+
+/**
+ * Function: mpmc_ring_init
+ * ------------------------------------------------------
+ * Public function to perform ring initialization. Cell i starts with
+ * sequence i, meaning it is free for the producer that claims position i.
+ *
+ * param elem_sz  - the size of elements in bytes that are stored
+ * param capacity - the minimum number of elements the ring holds
+ * param fn       - the cleanup function to call on elements left at destroy
+ *
+ * returns - a pointer to the ring object
+ */
+mpmc_ring *
+mpmc_ring_init (size_t elem_sz, size_t capacity, elem_destroy_fn fn)
+{
+	assert (elem_sz > 0);
+	assert (capacity > 0);
+	mpmc_ring *r;
+	size_t i;
+
+	r = aligned_alloc (CACHE_LINE_SZ, sizeof (mpmc_ring));
+	assert (r != NULL);
+
+	capacity = ring_capacity (capacity < 2 ? 2 : capacity);
+	r->elem_sz = elem_sz;
+	r->cell_sz = (sizeof (atomic_size_t) + elem_sz + sizeof (size_t) - 1)
+	             & ~(sizeof (size_t) - 1);
+	r->mask = capacity - 1;
+
+	r->cells = malloc (capacity * r->cell_sz);
+	assert (r->cells != NULL);
+
+	for (i = 0; i < capacity; i++)
+	{
+		atomic_init (CELL_SEQ (GET_PTR_CELL (r, i)), i);
+	}
+
+	atomic_init (&r->enqueue_pos, 0);
+	atomic_init (&r->dequeue_pos, 0);
+	r->elem_destroy = fn;
+	r->magic = MAGIC_INIT_VALUE;
+
+	return r;
+}
+
+/**
+ * Function: mpmc_ring_destroy
+ * ------------------------------------------------------
+ * Destroys the ring, calling the destroy function on elements not dequeued.
+ *
+ * param r - the ring to destroy
+ */
+void
+mpmc_ring_destroy (mpmc_ring *r)
+{
+	assert (r != NULL);
+	assert (r->magic == MAGIC_INIT_VALUE);
+
+	size_t pos, end = atomic_load (&r->enqueue_pos);
+
+	if (r->elem_destroy)
+	{
+		for (pos = atomic_load (&r->dequeue_pos); pos != end; pos++)
+		{
+			r->elem_destroy (CELL_DATA (GET_PTR_CELL (r, pos)));
+		}
+	}
+
+	free (r->cells);
+	free (r);
+}
+
+/**
+ * Function: mpmc_ring_size
+ * ------------------------------------------------------
+ */
+size_t
+mpmc_ring_size (const mpmc_ring *r)
+{
+	assert (r != NULL);
+	assert (r->magic == MAGIC_INIT_VALUE);
+
+	size_t dequeue_pos = atomic_load_explicit (&r->dequeue_pos, memory_order_acquire);
+	return atomic_load_explicit (&r->enqueue_pos, memory_order_acquire) - dequeue_pos;
+}
+
+/**
+ * Function: mpmc_ring_enqueue
+ * ------------------------------------------------------
+ */
+bool
+mpmc_ring_enqueue (mpmc_ring *r, const void *elem)
+{
+	return mpmc_ring_enqueue_many (r, elem, 1) == 1;
+}
+
+/**
+ * Function: mpmc_ring_dequeue
+ * ------------------------------------------------------
+ */
+bool
+mpmc_ring_dequeue (mpmc_ring *r, void *out)
+{
+	return mpmc_ring_dequeue_many (r, out, 1) == 1;
+}
+
+/**
+ * Function: mpmc_ring_enqueue_many
+ * ------------------------------------------------------
+ * Counts how many cells from the current position are free for this lap,
+ * then claims them all by moving enqueue_pos past them. A cell whose
+ * sequence is behind the position still holds an element from the previous
+ * lap, so the ring is full. A sequence ahead of it means another producer
+ * claimed the position first, and the scan restarts from the new position.
+ * Each element is published by storing the sequence one past its position.
+ *
+ * param r     - initialized ring
+ * param elems - the array of elements to enqueue by copy
+ * param n     - the number of elements in the array
+ *
+ * returns - the number of elements enqueued
+ */
+size_t
+mpmc_ring_enqueue_many (mpmc_ring *r, const void *elems, size_t n)
+{
+	assert (r != NULL);
+	assert (elems != NULL);
+	assert (r->magic == MAGIC_INIT_VALUE);
+
+	size_t pos, seq = 0, k, i;
+	uint8_t *cell;
+
+	pos = atomic_load_explicit (&r->enqueue_pos, memory_order_relaxed);
+
+	for (;;)
+	{
+		for (k = 0; k < n && k <= r->mask; k++)
+		{
+			cell = GET_PTR_CELL (r, pos + k);
+			seq = atomic_load_explicit (CELL_SEQ (cell), memory_order_acquire);
+			if (seq != pos + k)
+			{
+				break;
+			}
+		}
+
+		if (k == 0)
+		{
+			if (n == 0 || (intptr_t)(seq - pos) < 0)
+			{
+				return 0;
+			}
+			pos = atomic_load_explicit (&r->enqueue_pos, memory_order_relaxed);
+			continue;
+		}
+
+		if (atomic_compare_exchange_weak_explicit (&r->enqueue_pos, &pos, pos + k,
+		                                           memory_order_relaxed,
+		                                           memory_order_relaxed))
+		{
+			break;
+		}
+	}
+
+	for (i = 0; i < k; i++)
+	{
+		cell = GET_PTR_CELL (r, pos + i);
+		memcpy (CELL_DATA (cell), (const char *)elems + i * r->elem_sz, r->elem_sz);
+		atomic_store_explicit (CELL_SEQ (cell), pos + i + 1, memory_order_release);
+	}
+
+	return k;
+}
+
+/**
+ * Function: mpmc_ring_dequeue_many
+ * ------------------------------------------------------
+ * Counts how many cells from the current position hold published elements,
+ * claims them by moving dequeue_pos past them, and copies them out. Each
+ * cell is released to the producer of the next lap by storing its position
+ * plus the capacity as the sequence.
+ *
+ * param r   - initialized ring
+ * param out - where to copy the dequeued elements
+ * param n   - the maximum number of elements to dequeue
+ *
+ * returns - the number of elements dequeued
+ */
+size_t
+mpmc_ring_dequeue_many (mpmc_ring *r, void *out, size_t n)
+{
+	assert (r != NULL);
+	assert (out != NULL);
+	assert (r->magic == MAGIC_INIT_VALUE);
+
+	size_t pos, seq = 0, k, i;
+	uint8_t *cell;
+
+	pos = atomic_load_explicit (&r->dequeue_pos, memory_order_relaxed);
+
+	for (;;)
+	{
+		for (k = 0; k < n && k <= r->mask; k++)
+		{
+			cell = GET_PTR_CELL (r, pos + k);
+			seq = atomic_load_explicit (CELL_SEQ (cell), memory_order_acquire);
+			if (seq != pos + k + 1)
+			{
+				break;
+			}
+		}
+
+		if (k == 0)
+		{
+			if (n == 0 || (intptr_t)(seq - (pos + 1)) < 0)
+			{
+				return 0;
+			}
+			pos = atomic_load_explicit (&r->dequeue_pos, memory_order_relaxed);
+			continue;
+		}
+
+		if (atomic_compare_exchange_weak_explicit (&r->dequeue_pos, &pos, pos + k,
+		                                           memory_order_relaxed,
+		                                           memory_order_relaxed))
+		{
+			break;
+		}
+	}
+
+	for (i = 0; i < k; i++)
+	{
+		cell = GET_PTR_CELL (r, pos + i);
+		memcpy ((char *)out + i * r->elem_sz, CELL_DATA (cell), r->elem_sz);
+		atomic_store_explicit (CELL_SEQ (cell), pos + i + r->mask + 1, memory_order_release);
+	}
+
+	return k;
+}
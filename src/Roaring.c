@@ -0,0 +1,1879 @@
+/**
+ * File: Roaring.c
+ * Author: Seth Charles
+ * ----------------------
+ */
+#include "Roaring.h"
+#include "ADT_stream.h"
+#include <assert.h>
+#include <string.h>
+
+#define MAGIC_INIT_VALUE (0x5ad3e9172c60b84f)
+#define STREAM_MAGIC     (0x4d52545352544441ULL) /* "ADTRSTRM" */
+#define CHUNK_VALUES     (65536)
+#define BITMAP_WORDS     (CHUNK_VALUES / 64)
+#define BITMAP_BYTES     (BITMAP_WORDS * sizeof (uint64_t))
+#define MAX_RUNS         (BITMAP_BYTES / (2 * sizeof (uint16_t))) /* past this a bitmap is smaller */
+#define KEY(X)           ((uint16_t)((X) >> 16))
+#define LOW(X)           ((uint16_t)(X))
+#define WORDS(C)         (((bitset *)(C)->data)->words)
+
+/**
+ * Function: container_reserve
+ * ------------------------------------------------------
+ * Makes room for n_slots uint16_t in an array or run container, doubling
+ * its capacity as needed.
+ */
+static void
+container_reserve (roaring_container *c, uint32_t n_slots)
+{
+	uint32_t capacity = (c->capacity < 8) ? 8 : c->capacity;
+
+	if (n_slots <= c->capacity)
+	{
+		return;
+	}
+	while (capacity < n_slots)
+	{
+		capacity *= 2;
+	}
+	c->data = realloc (c->data, capacity * sizeof (uint16_t));
+	assert (c->data != NULL);
+	c->capacity = capacity;
+}
+
+/**
+ * Function: container_free
+ * ------------------------------------------------------
+ * Frees a container's values, through bitset_destroy for a bitmap.
+ */
+static void
+container_free (roaring_container *c)
+{
+	if (c->type == ROARING_BITMAP)
+	{
+		bitset_destroy (c->data);
+	}
+	else
+	{
+		free (c->data);
+	}
+	c->data = NULL;
+}
+
+/**
+ * Function: array_lower_bound
+ * ------------------------------------------------------
+ * Returns the index of the first of n sorted values not below x.
+ */
+static uint32_t
+array_lower_bound (const uint16_t *values, uint32_t n, uint16_t x)
+{
+	uint32_t lo = 0, hi = n, mid;
+
+	while (lo < hi)
+	{
+		mid = (lo + hi) / 2;
+		if (values[mid] < x)
+		{
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+/**
+ * Function: run_upper_bound
+ * ------------------------------------------------------
+ * Returns the number of the n runs that start at or below x, so the run
+ * that could hold x is the one before.
+ */
+static uint32_t
+run_upper_bound (const uint16_t *runs, uint32_t n, uint16_t x)
+{
+	uint32_t lo = 0, hi = n, mid;
+
+	while (lo < hi)
+	{
+		mid = (lo + hi) / 2;
+		if (runs[2 * mid] <= x)
+		{
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+/**
+ * Function: container_contains
+ * ------------------------------------------------------
+ * Tests for x by a binary search of an array or of the run starts, or by
+ * reading its bit in a bitmap.
+ */
+static bool
+container_contains (const roaring_container *c, uint16_t x)
+{
+	const uint16_t *v = c->data;
+	uint32_t i;
+
+	switch (c->type)
+	{
+	case ROARING_ARRAY:
+		i = array_lower_bound (v, c->n, x);
+		return i < c->n && v[i] == x;
+	case ROARING_BITMAP:
+		return (WORDS (c)[x / 64] >> (x % 64)) & 1;
+	default:
+		i = run_upper_bound (v, c->n, x);
+		return i > 0 && x <= v[2 * i - 2] + v[2 * i - 1];
+	}
+}
+
+/**
+ * Function: fill_range
+ * ------------------------------------------------------
+ * Sets the bits from first to last inclusive, whole words at a time.
+ */
+static void
+fill_range (uint64_t *words, uint32_t first, uint32_t last)
+{
+	uint32_t fw = first / 64, lw = last / 64, w;
+	uint64_t lo_mask = ~0ULL << (first % 64), hi_mask = ~0ULL >> (63 - last % 64);
+
+	if (fw == lw)
+	{
+		words[fw] |= lo_mask & hi_mask;
+		return;
+	}
+	words[fw] |= lo_mask;
+	for (w = fw + 1; w < lw; w++)
+	{
+		words[w] = ~0ULL;
+	}
+	words[lw] |= hi_mask;
+}
+
+/**
+ * Function: container_fill
+ * ------------------------------------------------------
+ * Sets the bit of each of a container's values in a bitset of 65536 bits.
+ */
+static void
+container_fill (const roaring_container *c, bitset *bs)
+{
+	const uint16_t *v = c->data;
+	uint32_t i;
+
+	switch (c->type)
+	{
+	case ROARING_ARRAY:
+		for (i = 0; i < c->n; i++)
+		{
+			bs->words[v[i] / 64] |= 1ULL << (v[i] % 64);
+		}
+		break;
+	case ROARING_BITMAP:
+		bitset_or (bs, c->data);
+		break;
+	default:
+		for (i = 0; i < c->n; i++)
+		{
+			fill_range (bs->words, v[2 * i], (uint32_t)v[2 * i] + v[2 * i + 1]);
+		}
+		break;
+	}
+	bs->index_valid = false;
+}
+
+/**
+ * Function: container_to_bitset
+ * ------------------------------------------------------
+ * Returns a new bitset of 65536 bits holding a container's values.
+ */
+static bitset *
+container_to_bitset (const roaring_container *c)
+{
+	bitset *bs = bitset_init (CHUNK_VALUES);
+
+	if (c->type == ROARING_BITMAP)
+	{
+		memcpy (bs->words, WORDS (c), BITMAP_BYTES);
+	}
+	else
+	{
+		container_fill (c, bs);
+	}
+	return bs;
+}
+
+/**
+ * Function: container_from_bitset
+ * ------------------------------------------------------
+ * Makes a container of the card values set in a bitset: the bitset itself
+ * when they are too many for an array, else an array of them, in which case
+ * the bitset is freed. No values give an empty container holding nothing.
+ */
+static roaring_container
+container_from_bitset (uint16_t key, bitset *bs, uint32_t card)
+{
+	roaring_container c = { .key = key, .card = card };
+	uint16_t *v;
+	uint64_t bits;
+	uint32_t w;
+
+	if (card > ROARING_ARRAY_MAX)
+	{
+		c.type = ROARING_BITMAP;
+		c.data = bs;
+		return c;
+	}
+
+	c.type = ROARING_ARRAY;
+	if (card > 0)
+	{
+		container_reserve (&c, card);
+		v = c.data;
+		for (w = 0; w < BITMAP_WORDS; w++)
+		{
+			for (bits = bs->words[w]; bits != 0; bits &= bits - 1)
+			{
+				v[c.n++] = (uint16_t)(w * 64 + (uint32_t)__builtin_ctzll (bits));
+			}
+		}
+	}
+	bitset_destroy (bs);
+	return c;
+}
+
+/**
+ * Function: container_count_runs
+ * ------------------------------------------------------
+ * Returns the number of runs a container's values would make. A bitmap
+ * word's runs start at the set bits whose lower neighbour is clear.
+ */
+static uint32_t
+container_count_runs (const roaring_container *c)
+{
+	const uint16_t *v = c->data;
+	const uint64_t *words;
+	uint64_t carry = 0;
+	uint32_t i, n;
+
+	switch (c->type)
+	{
+	case ROARING_ARRAY:
+		for (i = 1, n = (c->n > 0); i < c->n; i++)
+		{
+			n += (v[i] != v[i - 1] + 1);
+		}
+		return n;
+	case ROARING_BITMAP:
+		words = WORDS (c);
+		for (i = 0, n = 0; i < BITMAP_WORDS; i++)
+		{
+			n += (uint32_t)__builtin_popcountll (words[i] & ~(words[i] << 1 | carry));
+			carry = words[i] >> 63;
+		}
+		return n;
+	default:
+		return c->n;
+	}
+}
+
+/**
+ * Function: runs_append
+ * ------------------------------------------------------
+ * Adds a value above all those of a run container, extending its last run
+ * when the value follows on.
+ */
+static void
+runs_append (roaring_container *c, uint16_t x)
+{
+	uint16_t *runs = c->data;
+
+	if (c->n > 0 && runs[2 * c->n - 2] + runs[2 * c->n - 1] + 1 == x)
+	{
+		runs[2 * c->n - 1]++;
+	}
+	else
+	{
+		container_reserve (c, 2 * c->n + 2);
+		runs = c->data;
+		runs[2 * c->n] = x;
+		runs[2 * c->n + 1] = 0;
+		c->n++;
+	}
+	c->card++;
+}
+
+/**
+ * Function: container_shrink
+ * ------------------------------------------------------
+ * Converts a container to whichever of runs, an array or a bitmap takes the
+ * fewest bytes, with runs chosen only when strictly smaller.
+ */
+static void
+container_shrink (roaring_container *c)
+{
+	size_t run_bytes = container_count_runs (c) * 2 * sizeof (uint16_t);
+	size_t other_bytes = (c->card <= ROARING_ARRAY_MAX) ? c->card * sizeof (uint16_t) : BITMAP_BYTES;
+	roaring_container runs = { .key = c->key, .type = ROARING_RUN };
+	const uint16_t *v = c->data;
+	uint64_t bits;
+	uint32_t i, w;
+
+	if (run_bytes < other_bytes && c->type != ROARING_RUN)
+	{
+		if (c->type == ROARING_ARRAY)
+		{
+			for (i = 0; i < c->n; i++)
+			{
+				runs_append (&runs, v[i]);
+			}
+		}
+		else
+		{
+			for (w = 0; w < BITMAP_WORDS; w++)
+			{
+				for (bits = WORDS (c)[w]; bits != 0; bits &= bits - 1)
+				{
+					runs_append (&runs, (uint16_t)(w * 64 + (uint32_t)__builtin_ctzll (bits)));
+				}
+			}
+		}
+		container_free (c);
+		*c = runs;
+	}
+	else if (run_bytes >= other_bytes && c->type == ROARING_RUN)
+	{
+		runs = container_from_bitset (c->key, container_to_bitset (c), c->card);
+		container_free (c);
+		*c = runs;
+	}
+}
+
+/**
+ * Function: container_clone
+ * ------------------------------------------------------
+ * Copies a container, with its values in a new allocation sized to fit.
+ */
+static roaring_container
+container_clone (const roaring_container *c)
+{
+	roaring_container d = *c;
+
+	if (c->type == ROARING_BITMAP)
+	{
+		d.data = container_to_bitset (c);
+		return d;
+	}
+	d.capacity = (c->type == ROARING_RUN) ? 2 * c->n : c->n;
+	d.data = malloc (d.capacity * sizeof (uint16_t));
+	assert (d.data != NULL);
+	memcpy (d.data, c->data, d.capacity * sizeof (uint16_t));
+	return d;
+}
+
+/**
+ * Function: container_add
+ * ------------------------------------------------------
+ * Adds a value, turning a full array into a bitmap and a run container that
+ * has split into too many runs into whatever is smaller.
+ *
+ * returns - false if the value was already present
+ */
+static bool
+container_add (roaring_container *c, uint16_t x)
+{
+	uint16_t *v = c->data;
+	uint64_t *word;
+	uint32_t i;
+	bool joins_prev, joins_next;
+
+	if (c->type == ROARING_ARRAY)
+	{
+		i = array_lower_bound (v, c->n, x);
+		if (i < c->n && v[i] == x)
+		{
+			return false;
+		}
+		if (c->n < ROARING_ARRAY_MAX)
+		{
+			container_reserve (c, c->n + 1);
+			v = c->data;
+			memmove (v + i + 1, v + i, (c->n - i) * sizeof (uint16_t));
+			v[i] = x;
+			c->n++;
+			c->card++;
+			return true;
+		}
+		c->data = container_to_bitset (c);
+		free (v);
+		c->type = ROARING_BITMAP;
+		c->n = c->capacity = 0;
+	}
+
+	if (c->type == ROARING_BITMAP)
+	{
+		word = &WORDS (c)[x / 64];
+		if (*word & (1ULL << (x % 64)))
+		{
+			return false;
+		}
+		*word |= 1ULL << (x % 64);
+		c->card++;
+		return true;
+	}
+
+	i = run_upper_bound (v, c->n, x);
+	if (i > 0 && x <= v[2 * i - 2] + v[2 * i - 1])
+	{
+		return false;
+	}
+	joins_prev = i > 0 && v[2 * i - 2] + v[2 * i - 1] + 1 == x;
+	joins_next = i < c->n && v[2 * i] == x + 1;
+	if (joins_prev && joins_next)
+	{
+		v[2 * i - 1] = (uint16_t)(v[2 * i - 1] + v[2 * i + 1] + 2);
+		memmove (v + 2 * i, v + 2 * i + 2, (c->n - i - 1) * 2 * sizeof (uint16_t));
+		c->n--;
+	}
+	else if (joins_prev)
+	{
+		v[2 * i - 1]++;
+	}
+	else if (joins_next)
+	{
+		v[2 * i] = x;
+		v[2 * i + 1]++;
+	}
+	else
+	{
+		container_reserve (c, 2 * c->n + 2);
+		v = c->data;
+		memmove (v + 2 * i + 2, v + 2 * i, (c->n - i) * 2 * sizeof (uint16_t));
+		v[2 * i] = x;
+		v[2 * i + 1] = 0;
+		c->n++;
+	}
+	c->card++;
+	if (c->n > MAX_RUNS)
+	{
+		container_shrink (c);
+	}
+	return true;
+}
+
+/**
+ * Function: container_remove
+ * ------------------------------------------------------
+ * Removes a value, turning a bitmap left with few enough values into an
+ * array. The container may be left empty.
+ *
+ * returns - false if the value was not present
+ */
+static bool
+container_remove (roaring_container *c, uint16_t x)
+{
+	uint16_t *v = c->data;
+	uint64_t *word;
+	uint32_t i, first, last;
+
+	if (c->type == ROARING_ARRAY)
+	{
+		i = array_lower_bound (v, c->n, x);
+		if (i == c->n || v[i] != x)
+		{
+			return false;
+		}
+		memmove (v + i, v + i + 1, (c->n - i - 1) * sizeof (uint16_t));
+		c->n--;
+		c->card--;
+		return true;
+	}
+
+	if (c->type == ROARING_BITMAP)
+	{
+		word = &WORDS (c)[x / 64];
+		if (!(*word & (1ULL << (x % 64))))
+		{
+			return false;
+		}
+		*word &= ~(1ULL << (x % 64));
+		if (--c->card <= ROARING_ARRAY_MAX)
+		{
+			*c = container_from_bitset (c->key, c->data, c->card);
+		}
+		return true;
+	}
+
+	i = run_upper_bound (v, c->n, x);
+	if (i == 0 || x > v[2 * i - 2] + v[2 * i - 1])
+	{
+		return false;
+	}
+	i--;
+	first = v[2 * i];
+	last = first + v[2 * i + 1];
+	if (first == last)
+	{
+		memmove (v + 2 * i, v + 2 * i + 2, (c->n - i - 1) * 2 * sizeof (uint16_t));
+		c->n--;
+	}
+	else if (x == first)
+	{
+		v[2 * i]++;
+		v[2 * i + 1]--;
+	}
+	else if (x == last)
+	{
+		v[2 * i + 1]--;
+	}
+	else
+	{
+		/* split the run around x */
+		container_reserve (c, 2 * c->n + 2);
+		v = c->data;
+		memmove (v + 2 * i + 2, v + 2 * i, (c->n - i) * 2 * sizeof (uint16_t));
+		v[2 * i + 1] = (uint16_t)(x - first - 1);
+		v[2 * i + 2] = (uint16_t)(x + 1);
+		v[2 * i + 3] = (uint16_t)(last - x - 1);
+		c->n++;
+	}
+	c->card--;
+	if (c->n > MAX_RUNS)
+	{
+		container_shrink (c);
+	}
+	return true;
+}
+
+/**
+ * Function: container_interval
+ * ------------------------------------------------------
+ * Reads interval i of an array or run container, a single value for an
+ * array, so that the two can be merged alike.
+ *
+ * returns - false past the last interval
+ */
+static inline bool
+container_interval (const roaring_container *c, uint32_t i, uint32_t *first, uint32_t *last)
+{
+	const uint16_t *v = c->data;
+
+	if (i >= c->n)
+	{
+		return false;
+	}
+	if (c->type == ROARING_RUN)
+	{
+		*first = v[2 * i];
+		*last = *first + v[2 * i + 1];
+	}
+	else
+	{
+		*first = *last = v[i];
+	}
+	return true;
+}
+
+/**
+ * Function: runs_union
+ * ------------------------------------------------------
+ * Merges the intervals of two array or run containers in order of their
+ * starts into a run container, joining any that overlap or touch.
+ */
+static roaring_container
+runs_union (const roaring_container *a, const roaring_container *b)
+{
+	roaring_container c = { .key = a->key, .type = ROARING_RUN };
+	uint32_t i = 0, j = 0, af = 0, al = 0, bf = 0, bl = 0, first, last, end;
+	bool has_a = container_interval (a, 0, &af, &al), has_b = container_interval (b, 0, &bf, &bl);
+	uint16_t *runs;
+
+	container_reserve (&c, 2 * (a->n + b->n));
+	runs = c.data;
+	while (has_a || has_b)
+	{
+		if (has_a && (!has_b || af <= bf))
+		{
+			first = af;
+			last = al;
+			has_a = container_interval (a, ++i, &af, &al);
+		}
+		else
+		{
+			first = bf;
+			last = bl;
+			has_b = container_interval (b, ++j, &bf, &bl);
+		}
+
+		end = (c.n > 0) ? (uint32_t)runs[2 * c.n - 2] + runs[2 * c.n - 1] : 0;
+		if (c.n > 0 && first <= end + 1)
+		{
+			if (last > end)
+			{
+				c.card += last - end;
+				runs[2 * c.n - 1] = (uint16_t)(last - runs[2 * c.n - 2]);
+			}
+		}
+		else
+		{
+			runs[2 * c.n] = (uint16_t)first;
+			runs[2 * c.n + 1] = (uint16_t)(last - first);
+			c.card += last - first + 1;
+			c.n++;
+		}
+	}
+	return c;
+}
+
+/**
+ * Function: runs_intersect
+ * ------------------------------------------------------
+ * Intersects the runs of two run containers, stepping past whichever run
+ * ends first.
+ */
+static roaring_container
+runs_intersect (const roaring_container *a, const roaring_container *b)
+{
+	roaring_container c = { .key = a->key, .type = ROARING_RUN };
+	uint32_t i = 0, j = 0, af, al, bf, bl, first, last;
+	uint16_t *runs;
+
+	container_reserve (&c, 2 * (a->n + b->n));
+	runs = c.data;
+	while (container_interval (a, i, &af, &al) && container_interval (b, j, &bf, &bl))
+	{
+		first = (af > bf) ? af : bf;
+		last = (al < bl) ? al : bl;
+		if (first <= last)
+		{
+			runs[2 * c.n] = (uint16_t)first;
+			runs[2 * c.n + 1] = (uint16_t)(last - first);
+			c.card += last - first + 1;
+			c.n++;
+		}
+		if (al < bl)
+		{
+			i++;
+		}
+		else
+		{
+			j++;
+		}
+	}
+	return c;
+}
+
+/**
+ * Function: array_union
+ * ------------------------------------------------------
+ * Merges two array containers whose values fit in one, without branching
+ * on the comparisons, as the sorted kernels in Vector.c do.
+ */
+static roaring_container
+array_union (const roaring_container *a, const roaring_container *b)
+{
+	roaring_container c = { .key = a->key, .type = ROARING_ARRAY };
+	const uint16_t *va = a->data, *vb = b->data;
+	uint32_t i = 0, j = 0;
+	uint16_t *out, x, y;
+
+	container_reserve (&c, a->n + b->n);
+	out = c.data;
+	while (i < a->n && j < b->n)
+	{
+		x = va[i];
+		y = vb[j];
+		out[c.n++] = (y < x) ? y : x;
+		i += (x <= y);
+		j += (y <= x);
+	}
+	memcpy (out + c.n, va + i, (a->n - i) * sizeof (uint16_t));
+	c.n += a->n - i;
+	memcpy (out + c.n, vb + j, (b->n - j) * sizeof (uint16_t));
+	c.n += b->n - j;
+	c.card = c.n;
+	return c;
+}
+
+/**
+ * Function: array_from_values
+ * ------------------------------------------------------
+ * Makes an array container holding a copy of n values, allocating nothing
+ * when there are none.
+ */
+static roaring_container
+array_from_values (uint16_t key, const uint16_t *values, uint32_t n)
+{
+	roaring_container c = { .key = key, .type = ROARING_ARRAY, .n = n, .card = n };
+
+	if (n > 0)
+	{
+		container_reserve (&c, n);
+		memcpy (c.data, values, n * sizeof (uint16_t));
+	}
+	return c;
+}
+
+/**
+ * Function: array_intersect
+ * ------------------------------------------------------
+ * Keeps the values two array containers share, stepping past the smaller
+ * value, or both when equal, without branching. The values are gathered on
+ * the stack, since most intersections of sparse chunks come out empty.
+ */
+static roaring_container
+array_intersect (const roaring_container *a, const roaring_container *b)
+{
+	const uint16_t *va = a->data, *vb = b->data;
+	uint16_t out[ROARING_ARRAY_MAX], x, y;
+	uint32_t i = 0, j = 0, n = 0;
+
+	while (i < a->n && j < b->n)
+	{
+		x = va[i];
+		y = vb[j];
+		out[n] = x;
+		n += (x == y);
+		i += (x <= y);
+		j += (y <= x);
+	}
+	return array_from_values (a->key, out, n);
+}
+
+/**
+ * Function: array_filter
+ * ------------------------------------------------------
+ * Keeps the values of an array container that a bitmap or run container
+ * also holds.
+ */
+static roaring_container
+array_filter (const roaring_container *a, const roaring_container *b)
+{
+	const uint16_t *va = a->data;
+	uint16_t out[ROARING_ARRAY_MAX];
+	uint32_t i, n = 0;
+
+	for (i = 0; i < a->n; i++)
+	{
+		out[n] = va[i];
+		n += container_contains (b, va[i]);
+	}
+	return array_from_values (a->key, out, n);
+}
+
+/**
+ * Function: container_union
+ * ------------------------------------------------------
+ * Unites two containers with the same key. Arrays that fit together are
+ * merged, and runs merged with runs or an array; anything else goes through
+ * a bitmap. A result with runs in it is shrunk to its smallest form.
+ */
+static roaring_container
+container_union (const roaring_container *a, const roaring_container *b)
+{
+	roaring_container c;
+	bitset *bs;
+
+	if (a->type == ROARING_ARRAY && b->type == ROARING_ARRAY && a->card + b->card <= ROARING_ARRAY_MAX)
+	{
+		return array_union (a, b);
+	}
+
+	if (a->type != ROARING_BITMAP && b->type != ROARING_BITMAP &&
+	    (a->type == ROARING_RUN || b->type == ROARING_RUN))
+	{
+		c = runs_union (a, b);
+	}
+	else
+	{
+		/* start from the bitmap if there is one */
+		if (b->type == ROARING_BITMAP)
+		{
+			const roaring_container *t = a;
+			a = b;
+			b = t;
+		}
+		bs = container_to_bitset (a);
+		container_fill (b, bs);
+		c = container_from_bitset (a->key, bs, (uint32_t)bitset_count (bs));
+	}
+
+	if (a->type == ROARING_RUN || b->type == ROARING_RUN)
+	{
+		container_shrink (&c);
+	}
+	return c;
+}
+
+/**
+ * Function: container_intersect
+ * ------------------------------------------------------
+ * Intersects two containers with the same key: arrays by merging, an array
+ * with anything else by testing its values, runs with runs interval by
+ * interval, and the rest as bitmaps. The result may be empty.
+ */
+static roaring_container
+container_intersect (const roaring_container *a, const roaring_container *b)
+{
+	roaring_container c;
+	bitset *bs, *t;
+
+	if (b->type == ROARING_ARRAY && a->type != ROARING_ARRAY)
+	{
+		const roaring_container *swap = a;
+		a = b;
+		b = swap;
+	}
+
+	if (a->type == ROARING_ARRAY)
+	{
+		c = (b->type == ROARING_ARRAY) ? array_intersect (a, b) : array_filter (a, b);
+	}
+	else if (a->type == ROARING_RUN && b->type == ROARING_RUN)
+	{
+		c = runs_intersect (a, b);
+	}
+	else
+	{
+		bs = container_to_bitset (a);
+		if (b->type == ROARING_BITMAP)
+		{
+			bitset_and (bs, b->data);
+		}
+		else
+		{
+			t = container_to_bitset (b);
+			bitset_and (bs, t);
+			bitset_destroy (t);
+		}
+		c = container_from_bitset (a->key, bs, (uint32_t)bitset_count (bs));
+	}
+
+	if (c.card == 0)
+	{
+		container_free (&c);
+	}
+	else if (a->type == ROARING_RUN || b->type == ROARING_RUN)
+	{
+		container_shrink (&c);
+	}
+	return c;
+}
+
+/**
+ * Function: roaring_find
+ * ------------------------------------------------------
+ * Returns the index of the first container with a key not below key,
+ * checking the last container first since ids often arrive in order.
+ */
+static size_t
+roaring_find (const roaring *r, uint16_t key)
+{
+	size_t lo = 0, hi = r->n_containers, mid;
+
+	if (hi > 0 && r->containers[hi - 1].key < key)
+	{
+		return hi;
+	}
+	while (lo < hi)
+	{
+		mid = (lo + hi) / 2;
+		if (r->containers[mid].key < key)
+		{
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+/**
+ * Function: roaring_reserve
+ * ------------------------------------------------------
+ * Makes room for capacity containers, at least doubling the array when it
+ * grows so a run of inserts is amortised.
+ */
+static void
+roaring_reserve (roaring *r, size_t capacity)
+{
+	if (capacity <= r->capacity)
+	{
+		return;
+	}
+	if (capacity < 2 * r->capacity)
+	{
+		capacity = 2 * r->capacity;
+	}
+	r->containers = realloc (r->containers, capacity * sizeof (roaring_container));
+	assert (r->containers != NULL);
+	r->capacity = capacity;
+}
+
+/**
+ * Function: roaring_insert_at
+ * ------------------------------------------------------
+ * Inserts c as container i, shifting the containers from i on up one.
+ */
+static void
+roaring_insert_at (roaring *r, size_t i, roaring_container c)
+{
+	roaring_reserve (r, r->n_containers + 1);
+	memmove (r->containers + i + 1, r->containers + i, (r->n_containers - i) * sizeof (roaring_container));
+	r->containers[i] = c;
+	r->n_containers++;
+}
+
+/**
+ * Function: roaring_remove_at
+ * ------------------------------------------------------
+ * Frees container i and shifts the containers after it down one.
+ */
+static void
+roaring_remove_at (roaring *r, size_t i)
+{
+	container_free (&r->containers[i]);
+	memmove (r->containers + i, r->containers + i + 1, (r->n_containers - i - 1) * sizeof (roaring_container));
+	r->n_containers--;
+}
+
+/**
+ * Function: roaring_init
+ * ------------------------------------------------------
+ * Public function to perform roaring bitmap initialization
+ *
+ * returns - a pointer to an empty roaring bitmap
+ */
+roaring *
+roaring_init (void)
+{
+	roaring *r = calloc (1, sizeof (roaring));
+	assert (r != NULL);
+
+	r->magic = MAGIC_INIT_VALUE;
+	return r;
+}
+
+/**
+ * Function: roaring_destroy
+ * ------------------------------------------------------
+ * Frees every container's values, the container array and the bitmap.
+ */
+void
+roaring_destroy (roaring *r)
+{
+	assert (r != NULL);
+	assert (r->magic == MAGIC_INIT_VALUE);
+
+	size_t i;
+
+	for (i = 0; i < r->n_containers; i++)
+	{
+		container_free (&r->containers[i]);
+	}
+	free (r->containers);
+	free (r);
+}
+
+/**
+ * Function: roaring_add
+ * ------------------------------------------------------
+ * Adds value to its chunk's container, making an empty array container for
+ * the chunk if it has none.
+ */
+bool
+roaring_add (roaring *r, uint32_t value)
+{
+	assert (r != NULL);
+	assert (r->magic == MAGIC_INIT_VALUE);
+
+	size_t i = roaring_find (r, KEY (value));
+
+	if (i == r->n_containers || r->containers[i].key != KEY (value))
+	{
+		roaring_insert_at (r, i, (roaring_container){ .key = KEY (value), .type = ROARING_ARRAY });
+	}
+	return container_add (&r->containers[i], LOW (value));
+}
+
+/**
+ * Function: roaring_add_range
+ * ------------------------------------------------------
+ * Makes a single run for the part of the range in each chunk, which becomes
+ * the chunk's container if it had none and is united with it otherwise.
+ */
+void
+roaring_add_range (roaring *r, uint32_t first, uint32_t last)
+{
+	assert (r != NULL);
+	assert (r->magic == MAGIC_INIT_VALUE);
+	assert (first <= last);
+
+	roaring_container run, *c, u;
+	uint32_t key, lo, hi;
+	size_t i;
+
+	for (key = KEY (first); key <= KEY (last); key++)
+	{
+		lo = (key == KEY (first)) ? LOW (first) : 0;
+		hi = (key == KEY (last)) ? LOW (last) : CHUNK_VALUES - 1;
+		run = (roaring_container){ .key = (uint16_t)key, .type = ROARING_RUN, .n = 1, .card = hi - lo + 1 };
+		container_reserve (&run, 2);
+		((uint16_t *)run.data)[0] = (uint16_t)lo;
+		((uint16_t *)run.data)[1] = (uint16_t)(hi - lo);
+
+		i = roaring_find (r, (uint16_t)key);
+		if (i == r->n_containers || r->containers[i].key != key)
+		{
+			roaring_insert_at (r, i, run);
+			continue;
+		}
+		c = &r->containers[i];
+		u = container_union (c, &run);
+		container_free (c);
+		container_free (&run);
+		*c = u;
+	}
+}
+
+/**
+ * Function: roaring_remove
+ * ------------------------------------------------------
+ * Removes value from its chunk's container, dropping the container once it
+ * is empty.
+ */
+bool
+roaring_remove (roaring *r, uint32_t value)
+{
+	assert (r != NULL);
+	assert (r->magic == MAGIC_INIT_VALUE);
+
+	size_t i = roaring_find (r, KEY (value));
+
+	if (i == r->n_containers || r->containers[i].key != KEY (value) ||
+	    !container_remove (&r->containers[i], LOW (value)))
+	{
+		return false;
+	}
+	if (r->containers[i].card == 0)
+	{
+		roaring_remove_at (r, i);
+	}
+	return true;
+}
+
+/**
+ * Function: roaring_contains
+ * ------------------------------------------------------
+ * Finds value's chunk's container and tests it for the low half of value.
+ */
+bool
+roaring_contains (const roaring *r, uint32_t value)
+{
+	assert (r != NULL);
+	assert (r->magic == MAGIC_INIT_VALUE);
+
+	size_t i = roaring_find (r, KEY (value));
+
+	return i < r->n_containers && r->containers[i].key == KEY (value) &&
+	       container_contains (&r->containers[i], LOW (value));
+}
+
+/**
+ * Function: roaring_cardinality
+ * ------------------------------------------------------
+ * Sums the cardinalities the containers keep.
+ */
+size_t
+roaring_cardinality (const roaring *r)
+{
+	assert (r != NULL);
+	assert (r->magic == MAGIC_INIT_VALUE);
+
+	size_t i, n = 0;
+
+	for (i = 0; i < r->n_containers; i++)
+	{
+		n += r->containers[i].card;
+	}
+	return n;
+}
+
+/**
+ * Function: roaring_bytes
+ * ------------------------------------------------------
+ * Counts the bytes held: the struct, the container array and each
+ * container's values, at their length rather than capacity.
+ */
+size_t
+roaring_bytes (const roaring *r)
+{
+	assert (r != NULL);
+	assert (r->magic == MAGIC_INIT_VALUE);
+
+	size_t i, bytes = sizeof (roaring) + r->n_containers * sizeof (roaring_container);
+	const roaring_container *c;
+
+	for (i = 0; i < r->n_containers; i++)
+	{
+		c = &r->containers[i];
+		switch (c->type)
+		{
+		case ROARING_ARRAY: bytes += c->n * sizeof (uint16_t); break;
+		case ROARING_BITMAP: bytes += sizeof (bitset) + BITMAP_BYTES; break;
+		default: bytes += c->n * 2 * sizeof (uint16_t); break;
+		}
+	}
+	return bytes;
+}
+
+/**
+ * Function: roaring_optimize
+ * ------------------------------------------------------
+ * Converts each container, through container_shrink, to whichever of runs,
+ * an array or a bitmap takes the least space.
+ */
+void
+roaring_optimize (roaring *r)
+{
+	assert (r != NULL);
+	assert (r->magic == MAGIC_INIT_VALUE);
+
+	size_t i;
+
+	for (i = 0; i < r->n_containers; i++)
+	{
+		container_shrink (&r->containers[i]);
+	}
+}
+
+/**
+ * Function: roaring_union
+ * ------------------------------------------------------
+ * Walks both container arrays in key order, copying the containers only one
+ * side has and uniting those both have.
+ */
+roaring *
+roaring_union (const roaring *a, const roaring *b)
+{
+	assert (a != NULL);
+	assert (b != NULL);
+	assert (a->magic == MAGIC_INIT_VALUE);
+	assert (b->magic == MAGIC_INIT_VALUE);
+
+	roaring *r = roaring_init ();
+	size_t i = 0, j = 0;
+
+	roaring_reserve (r, a->n_containers + b->n_containers);
+	while (i < a->n_containers || j < b->n_containers)
+	{
+		if (j == b->n_containers || (i < a->n_containers && a->containers[i].key < b->containers[j].key))
+		{
+			r->containers[r->n_containers++] = container_clone (&a->containers[i++]);
+		}
+		else if (i == a->n_containers || b->containers[j].key < a->containers[i].key)
+		{
+			r->containers[r->n_containers++] = container_clone (&b->containers[j++]);
+		}
+		else
+		{
+			r->containers[r->n_containers++] = container_union (&a->containers[i++], &b->containers[j++]);
+		}
+	}
+	return r;
+}
+
+/**
+ * Function: roaring_intersect
+ * ------------------------------------------------------
+ * Walks both container arrays in key order, intersecting the containers
+ * both have and keeping the results that are not empty.
+ */
+roaring *
+roaring_intersect (const roaring *a, const roaring *b)
+{
+	assert (a != NULL);
+	assert (b != NULL);
+	assert (a->magic == MAGIC_INIT_VALUE);
+	assert (b->magic == MAGIC_INIT_VALUE);
+
+	roaring *r = roaring_init ();
+	roaring_container c;
+	size_t i = 0, j = 0;
+
+	roaring_reserve (r, (a->n_containers < b->n_containers) ? a->n_containers : b->n_containers);
+	while (i < a->n_containers && j < b->n_containers)
+	{
+		if (a->containers[i].key < b->containers[j].key)
+		{
+			i++;
+		}
+		else if (b->containers[j].key < a->containers[i].key)
+		{
+			j++;
+		}
+		else
+		{
+			c = container_intersect (&a->containers[i++], &b->containers[j++]);
+			if (c.card > 0)
+			{
+				r->containers[r->n_containers++] = c;
+			}
+		}
+	}
+	return r;
+}
+
+/**
+ * Function: roaring_iter_enter
+ * ------------------------------------------------------
+ * Positions an iterator at the start of its current container.
+ */
+static void
+roaring_iter_enter (roaring_iter *it)
+{
+	const roaring_container *c;
+
+	it->pos = it->offset = 0;
+	it->bits = 0;
+	if (it->container < it->r->n_containers)
+	{
+		c = &it->r->containers[it->container];
+		if (c->type == ROARING_BITMAP)
+		{
+			it->bits = WORDS (c)[0];
+		}
+	}
+}
+
+/**
+ * Function: roaring_iter_init
+ * ------------------------------------------------------
+ * Points the iterator at the first value of the first container.
+ */
+void
+roaring_iter_init (const roaring *r, roaring_iter *it)
+{
+	assert (r != NULL);
+	assert (it != NULL);
+	assert (r->magic == MAGIC_INIT_VALUE);
+
+	it->r = r;
+	it->container = 0;
+	roaring_iter_enter (it);
+}
+
+/**
+ * Function: roaring_iter_next
+ * ------------------------------------------------------
+ * Returns the next value in order, moving on to the next container once
+ * the current one is done.
+ */
+bool
+roaring_iter_next (roaring_iter *it, uint32_t *value)
+{
+	assert (it != NULL);
+	assert (value != NULL);
+	assert (it->r != NULL && it->r->magic == MAGIC_INIT_VALUE);
+
+	const roaring_container *c;
+	const uint16_t *v;
+	const uint64_t *words;
+
+	while (it->container < it->r->n_containers)
+	{
+		c = &it->r->containers[it->container];
+		v = c->data;
+		switch (c->type)
+		{
+		case ROARING_ARRAY:
+			if (it->pos < c->n)
+			{
+				*value = (uint32_t)c->key << 16 | v[it->pos++];
+				return true;
+			}
+			break;
+		case ROARING_BITMAP:
+			words = WORDS (c);
+			while (it->bits == 0 && it->pos + 1 < BITMAP_WORDS)
+			{
+				it->bits = words[++it->pos];
+			}
+			if (it->bits != 0)
+			{
+				*value = (uint32_t)c->key << 16 | (it->pos * 64 + (uint32_t)__builtin_ctzll (it->bits));
+				it->bits &= it->bits - 1;
+				return true;
+			}
+			break;
+		default:
+			if (it->pos < c->n)
+			{
+				*value = (uint32_t)c->key << 16 | (v[2 * it->pos] + it->offset);
+				if (it->offset == v[2 * it->pos + 1])
+				{
+					it->pos++;
+					it->offset = 0;
+				}
+				else
+				{
+					it->offset++;
+				}
+				return true;
+			}
+			break;
+		}
+		it->container++;
+		roaring_iter_enter (it);
+	}
+	return false;
+}
+
+/**
+ * Struct: roaring_stream
+ * ----------------------------------
+ * The state of a roaring bitmap being written or read a chunk at a time.
+ *
+ * field fd     - the file descriptor
+ * field c      - the running checksum
+ * field buf    - STREAM_CHUNK_SZ bytes of elements on their way through
+ * field pos    - the bytes of buf filled, when writing, or consumed
+ * field len    - the bytes of buf read, when reading
+ * field left   - the bytes of the stream's elements not yet read
+ * field header - the header, until it has been written with the first chunk
+ * field failed - whether an I/O error, a bad checksum or an inconsistent
+ *                container has been met
+ */
+typedef struct
+{
+	int fd;
+	stream_checksum c;
+	uint8_t *buf;
+	size_t pos, len, left;
+	const uint8_t *header;
+	bool failed;
+} roaring_stream;
+
+/**
+ * Function: roaring_stream_put
+ * ------------------------------------------------------
+ * Copies bytes into the write buffer, writing the buffer out whenever it
+ * fills.
+ */
+static void
+roaring_stream_put (roaring_stream *st, const void *data, size_t len)
+{
+	const uint8_t *p = data;
+	size_t n;
+
+	while (len > 0 && !st->failed)
+	{
+		if (st->pos == STREAM_CHUNK_SZ)
+		{
+			st->failed = !stream_write_chunk (st->fd, &st->c, st->header, st->buf, st->pos, false);
+			st->header = NULL;
+			st->pos = 0;
+		}
+
+		n = (len < STREAM_CHUNK_SZ - st->pos) ? len : STREAM_CHUNK_SZ - st->pos;
+		memcpy (st->buf + st->pos, p, n);
+		st->pos += n;
+		p += n;
+		len -= n;
+	}
+}
+
+/**
+ * Function: roaring_stream_get
+ * ------------------------------------------------------
+ * Copies bytes out of the read buffer, refilling it as it empties. Asking
+ * for more than the stream holds fails it.
+ */
+static void
+roaring_stream_get (roaring_stream *st, void *data, size_t len)
+{
+	uint8_t *p = data;
+	size_t n;
+
+	while (len > 0 && !st->failed)
+	{
+		if (st->pos == st->len)
+		{
+			if (st->left == 0)
+			{
+				st->failed = true;
+				break;
+			}
+			st->len = (st->left < STREAM_CHUNK_SZ) ? st->left : STREAM_CHUNK_SZ;
+			st->failed = !stream_read_chunk (st->fd, &st->c, st->buf, st->len, st->len == st->left);
+			st->left -= st->len;
+			st->pos = 0;
+			continue;
+		}
+
+		n = (len < st->len - st->pos) ? len : st->len - st->pos;
+		memcpy (p, st->buf + st->pos, n);
+		st->pos += n;
+		p += n;
+		len -= n;
+	}
+}
+
+/*
+ * The stream's words are little-endian, so on a big-endian host each is
+ * swapped on its way through; elsewhere arrays are copied as they are.
+ */
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+
+/**
+ * Function: roaring_stream_put16
+ * ------------------------------------------------------
+ * Writes n 16 bit words byte-swapped to little-endian.
+ */
+static void
+roaring_stream_put16 (roaring_stream *st, const uint16_t *values, size_t n)
+{
+	uint16_t x;
+	size_t i;
+
+	for (i = 0; i < n; i++)
+	{
+		x = __builtin_bswap16 (values[i]);
+		roaring_stream_put (st, &x, sizeof (x));
+	}
+}
+
+/**
+ * Function: roaring_stream_put64
+ * ------------------------------------------------------
+ * Writes n 64 bit words byte-swapped to little-endian.
+ */
+static void
+roaring_stream_put64 (roaring_stream *st, const uint64_t *values, size_t n)
+{
+	uint64_t x;
+	size_t i;
+
+	for (i = 0; i < n; i++)
+	{
+		x = __builtin_bswap64 (values[i]);
+		roaring_stream_put (st, &x, sizeof (x));
+	}
+}
+
+/**
+ * Function: roaring_stream_get16
+ * ------------------------------------------------------
+ * Reads n little-endian 16 bit words and swaps them in place.
+ */
+static void
+roaring_stream_get16 (roaring_stream *st, uint16_t *values, size_t n)
+{
+	size_t i;
+
+	roaring_stream_get (st, values, n * sizeof (uint16_t));
+	for (i = 0; i < n; i++)
+	{
+		values[i] = __builtin_bswap16 (values[i]);
+	}
+}
+
+/**
+ * Function: roaring_stream_get64
+ * ------------------------------------------------------
+ * Reads n little-endian 64 bit words and swaps them in place.
+ */
+static void
+roaring_stream_get64 (roaring_stream *st, uint64_t *values, size_t n)
+{
+	size_t i;
+
+	roaring_stream_get (st, values, n * sizeof (uint64_t));
+	for (i = 0; i < n; i++)
+	{
+		values[i] = __builtin_bswap64 (values[i]);
+	}
+}
+
+#else
+
+/**
+ * Function: roaring_stream_put16
+ * ------------------------------------------------------
+ * Writes n 16 bit words as they are, already little-endian.
+ */
+static void
+roaring_stream_put16 (roaring_stream *st, const uint16_t *values, size_t n)
+{
+	roaring_stream_put (st, values, n * sizeof (uint16_t));
+}
+
+/**
+ * Function: roaring_stream_put64
+ * ------------------------------------------------------
+ * Writes n 64 bit words as they are, already little-endian.
+ */
+static void
+roaring_stream_put64 (roaring_stream *st, const uint64_t *values, size_t n)
+{
+	roaring_stream_put (st, values, n * sizeof (uint64_t));
+}
+
+/**
+ * Function: roaring_stream_get16
+ * ------------------------------------------------------
+ * Reads n 16 bit words straight into values.
+ */
+static void
+roaring_stream_get16 (roaring_stream *st, uint16_t *values, size_t n)
+{
+	roaring_stream_get (st, values, n * sizeof (uint16_t));
+}
+
+/**
+ * Function: roaring_stream_get64
+ * ------------------------------------------------------
+ * Reads n 64 bit words straight into values.
+ */
+static void
+roaring_stream_get64 (roaring_stream *st, uint64_t *values, size_t n)
+{
+	roaring_stream_get (st, values, n * sizeof (uint64_t));
+}
+
+#endif
+
+/**
+ * Function: roaring_write
+ * ------------------------------------------------------
+ * Writes the number of containers, a directory of each one's key, type and
+ * size less one, then the containers' contents, through a chunk buffer. The
+ * size is the number of values of an array or bitmap and of runs of a run
+ * container. A bitmap's 64 bit words are written as four 16 bit words each,
+ * so its bytes are the same as if it were written whole.
+ *
+ * param r  - initialized roaring bitmap
+ * param fd - the file descriptor to write to
+ *
+ * returns - false on an I/O error
+ */
+bool
+roaring_write (const roaring *r, int fd)
+{
+	assert (r != NULL);
+	assert (r->magic == MAGIC_INIT_VALUE);
+
+	uint8_t header[STREAM_HEADER_SZ];
+	roaring_stream st = { .fd = fd, .header = header };
+	const roaring_container *c;
+	size_t i, n_words = 2 + 3 * r->n_containers;
+	uint16_t entry[3];
+
+	for (i = 0; i < r->n_containers; i++)
+	{
+		c = &r->containers[i];
+		n_words += (c->type == ROARING_BITMAP) ? BITMAP_BYTES / sizeof (uint16_t)
+		         : (c->type == ROARING_RUN)    ? 2 * c->n
+		                                       : c->n;
+	}
+
+	st.buf = malloc (STREAM_CHUNK_SZ);
+	assert (st.buf != NULL);
+	stream_header_encode (header, STREAM_MAGIC, sizeof (uint16_t), n_words, &st.c);
+
+	entry[0] = (uint16_t)r->n_containers;
+	entry[1] = (uint16_t)(r->n_containers >> 16);
+	roaring_stream_put16 (&st, entry, 2);
+	for (i = 0; i < r->n_containers; i++)
+	{
+		c = &r->containers[i];
+		entry[0] = c->key;
+		entry[1] = c->type;
+		entry[2] = (uint16_t)(((c->type == ROARING_RUN) ? c->n : c->card) - 1);
+		roaring_stream_put16 (&st, entry, 3);
+	}
+	for (i = 0; i < r->n_containers; i++)
+	{
+		c = &r->containers[i];
+		if (c->type == ROARING_BITMAP)
+		{
+			roaring_stream_put64 (&st, WORDS (c), BITMAP_WORDS);
+		}
+		else
+		{
+			roaring_stream_put16 (&st, c->data, (c->type == ROARING_RUN) ? 2 * c->n : c->n);
+		}
+	}
+
+	if (!st.failed)
+	{
+		st.failed = !stream_write_chunk (fd, &st.c, st.header, st.buf, st.pos, true);
+	}
+
+	free (st.buf);
+	return !st.failed;
+}
+
+/**
+ * Function: roaring_read_container
+ * ------------------------------------------------------
+ * Reads the contents of a container described by a directory entry and
+ * checks them: array values and runs must be increasing, runs may neither
+ * touch nor pass the end of the chunk, and a bitmap must hold as many values
+ * as its entry says.
+ */
+static void
+roaring_read_container (roaring_stream *st, roaring_container *c, uint32_t size)
+{
+	uint16_t *v;
+	uint32_t i, end = 0;
+	bitset *bs;
+
+	if (c->type == ROARING_BITMAP)
+	{
+		bs = bitset_init (CHUNK_VALUES);
+		c->data = bs;
+		roaring_stream_get64 (st, bs->words, BITMAP_WORDS);
+		st->failed |= (bitset_count (bs) != c->card);
+		return;
+	}
+
+	container_reserve (c, (c->type == ROARING_RUN) ? 2 * size : size);
+	v = c->data;
+	roaring_stream_get16 (st, v, (c->type == ROARING_RUN) ? 2 * size : size);
+	for (i = 0; i < size && !st->failed; i++)
+	{
+		if (c->type == ROARING_ARRAY)
+		{
+			st->failed = (i > 0 && v[i] <= v[i - 1]);
+			continue;
+		}
+		st->failed = (i > 0 && v[2 * i] <= end + 1) || (uint32_t)v[2 * i] + v[2 * i + 1] >= CHUNK_VALUES;
+		end = (uint32_t)v[2 * i] + v[2 * i + 1];
+		c->card += (uint32_t)v[2 * i + 1] + 1;
+	}
+}
+
+/**
+ * Function: roaring_read
+ * ------------------------------------------------------
+ * Reads the directory, checking that keys increase and that each size suits
+ * its type, then reads and checks each container in turn. Containers join
+ * the bitmap as they are read, so a failure part way frees just those.
+ *
+ * param fd - the file descriptor to read from
+ *
+ * returns - a pointer to the roaring bitmap, or NULL if the stream is
+ *           unreadable, of another kind, fails its checksum or holds
+ *           inconsistent containers
+ */
+roaring *
+roaring_read (int fd)
+{
+	size_t elem_sz, n_words, n, i;
+	roaring_stream st = { .fd = fd };
+	roaring_container *dir = NULL;
+	uint32_t *sizes = NULL;
+	uint16_t entry[3];
+	roaring *r;
+
+	if (!stream_read_header (fd, STREAM_MAGIC, &elem_sz, &n_words, &st.c) ||
+	    elem_sz != sizeof (uint16_t) || n_words > SIZE_MAX / sizeof (uint16_t))
+	{
+		return NULL;
+	}
+
+	r = roaring_init ();
+	st.left = n_words * sizeof (uint16_t);
+	st.buf = malloc (STREAM_CHUNK_SZ);
+	assert (st.buf != NULL);
+
+	roaring_stream_get16 (&st, entry, 2);
+	n = (size_t)entry[0] | (size_t)entry[1] << 16;
+	st.failed |= (n > CHUNK_VALUES);
+	if (!st.failed)
+	{
+		dir = calloc (n + 1, sizeof (roaring_container));
+		sizes = malloc ((n + 1) * sizeof (uint32_t));
+		assert (dir != NULL && sizes != NULL);
+	}
+
+	for (i = 0; i < n && !st.failed; i++)
+	{
+		roaring_stream_get16 (&st, entry, 3);
+		sizes[i] = (uint32_t)entry[2] + 1;
+		dir[i] = (roaring_container){ .key = entry[0], .type = (uint8_t)entry[1] };
+		st.failed |= (i > 0 && entry[0] <= dir[i - 1].key) || entry[1] > ROARING_RUN ||
+		             (entry[1] == ROARING_ARRAY && sizes[i] > ROARING_ARRAY_MAX) ||
+		             (entry[1] == ROARING_BITMAP && sizes[i] <= ROARING_ARRAY_MAX) ||
+		             (entry[1] == ROARING_RUN && sizes[i] > CHUNK_VALUES / 2);
+		if (entry[1] == ROARING_BITMAP)
+		{
+			dir[i].card = sizes[i];
+		}
+		else if (entry[1] == ROARING_ARRAY)
+		{
+			dir[i].n = dir[i].card = sizes[i];
+		}
+		else
+		{
+			dir[i].n = sizes[i];
+		}
+	}
+
+	if (!st.failed)
+	{
+		roaring_reserve (r, n);
+	}
+	for (i = 0; i < n && !st.failed; i++)
+	{
+		roaring_read_container (&st, &dir[i], sizes[i]);
+		r->containers[r->n_containers++] = dir[i];
+	}
+
+	if (!st.failed && (st.left != 0 || st.pos != st.len))
+	{
+		st.failed = true;
+	}
+
+	free (dir);
+	free (sizes);
+	free (st.buf);
+	if (st.failed)
+	{
+		roaring_destroy (r);
+		return NULL;
+	}
+	return r;
+}
+
+/**
+ * Function: roaring_from_vector
+ * ------------------------------------------------------
+ * Checks whether the ids are sorted, and if so builds each chunk's
+ * container from its stretch of the array: an array if the stretch is
+ * short enough, else through a bitmap, which becomes an array again if
+ * repeats leave few enough ids.
+ */
+roaring *
+roaring_from_vector (const vector *v)
+{
+	assert (v != NULL);
+	size_t n = vector_size (v), i, j, k; /* vector_size checks v's magic value */
+	assert (v->elem_sz == sizeof (uint32_t));
+
+	const uint32_t *ids = v->elems;
+	roaring *r = roaring_init ();
+	roaring_container c;
+	uint16_t *out;
+	bitset *bs;
+
+	for (i = 1; i < n && ids[i - 1] <= ids[i]; i++)
+		;
+	if (i < n)
+	{
+		for (i = 0; i < n; i++)
+		{
+			roaring_add (r, ids[i]);
+		}
+		return r;
+	}
+
+	for (i = 0; i < n; i = j)
+	{
+		for (j = i + 1; j < n && KEY (ids[j]) == KEY (ids[i]); j++)
+			;
+		if (j - i <= ROARING_ARRAY_MAX)
+		{
+			c = (roaring_container){ .key = KEY (ids[i]), .type = ROARING_ARRAY };
+			container_reserve (&c, (uint32_t)(j - i));
+			out = c.data;
+			for (k = i; k < j; k++)
+			{
+				out[c.n] = LOW (ids[k]);
+				c.n += (c.n == 0 || out[c.n - 1] != out[c.n]);
+			}
+			c.card = c.n;
+		}
+		else
+		{
+			bs = bitset_init (CHUNK_VALUES);
+			for (k = i; k < j; k++)
+			{
+				bs->words[LOW (ids[k]) / 64] |= 1ULL << (ids[k] % 64);
+			}
+			c = container_from_bitset (KEY (ids[i]), bs, (uint32_t)bitset_count (bs));
+		}
+		roaring_insert_at (r, r->n_containers, c);
+	}
+	return r;
+}
+
+/**
+ * Function: roaring_to_vector
+ * ------------------------------------------------------
+ * Writes every value in order into a vector sized to the cardinality, a
+ * container at a time.
+ */
+vector *
+roaring_to_vector (const roaring *r)
+{
+	assert (r != NULL);
+	assert (r->magic == MAGIC_INIT_VALUE);
+
+	size_t card = roaring_cardinality (r), i, n = 0;
+	vector *v = vector_init (sizeof (uint32_t), card, NULL);
+	uint32_t *out = v->elems, base, j, k;
+	const roaring_container *c;
+	const uint16_t *values;
+	uint64_t bits;
+
+	for (i = 0; i < r->n_containers; i++)
+	{
+		c = &r->containers[i];
+		values = c->data;
+		base = (uint32_t)c->key << 16;
+		switch (c->type)
+		{
+		case ROARING_ARRAY:
+			for (j = 0; j < c->n; j++)
+			{
+				out[n++] = base | values[j];
+			}
+			break;
+		case ROARING_BITMAP:
+			for (j = 0; j < BITMAP_WORDS; j++)
+			{
+				for (bits = WORDS (c)[j]; bits != 0; bits &= bits - 1)
+				{
+					out[n++] = base | (j * 64 + (uint32_t)__builtin_ctzll (bits));
+				}
+			}
+			break;
+		default:
+			for (j = 0; j < c->n; j++)
+			{
+				for (k = 0; k <= values[2 * j + 1]; k++)
+				{
+					out[n++] = base | (values[2 * j] + k);
+				}
+			}
+			break;
+		}
+	}
+	v->n_elems = n;
+	return v;
+}
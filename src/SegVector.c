@@ -0,0 +1,275 @@
+/**
+ * File: SegVector.c
+ * Author: Seth Charles
+ * ----------------------
+ */
+#include "SegVector.h"
+#include <assert.h>
+#include <string.h>
+
+#define MAGIC_INIT_VALUE (0x5d27e0b93a4c618f)
+#define FIRST_CHUNK      ((size_t)1 << SEG_VECTOR_FIRST_SHIFT)
+
+/**
+ * Function: seg_vector_locate
+ * ------------------------------------------------------
+ * Maps an index to its chunk and offset. With FIRST_CHUNK added, the indexes
+ * of chunk k are exactly the numbers whose highest set bit is
+ * SEG_VECTOR_FIRST_SHIFT + k, and the offset is what remains below that bit.
+ */
+static inline uint8_t *
+seg_vector_locate (const seg_vector *sv, size_t index, size_t *chunk_len)
+{
+	size_t pos = index + FIRST_CHUNK;
+	unsigned high = 63 - (unsigned)__builtin_clzll ((unsigned long long)pos);
+	size_t chunk = high - SEG_VECTOR_FIRST_SHIFT;
+
+	if (chunk_len != NULL)
+	{
+		*chunk_len = (size_t)1 << high;
+	}
+
+	return sv->chunks[chunk] + (pos - ((size_t)1 << high)) * sv->elem_sz;
+}
+
+/**
+ * Function: seg_vector_grow
+ * ------------------------------------------------------
+ * Allocates the next chunk, twice the size of the one before it.
+ */
+static void
+seg_vector_grow (seg_vector *sv)
+{
+	size_t len = FIRST_CHUNK << sv->n_chunks;
+
+	assert (sv->n_chunks < SEG_VECTOR_MAX_CHUNKS);
+
+	sv->chunks[sv->n_chunks] = malloc (len * sv->elem_sz);
+	assert (sv->chunks[sv->n_chunks] != NULL);
+
+	sv->n_chunks++;
+	sv->capacity += len;
+}
+
+/**
+ * Function: seg_vector_init
+ * ------------------------------------------------------
+ * Public function to perform seg_vector initialization
+ *
+ * param elem_sz       - the size of elements in bytes that are stored
+ * param capacity_hint - the number of elements to allocate chunks for up front
+ * param fn            - the cleanup function to call when an element is destroyed
+ *
+ * returns - a pointer to the seg_vector object
+ */
+seg_vector *
+seg_vector_init (size_t elem_sz, size_t capacity_hint, elem_destroy_fn fn)
+{
+	assert (elem_sz > 0);
+	seg_vector *sv;
+
+	sv = calloc (1, sizeof (seg_vector));
+	assert (sv != NULL);
+
+	sv->elem_sz = elem_sz;
+	sv->elem_destroy = fn;
+	sv->magic = MAGIC_INIT_VALUE;
+
+	do
+	{
+		seg_vector_grow (sv);
+	} while (sv->capacity < capacity_hint);
+
+	return sv;
+}
+
+/**
+ * Function: seg_vector_destroy
+ * ------------------------------------------------------
+ * Destroys every element, then frees each chunk and the vector.
+ */
+void
+seg_vector_destroy (seg_vector *sv)
+{
+	assert (sv != NULL);
+	assert (sv->magic == MAGIC_INIT_VALUE);
+	size_t i;
+
+	seg_vector_clear (sv);
+	for (i = 0; i < sv->n_chunks; i++)
+	{
+		free (sv->chunks[i]);
+	}
+	free (sv);
+}
+
+/**
+ * Function: seg_vector_size
+ * ------------------------------------------------------
+ * Returns the number of elements in the seg_vector.
+ *
+ * param sv - initialized seg_vector
+ */
+size_t
+seg_vector_size (const seg_vector *sv)
+{
+	assert (sv != NULL);
+	assert (sv->magic == MAGIC_INIT_VALUE);
+
+	return sv->n_elems;
+}
+
+/**
+ * Function: seg_vector_access
+ * ------------------------------------------------------
+ * Finds the chunk holding index from the high bits of its position and the
+ * element within it from the low bits.
+ *
+ * param sv    - initialized seg_vector
+ * param index - the index of the element, less than the size
+ *
+ * returns - a pointer to the element, stable until it is removed
+ */
+void *
+seg_vector_access (seg_vector *sv, size_t index)
+{
+	assert (sv != NULL);
+	assert (sv->magic == MAGIC_INIT_VALUE);
+	assert (index < sv->n_elems);
+
+	return seg_vector_locate (sv, index, NULL);
+}
+
+/**
+ * Function: seg_vector_span
+ * ------------------------------------------------------
+ * Finds the element at index and how far its chunk runs on from it, cut off
+ * at the end of the vector.
+ *
+ * param sv    - initialized seg_vector
+ * param index - the index of the first element of the span
+ * param n_run - where to store the number of contiguous elements
+ *
+ * returns - a pointer to the element at index
+ */
+void *
+seg_vector_span (seg_vector *sv, size_t index, size_t *n_run)
+{
+	assert (sv != NULL);
+	assert (n_run != NULL);
+	assert (sv->magic == MAGIC_INIT_VALUE);
+	assert (index < sv->n_elems);
+	size_t chunk_len, chunk_end;
+	uint8_t *ptr;
+
+	ptr = seg_vector_locate (sv, index, &chunk_len);
+
+	/* the chunk of length 2^high ends where pos reaches 2^(high + 1) */
+	chunk_end = 2 * chunk_len - FIRST_CHUNK;
+	*n_run = ((chunk_end < sv->n_elems) ? chunk_end : sv->n_elems) - index;
+
+	return ptr;
+}
+
+/**
+ * Function: seg_vector_append
+ * ------------------------------------------------------
+ * Appends a copy of elem, adding a chunk first if every chunk is full.
+ *
+ * param sv   - initialized seg_vector
+ * param elem - a pointer to the new element data to append by copy
+ *
+ * returns - a pointer to the stored element
+ */
+void *
+seg_vector_append (seg_vector *sv, const void *elem)
+{
+	assert (sv != NULL);
+	assert (elem != NULL);
+	assert (sv->magic == MAGIC_INIT_VALUE);
+	uint8_t *slot;
+
+	if (sv->n_elems == sv->capacity)
+	{
+		seg_vector_grow (sv);
+	}
+
+	slot = seg_vector_locate (sv, sv->n_elems++, NULL);
+	memcpy (slot, elem, sv->elem_sz);
+
+	return slot;
+}
+
+/**
+ * Function: seg_vector_replace
+ * ------------------------------------------------------
+ * Destroys the element at index and copies elem into its place.
+ *
+ * param sv    - initialized seg_vector
+ * param elem  - a pointer to the element to copy in
+ * param index - the index of the element to replace
+ */
+void
+seg_vector_replace (seg_vector *sv, const void *elem, size_t index)
+{
+	assert (sv != NULL);
+	assert (elem != NULL);
+	assert (sv->magic == MAGIC_INIT_VALUE);
+	uint8_t *slot = seg_vector_access (sv, index);
+
+	if (sv->elem_destroy)
+	{
+		sv->elem_destroy (slot);
+	}
+	memcpy (slot, elem, sv->elem_sz);
+}
+
+/**
+ * Function: seg_vector_remove_last
+ * ------------------------------------------------------
+ * Destroys the last element. Its chunk stays allocated for the next append.
+ *
+ * param sv - initialized, non empty seg_vector
+ */
+void
+seg_vector_remove_last (seg_vector *sv)
+{
+	assert (sv != NULL);
+	assert (sv->magic == MAGIC_INIT_VALUE);
+	assert (sv->n_elems > 0);
+
+	sv->n_elems--;
+	if (sv->elem_destroy)
+	{
+		sv->elem_destroy (seg_vector_locate (sv, sv->n_elems, NULL));
+	}
+}
+
+/**
+ * Function: seg_vector_clear
+ * ------------------------------------------------------
+ * Destroys every element a chunk at a time. The chunks stay allocated.
+ */
+void
+seg_vector_clear (seg_vector *sv)
+{
+	assert (sv != NULL);
+	assert (sv->magic == MAGIC_INIT_VALUE);
+	size_t i = 0, n_run, k;
+	uint8_t *run;
+
+	if (sv->elem_destroy)
+	{
+		while (i < sv->n_elems)
+		{
+			run = seg_vector_span (sv, i, &n_run);
+			for (k = 0; k < n_run; k++)
+			{
+				sv->elem_destroy (run + k * sv->elem_sz);
+			}
+			i += n_run;
+		}
+	}
+
+	sv->n_elems = 0;
+}
@@ -2,13 +2,153 @@
  * File: Set.c
  * Author: Seth Charles
  * ----------------------
+ * The set is a red-black tree balanced top-down, so that insertion and
+ * removal make a single pass from the root without parent pointers. links[0]
+ * holds the smaller elements and links[1] the larger.
  */
 #include "Set.h"
+#include "ADT_stream.h"
+#include "Bloom.h"
 #include <assert.h>
 #include <string.h>
 #include <stdio.h>
 
 #define MAGIC_INIT_VALUE   (0x739caf14a2d9e85f)
+#define IS_RED(SE)         ((SE) != NULL && (SE)->is_red)
+#define MAX_HEIGHT         (128) /* a red-black tree is at most 2 log2 (n + 1) tall */
+#define STREAM_MAGIC       (0x4d52545353544441ULL) /* "ADTSSTRM" */
+#define FILTER_MIN_SZ      (1024) /* the fewest elements a filter is sized for */
+
+/**
+ * Function: set_elem_new
+ * ------------------------------------------------------
+ * Allocates a red leaf holding a copy of key.
+ */
+static set_elem *
+set_elem_new (const set *s, const void *key)
+{
+	set_elem *se = malloc (sizeof (set_elem) + s->elem_sz);
+	assert (se != NULL);
+
+	se->links[0] = se->links[1] = NULL;
+	se->is_red = 1;
+	memcpy (se->data, key, s->elem_sz);
+
+	return se;
+}
+
+/**
+ * Function: set_rotate_single
+ * ------------------------------------------------------
+ * Rotates root in direction dir and recolors so that the new root is black
+ * and the old root red.
+ *
+ * returns - the new root of the subtree
+ */
+static set_elem *
+set_rotate_single (set_elem *root, int dir)
+{
+	set_elem *save = root->links[!dir];
+
+	root->links[!dir] = save->links[dir];
+	save->links[dir] = root;
+
+	root->is_red = 1;
+	save->is_red = 0;
+
+	return save;
+}
+
+/**
+ * Function: set_rotate_double
+ * ------------------------------------------------------
+ * Rotates the child of root opposite dir, then root itself in dir.
+ *
+ * returns - the new root of the subtree
+ */
+static set_elem *
+set_rotate_double (set_elem *root, int dir)
+{
+	root->links[!dir] = set_rotate_single (root->links[!dir], !dir);
+	return set_rotate_single (root, dir);
+}
+
+/**
+ * Function: set_destroy_helper
+ * ------------------------------------------------------
+ * Frees a subtree. The recursion depth is bounded by the tree height.
+ */
+static void
+set_destroy_helper (set *s, set_elem *se)
+{
+	if (se != NULL)
+	{
+		set_destroy_helper (s, se->links[0]);
+		set_destroy_helper (s, se->links[1]);
+
+		if (s->elem_destroy)
+		{
+			s->elem_destroy (se->data);
+		}
+		free (se);
+	}
+}
+
+/**
+ * Function: set_filter_build
+ * ------------------------------------------------------
+ * Replaces the filter with one sized for twice the elements, or
+ * FILTER_MIN_SZ, and adds every element, walking the tree with an explicit
+ * stack.
+ */
+static void
+set_filter_build (set *s, hash_fn hash, double fp_rate)
+{
+	const set_elem *stack[MAX_HEIGHT], *se = s->root;
+	size_t top = 0;
+	bloom *filter;
+
+	filter = bloom_init (s->elem_sz, (2 * s->n_elems > FILTER_MIN_SZ) ? 2 * s->n_elems : FILTER_MIN_SZ,
+	                     fp_rate, hash);
+	while (se != NULL || top > 0)
+	{
+		while (se != NULL)
+		{
+			stack[top++] = se;
+			se = se->links[0];
+		}
+		se = stack[--top];
+		bloom_add (filter, se->data);
+		se = se->links[1];
+	}
+
+	if (s->filter != NULL)
+	{
+		bloom_destroy (s->filter);
+	}
+	s->filter = filter;
+}
+
+/**
+ * Function: set_filter_add
+ * ------------------------------------------------------
+ * Adds a new element to the filter, if there is one, rebuilding it once it
+ * has taken more additions than it was sized for.
+ */
+static void
+set_filter_add (set *s, const void *key)
+{
+	if (s->filter == NULL)
+	{
+		return;
+	}
+	if (s->filter->n_added >= s->filter->capacity)
+	{
+		set_filter_build (s, s->filter->elem_hash, s->filter->fp_rate);
+		return;
+	}
+	bloom_add (s->filter, key);
+}
 
 /**
  * Function: set_init
@@ -42,11 +182,11 @@ set_destroy (set *s)
 	assert (s != NULL);
 	assert (s->magic == MAGIC_INIT_VALUE);
 
-	if (s->elem_destroy)
+	set_destroy_helper (s, s->root);
+	if (s->filter != NULL)
 	{
-		/* TODO: need to traverse tree and free all the leaves */
+		bloom_destroy (s->filter);
 	}
-
 	free (s);
 }
 
@@ -76,64 +216,526 @@ set_size (const set *s)
 	return s->n_elems;
 }
 
+/**
+ * Function: set_contains
+ * ------------------------------------------------------
+ */
+bool
+set_contains (const set *s, const void *key)
+{
+	assert (s != NULL);
+	assert (key != NULL);
+	assert (s->magic == MAGIC_INIT_VALUE);
+
+	const set_elem *se = s->root;
+	int result;
+
+	if (s->filter != NULL && !bloom_contains (s->filter, key))
+	{
+		return false;
+	}
+
+	while (se != NULL)
+	{
+		result = s->elem_cmp (se->data, key);
+		if (result == 0)
+		{
+			return true;
+		}
+		se = se->links[result < 0];
+	}
+
+	return false;
+}
 
 /**
- * Function: set_contains_helper
+ * Function: set_add
  * ------------------------------------------------------
+ * Walks down from the root, splitting any node with two red children by a
+ * color flip and repairing red violations with rotations on the way. The new
+ * leaf can then be attached red without any fix up on the way back.
  */
-static bool
-set_contains_helper (const set *s, const set_elem *se, const void *key)
+bool
+set_add (set *s, const void *key)
 {
-	bool retVal = false;
-	int result, i;
+	assert (s != NULL);
+	assert (key != NULL);
+	assert (s->magic == MAGIC_INIT_VALUE);
 
-	if (se != NULL)
+	set_elem head = { { NULL, NULL }, 0 };
+	set_elem *g, *t, *p, *q;
+	int dir = 0, last = 0, dir2, result;
+	bool added = false;
+
+	if (s->root == NULL)
+	{
+		s->root = set_elem_new (s, key);
+		s->root->is_red = 0;
+		++s->n_elems;
+		set_filter_add (s, key);
+		return true;
+	}
+
+	t = &head;
+	g = p = NULL;
+	q = t->links[1] = s->root;
+
+	for (;;)
 	{
-		result = s->elem_cmp (&se->data, key);
-		
+		if (q == NULL)
+		{
+			p->links[dir] = q = set_elem_new (s, key);
+			added = true;
+		}
+		else if (IS_RED (q->links[0]) && IS_RED (q->links[1]))
+		{
+			q->is_red = 1;
+			q->links[0]->is_red = 0;
+			q->links[1]->is_red = 0;
+		}
+
+		if (IS_RED (q) && IS_RED (p))
+		{
+			dir2 = (t->links[1] == g);
+			if (q == p->links[last])
+			{
+				t->links[dir2] = set_rotate_single (g, !last);
+			}
+			else
+			{
+				t->links[dir2] = set_rotate_double (g, !last);
+			}
+		}
+
+		result = added ? 0 : s->elem_cmp (q->data, key);
 		if (result == 0)
 		{
-			retVal =  true;
+			break;
 		}
-		else
+
+		last = dir;
+		dir = (result < 0);
+
+		if (g != NULL)
 		{
-			i = (result < 0) ? 0 : 1;
-			retVal = set_contains_helper (s, PTR_IGNORE_FLAG (se->links[i]), key);
+			t = g;
 		}
+		g = p;
+		p = q;
+		q = q->links[dir];
+	}
+
+	s->root = head.links[1];
+	s->root->is_red = 0;
+
+	if (added)
+	{
+		++s->n_elems;
+		set_filter_add (s, key);
 	}
-	return retVal;
+	return added;
 }
 
 /**
- * Function: set_contains
+ * Function: set_remove
  * ------------------------------------------------------
+ * Walks down to the in-order predecessor of the key, pushing a red node
+ * ahead of the walk so the node finally unlinked is red. The predecessor's
+ * data is copied over the matching node before the predecessor is freed.
  */
 bool
-set_contains (const set *s, const void *key)
+set_remove (set *s, const void *key)
 {
 	assert (s != NULL);
 	assert (key != NULL);
 	assert (s->magic == MAGIC_INIT_VALUE);
 
-	return set_contains_helper (s, s->root, key);
+	set_elem head = { { NULL, NULL }, 0 };
+	set_elem *q, *p, *g, *f = NULL, *sib;
+	int dir = 1, last, dir2, result;
+
+	if (s->root == NULL)
+	{
+		return false;
+	}
+
+	q = &head;
+	g = p = NULL;
+	q->links[1] = s->root;
+
+	while (q->links[dir] != NULL)
+	{
+		last = dir;
+
+		g = p;
+		p = q;
+		q = q->links[dir];
+
+		result = s->elem_cmp (q->data, key);
+		dir = (result < 0);
+
+		if (result == 0)
+		{
+			f = q;
+		}
+
+		if (!IS_RED (q) && !IS_RED (q->links[dir]))
+		{
+			if (IS_RED (q->links[!dir]))
+			{
+				p = p->links[last] = set_rotate_single (q, dir);
+			}
+			else if ((sib = p->links[!last]) != NULL)
+			{
+				if (!IS_RED (sib->links[!last]) && !IS_RED (sib->links[last]))
+				{
+					p->is_red = 0;
+					sib->is_red = 1;
+					q->is_red = 1;
+				}
+				else
+				{
+					dir2 = (g->links[1] == p);
+
+					if (IS_RED (sib->links[last]))
+					{
+						g->links[dir2] = set_rotate_double (p, last);
+					}
+					else
+					{
+						g->links[dir2] = set_rotate_single (p, last);
+					}
+
+					q->is_red = g->links[dir2]->is_red = 1;
+					g->links[dir2]->links[0]->is_red = 0;
+					g->links[dir2]->links[1]->is_red = 0;
+				}
+			}
+		}
+	}
+
+	if (f != NULL)
+	{
+		if (s->elem_destroy)
+		{
+			s->elem_destroy (f->data);
+		}
+		if (f != q)
+		{
+			memcpy (f->data, q->data, s->elem_sz);
+		}
+
+		p->links[p->links[1] == q] = q->links[q->links[0] == NULL];
+		free (q);
+		--s->n_elems;
+	}
+
+	s->root = head.links[1];
+	if (s->root != NULL)
+	{
+		s->root->is_red = 0;
+	}
+
+	return (f != NULL);
 }
 
 /**
- * Function: set_add
+ * Function: set_use_filter
  * ------------------------------------------------------
+ * Builds a Bloom filter of the elements already in the set, sized for twice
+ * as many or FILTER_MIN_SZ, whichever is more, and swaps it in for any
+ * filter the set had. With a NULL hash the filter is destroyed instead and
+ * set_contains goes back to walking the tree for every key; fp_rate is then
+ * ignored.
+ *
+ * param s       - initialized set
+ * param hash    - the hash function for elements, or NULL to drop the filter
+ * param fp_rate - the false positive rate the filter is sized for
  */
-void 
-set_add (set *s, const void *key)
+void
+set_use_filter (set *s, hash_fn hash, double fp_rate)
 {
+	assert (s != NULL);
+	assert (s->magic == MAGIC_INIT_VALUE);
 
+	if (hash == NULL)
+	{
+		if (s->filter != NULL)
+		{
+			bloom_destroy (s->filter);
+			s->filter = NULL;
+		}
+		return;
+	}
+
+	assert (fp_rate > 0.0 && fp_rate < 1.0);
+	set_filter_build (s, hash, fp_rate);
 }
 
 /**
- * Function: set_remove
+ * Struct: set_stream
+ * ----------------------------------
+ * The state of a set being written or read a chunk at a time.
+ *
+ * field fd     - the file descriptor
+ * field c      - the running checksum
+ * field buf    - STREAM_CHUNK_SZ bytes of elements on their way through
+ * field pos    - the bytes of buf filled, when writing, or consumed
+ * field len    - the bytes of buf read, when reading
+ * field left   - the bytes of the stream's elements not yet read
+ * field header - the header, until it has been written with the first chunk
+ * field s      - the set being written or built
+ * field prev   - the element read last, for the order check
+ * field failed - whether an I/O error, a bad checksum or a misordered
+ *                element has been met
+ */
+typedef struct
+{
+	int fd;
+	stream_checksum c;
+	uint8_t *buf;
+	size_t pos, len, left;
+	const uint8_t *header;
+	const set *s;
+	const set_elem *prev;
+	bool failed;
+} set_stream;
+
+/**
+ * Function: set_stream_put
  * ------------------------------------------------------
+ * Copies an element into the write buffer, writing the buffer out whenever
+ * it fills. An element may straddle two chunks.
  */
-bool 
-set_remove (set *s, const void *key)
+static void
+set_stream_put (set_stream *st, const uint8_t *data)
 {
-	return false;
-}
\ No newline at end of file
+	size_t left = st->s->elem_sz, n;
+
+	while (left > 0 && !st->failed)
+	{
+		if (st->pos == STREAM_CHUNK_SZ)
+		{
+			st->failed = !stream_write_chunk (st->fd, &st->c, st->header, st->buf, st->pos, false);
+			st->header = NULL;
+			st->pos = 0;
+		}
+
+		n = (left < STREAM_CHUNK_SZ - st->pos) ? left : STREAM_CHUNK_SZ - st->pos;
+		memcpy (st->buf + st->pos, data, n);
+		st->pos += n;
+		data += n;
+		left -= n;
+	}
+}
+
+/**
+ * Function: set_stream_next
+ * ------------------------------------------------------
+ * Reads the next element into a new node, refilling the read buffer
+ * as it empties, and checks that it sorts after the previous one.
+ *
+ * returns - the node, or NULL once the stream has failed
+ */
+static set_elem *
+set_stream_next (set_stream *st)
+{
+	set_elem *se;
+	size_t left = st->s->elem_sz, n;
+
+	se = malloc (sizeof (set_elem) + st->s->elem_sz);
+	assert (se != NULL);
+	se->links[0] = se->links[1] = NULL;
+
+	while (left > 0 && !st->failed)
+	{
+		if (st->pos == st->len)
+		{
+			st->len = (st->left < STREAM_CHUNK_SZ) ? st->left : STREAM_CHUNK_SZ;
+			st->failed = !stream_read_chunk (st->fd, &st->c, st->buf, st->len, st->len == st->left);
+			st->left -= st->len;
+			st->pos = 0;
+			continue;
+		}
+
+		n = (left < st->len - st->pos) ? left : st->len - st->pos;
+		memcpy (se->data + st->s->elem_sz - left, st->buf + st->pos, n);
+		st->pos += n;
+		left -= n;
+	}
+
+	if (!st->failed && st->prev != NULL && st->s->elem_cmp (st->prev->data, se->data) >= 0)
+	{
+		st->failed = true;
+	}
+	if (st->failed)
+	{
+		free (se);
+		return NULL;
+	}
+
+	st->prev = se;
+	return se;
+}
+
+/**
+ * Function: set_build
+ * ------------------------------------------------------
+ * Builds a tree of the next n elements in the stream, taking them in order:
+ * the smaller half becomes the left subtree, then the middle element is
+ * read into the root, then the rest becomes the right subtree. Halving this
+ * way fills every level above floor (log2 (n + 1)) and leaves the rest
+ * partly filled, so coloring just the nodes at that depth red gives every
+ * path the same number of black nodes with no red node under another.
+ *
+ * param st        - the stream to read from
+ * param n         - the number of elements in the subtree
+ * param depth     - the depth of the subtree's root
+ * param red_depth - the depth at which nodes are red
+ *
+ * returns - the root of the subtree, or NULL if the stream failed, in which
+ *           case any nodes read have been freed
+ */
+static set_elem *
+set_build (set_stream *st, size_t n, size_t depth, size_t red_depth)
+{
+	set_elem *left, *se;
+
+	if (n == 0)
+	{
+		return NULL;
+	}
+
+	left = set_build (st, (n - 1) / 2, depth + 1, red_depth);
+	if (st->failed || (se = set_stream_next (st)) == NULL)
+	{
+		set_destroy_helper ((set *)st->s, left);
+		return NULL;
+	}
+
+	se->links[0] = left;
+	se->is_red = (depth == red_depth);
+	se->links[1] = set_build (st, n - 1 - (n - 1) / 2, depth + 1, red_depth);
+	if (st->failed)
+	{
+		set_destroy_helper ((set *)st->s, se);
+		return NULL;
+	}
+
+	return se;
+}
+
+/**
+ * Function: set_write
+ * ------------------------------------------------------
+ * Walks the tree in order with an explicit stack, copying the elements into
+ * a chunk buffer that is checksummed and written each time it fills, so the
+ * stream is one sorted run written in megabyte writev calls.
+ *
+ * param s  - initialized set
+ * param fd - the file descriptor to write to
+ *
+ * returns - false on an I/O error
+ */
+bool
+set_write (const set *s, int fd)
+{
+	assert (s != NULL);
+	assert (s->magic == MAGIC_INIT_VALUE);
+
+	uint8_t header[STREAM_HEADER_SZ];
+	const set_elem *stack[MAX_HEIGHT], *se = s->root;
+	size_t top = 0;
+	set_stream st = { .fd = fd, .header = header, .s = s };
+
+	st.buf = malloc (STREAM_CHUNK_SZ);
+	assert (st.buf != NULL);
+	stream_header_encode (header, STREAM_MAGIC, s->elem_sz, s->n_elems, &st.c);
+
+	while ((se != NULL || top > 0) && !st.failed)
+	{
+		while (se != NULL)
+		{
+			/* the right child is next once the left subtree is done */
+			if (se->links[1] != NULL)
+			{
+				__builtin_prefetch (se->links[1]);
+			}
+			stack[top++] = se;
+			se = se->links[0];
+		}
+
+		se = stack[--top];
+		set_stream_put (&st, se->data);
+		se = se->links[1];
+	}
+
+	if (!st.failed)
+	{
+		st.failed = !stream_write_chunk (fd, &st.c, st.header, st.buf, st.pos, true);
+	}
+
+	free (st.buf);
+	return !st.failed;
+}
+
+/**
+ * Function: set_read
+ * ------------------------------------------------------
+ * Reads a stream written by set_write and builds a balanced tree from it in
+ * one pass, in O(n) rather than the O(n log n) of adding the elements one at
+ * a time. Nodes are allocated in order as the elements arrive, so a corrupt
+ * count fails at the end of the data rather than in the allocator.
+ *
+ * param fd         - the file descriptor to read from
+ * param cmp_fn     - the compare function the set was written under
+ * param destroy_fn - the cleanup function for elements
+ *
+ * returns - a pointer to the set object, or NULL if the stream is
+ *           unreadable, of another kind or version, fails its checksum or
+ *           is out of order
+ */
+set *
+set_read (int fd, compare_fn cmp_fn, elem_destroy_fn destroy_fn)
+{
+	assert (cmp_fn != NULL);
+
+	size_t elem_sz, n_elems, red_depth = 0;
+	set_stream st = { .fd = fd };
+	set *s;
+
+	if (!stream_read_header (fd, STREAM_MAGIC, &elem_sz, &n_elems, &st.c) ||
+	    n_elems > SIZE_MAX / elem_sz)
+	{
+		return NULL;
+	}
+
+	/* no destroy function until the elements are known good */
+	s = set_init (elem_sz, cmp_fn, NULL);
+	st.s = s;
+	st.left = n_elems * elem_sz;
+	st.buf = malloc (STREAM_CHUNK_SZ);
+	assert (st.buf != NULL);
+
+	while (((n_elems + 1) >> (red_depth + 1)) > 0)
+	{
+		red_depth++;
+	}
+
+	if (n_elems == 0)
+	{
+		st.failed = !stream_read_chunk (fd, &st.c, NULL, 0, true);
+	}
+	s->root = set_build (&st, n_elems, 0, red_depth);
+	free (st.buf);
+
+	if (st.failed)
+	{
+		set_destroy (s);
+		return NULL;
+	}
+
+	s->n_elems = n_elems;
+	s->elem_destroy = destroy_fn;
+	return s;
+}
@@ -0,0 +1,364 @@
+/**
+ * File: TimerWheel.c
+ * Author: Seth Charles
+ * ----------------------
+ */
+#include "TimerWheel.h"
+#include <assert.h>
+#include <string.h>
+#include <stdio.h>
+
+#define MAGIC_INIT_VALUE       (0x739caf14a2d9e85f)
+#define TIMER_WHEEL_MASK       ((uint64_t)TIMER_WHEEL_SLOTS - 1)
+#define TIMER_WHEEL_RANGE      ((uint64_t)1 << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS))
+#define LEVEL_SHIFT(L)         (TIMER_WHEEL_BITS * (L))
+#define LEVEL_INDEX(T, L)      (((T) >> LEVEL_SHIFT (L)) & TIMER_WHEEL_MASK)
+#define SLOT_LEVEL(TW, S)      ((size_t)((S) - &(TW)->slots[0][0]) / TIMER_WHEEL_SLOTS)
+
+/**
+ * Function: timer_wheel_place
+ * ------------------------------------------------------
+ * Links a timer into the slot covering its expiry. The level is chosen by how
+ * far the expiry is from the next tick to be processed. Expiries beyond the
+ * range of the wheel are parked in the top level and placed again when that
+ * slot is cascaded.
+ *
+ * param tw - initialized wheel
+ * param t  - the timer to place
+ */
+static void
+timer_wheel_place (timer_wheel *tw, timer_elem *t)
+{
+	uint64_t base = tw->now + 1, expires = t->expires, delta;
+	int level = 0;
+
+	if (expires < base)
+	{
+		expires = base;
+	}
+
+	delta = expires - base;
+	if (delta >= TIMER_WHEEL_RANGE)
+	{
+		delta = TIMER_WHEEL_RANGE - 1;
+		expires = base + delta;
+	}
+
+	while (delta >> LEVEL_SHIFT (level + 1))
+	{
+		++level;
+	}
+
+	t->slot = &tw->slots[level][LEVEL_INDEX (expires, level)];
+	list_push_back (t->slot, t);
+	++tw->n_level[level];
+}
+
+/**
+ * Function: timer_wheel_unlink
+ * ------------------------------------------------------
+ * Unlinks a pending timer from its slot.
+ */
+static void
+timer_wheel_unlink (timer_wheel *tw, timer_elem *t)
+{
+	--tw->n_level[SLOT_LEVEL (tw, t->slot)];
+	list_remove (t->slot, t);
+	t->slot = NULL;
+}
+
+/**
+ * Function: timer_wheel_cascade
+ * ------------------------------------------------------
+ * Moves every timer of a slot into the levels below. The slot is emptied
+ * first, since parked timers may be placed back into it.
+ *
+ * param tw    - initialized wheel
+ * param level - the level of the slot, never 0
+ * param index - the slot within the level
+ */
+static void
+timer_wheel_cascade (timer_wheel *tw, int level, size_t index)
+{
+	list pending;
+	timer_elem *t;
+
+	list_init_static (&pending, NULL);
+	list_splice (&pending, &tw->slots[level][index]);
+	tw->n_level[level] -= list_size (&pending);
+
+	while ((t = list_front (&pending)) != NULL)
+	{
+		list_pop_front (&pending);
+		timer_wheel_place (tw, t);
+	}
+}
+
+/**
+ * Function: timer_wheel_init
+ * ------------------------------------------------------
+ * Public function to perform wheel initialization
+ *
+ * param now  - the current tick
+ * param fire - the function called on each expired timer
+ * param fn   - the cleanup function to call on timers pending at destroy
+ *
+ * returns - a pointer to the wheel object
+ */
+timer_wheel *
+timer_wheel_init (uint64_t now, timer_fire_fn fire, elem_destroy_fn fn)
+{
+	assert (fire != NULL);
+	timer_wheel *tw;
+	int level, index;
+
+	tw = malloc (sizeof (timer_wheel));
+	assert (tw != NULL);
+
+	/* slots never destroy, cancelled timers still belong to the client */
+	for (level = 0; level < TIMER_WHEEL_LEVELS; level++)
+	{
+		for (index = 0; index < TIMER_WHEEL_SLOTS; index++)
+		{
+			list_init_static (&tw->slots[level][index], NULL);
+		}
+	}
+
+	memset (tw->n_level, 0, sizeof (tw->n_level));
+	tw->now = now;
+	tw->n_timers = 0;
+	tw->fire = fire;
+	tw->elem_destroy = fn;
+	tw->magic = MAGIC_INIT_VALUE;
+
+	return tw;
+}
+
+/**
+ * Function: timer_wheel_destroy
+ * ------------------------------------------------------
+ * Destroys the wheel, calling the destroy function on pending timers.
+ *
+ * param tw - the wheel to destroy
+ */
+void
+timer_wheel_destroy (timer_wheel *tw)
+{
+	assert (tw != NULL);
+	assert (tw->magic == MAGIC_INIT_VALUE);
+
+	timer_elem *t;
+	int level, index;
+
+	for (level = 0; level < TIMER_WHEEL_LEVELS; level++)
+	{
+		for (index = 0; index < TIMER_WHEEL_SLOTS; index++)
+		{
+			while ((t = list_front (&tw->slots[level][index])) != NULL)
+			{
+				list_pop_front (&tw->slots[level][index]);
+				t->slot = NULL;
+				if (tw->elem_destroy)
+				{
+					tw->elem_destroy (t);
+				}
+			}
+		}
+	}
+
+	free (tw);
+}
+
+/**
+ * Function: timer_wheel_size
+ * ------------------------------------------------------
+ */
+size_t
+timer_wheel_size (const timer_wheel *tw)
+{
+	assert (tw != NULL);
+	assert (tw->magic == MAGIC_INIT_VALUE);
+
+	return tw->n_timers;
+}
+
+/**
+ * Function: timer_wheel_now
+ * ------------------------------------------------------
+ */
+uint64_t
+timer_wheel_now (const timer_wheel *tw)
+{
+	assert (tw != NULL);
+	assert (tw->magic == MAGIC_INIT_VALUE);
+
+	return tw->now;
+}
+
+/**
+ * Function: timer_init
+ * ------------------------------------------------------
+ */
+void
+timer_init (void *timer)
+{
+	assert (timer != NULL);
+
+	((timer_elem *)timer)->slot = NULL;
+}
+
+/**
+ * Function: timer_pending
+ * ------------------------------------------------------
+ */
+bool
+timer_pending (const void *timer)
+{
+	assert (timer != NULL);
+
+	return ((const timer_elem *)timer)->slot != NULL;
+}
+
+/**
+ * Function: timer_add
+ * ------------------------------------------------------
+ * Arms a timer, re-arming it if it is already pending.
+ *
+ * param tw      - initialized wheel
+ * param timer   - the client timer, with timer_elem as its first field
+ * param expires - the tick at which to fire
+ */
+void
+timer_add (timer_wheel *tw, void *timer, uint64_t expires)
+{
+	assert (tw != NULL);
+	assert (timer != NULL);
+	assert (tw->magic == MAGIC_INIT_VALUE);
+
+	timer_elem *t = timer;
+
+	if (t->slot != NULL)
+	{
+		timer_wheel_unlink (tw, t);
+	}
+	else
+	{
+		++tw->n_timers;
+	}
+
+	t->expires = expires;
+	timer_wheel_place (tw, t);
+}
+
+/**
+ * Function: timer_cancel
+ * ------------------------------------------------------
+ * Unlinks a pending timer from its slot.
+ *
+ * param tw    - initialized wheel
+ * param timer - the client timer
+ *
+ * returns - true if the timer was pending
+ */
+bool
+timer_cancel (timer_wheel *tw, void *timer)
+{
+	assert (tw != NULL);
+	assert (timer != NULL);
+	assert (tw->magic == MAGIC_INIT_VALUE);
+
+	timer_elem *t = timer;
+
+	if (t->slot == NULL)
+	{
+		return false;
+	}
+
+	timer_wheel_unlink (tw, t);
+	--tw->n_timers;
+
+	return true;
+}
+
+/**
+ * Function: timer_advance
+ * ------------------------------------------------------
+ * Processes each tick up to now. On a tick that starts the range of a higher
+ * level slot, that slot is cascaded down first. The level 0 slot for the
+ * tick then holds exactly the timers due on it and is drained as one batch.
+ * While the lower levels are empty nothing can happen before the next
+ * boundary of the lowest occupied level, so the ticks up to it are skipped.
+ *
+ * param tw  - initialized wheel
+ * param now - the tick to advance to
+ *
+ * returns - the number of timers fired
+ */
+size_t
+timer_advance (timer_wheel *tw, uint64_t now)
+{
+	assert (tw != NULL);
+	assert (tw->magic == MAGIC_INIT_VALUE);
+
+	uint64_t tick, boundary;
+	size_t fired = 0, index;
+	int level;
+	list *slot;
+	timer_elem *t;
+
+	while (tw->now < now)
+	{
+		if (tw->n_timers == 0)
+		{
+			tw->now = now;
+			break;
+		}
+
+		for (level = 0; level < TIMER_WHEEL_LEVELS - 1; level++)
+		{
+			if (tw->n_level[level] != 0)
+			{
+				break;
+			}
+		}
+
+		if (level > 0)
+		{
+			boundary = ((tw->now >> LEVEL_SHIFT (level)) + 1) << LEVEL_SHIFT (level);
+			if (boundary > now)
+			{
+				tw->now = now;
+				break;
+			}
+			tw->now = boundary - 1;
+		}
+
+		tick = tw->now + 1;
+
+		for (level = 1; level < TIMER_WHEEL_LEVELS; level++)
+		{
+			if (tick & ((1ULL << LEVEL_SHIFT (level)) - 1))
+			{
+				break;
+			}
+			index = LEVEL_INDEX (tick, level);
+			timer_wheel_cascade (tw, level, index);
+		}
+
+		/* timers armed from fire callbacks land on later ticks */
+		tw->now = tick;
+		slot = &tw->slots[0][LEVEL_INDEX (tick, 0)];
+
+		while ((t = list_front (slot)) != NULL)
+		{
+			list_pop_front (slot);
+			t->slot = NULL;
+			--tw->n_level[0];
+			--tw->n_timers;
+			++fired;
+			tw->fire (t);
+		}
+	}
+
+	return fired;
+}
@@ -0,0 +1,503 @@
+/**
+ * File: UnrolledList.c
+ * Author: Seth Charles
+ * ----------------------
+ */
+#include "UnrolledList.h"
+#include <assert.h>
+#include <string.h>
+#include <stdio.h>
+
+#define DEFAULT_NODE_BYTES     (256UL)
+#define MIN_NODE_CAPACITY      (4UL)
+#define GET_PTR_ELEM(UL, N, I) ((N)->elems + ((I) * (UL)->elem_sz))
+#define MAGIC_INIT_VALUE       (0x739caf14a2d9e85f)
+
+/**
+ * Function: unrolled_list_node_new
+ * ------------------------------------------------------
+ * Allocates an empty node and links it after prev, or at the head when prev
+ * is NULL.
+ */
+static unrolled_list_node *
+unrolled_list_node_new (unrolled_list *ul, unrolled_list_node *prev)
+{
+	unrolled_list_node *node;
+
+	node = malloc (sizeof (unrolled_list_node) + ul->node_capacity * ul->elem_sz);
+	assert (node != NULL);
+
+	node->n_elems = 0;
+	node->prev = prev;
+	node->next = (prev != NULL) ? prev->next : ul->head;
+
+	if (node->next != NULL)
+	{
+		node->next->prev = node;
+	}
+	else
+	{
+		ul->tail = node;
+	}
+
+	if (prev != NULL)
+	{
+		prev->next = node;
+	}
+	else
+	{
+		ul->head = node;
+	}
+
+	return node;
+}
+
+/**
+ * Function: unrolled_list_node_free
+ * ------------------------------------------------------
+ * Unlinks and frees a node. Its elements must already have been moved out
+ * or destroyed.
+ */
+static void
+unrolled_list_node_free (unrolled_list *ul, unrolled_list_node *node)
+{
+	if (node->prev != NULL)
+	{
+		node->prev->next = node->next;
+	}
+	else
+	{
+		ul->head = node->next;
+	}
+
+	if (node->next != NULL)
+	{
+		node->next->prev = node->prev;
+	}
+	else
+	{
+		ul->tail = node->prev;
+	}
+
+	free (node);
+}
+
+/**
+ * Function: unrolled_list_locate
+ * ------------------------------------------------------
+ * Finds the node holding index, starting from whichever of the head, the
+ * tail or the finger is closest. The finger is left on the node found.
+ *
+ * param ul    - initialized non empty list
+ * param index - the index to find, less than the number of elements
+ * param base  - set to the index of the first element in the node found
+ *
+ * returns - the node holding index
+ */
+static unrolled_list_node *
+unrolled_list_locate (unrolled_list *ul, size_t index, size_t *base)
+{
+	unrolled_list_node *node = ul->finger;
+	size_t b = ul->finger_base;
+
+	if (node == NULL || (index < b && index < b - index))
+	{
+		node = ul->head;
+		b = 0;
+	}
+	else if (index >= b && ul->n_elems - index < index - b)
+	{
+		node = ul->tail;
+		b = ul->n_elems - node->n_elems;
+	}
+
+	while (index < b)
+	{
+		node = node->prev;
+		b -= node->n_elems;
+	}
+
+	while (index >= b + node->n_elems)
+	{
+		b += node->n_elems;
+		node = node->next;
+	}
+
+	ul->finger = node;
+	ul->finger_base = b;
+	*base = b;
+
+	return node;
+}
+
+/**
+ * Function: unrolled_list_rebalance
+ * ------------------------------------------------------
+ * Restores the min_fill invariant after a remove from node. The node and a
+ * neighbour are merged when both fit in one node, otherwise elements move
+ * across the boundary until neither is below min_fill. Since min_fill is at
+ * most half the capacity, two nodes that do not fit in one hold enough for
+ * both.
+ *
+ * param ul   - initialized list
+ * param node - the node an element was removed from
+ * param base - the index of the first element in node
+ */
+static void
+unrolled_list_rebalance (unrolled_list *ul, unrolled_list_node *node, size_t base)
+{
+	unrolled_list_node *a, *b;
+	size_t low = ul->min_fill, n_move;
+
+	if (node->n_elems >= low && node->n_elems > 0)
+	{
+		return;
+	}
+
+	if (node->next != NULL)
+	{
+		a = node;
+	}
+	else if (node->prev != NULL)
+	{
+		a = node->prev;
+		base -= a->n_elems;
+	}
+	else
+	{
+		/* the only node is allowed to run low, but never empty */
+		if (node->n_elems == 0)
+		{
+			unrolled_list_node_free (ul, node);
+			ul->finger = NULL;
+			ul->finger_base = 0;
+		}
+		return;
+	}
+
+	b = a->next;
+
+	if (a->n_elems + b->n_elems <= ul->node_capacity)
+	{
+		memcpy (GET_PTR_ELEM (ul, a, a->n_elems), b->elems, b->n_elems * ul->elem_sz);
+		a->n_elems += b->n_elems;
+		unrolled_list_node_free (ul, b);
+	}
+	else if (a->n_elems < low)
+	{
+		n_move = low - a->n_elems;
+		memcpy (GET_PTR_ELEM (ul, a, a->n_elems), b->elems, n_move * ul->elem_sz);
+		memmove (b->elems, GET_PTR_ELEM (ul, b, n_move), (b->n_elems - n_move) * ul->elem_sz);
+		a->n_elems += n_move;
+		b->n_elems -= n_move;
+	}
+	else
+	{
+		n_move = low - b->n_elems;
+		memmove (GET_PTR_ELEM (ul, b, n_move), b->elems, b->n_elems * ul->elem_sz);
+		memcpy (b->elems, GET_PTR_ELEM (ul, a, a->n_elems - n_move), n_move * ul->elem_sz);
+		a->n_elems -= n_move;
+		b->n_elems += n_move;
+	}
+
+	ul->finger = a;
+	ul->finger_base = base;
+}
+
+/**
+ * Function: unrolled_list_init
+ * ------------------------------------------------------
+ * Public function to perform unrolled list initialization
+ *
+ * param elem_sz       - the size of elements in bytes that are stored
+ * param node_capacity - the number of elements per node, 0 for a default
+ * param fill          - the fraction of a split node kept in the first node,
+ *                       from 0.5 below 1, 0 for a half
+ * param fn            - the cleanup function to call when an element is destroyed
+ *
+ * returns - a pointer to the unrolled list object
+ */
+unrolled_list *
+unrolled_list_init (size_t elem_sz, size_t node_capacity, double fill, elem_destroy_fn fn)
+{
+	assert (elem_sz > 0);
+	assert (node_capacity != 1);
+	assert (fill == 0.0 || (fill >= 0.5 && fill < 1.0));
+	unrolled_list *ul;
+
+	ul = calloc (1, sizeof (unrolled_list));
+	assert (ul != NULL);
+
+	if (node_capacity == 0)
+	{
+		node_capacity = DEFAULT_NODE_BYTES / elem_sz;
+		if (node_capacity < MIN_NODE_CAPACITY)
+		{
+			node_capacity = MIN_NODE_CAPACITY;
+		}
+	}
+
+	if (fill == 0.0)
+	{
+		fill = 0.5;
+	}
+
+	ul->node_capacity = node_capacity;
+	ul->min_fill = (size_t)((1.0 - fill) * (double)node_capacity);
+	if (ul->min_fill == 0)
+	{
+		ul->min_fill = 1;
+	}
+	ul->split_at = node_capacity - ul->min_fill;
+	ul->elem_sz = elem_sz;
+	ul->elem_destroy = fn;
+	ul->magic = MAGIC_INIT_VALUE;
+
+	return ul;
+}
+
+/**
+ * Function: unrolled_list_destroy
+ * ------------------------------------------------------
+ * Destroys the list and deallocates all the memory used for it. Also calls
+ * the provided element destroy function on individual elements.
+ *
+ * param ul - the list to destroy
+ */
+void
+unrolled_list_destroy (unrolled_list *ul)
+{
+	assert (ul != NULL);
+	assert (ul->magic == MAGIC_INIT_VALUE);
+
+	unrolled_list_clear (ul);
+	free (ul);
+}
+
+/**
+ * Function: unrolled_list_size
+ * ------------------------------------------------------
+ */
+size_t
+unrolled_list_size (const unrolled_list *ul)
+{
+	assert (ul != NULL);
+	assert (ul->magic == MAGIC_INIT_VALUE);
+
+	return ul->n_elems;
+}
+
+/**
+ * Function: unrolled_list_access
+ * ------------------------------------------------------
+ * Provides a pointer to the element at index
+ *
+ * param ul    - initialized list
+ * param index - the index to access
+ *
+ * returns     - a pointer to the element
+ */
+void *
+unrolled_list_access (unrolled_list *ul, size_t index)
+{
+	assert (ul != NULL);
+	assert (ul->magic == MAGIC_INIT_VALUE);
+	assert (index < ul->n_elems);
+
+	unrolled_list_node *node;
+	size_t base;
+
+	node = unrolled_list_locate (ul, index, &base);
+
+	return GET_PTR_ELEM (ul, node, index - base);
+}
+
+/**
+ * Function: unrolled_list_insert
+ * ------------------------------------------------------
+ * Inserts an element at index. An insert at the start of a node goes at the
+ * end of the previous node when it has room. A full node is split after its
+ * first split_at elements and the insert goes to whichever part holds index.
+ *
+ * param ul    - initialized list
+ * param elem  - a pointer to the new element data to insert by copy
+ * param index - the index to insert at
+ */
+void
+unrolled_list_insert (unrolled_list *ul, const void *elem, size_t index)
+{
+	assert (ul != NULL);
+	assert (elem != NULL);
+	assert (ul->magic == MAGIC_INIT_VALUE);
+	assert (index <= ul->n_elems);
+
+	unrolled_list_node *node, *split;
+	size_t base, offset, keep;
+
+	if (ul->tail == NULL)
+	{
+		node = unrolled_list_node_new (ul, NULL);
+		base = 0;
+	}
+	else if (index == ul->n_elems)
+	{
+		node = ul->tail;
+		base = ul->n_elems - node->n_elems;
+	}
+	else
+	{
+		node = unrolled_list_locate (ul, index, &base);
+		if (index == base && node->prev != NULL
+		    && node->prev->n_elems < ul->node_capacity)
+		{
+			node = node->prev;
+			base -= node->n_elems;
+		}
+	}
+
+	offset = index - base;
+
+	if (node->n_elems == ul->node_capacity)
+	{
+		/* appends at the tail start a fresh node to keep nodes full */
+		keep = (node == ul->tail && offset == node->n_elems)
+		       ? node->n_elems : ul->split_at;
+
+		split = unrolled_list_node_new (ul, node);
+		memcpy (split->elems, GET_PTR_ELEM (ul, node, keep),
+		        (node->n_elems - keep) * ul->elem_sz);
+		split->n_elems = node->n_elems - keep;
+		node->n_elems = keep;
+
+		if (offset >= keep)
+		{
+			node = split;
+			base += keep;
+			offset -= keep;
+		}
+	}
+
+	memmove (GET_PTR_ELEM (ul, node, offset + 1), GET_PTR_ELEM (ul, node, offset),
+	         (node->n_elems - offset) * ul->elem_sz);
+	memcpy (GET_PTR_ELEM (ul, node, offset), elem, ul->elem_sz);
+
+	++node->n_elems;
+	++ul->n_elems;
+
+	ul->finger = node;
+	ul->finger_base = base;
+}
+
+/**
+ * Function: unrolled_list_append
+ * ------------------------------------------------------
+ * Appends an element to the end of the list.
+ *
+ * param ul   - initialized list
+ * param elem - a pointer to the new element data to append by copy
+ */
+void
+unrolled_list_append (unrolled_list *ul, const void *elem)
+{
+	assert (ul != NULL);
+	assert (ul->magic == MAGIC_INIT_VALUE);
+
+	unrolled_list_insert (ul, elem, ul->n_elems);
+}
+
+/**
+ * Function: unrolled_list_remove
+ * ------------------------------------------------------
+ * Removes an element at index, destroying it with the cleanup function, and
+ * shifts the rest of its node down.
+ *
+ * param ul    - initialized list
+ * param index - the index to remove at
+ */
+void
+unrolled_list_remove (unrolled_list *ul, size_t index)
+{
+	assert (ul != NULL);
+	assert (ul->magic == MAGIC_INIT_VALUE);
+	assert (index < ul->n_elems);
+
+	unrolled_list_node *node;
+	size_t base, offset;
+
+	node = unrolled_list_locate (ul, index, &base);
+	offset = index - base;
+
+	if (ul->elem_destroy)
+	{
+		ul->elem_destroy (GET_PTR_ELEM (ul, node, offset));
+	}
+
+	--node->n_elems;
+	--ul->n_elems;
+	memmove (GET_PTR_ELEM (ul, node, offset), GET_PTR_ELEM (ul, node, offset + 1),
+	         (node->n_elems - offset) * ul->elem_sz);
+
+	unrolled_list_rebalance (ul, node, base);
+}
+
+/**
+ * Function: unrolled_list_replace
+ * ------------------------------------------------------
+ * Replaces an element at index. The old element is destroyed.
+ *
+ * param ul    - initialized list
+ * param elem  - a pointer to the new element data to replace by copy
+ * param index - the index to replace
+ */
+void
+unrolled_list_replace (unrolled_list *ul, const void *elem, size_t index)
+{
+	assert (ul != NULL);
+	assert (elem != NULL);
+	assert (ul->magic == MAGIC_INIT_VALUE);
+	assert (index < ul->n_elems);
+	void *to_replace;
+
+	to_replace = unrolled_list_access (ul, index);
+	if (ul->elem_destroy)
+	{
+		ul->elem_destroy (to_replace);
+	}
+
+	memcpy (to_replace, elem, ul->elem_sz);
+}
+
+/**
+ * Function: unrolled_list_clear
+ * ------------------------------------------------------
+ * Destroys every element and frees every node. After calling this the list
+ * has 0 elements.
+ *
+ * param ul - initialized list
+ */
+void
+unrolled_list_clear (unrolled_list *ul)
+{
+	assert (ul != NULL);
+	assert (ul->magic == MAGIC_INIT_VALUE);
+
+	unrolled_list_node *node, *next;
+	size_t i;
+
+	for (node = ul->head; node != NULL; node = next)
+	{
+		next = node->next;
+		if (ul->elem_destroy)
+		{
+			for (i = 0; i < node->n_elems; i++)
+			{
+				ul->elem_destroy (GET_PTR_ELEM (ul, node, i));
+			}
+		}
+		free (node);
+	}
+
+	ul->head = ul->tail = ul->finger = NULL;
+	ul->finger_base = 0;
+	ul->n_elems = 0;
+}
@@ -3,15 +3,199 @@
  * Author: Seth Charles
  * ----------------------
  */
+#ifdef __linux__
+#define _GNU_SOURCE /* mremap */
+#endif
 #include "Vector.h"
+#include "ADT_stream.h"
 #include <assert.h>
 #include <string.h>
 #include <stdio.h>
 #include <search.h>
 
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define VECTOR_MAP_STORAGE
+#endif
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #define DEFAULT_CAPACITY       (16UL)
 #define GET_PTR_ELEM(V, INDEX) ((char *)(V->elems) + ((INDEX) * (V->elem_sz)))
 #define MAGIC_INIT_VALUE       (0x739caf14a2d9e85f)
+#define MAP_THRESHOLD          ((size_t)64 << 20) /* bytes */
+#define SKEW_RATIO             (32)
+#define INSERTION_THRESHOLD    (16)
+#define TOP_K_HEAP_RATIO       (64)
+#define MIN_MERGE              (64)
+#define MAX_RUNS               (85)
+
+/* what the sorted set operations emit */
+#define SORTED_KEEP_A          (1)   /* elements only in a */
+#define SORTED_KEEP_B          (2)   /* elements only in b */
+#define SORTED_KEEP_COMMON     (4)   /* elements in both, taken once from a */
+#define SORTED_MERGE           (8)   /* equal elements are kept apart, a's first */
+
+#define FILE_MAGIC             (0x3130434556544441ULL) /* "ADTVEC01" */
+#define FILE_VERSION           (1)
+#define FILE_HEADER_SZ         (64)
+#define FILE_HEADER(V)         ((vector_file_header *)((char *)(V)->elems - FILE_HEADER_SZ))
+#define STREAM_MAGIC           (0x4d52545356544441ULL) /* "ADTVSTRM" */
+
+/**
+ * Struct: vector_file_header
+ * ----------------------------------
+ * The first FILE_HEADER_SZ bytes of a file mapped by vector_map_file. The
+ * elements follow, so they start at a 64 byte aligned address. Fields are in
+ * the byte order of the machine that wrote the file.
+ *
+ * field magic   - FILE_MAGIC
+ * field version - FILE_VERSION
+ * field elem_sz - the size of the elements in bytes
+ * field n_elems - the number of elements stored, as of the last sync
+ */
+typedef struct
+{
+	uint64_t magic;
+	uint32_t version;
+	uint32_t elem_sz;
+	uint64_t n_elems;
+	uint8_t reserved[FILE_HEADER_SZ - 24];
+} vector_file_header;
+
+#ifdef VECTOR_MAP_STORAGE
+/**
+ * Function: vector_map_len
+ * ------------------------------------------------------
+ * Rounds a byte count up to whole pages, the unit mappings are sized in.
+ */
+static size_t
+vector_map_len (size_t bytes)
+{
+	size_t page = (size_t)sysconf (_SC_PAGESIZE);
+
+	return (bytes + page - 1) / page * page;
+}
+
+/**
+ * Function: vector_advise
+ * ------------------------------------------------------
+ * Asks for transparent huge pages over mapped storage if the vector wants
+ * them. Only the 2 MB aligned stretches of the mapping can be backed by huge
+ * pages, which on a mapping this large is nearly all of it.
+ */
+static void
+vector_advise (vector *v)
+{
+#ifdef MADV_HUGEPAGE
+	if (v->huge_pages)
+	{
+		madvise (v->elems, vector_map_len (v->capacity * v->elem_sz), MADV_HUGEPAGE);
+	}
+#endif
+}
+#endif
+
+/**
+ * Function: vector_set_capacity
+ * ------------------------------------------------------
+ * Module function that resizes the storage of a vector. Every growth goes
+ * through here. Heap storage is reallocated until it reaches MAP_THRESHOLD
+ * bytes; it is then moved, once, into an anonymous mapping of its own. From
+ * then on growth is an mremap, which moves the pages to a larger range of
+ * addresses instead of copying their contents, so growing a vector of many
+ * gigabytes costs page table updates rather than a copy.
+ *
+ * A file backed vector grows its file and remaps it. A vector in a buffer
+ * of the caller's moves to the heap.
+ *
+ * Mapped storage is sized in whole pages, so the capacity is rounded up to
+ * what the pages hold.
+ *
+ * param v            - the vector to resize
+ * param new_capacity - the number of elements the storage must hold
+ */
+static void
+vector_set_capacity (vector *v, size_t new_capacity)
+{
+	size_t bytes = new_capacity * v->elem_sz;
+	void *larger;
+
+	/* leave the caller's buffer: allocate as for an empty vector, then copy */
+	if (v->storage == VECTOR_STORAGE_BUFFER)
+	{
+		void *buf = v->elems;
+		size_t n_elems = v->n_elems;
+
+		v->elems = NULL;
+		v->n_elems = 0;
+		v->storage = VECTOR_STORAGE_HEAP;
+		vector_set_capacity (v, new_capacity);
+
+		memcpy (v->elems, buf, n_elems * v->elem_sz);
+		v->n_elems = n_elems;
+		return;
+	}
+
+#ifdef VECTOR_MAP_STORAGE
+	if (v->storage == VECTOR_STORAGE_FILE)
+	{
+		int grown;
+
+		/* the file grows first so the remapped range is backed */
+		bytes = vector_map_len (FILE_HEADER_SZ + bytes);
+		grown = ftruncate (v->fd, (off_t)bytes);
+		assert (grown == 0);
+		(void)grown;
+		larger = mremap (FILE_HEADER (v), vector_map_len (FILE_HEADER_SZ + v->capacity * v->elem_sz),
+		                 bytes, MREMAP_MAYMOVE);
+		assert (larger != MAP_FAILED);
+
+		v->elems = (char *)larger + FILE_HEADER_SZ;
+		v->capacity = (bytes - FILE_HEADER_SZ) / v->elem_sz;
+		return;
+	}
+
+	if (bytes >= MAP_THRESHOLD || v->storage == VECTOR_STORAGE_MAPPED)
+	{
+		bytes = vector_map_len (bytes);
+		if (v->storage == VECTOR_STORAGE_MAPPED)
+		{
+			larger = mremap (v->elems, vector_map_len (v->capacity * v->elem_sz),
+			                 bytes, MREMAP_MAYMOVE);
+			assert (larger != MAP_FAILED);
+		}
+		else
+		{
+			larger = mmap (NULL, bytes, PROT_READ | PROT_WRITE,
+			               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			assert (larger != MAP_FAILED);
+			if (v->elems != NULL)
+			{
+				memcpy (larger, v->elems, v->n_elems * v->elem_sz);
+				free (v->elems);
+			}
+			v->storage = VECTOR_STORAGE_MAPPED;
+		}
+
+		v->elems = larger;
+		v->capacity = bytes / v->elem_sz;
+		vector_advise (v);
+		return;
+	}
+#endif
+
+	larger = realloc (v->elems, bytes);
+	assert (larger != NULL);
+
+	v->capacity = new_capacity;
+	v->elems = larger;
+}
 
 /**
  * Function: vector_double_capacity
@@ -23,14 +207,185 @@
 static void
 vector_double_capacity (vector *v)
 {
-	void *larger;
-	size_t new_capacity =  v->capacity * 2;
+	vector_set_capacity (v, v->capacity * 2);
+}
 
-	larger = realloc (v->elems, new_capacity * v->elem_sz);
-	assert (larger != NULL);
+/**
+ * Function: vector_reserve
+ * ------------------------------------------------------
+ * Public function to grow the capacity, by doubling, until n more elements
+ * fit. Growth goes through vector_set_capacity, so a large vector moves to
+ * mapped storage as it would growing one append at a time.
+ *
+ * param v - initialized vector
+ * param n - the number of elements to make room for past the last one
+ */
+void
+vector_reserve (vector *v, size_t n)
+{
+	assert (v != NULL);
+	assert (v->magic == MAGIC_INIT_VALUE);
+	assert (!v->read_only);
+	vector_unshare (v);
+	size_t new_capacity = (v->capacity > 0) ? v->capacity : 1;
 
-	v->capacity = new_capacity;
-	v->elems = larger;
+	while (new_capacity < v->n_elems + n)
+	{
+		new_capacity *= 2;
+	}
+
+	if (new_capacity != v->capacity)
+	{
+		vector_set_capacity (v, new_capacity);
+	}
+}
+
+/**
+ * Function: vector_free_elems
+ * ------------------------------------------------------
+ * Releases the array of elements by whatever means it was allocated. A
+ * buffer of the caller's is left alone.
+ */
+static void
+vector_free_elems (vector *v)
+{
+#ifdef VECTOR_MAP_STORAGE
+	if (v->storage == VECTOR_STORAGE_MAPPED)
+	{
+		munmap (v->elems, vector_map_len (v->capacity * v->elem_sz));
+	}
+#endif
+	if (v->storage == VECTOR_STORAGE_HEAP)
+	{
+		free (v->elems);
+	}
+}
+
+/**
+ * Function: vector_leave_share
+ * ------------------------------------------------------
+ * Gives a vector sharing its array with clones an array of its own, of the
+ * same capacity, and drops its reference to the shared one, freeing it if
+ * the other sharers let go meanwhile. The elements are copied across only
+ * when keep is set. A vector left as the only sharer just takes the array
+ * back.
+ */
+static void
+vector_leave_share (vector *v, bool keep)
+{
+	vector shared;
+
+	if (v->share == NULL)
+	{
+		return;
+	}
+
+	/* acquire pairs with the release of the sharers that let go */
+	if (atomic_load_explicit (&v->share->refs, memory_order_acquire) == 1)
+	{
+		free (v->share);
+		v->share = NULL;
+		return;
+	}
+
+	shared = *v;
+	v->elems = NULL;
+	v->capacity = 0;
+	v->n_elems = 0;
+	v->storage = VECTOR_STORAGE_HEAP;
+	v->share = NULL;
+	vector_set_capacity (v, shared.capacity);
+
+	if (keep)
+	{
+		memcpy (v->elems, shared.elems, shared.n_elems * shared.elem_sz);
+		v->n_elems = shared.n_elems;
+	}
+
+	if (atomic_fetch_sub_explicit (&shared.share->refs, 1, memory_order_acq_rel) == 1)
+	{
+		vector_free_elems (&shared);
+		free (shared.share);
+	}
+}
+
+/**
+ * Function: vector_unshare
+ * ------------------------------------------------------
+ * Called before every change to the elements, so that a vector sharing its
+ * array with clones changes a private copy.
+ */
+void
+vector_unshare (vector *v)
+{
+	vector_leave_share (v, true);
+}
+
+/**
+ * Function: vector_init_static
+ * ------------------------------------------------------
+ * Public function to perform vector initialization in caller owned space
+ *
+ * param v             - the space for the vector object
+ * param elem_sz       - the size of elements in bytes that are stored
+ * param capacity_hint - a capacity suggestion for initialization
+ * param fn            - the cleanup function to call when an element is destroyed
+ */
+void
+vector_init_static (vector *v, size_t elem_sz, size_t capacity_hint, elem_destroy_fn fn)
+{
+	assert (v != NULL);
+	assert (elem_sz > 0);
+
+	v->elems = NULL;
+	v->capacity = 0;
+	v->elem_sz = elem_sz;
+	v->n_elems = 0;
+	v->storage = VECTOR_STORAGE_HEAP;
+	v->huge_pages = false;
+	v->read_only = false;
+	v->alloc_static = true;
+	v->fd = -1;
+	v->share = NULL;
+	v->elem_destroy = fn;
+	v->magic = MAGIC_INIT_VALUE;
+
+	/* allocate space for the elements in the vector */
+	vector_set_capacity (v, (capacity_hint == 0) ? DEFAULT_CAPACITY : capacity_hint);
+}
+
+/**
+ * Function: vector_init_buffer
+ * ------------------------------------------------------
+ * Public function to perform vector initialization over a caller owned
+ * buffer. Nothing is allocated until the buffer is outgrown.
+ *
+ * param v       - the space for the vector object
+ * param elem_sz - the size of elements in bytes that are stored
+ * param buf     - the space for the first elements
+ * param buf_sz  - the size of buf in bytes
+ * param fn      - the cleanup function to call when an element is destroyed
+ */
+void
+vector_init_buffer (vector *v, size_t elem_sz, void *buf, size_t buf_sz, elem_destroy_fn fn)
+{
+	assert (v != NULL);
+	assert (buf != NULL);
+	assert (elem_sz > 0);
+	assert (buf_sz >= elem_sz);
+
+	v->elems = buf;
+	v->capacity = buf_sz / elem_sz;
+	v->elem_sz = elem_sz;
+	v->n_elems = 0;
+	v->storage = VECTOR_STORAGE_BUFFER;
+	v->huge_pages = false;
+	v->read_only = false;
+	v->alloc_static = true;
+	v->fd = -1;
+	v->share = NULL;
+	v->elem_destroy = fn;
+	v->magic = MAGIC_INIT_VALUE;
 }
 
 /**
@@ -53,24 +408,62 @@ vector_init (size_t elem_sz, size_t capacity_hint, elem_destroy_fn fn)
 	v = (vector *)malloc (sizeof (vector));
 	assert (v != NULL);
 
-	/* allocate space for the elements in the vector */
-	v->capacity = (capacity_hint == 0) ? DEFAULT_CAPACITY : capacity_hint;
-	v->elems = malloc (v->capacity * elem_sz);
-	assert (v->elems != NULL);
-	
-	v->elem_sz = elem_sz;
-	v->n_elems = 0;
-	v->elem_destroy = fn;
-	v->magic = MAGIC_INIT_VALUE;
+	vector_init_static (v, elem_sz, capacity_hint, fn);
+	v->alloc_static = false;
 
 	return v;
 }
 
+/**
+ * Function: vector_clone_cow
+ * ------------------------------------------------------
+ * Creates a vector that shares v's array of elements. The first vector to
+ * change the shared array copies it, in vector_unshare, so a clone costs a
+ * vector object and, the first time v is cloned, its reference count.
+ *
+ * param v - initialized vector whose elements own nothing
+ *
+ * returns - a pointer to the new vector object
+ */
+vector *
+vector_clone_cow (vector *v)
+{
+	assert (v != NULL);
+	assert (v->magic == MAGIC_INIT_VALUE);
+	assert (v->elem_destroy == NULL);
+	vector *clone;
+
+	/* a buffer of the caller's or a file mapping is not ours to share */
+	if (v->storage == VECTOR_STORAGE_BUFFER || v->storage == VECTOR_STORAGE_FILE)
+	{
+		clone = vector_init (v->elem_sz, v->n_elems, NULL);
+		memcpy (clone->elems, v->elems, v->n_elems * v->elem_sz);
+		clone->n_elems = v->n_elems;
+		return clone;
+	}
+
+	if (v->share == NULL)
+	{
+		v->share = malloc (sizeof (vector_share));
+		assert (v->share != NULL);
+		atomic_init (&v->share->refs, 1);
+	}
+	atomic_fetch_add_explicit (&v->share->refs, 1, memory_order_relaxed);
+
+	clone = malloc (sizeof (vector));
+	assert (clone != NULL);
+	*clone = *v;
+	clone->alloc_static = false;
+
+	return clone;
+}
+
 /**
  * Function: vector_destroy
  * ------------------------------------------------------
  * Destroys the vector and deallocates all the memory used for the vector. Also
- * calls the provided element destroy function on individual elements.
+ * calls the provided element destroy function on individual elements. The
+ * vector object and a buffer of the caller's are not freed.
  *
  * param v - the vector to destroy
  */
@@ -80,9 +473,39 @@ vector_destroy (vector *v)
 	assert (v != NULL);
 	assert (v->magic == MAGIC_INIT_VALUE);
 
+#ifdef VECTOR_MAP_STORAGE
+	/* elements in a file own nothing, and stay in the file */
+	if (v->storage == VECTOR_STORAGE_FILE)
+	{
+		if (!v->read_only)
+		{
+			FILE_HEADER (v)->n_elems = v->n_elems;
+		}
+		munmap (FILE_HEADER (v), vector_map_len (FILE_HEADER_SZ + v->capacity * v->elem_sz));
+		close (v->fd);
+		free (v);
+		return;
+	}
+#endif
+
+	/* a shared array belongs to the last vector to let go of it */
+	if (v->share != NULL && atomic_fetch_sub_explicit (&v->share->refs, 1, memory_order_acq_rel) != 1)
+	{
+		if (!v->alloc_static)
+		{
+			free (v);
+		}
+		return;
+	}
+	free (v->share);
+	v->share = NULL;
+
 	vector_clear (v);
-	free (v->elems);
-	free (v);
+	vector_free_elems (v);
+	if (!v->alloc_static)
+	{
+		free (v);
+	}
 }
 
 /**
@@ -142,6 +565,8 @@ vector_insert (vector *v, const void *elem, int index)
 	assert (v != NULL);
 	assert (elem != NULL);
 	assert (v->magic == MAGIC_INIT_VALUE);
+	assert (!v->read_only);
+	vector_unshare (v);
 	assert (index <= v->n_elems);
 
 	void *insert_at, *next;
@@ -176,6 +601,8 @@ vector_remove (vector *v, int index)
 {
 	assert (v != NULL);
 	assert (v->magic == MAGIC_INIT_VALUE);
+	assert (!v->read_only);
+	vector_unshare (v);
 	assert (index < v->n_elems);
 
 	void *remove_at, *next;
@@ -206,6 +633,8 @@ vector_append (vector *v, const void *elem)
 	assert (v != NULL);
 	assert (elem != NULL);
 	assert (v->magic == MAGIC_INIT_VALUE);
+	assert (!v->read_only);
+	vector_unshare (v);
 	void *next_elem;
 
 	if (v->capacity <= v->n_elems)
@@ -234,6 +663,8 @@ vector_replace (vector *v, const void *elem, int index)
 	assert (v != NULL);
 	assert (elem != NULL);
 	assert (v->magic == MAGIC_INIT_VALUE);
+	assert (!v->read_only);
+	vector_unshare (v);
 	assert (index < v->n_elems);
 	void *to_replace;
 
@@ -260,8 +691,11 @@ vector_clear (vector *v)
 {
 	assert (v != NULL);
 	assert (v->magic == MAGIC_INIT_VALUE);
+	assert (!v->read_only);
 	size_t i;
 
+	/* a clone's elements stay with the other sharers, so none are copied */
+	vector_leave_share (v, false);
 	if (v->elem_destroy)
 	{
 		for (i = 0; i < v->n_elems; i++)
@@ -270,60 +704,1523 @@ vector_clear (vector *v)
 		}
 	}
 
+#ifdef VECTOR_MAP_STORAGE
+	/* hand the pages back; the range stays reserved and refaults as zeros */
+	if (v->storage == VECTOR_STORAGE_MAPPED)
+	{
+		madvise (v->elems, vector_map_len (v->capacity * v->elem_sz), MADV_DONTNEED);
+	}
+#endif
+
 	v->n_elems = 0;
 }
 
 /**
- * Function: vector_search
+ * Function: vector_set_huge_pages
  * ------------------------------------------------------
- * Searches the vector for an element matching the key utilizing the provided
- * compare function. The sorted flag controls whether to use a binary search on
- * an already sorted vector verses a linear search on an unsorted vector.
- *
- * param v      - initialized vector
- * param key    - a pointer to the data to find in the vector
- * param fn     - a compare function for searching
- * param sorted - a flag provided to signal whether the vector is sorted
+ * Records whether mapped storage should be advised to use huge pages, and
+ * applies the advice now if the storage is already mapped.
  *
- * returns - a pointer to the matching vector element or NULL if it doesn't 
- *           contain the key
+ * param v       - initialized vector
+ * param enabled - whether to ask for huge pages
  */
-void *
-vector_search (const vector *v, const void *key, compare_fn fn, bool sorted)
+void
+vector_set_huge_pages (vector *v, bool enabled)
 {
 	assert (v != NULL);
-	assert (key != NULL);
 	assert (v->magic == MAGIC_INIT_VALUE);
-	void *ptr;
 
-	size_t n_elems = v->n_elems;
-
-	if (sorted) /* binary search */
-	{
-		ptr = bsearch (key, v->elems, v->n_elems, v->elem_sz, fn);
-	}
-	else /* linear search */
+	v->huge_pages = enabled;
+#ifdef VECTOR_MAP_STORAGE
+	if (v->storage == VECTOR_STORAGE_MAPPED)
 	{
-		ptr = lfind (key, v->elems, &n_elems, v->elem_sz, fn);
+		vector_advise (v);
 	}
+#endif
+}
 
-	return ptr;
+/**
+ * Function: vector_is_mapped
+ * ------------------------------------------------------
+ * Reports whether the storage has moved into its own mapping.
+ */
+bool
+vector_is_mapped (const vector *v)
+{
+	assert (v != NULL);
+	assert (v->magic == MAGIC_INIT_VALUE);
+
+	return v->storage == VECTOR_STORAGE_MAPPED;
 }
 
 /**
- * Function: vector_sort
+ * Function: vector_map_file
  * ------------------------------------------------------
- * Sorts the provided vector according to the provided compare function. Uses
- * the quicksort algorithm.
+ * Opens a vector stored in a file. The whole file is mapped shared, so
+ * elements are read straight from the page cache with no copy at startup,
+ * and processes mapping the same file share its pages. A writable vector
+ * grows by extending the file and remapping it.
  *
- * param v  - initialized vector
- * param fn - the provided compare function for sorting
+ * param path    - the file to map
+ * param elem_sz - the size of the elements in bytes, which must match the
+ *                 file's
+ * param flags   - VECTOR_MAP_RDONLY or VECTOR_MAP_RDWR, the latter optionally
+ *                 with VECTOR_MAP_CREATE
+ *
+ * returns - a pointer to the vector object, or NULL if the file cannot be
+ *           opened or is not a vector file of elem_sz elements
  */
-void 
-vector_sort (vector *v, compare_fn fn)
+vector *
+vector_map_file (const char *path, size_t elem_sz, int flags)
 {
+	assert (path != NULL);
+	assert (elem_sz > 0);
+#ifdef VECTOR_MAP_STORAGE
+	bool writable = (flags & VECTOR_MAP_RDWR) != 0;
+	vector_file_header *hdr;
+	struct stat st;
+	size_t capacity, len;
+	vector *v;
+	int fd;
+
+	fd = open (path, writable ? (O_RDWR | ((flags & VECTOR_MAP_CREATE) ? O_CREAT : 0)) : O_RDONLY, 0644);
+	if (fd < 0 || fstat (fd, &st) != 0)
+	{
+		goto fail_open;
+	}
+
+	/* a new file gets a header and room for the default capacity */
+	if (st.st_size == 0 && writable && (flags & VECTOR_MAP_CREATE))
+	{
+		vector_file_header fresh = { FILE_MAGIC, FILE_VERSION, (uint32_t)elem_sz, 0, { 0 } };
+
+		st.st_size = (off_t)vector_map_len (FILE_HEADER_SZ + DEFAULT_CAPACITY * elem_sz);
+		if (ftruncate (fd, st.st_size) != 0 || pwrite (fd, &fresh, sizeof (fresh), 0) != sizeof (fresh))
+		{
+			goto fail_open;
+		}
+	}
+
+	if ((size_t)st.st_size < FILE_HEADER_SZ)
+	{
+		goto fail_open;
+	}
+
+	/* the mapped length must follow from the capacity alone, for remapping */
+	capacity = ((size_t)st.st_size - FILE_HEADER_SZ) / elem_sz;
+	len = vector_map_len (FILE_HEADER_SZ + capacity * elem_sz);
+	hdr = mmap (NULL, len, writable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fd, 0);
+	if (hdr == MAP_FAILED)
+	{
+		goto fail_open;
+	}
+
+	if (hdr->magic != FILE_MAGIC || hdr->version != FILE_VERSION ||
+	    hdr->elem_sz != elem_sz || hdr->n_elems > capacity)
+	{
+		munmap (hdr, len);
+		goto fail_open;
+	}
+
+	v = malloc (sizeof (vector));
 	assert (v != NULL);
-	assert (v->magic == MAGIC_INIT_VALUE);
 
-	qsort (v->elems, v->n_elems, v->elem_sz, fn);
-}
\ No newline at end of file
+	v->elems = (char *)hdr + FILE_HEADER_SZ;
+	v->capacity = capacity;
+	v->elem_sz = elem_sz;
+	v->n_elems = hdr->n_elems;
+	v->storage = VECTOR_STORAGE_FILE;
+	v->huge_pages = false;
+	v->read_only = !writable;
+	v->alloc_static = false;
+	v->fd = fd;
+	v->share = NULL;
+	v->elem_destroy = NULL;
+	v->magic = MAGIC_INIT_VALUE;
+
+	return v;
+
+fail_open:
+	if (fd >= 0)
+	{
+		close (fd);
+	}
+#endif
+	return NULL;
+}
+
+/**
+ * Function: vector_sync
+ * ------------------------------------------------------
+ * Records the element count in a mapped file's header and waits for the
+ * mapping to be written back to disk.
+ *
+ * param v - initialized vector
+ *
+ * returns - false if writing back failed, true otherwise, including for
+ *           vectors not backed by a file
+ */
+bool
+vector_sync (vector *v)
+{
+	assert (v != NULL);
+	assert (v->magic == MAGIC_INIT_VALUE);
+
+#ifdef VECTOR_MAP_STORAGE
+	if (v->storage == VECTOR_STORAGE_FILE && !v->read_only)
+	{
+		FILE_HEADER (v)->n_elems = v->n_elems;
+		return msync (FILE_HEADER (v), vector_map_len (FILE_HEADER_SZ + v->capacity * v->elem_sz),
+		              MS_SYNC) == 0;
+	}
+#endif
+
+	return true;
+}
+
+/**
+ * Function: vector_stream_chunk
+ * ------------------------------------------------------
+ * The number of bytes vector_write and vector_read move per call: about
+ * STREAM_CHUNK_SZ, and a multiple both of the element size and of the 32
+ * bytes the checksum consumes at a time.
+ */
+static size_t
+vector_stream_chunk (size_t elem_sz)
+{
+	size_t stripe = 32 * elem_sz;
+
+	return (STREAM_CHUNK_SZ > stripe) ? STREAM_CHUNK_SZ / stripe * stripe : stripe;
+}
+
+/**
+ * Function: vector_write
+ * ------------------------------------------------------
+ * Streams the vector to fd. The elements are checksummed and written a chunk
+ * at a time straight from the storage, so each chunk is still in cache when
+ * the kernel copies it out. The header goes out with the first chunk and the
+ * checksum with the last.
+ *
+ * param v  - initialized vector
+ * param fd - the file descriptor to write to
+ *
+ * returns - false on an I/O error
+ */
+bool
+vector_write (const vector *v, int fd)
+{
+	assert (v != NULL);
+	assert (v->magic == MAGIC_INIT_VALUE);
+
+	uint8_t header[STREAM_HEADER_SZ];
+	const char *data = v->elems;
+	size_t left = v->n_elems * v->elem_sz, chunk = vector_stream_chunk (v->elem_sz), len;
+	stream_checksum c;
+
+	stream_header_encode (header, STREAM_MAGIC, v->elem_sz, v->n_elems, &c);
+
+	do
+	{
+		len = (left > chunk) ? chunk : left;
+		if (!stream_write_chunk (fd, &c, (data == v->elems) ? header : NULL,
+		                         data, len, len == left))
+		{
+			return false;
+		}
+		data += len;
+		left -= len;
+	} while (left > 0);
+
+	return true;
+}
+
+/**
+ * Function: vector_read
+ * ------------------------------------------------------
+ * Reads a stream written by vector_write. The storage is sized from the
+ * header up to MAP_THRESHOLD and grows as chunks arrive beyond that, so a
+ * corrupt count fails at the end of the data rather than in the allocator.
+ * Chunks hold whole elements, so the count only ever covers complete ones.
+ *
+ * param fd - the file descriptor to read from
+ *
+ * returns - a pointer to the vector object, or NULL if the stream is
+ *           unreadable, of another kind or version, or fails its checksum
+ */
+vector *
+vector_read (int fd)
+{
+	size_t elem_sz, n_elems, chunk, left, len;
+	stream_checksum c;
+	vector *v;
+
+	if (!stream_read_header (fd, STREAM_MAGIC, &elem_sz, &n_elems, &c) ||
+	    n_elems > SIZE_MAX / elem_sz)
+	{
+		return NULL;
+	}
+
+	chunk = vector_stream_chunk (elem_sz) / elem_sz;
+	left = n_elems;
+	v = vector_init (elem_sz, (n_elems < MAP_THRESHOLD / elem_sz) ? n_elems : MAP_THRESHOLD / elem_sz, NULL);
+
+	do
+	{
+		len = (left > chunk) ? chunk : left;
+		vector_reserve (v, len);
+		if (!stream_read_chunk (fd, &c, GET_PTR_ELEM (v, v->n_elems), len * elem_sz, len == left))
+		{
+			vector_destroy (v);
+			return NULL;
+		}
+		v->n_elems += len;
+		left -= len;
+	} while (left > 0);
+
+	return v;
+}
+
+/**
+ * Function: vector_search
+ * ------------------------------------------------------
+ * Searches the vector for an element matching the key utilizing the provided
+ * compare function. The sorted flag controls whether to use a binary search on
+ * an already sorted vector verses a linear search on an unsorted vector.
+ *
+ * param v      - initialized vector
+ * param key    - a pointer to the data to find in the vector
+ * param fn     - a compare function for searching
+ * param sorted - a flag provided to signal whether the vector is sorted
+ *
+ * returns - a pointer to the matching vector element or NULL if it doesn't 
+ *           contain the key
+ */
+void *
+vector_search (const vector *v, const void *key, compare_fn fn, bool sorted)
+{
+	assert (v != NULL);
+	assert (key != NULL);
+	assert (v->magic == MAGIC_INIT_VALUE);
+	void *ptr;
+
+	size_t n_elems = v->n_elems;
+
+	if (sorted) /* binary search */
+	{
+		ptr = bsearch (key, v->elems, v->n_elems, v->elem_sz, fn);
+	}
+	else /* linear search */
+	{
+		ptr = lfind (key, v->elems, &n_elems, v->elem_sz, fn);
+	}
+
+	return ptr;
+}
+
+/**
+ * Function: vector_sort
+ * ------------------------------------------------------
+ * Sorts the provided vector according to the provided compare function. Uses
+ * the quicksort algorithm.
+ *
+ * param v  - initialized vector
+ * param fn - the provided compare function for sorting
+ */
+void 
+vector_sort (vector *v, compare_fn fn)
+{
+	assert (v != NULL);
+	assert (v->magic == MAGIC_INIT_VALUE);
+	assert (!v->read_only);
+	vector_unshare (v);
+
+	qsort (v->elems, v->n_elems, v->elem_sz, fn);
+}
+
+/**
+ * Function: vector_swap
+ * ------------------------------------------------------
+ * Swaps two elements through a scratch element.
+ */
+static void
+vector_swap (char *x, char *y, size_t elem_sz, char *tmp)
+{
+	memcpy (tmp, x, elem_sz);
+	memcpy (x, y, elem_sz);
+	memcpy (y, tmp, elem_sz);
+}
+
+/**
+ * Function: vector_insertion_sort
+ * ------------------------------------------------------
+ * Sorts elements lo up to hi of a flat array. Used for the short ranges
+ * selection narrows down to, where it beats partitioning.
+ */
+static void
+vector_insertion_sort (char *base, size_t elem_sz, size_t lo, size_t hi,
+                       compare_fn fn, char *tmp)
+{
+	size_t i, j;
+
+	for (i = lo + 1; i < hi; i++)
+	{
+		if (fn (base + (i - 1) * elem_sz, base + i * elem_sz) <= 0)
+		{
+			continue;
+		}
+
+		memcpy (tmp, base + i * elem_sz, elem_sz);
+		for (j = i; j > lo && fn (base + (j - 1) * elem_sz, tmp) > 0; j--)
+		{
+			memcpy (base + j * elem_sz, base + (j - 1) * elem_sz, elem_sz);
+		}
+		memcpy (base + j * elem_sz, tmp, elem_sz);
+	}
+}
+
+/**
+ * Function: vector_partition
+ * ------------------------------------------------------
+ * Partitions elements lo up to hi around the element at index pivot. Both
+ * scans stop on elements equal to the pivot, so runs of duplicates are split
+ * evenly rather than piling up on one side.
+ *
+ * returns - the final index of the pivot
+ */
+static size_t
+vector_partition (char *base, size_t elem_sz, size_t lo, size_t hi,
+                  size_t pivot, compare_fn fn, char *tmp)
+{
+	size_t i = lo + 1, j = hi - 1;
+	char *p = base + lo * elem_sz;
+
+	vector_swap (p, base + pivot * elem_sz, elem_sz, tmp);
+
+	for (;;)
+	{
+		while (i <= j && fn (base + i * elem_sz, p) < 0)
+		{
+			i++;
+		}
+		while (i <= j && fn (base + j * elem_sz, p) > 0)
+		{
+			j--;
+		}
+		if (i >= j)
+		{
+			break;
+		}
+		vector_swap (base + i * elem_sz, base + j * elem_sz, elem_sz, tmp);
+		i++;
+		j--;
+	}
+
+	vector_swap (p, base + j * elem_sz, elem_sz, tmp);
+	return j;
+}
+
+static void vector_select (char *base, size_t elem_sz, size_t lo, size_t hi,
+                           size_t nth, compare_fn fn, char *tmp);
+
+/**
+ * Function: vector_median_of_medians
+ * ------------------------------------------------------
+ * Sorts each group of five among elements lo up to hi, gathers the group
+ * medians at the front of the range and selects their median. That pivot has
+ * at least 3/10 of the range on each side, which bounds selection to linear
+ * time however the input is ordered.
+ *
+ * returns - the index of the pivot
+ */
+static size_t
+vector_median_of_medians (char *base, size_t elem_sz, size_t lo, size_t hi,
+                          compare_fn fn, char *tmp)
+{
+	size_t group, n_groups = 0, end;
+
+	for (group = lo; group < hi; group += 5)
+	{
+		end = (group + 5 < hi) ? group + 5 : hi;
+		vector_insertion_sort (base, elem_sz, group, end, fn, tmp);
+		vector_swap (base + (lo + n_groups) * elem_sz,
+		             base + (group + (end - group) / 2) * elem_sz, elem_sz, tmp);
+		n_groups++;
+	}
+
+	vector_select (base, elem_sz, lo, lo + n_groups, lo + n_groups / 2, fn, tmp);
+	return lo + n_groups / 2;
+}
+
+/**
+ * Function: vector_select
+ * ------------------------------------------------------
+ * Introselect over elements lo up to hi: quickselect with a median of three
+ * pivot, narrowing to the side that holds nth. Each step is charged against a
+ * budget of twice log2 of the range; once it is spent every further pivot
+ * comes from median of medians.
+ */
+static void
+vector_select (char *base, size_t elem_sz, size_t lo, size_t hi, size_t nth,
+               compare_fn fn, char *tmp)
+{
+	size_t budget = 0, n, mid, pivot;
+
+	for (n = hi - lo; n > 1; n >>= 1)
+	{
+		budget += 2;
+	}
+
+	while (hi - lo > INSERTION_THRESHOLD)
+	{
+		if (budget == 0)
+		{
+			pivot = vector_median_of_medians (base, elem_sz, lo, hi, fn, tmp);
+		}
+		else
+		{
+			budget--;
+			mid = lo + (hi - lo) / 2;
+			/* order lo, mid and hi - 1 so mid holds their median */
+			if (fn (base + mid * elem_sz, base + lo * elem_sz) < 0)
+			{
+				vector_swap (base + mid * elem_sz, base + lo * elem_sz, elem_sz, tmp);
+			}
+			if (fn (base + (hi - 1) * elem_sz, base + mid * elem_sz) < 0)
+			{
+				vector_swap (base + (hi - 1) * elem_sz, base + mid * elem_sz, elem_sz, tmp);
+				if (fn (base + mid * elem_sz, base + lo * elem_sz) < 0)
+				{
+					vector_swap (base + mid * elem_sz, base + lo * elem_sz, elem_sz, tmp);
+				}
+			}
+			pivot = mid;
+		}
+
+		pivot = vector_partition (base, elem_sz, lo, hi, pivot, fn, tmp);
+		if (nth == pivot)
+		{
+			return;
+		}
+		if (nth < pivot)
+		{
+			hi = pivot;
+		}
+		else
+		{
+			lo = pivot + 1;
+		}
+	}
+
+	vector_insertion_sort (base, elem_sz, lo, hi, fn, tmp);
+}
+
+/**
+ * Function: vector_heap_sift_down
+ * ------------------------------------------------------
+ * Restores a binary max heap of n elements below index i, the largest under
+ * fn at the root.
+ */
+static void
+vector_heap_sift_down (char *heap, size_t elem_sz, size_t i, size_t n,
+                       compare_fn fn, char *tmp)
+{
+	size_t child;
+
+	memcpy (tmp, heap + i * elem_sz, elem_sz);
+	while ((child = 2 * i + 1) < n)
+	{
+		if (child + 1 < n && fn (heap + (child + 1) * elem_sz, heap + child * elem_sz) > 0)
+		{
+			child++;
+		}
+		if (fn (heap + child * elem_sz, tmp) <= 0)
+		{
+			break;
+		}
+		memcpy (heap + i * elem_sz, heap + child * elem_sz, elem_sz);
+		i = child;
+	}
+	memcpy (heap + i * elem_sz, tmp, elem_sz);
+}
+
+/**
+ * Function: vector_nth_element
+ * ------------------------------------------------------
+ * Places the element that sorts to index n there, smaller ones before it and
+ * larger ones after.
+ *
+ * param v  - initialized vector
+ * param n  - the index to select
+ * param fn - the compare function for ordering
+ */
+void
+vector_nth_element (vector *v, size_t n, compare_fn fn)
+{
+	assert (v != NULL);
+	assert (fn != NULL);
+	assert (v->magic == MAGIC_INIT_VALUE);
+	assert (!v->read_only);
+	vector_unshare (v);
+	assert (n < v->n_elems);
+	char *tmp;
+
+	tmp = malloc (v->elem_sz);
+	assert (tmp != NULL);
+
+	vector_select (v->elems, v->elem_sz, 0, v->n_elems, n, fn, tmp);
+
+	free (tmp);
+}
+
+/**
+ * Function: vector_partial_sort
+ * ------------------------------------------------------
+ * Selects the k smallest elements into the front of the vector, then sorts
+ * just those.
+ *
+ * param v  - initialized vector
+ * param k  - the number of elements to sort into place
+ * param fn - the compare function for ordering
+ */
+void
+vector_partial_sort (vector *v, size_t k, compare_fn fn)
+{
+	assert (v != NULL);
+	assert (fn != NULL);
+	assert (v->magic == MAGIC_INIT_VALUE);
+	assert (!v->read_only);
+	vector_unshare (v);
+	assert (k <= v->n_elems);
+
+	if (k == 0)
+	{
+		return;
+	}
+
+	if (k == v->n_elems)
+	{
+		qsort (v->elems, k, v->elem_sz, fn);
+		return;
+	}
+
+	/* the element at k - 1 is already in its sorted place */
+	vector_nth_element (v, k - 1, fn);
+	qsort (v->elems, k - 1, v->elem_sz, fn);
+}
+
+/**
+ * Function: vector_top_k
+ * ------------------------------------------------------
+ * Appends the k elements that sort first to out. For k at most a
+ * TOP_K_HEAP_RATIO fraction of the size, keeps them in a max heap at the end
+ * of out while scanning v: an element that sorts before the heap's largest
+ * replaces it. On random input only O(k log (size / k)) elements get that
+ * far, so the scan costs little more than one compare per element. For
+ * larger k the whole vector is copied into out and selected there.
+ *
+ * param v   - initialized vector, left unchanged
+ * param k   - the number of elements wanted
+ * param fn  - the compare function for ordering
+ * param out - initialized vector receiving the elements
+ *
+ * returns - the number of elements appended
+ */
+size_t
+vector_top_k (const vector *v, size_t k, compare_fn fn, vector *out)
+{
+	assert (v != NULL && out != NULL);
+	assert (fn != NULL);
+	assert (v->magic == MAGIC_INIT_VALUE && out->magic == MAGIC_INIT_VALUE);
+	assert (!out->read_only);
+	vector_unshare (out);
+	assert (v != out);
+	assert (v->elem_sz == out->elem_sz);
+	size_t n = v->n_elems, sz = v->elem_sz, i;
+	const char *src = v->elems;
+	char *dst, *tmp;
+
+	if (k > n)
+	{
+		k = n;
+	}
+	if (k == 0)
+	{
+		return 0;
+	}
+
+	tmp = malloc (sz);
+	assert (tmp != NULL);
+
+	if (k <= n / TOP_K_HEAP_RATIO)
+	{
+		vector_reserve (out, k);
+		dst = GET_PTR_ELEM (out, out->n_elems);
+		memcpy (dst, src, k * sz);
+		for (i = k / 2; i-- > 0; )
+		{
+			vector_heap_sift_down (dst, sz, i, k, fn, tmp);
+		}
+
+		for (i = k; i < n; i++)
+		{
+			if (fn (src + i * sz, dst) < 0)
+			{
+				memcpy (dst, src + i * sz, sz);
+				vector_heap_sift_down (dst, sz, 0, k, fn, tmp);
+			}
+		}
+	}
+	else
+	{
+		vector_reserve (out, n);
+		dst = GET_PTR_ELEM (out, out->n_elems);
+		memcpy (dst, src, n * sz);
+		if (k < n)
+		{
+			vector_select (dst, sz, 0, n, k - 1, fn, tmp);
+		}
+	}
+	qsort (dst, k, sz, fn);
+
+	free (tmp);
+	out->n_elems += k;
+	return k;
+}
+
+/**
+ * Function: vector_compare_u32
+ * ------------------------------------------------------
+ * Compares two unsigned 32 bit integers. Also marks a vector as holding them
+ * for the integer kernels below.
+ */
+int
+vector_compare_u32 (const void *elem1, const void *elem2)
+{
+	const uint32_t *ptr1 = elem1;
+	const uint32_t *ptr2 = elem2;
+
+	return (*ptr1 > *ptr2) - (*ptr1 < *ptr2);
+}
+
+/**
+ * Function: vector_compare_u64
+ * ------------------------------------------------------
+ * Compares two unsigned 64 bit integers.
+ */
+int
+vector_compare_u64 (const void *elem1, const void *elem2)
+{
+	const uint64_t *ptr1 = elem1;
+	const uint64_t *ptr2 = elem2;
+
+	return (*ptr1 > *ptr2) - (*ptr1 < *ptr2);
+}
+
+/**
+ * Integer kernels
+ * ------------------------------------------------------
+ * Typed versions of vector_unique and of the linear walk behind the sorted
+ * set operations, instantiated for uint32_t and uint64_t. They compare the
+ * integers in registers and advance both inputs without branching on the
+ * data, which random ids would mispredict half the time.
+ */
+#define DEFINE_INTEGER_KERNELS(T, SUFFIX)                                      \
+static size_t                                                                  \
+vector_unique_##SUFFIX (T *e, size_t n)                                        \
+{                                                                              \
+	size_t r, w = 0;                                                           \
+	T x;                                                                       \
+                                                                               \
+	for (r = 1; r < n; r++)                                                    \
+	{                                                                          \
+		x = e[r];                                                              \
+		e[w + 1] = x;                                                          \
+		w += (x != e[w]);                                                      \
+	}                                                                          \
+                                                                               \
+	return (n > 0) ? w + 1 : 0;                                                \
+}                                                                              \
+                                                                               \
+static T *                                                                     \
+vector_merge_##SUFFIX (T *dst, const T *a, size_t na, const T *b, size_t nb)   \
+{                                                                              \
+	size_t i = 0, j = 0, take_a;                                               \
+                                                                               \
+	while (i < na && j < nb)                                                   \
+	{                                                                          \
+		take_a = (a[i] <= b[j]);                                               \
+		*dst++ = take_a ? a[i] : b[j];                                         \
+		i += take_a;                                                           \
+		j += !take_a;                                                          \
+	}                                                                          \
+                                                                               \
+	memcpy (dst, a + i, (na - i) * sizeof (T));                                \
+	dst += na - i;                                                             \
+	memcpy (dst, b + j, (nb - j) * sizeof (T));                                \
+	return dst + (nb - j);                                                     \
+}                                                                              \
+                                                                               \
+static T *                                                                     \
+vector_sorted_linear_##SUFFIX (T *dst, const T *a, size_t na, const T *b,      \
+                               size_t nb, int op)                              \
+{                                                                              \
+	size_t i = 0, j = 0, lt, gt, eq;                                           \
+	size_t keep_a = ((op & SORTED_KEEP_A) != 0);                               \
+	size_t keep_b = ((op & SORTED_KEEP_B) != 0);                               \
+	size_t keep_common = ((op & SORTED_KEEP_COMMON) != 0);                     \
+	T x, y;                                                                    \
+                                                                               \
+	while (i < na && j < nb)                                                   \
+	{                                                                          \
+		x = a[i];                                                              \
+		y = b[j];                                                              \
+		lt = (x < y);                                                          \
+		gt = (x > y);                                                          \
+		eq = (x == y);                                                         \
+		*dst = gt ? y : x;                                                     \
+		dst += (lt & keep_a) | (gt & keep_b) | (eq & keep_common);              \
+		i += !gt;                                                              \
+		j += !lt;                                                              \
+	}                                                                          \
+                                                                               \
+	if (keep_a)                                                                \
+	{                                                                          \
+		memcpy (dst, a + i, (na - i) * sizeof (T));                            \
+		dst += na - i;                                                         \
+	}                                                                          \
+	if (keep_b)                                                                \
+	{                                                                          \
+		memcpy (dst, b + j, (nb - j) * sizeof (T));                            \
+		dst += nb - j;                                                         \
+	}                                                                          \
+	return dst;                                                                \
+}
+
+DEFINE_INTEGER_KERNELS (uint32_t, u32)
+DEFINE_INTEGER_KERNELS (uint64_t, u64)
+
+#ifdef __SSE2__
+/**
+ * Function: vector_block_match_u32
+ * ------------------------------------------------------
+ * Intersection or difference of two strictly increasing uint32_t arrays, four
+ * elements of each at a time. Every element of a block of a is compared with
+ * every element of a block of b in four vector compares, b rotated a lane
+ * each time, and the hits collect in a mask. Whichever block ends lower is
+ * done with and the next is loaded. A block of a is emitted, its hits for an
+ * intersection or its misses for a difference, once a block of b reaching
+ * past its end has been compared.
+ *
+ * Stops when either input has fewer than four elements left and reports how
+ * far it got through *pi and *pj, for the scalar kernel to finish.
+ *
+ * returns - the end of the elements written at dst
+ */
+static uint32_t *
+vector_block_match_u32 (uint32_t *dst, const uint32_t *a, size_t na,
+                        const uint32_t *b, size_t nb, bool keep_common,
+                        size_t *pi, size_t *pj)
+{
+	size_t i = 0, j = 0, k;
+	unsigned hits = 0, keep;
+	bool pending = false, hit;
+	uint32_t a_last, b_last, x;
+	__m128i va, vb, eq;
+
+	while (i + 4 <= na && j + 4 <= nb)
+	{
+		va = _mm_loadu_si128 ((const __m128i *)(a + i));
+		vb = _mm_loadu_si128 ((const __m128i *)(b + j));
+		eq = _mm_or_si128 (
+			_mm_or_si128 (_mm_cmpeq_epi32 (va, vb),
+			              _mm_cmpeq_epi32 (va, _mm_shuffle_epi32 (vb, _MM_SHUFFLE (0, 3, 2, 1)))),
+			_mm_or_si128 (_mm_cmpeq_epi32 (va, _mm_shuffle_epi32 (vb, _MM_SHUFFLE (1, 0, 3, 2))),
+			              _mm_cmpeq_epi32 (va, _mm_shuffle_epi32 (vb, _MM_SHUFFLE (2, 1, 0, 3)))));
+		hits |= (unsigned)_mm_movemask_ps (_mm_castsi128_ps (eq));
+		pending = true;
+
+		a_last = a[i + 3];
+		b_last = b[j + 3];
+		if (a_last <= b_last)
+		{
+			keep = keep_common ? hits : ~hits;
+			for (k = 0; k < 4; k++)
+			{
+				*dst = a[i + k];
+				dst += (keep >> k) & 1;
+			}
+			i += 4;
+			hits = 0;
+			pending = false;
+		}
+		if (b_last <= a_last)
+		{
+			j += 4;
+		}
+	}
+
+	/* a block of a met only some of the blocks of b it overlaps */
+	if (pending)
+	{
+		for (k = 0; k < 4; k++)
+		{
+			x = a[i + k];
+			hit = (hits >> k) & 1;
+			if (!hit)
+			{
+				while (j < nb && b[j] < x)
+				{
+					j++;
+				}
+				hit = (j < nb && b[j] == x);
+			}
+			if (hit == keep_common)
+			{
+				*dst++ = x;
+			}
+		}
+		i += 4;
+	}
+
+	*pi = i;
+	*pj = j;
+	return dst;
+}
+#endif
+
+/**
+ * Function: vector_gallop
+ * ------------------------------------------------------
+ * Finds the first of the elements lo up to n that compares greater than key,
+ * or not less than key if past_equal is false. Probes at lo, lo + 1, lo + 3,
+ * lo + 7 and so on until one is past key, then binary searches the last gap,
+ * so a run of length r costs O(log r) compares.
+ *
+ * returns - the index found, or n if every element qualifies
+ */
+static size_t
+vector_gallop (const char *base, size_t elem_sz, size_t lo, size_t n,
+               const void *key, compare_fn fn, bool past_equal)
+{
+	int limit = past_equal ? 0 : -1;
+	size_t hi = lo, step = 1, mid;
+
+	while (hi < n && fn (base + hi * elem_sz, key) <= limit)
+	{
+		lo = hi + 1;
+		hi += step;
+		step *= 2;
+	}
+	if (hi > n)
+	{
+		hi = n;
+	}
+
+	while (lo < hi)
+	{
+		mid = lo + (hi - lo) / 2;
+		if (fn (base + mid * elem_sz, key) <= limit)
+		{
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
+
+/**
+ * Function: vector_sorted_generic
+ * ------------------------------------------------------
+ * Walks a and b together through the compare function. With gallop set, each
+ * step skips a whole run of one input that sorts before the head of the
+ * other, copying it with one memcpy when it is kept. For a small input
+ * against a large one this costs O(small log large) compares.
+ *
+ * returns - the end of the elements written at dst
+ */
+static char *
+vector_sorted_generic (char *dst, const vector *a, const vector *b,
+                       compare_fn fn, int op, bool gallop)
+{
+	const char *pa = a->elems, *pb = b->elems;
+	size_t sz = a->elem_sz, na = a->n_elems, nb = b->n_elems;
+	size_t i = 0, j = 0, run;
+	bool merge = (op & SORTED_MERGE) != 0;
+	int c;
+
+	while (i < na && j < nb)
+	{
+		c = fn (pa + i * sz, pb + j * sz);
+		if (c < 0 || (c == 0 && merge))
+		{
+			run = gallop ? vector_gallop (pa, sz, i + 1, na, pb + j * sz, fn, merge) : i + 1;
+			if (op & SORTED_KEEP_A)
+			{
+				memcpy (dst, pa + i * sz, (run - i) * sz);
+				dst += (run - i) * sz;
+			}
+			i = run;
+		}
+		else if (c > 0)
+		{
+			run = gallop ? vector_gallop (pb, sz, j + 1, nb, pa + i * sz, fn, false) : j + 1;
+			if (op & SORTED_KEEP_B)
+			{
+				memcpy (dst, pb + j * sz, (run - j) * sz);
+				dst += (run - j) * sz;
+			}
+			j = run;
+		}
+		else
+		{
+			if (op & SORTED_KEEP_COMMON)
+			{
+				memcpy (dst, pa + i * sz, sz);
+				dst += sz;
+			}
+			i++;
+			j++;
+		}
+	}
+
+	if (op & SORTED_KEEP_A)
+	{
+		memcpy (dst, pa + i * sz, (na - i) * sz);
+		dst += (na - i) * sz;
+	}
+	if (op & SORTED_KEEP_B)
+	{
+		memcpy (dst, pb + j * sz, (nb - j) * sz);
+		dst += (nb - j) * sz;
+	}
+	return dst;
+}
+
+/**
+ * Function: vector_sorted_op
+ * ------------------------------------------------------
+ * Runs one sorted set operation into the end of out, choosing a kernel: the
+ * galloping walk when the sizes are skewed, the integer kernels when fn is
+ * one of the integer compares and the element size matches, and the plain
+ * walk through fn otherwise.
+ *
+ * returns - the number of elements appended
+ */
+static size_t
+vector_sorted_op (vector *out, const vector *a, const vector *b,
+                  compare_fn fn, int op)
+{
+	assert (out != NULL && a != NULL && b != NULL);
+	assert (fn != NULL);
+	assert (out->magic == MAGIC_INIT_VALUE);
+	assert (!out->read_only);
+	vector_unshare (out);
+	assert (a->magic == MAGIC_INIT_VALUE && b->magic == MAGIC_INIT_VALUE);
+	assert (out != a && out != b);
+	assert (a->elem_sz == b->elem_sz && a->elem_sz == out->elem_sz);
+	size_t na = a->n_elems, nb = b->n_elems, bound = 0, i = 0, j = 0;
+	char *start, *end;
+
+	if (op & SORTED_KEEP_A)
+	{
+		bound += na;
+	}
+	if (op & SORTED_KEEP_B)
+	{
+		bound += nb;
+	}
+	if (bound == 0)
+	{
+		bound = (na < nb) ? na : nb;
+	}
+	vector_reserve (out, bound);
+	start = GET_PTR_ELEM (out, out->n_elems);
+
+	if (na > SKEW_RATIO * nb || nb > SKEW_RATIO * na)
+	{
+		end = vector_sorted_generic (start, a, b, fn, op, true);
+	}
+	else if (fn == vector_compare_u32 && a->elem_sz == sizeof (uint32_t))
+	{
+		const uint32_t *pa = a->elems, *pb = b->elems;
+		uint32_t *dst = (uint32_t *)start;
+
+		if (op & SORTED_MERGE)
+		{
+			dst = vector_merge_u32 (dst, pa, na, pb, nb);
+		}
+		else
+		{
+#ifdef __SSE2__
+			if (op == SORTED_KEEP_COMMON || op == SORTED_KEEP_A)
+			{
+				dst = vector_block_match_u32 (dst, pa, na, pb, nb, op == SORTED_KEEP_COMMON, &i, &j);
+			}
+#endif
+			dst = vector_sorted_linear_u32 (dst, pa + i, na - i, pb + j, nb - j, op);
+		}
+		end = (char *)dst;
+	}
+	else if (fn == vector_compare_u64 && a->elem_sz == sizeof (uint64_t))
+	{
+		const uint64_t *pa = a->elems, *pb = b->elems;
+		uint64_t *dst = (uint64_t *)start;
+
+		if (op & SORTED_MERGE)
+		{
+			dst = vector_merge_u64 (dst, pa, na, pb, nb);
+		}
+		else
+		{
+			dst = vector_sorted_linear_u64 (dst, pa, na, pb, nb, op);
+		}
+		end = (char *)dst;
+	}
+	else
+	{
+		end = vector_sorted_generic (start, a, b, fn, op, false);
+	}
+
+	out->n_elems += (size_t)(end - start) / out->elem_sz;
+	return (size_t)(end - start) / out->elem_sz;
+}
+
+/**
+ * Function: vector_unique
+ * ------------------------------------------------------
+ * Compacts the vector in place, keeping the first of every run of equal
+ * elements and destroying the rest.
+ *
+ * param v  - initialized vector
+ * param fn - the compare function that decides equality
+ *
+ * returns - the number of elements removed
+ */
+size_t
+vector_unique (vector *v, compare_fn fn)
+{
+	assert (v != NULL);
+	assert (fn != NULL);
+	assert (v->magic == MAGIC_INIT_VALUE);
+	assert (!v->read_only);
+	vector_unshare (v);
+	size_t n = v->n_elems, r, w = 0;
+
+	if (n < 2)
+	{
+		return 0;
+	}
+
+	if (v->elem_destroy == NULL && fn == vector_compare_u32 && v->elem_sz == sizeof (uint32_t))
+	{
+		v->n_elems = vector_unique_u32 (v->elems, n);
+	}
+	else if (v->elem_destroy == NULL && fn == vector_compare_u64 && v->elem_sz == sizeof (uint64_t))
+	{
+		v->n_elems = vector_unique_u64 (v->elems, n);
+	}
+	else
+	{
+		for (r = 1; r < n; r++)
+		{
+			if (fn (GET_PTR_ELEM (v, w), GET_PTR_ELEM (v, r)) != 0)
+			{
+				if (++w != r)
+				{
+					memcpy (GET_PTR_ELEM (v, w), GET_PTR_ELEM (v, r), v->elem_sz);
+				}
+			}
+			else if (v->elem_destroy)
+			{
+				v->elem_destroy (GET_PTR_ELEM (v, r));
+			}
+		}
+		v->n_elems = w + 1;
+	}
+
+	return n - v->n_elems;
+}
+
+/**
+ * Function: vector_merge_sorted
+ * ------------------------------------------------------
+ * Appends every element of a and b to out in sorted order. Stable: among
+ * equal elements a's come first, each side in its own order.
+ *
+ * param out - initialized vector receiving the result
+ * param a   - vector sorted by fn
+ * param b   - vector sorted by fn
+ * param fn  - the compare function both inputs are sorted by
+ *
+ * returns - the number of elements appended
+ */
+size_t
+vector_merge_sorted (vector *out, const vector *a, const vector *b,
+                     compare_fn fn)
+{
+	return vector_sorted_op (out, a, b, fn, SORTED_KEEP_A | SORTED_KEEP_B | SORTED_MERGE);
+}
+
+/**
+ * Function: vector_union_sorted
+ * ------------------------------------------------------
+ * Appends the elements found in a, in b or in both, once each.
+ */
+size_t
+vector_union_sorted (vector *out, const vector *a, const vector *b,
+                     compare_fn fn)
+{
+	return vector_sorted_op (out, a, b, fn, SORTED_KEEP_A | SORTED_KEEP_B | SORTED_KEEP_COMMON);
+}
+
+/**
+ * Function: vector_intersect_sorted
+ * ------------------------------------------------------
+ * Appends the elements found in both a and b.
+ */
+size_t
+vector_intersect_sorted (vector *out, const vector *a, const vector *b,
+                         compare_fn fn)
+{
+	return vector_sorted_op (out, a, b, fn, SORTED_KEEP_COMMON);
+}
+
+/**
+ * Function: vector_difference_sorted
+ * ------------------------------------------------------
+ * Appends the elements of a that are not found in b.
+ */
+size_t
+vector_difference_sorted (vector *out, const vector *a, const vector *b,
+                          compare_fn fn)
+{
+	return vector_sorted_op (out, a, b, fn, SORTED_KEEP_A);
+}
+
+/**
+ * Stable sort
+ * ------------------------------------------------------
+ * An adaptive merge sort after TimSort. The input is split into natural
+ * runs, strictly descending ones reversed in place, and runs shorter than a
+ * minimum length are extended with binary insertion sort. Runs are pushed on
+ * a stack and merged while the lengths on top break the rule that each run
+ * is longer than the two above it together, which keeps merges balanced and
+ * the stack logarithmic.
+ */
+typedef struct
+{
+	char *base;
+	char *scratch;
+	char *tmp;
+	size_t elem_sz;
+	compare_fn fn;
+	size_t n_runs;
+	size_t run_start[MAX_RUNS];
+	size_t run_len[MAX_RUNS];
+} stable_sort_state;
+
+#define RUN_PTR(S, I) ((S)->base + (I) * (S)->elem_sz)
+
+/**
+ * Function: stable_min_run
+ * ------------------------------------------------------
+ * Picks a minimum run length between MIN_MERGE / 2 and MIN_MERGE such that
+ * n splits into a power of two runs of it, or slightly fewer.
+ */
+static size_t
+stable_min_run (size_t n)
+{
+	size_t r = 0;
+
+	while (n >= MIN_MERGE)
+	{
+		r |= n & 1;
+		n >>= 1;
+	}
+
+	return n + r;
+}
+
+/**
+ * Function: stable_count_run
+ * ------------------------------------------------------
+ * Measures the run starting at lo. A strictly descending run is reversed so
+ * every run ends up ascending; it must be strict so that reversing cannot
+ * reorder equal elements.
+ *
+ * returns - the length of the run
+ */
+static size_t
+stable_count_run (stable_sort_state *s, size_t lo, size_t hi)
+{
+	size_t i = lo + 1, x, y;
+
+	if (i == hi)
+	{
+		return 1;
+	}
+
+	if (s->fn (RUN_PTR (s, i), RUN_PTR (s, lo)) < 0)
+	{
+		while (++i < hi && s->fn (RUN_PTR (s, i), RUN_PTR (s, i - 1)) < 0)
+			;
+		for (x = lo, y = i - 1; x < y; x++, y--)
+		{
+			vector_swap (RUN_PTR (s, x), RUN_PTR (s, y), s->elem_sz, s->tmp);
+		}
+	}
+	else
+	{
+		while (++i < hi && s->fn (RUN_PTR (s, i), RUN_PTR (s, i - 1)) >= 0)
+			;
+	}
+
+	return i - lo;
+}
+
+/**
+ * Function: stable_insertion_sort
+ * ------------------------------------------------------
+ * Extends the sorted elements lo up to start to cover lo up to hi, placing
+ * each new element after any equal ones with a binary search.
+ */
+static void
+stable_insertion_sort (stable_sort_state *s, size_t lo, size_t hi, size_t start)
+{
+	size_t i, left, right, mid;
+
+	for (i = start; i < hi; i++)
+	{
+		memcpy (s->tmp, RUN_PTR (s, i), s->elem_sz);
+
+		left = lo;
+		right = i;
+		while (left < right)
+		{
+			mid = left + (right - left) / 2;
+			if (s->fn (s->tmp, RUN_PTR (s, mid)) < 0)
+			{
+				right = mid;
+			}
+			else
+			{
+				left = mid + 1;
+			}
+		}
+
+		memmove (RUN_PTR (s, left + 1), RUN_PTR (s, left), (i - left) * s->elem_sz);
+		memcpy (RUN_PTR (s, left), s->tmp, s->elem_sz);
+	}
+}
+
+/**
+ * Function: stable_merge_lo
+ * ------------------------------------------------------
+ * Merges run a into the run b that follows it, front to back, with a copied
+ * out to scratch. Ties go to a. Whatever is left of b is already in place.
+ */
+static void
+stable_merge_lo (stable_sort_state *s, size_t a, size_t na, size_t b, size_t nb)
+{
+	size_t sz = s->elem_sz;
+	char *dst = RUN_PTR (s, a), *pb = RUN_PTR (s, b), *pb_end = RUN_PTR (s, b + nb);
+	char *pa = s->scratch, *pa_end = s->scratch + na * sz;
+
+	memcpy (s->scratch, dst, na * sz);
+
+	while (pa < pa_end && pb < pb_end)
+	{
+		if (s->fn (pb, pa) < 0)
+		{
+			memcpy (dst, pb, sz);
+			pb += sz;
+		}
+		else
+		{
+			memcpy (dst, pa, sz);
+			pa += sz;
+		}
+		dst += sz;
+	}
+
+	memcpy (dst, pa, (size_t)(pa_end - pa));
+}
+
+/**
+ * Function: stable_merge_hi
+ * ------------------------------------------------------
+ * Merges run b into the run a before it, back to front, with b copied out to
+ * scratch. Ties go to b, which keeps a's elements first.
+ */
+static void
+stable_merge_hi (stable_sort_state *s, size_t a, size_t na, size_t b, size_t nb)
+{
+	size_t sz = s->elem_sz;
+	char *dst = RUN_PTR (s, b + nb), *pa = RUN_PTR (s, a + na), *a_start = RUN_PTR (s, a);
+	char *pb = s->scratch + nb * sz;
+
+	memcpy (s->scratch, RUN_PTR (s, b), nb * sz);
+
+	while (pa > a_start && pb > s->scratch)
+	{
+		dst -= sz;
+		if (s->fn (pb - sz, pa - sz) < 0)
+		{
+			pa -= sz;
+			memcpy (dst, pa, sz);
+		}
+		else
+		{
+			pb -= sz;
+			memcpy (dst, pb, sz);
+		}
+	}
+
+	memcpy (dst - (pb - s->scratch), s->scratch, (size_t)(pb - s->scratch));
+}
+
+/**
+ * Function: stable_merge_at
+ * ------------------------------------------------------
+ * Merges stack runs k and k + 1. Before merging, gallops to skip the front
+ * of a that sorts before all of b and the back of b that sorts after all of
+ * a, both already in place. On nearly sorted data this leaves little or
+ * nothing to merge. The shorter remaining run is the one copied out.
+ */
+static void
+stable_merge_at (stable_sort_state *s, size_t k)
+{
+	size_t a = s->run_start[k], na = s->run_len[k];
+	size_t b = s->run_start[k + 1], nb = s->run_len[k + 1], skip;
+
+	s->run_len[k] = na + nb;
+	if (k + 3 == s->n_runs)
+	{
+		s->run_start[k + 1] = s->run_start[k + 2];
+		s->run_len[k + 1] = s->run_len[k + 2];
+	}
+	s->n_runs--;
+
+	skip = vector_gallop (s->base, s->elem_sz, a, a + na, RUN_PTR (s, b), s->fn, true) - a;
+	a += skip;
+	na -= skip;
+	if (na == 0)
+	{
+		return;
+	}
+
+	nb = vector_gallop (s->base, s->elem_sz, b, b + nb, RUN_PTR (s, a + na - 1), s->fn, false) - b;
+	if (nb == 0)
+	{
+		return;
+	}
+
+	if (na <= nb)
+	{
+		stable_merge_lo (s, a, na, b, nb);
+	}
+	else
+	{
+		stable_merge_hi (s, a, na, b, nb);
+	}
+}
+
+/**
+ * Function: stable_merge_collapse
+ * ------------------------------------------------------
+ * Merges runs on top of the stack until, for the top three lengths x, y, z
+ * (z on top), x > y + z and y > z, checking one level deeper as well.
+ */
+static void
+stable_merge_collapse (stable_sort_state *s)
+{
+	size_t k, *len = s->run_len;
+
+	while (s->n_runs > 1)
+	{
+		k = s->n_runs - 2;
+		if ((k > 0 && len[k - 1] <= len[k] + len[k + 1]) ||
+		    (k > 1 && len[k - 2] <= len[k - 1] + len[k]))
+		{
+			if (len[k - 1] < len[k + 1])
+			{
+				k--;
+			}
+		}
+		else if (len[k] > len[k + 1])
+		{
+			break;
+		}
+		stable_merge_at (s, k);
+	}
+}
+
+/**
+ * Function: vector_sort_stable
+ * ------------------------------------------------------
+ * Sorts the vector, keeping equal elements in their original order.
+ *
+ * param v  - initialized vector
+ * param fn - the compare function for sorting
+ */
+void
+vector_sort_stable (vector *v, compare_fn fn)
+{
+	assert (v != NULL);
+	assert (fn != NULL);
+	assert (v->magic == MAGIC_INIT_VALUE);
+	assert (!v->read_only);
+	vector_unshare (v);
+	stable_sort_state s;
+	size_t n = v->n_elems, lo = 0, len, force, min_run, k;
+
+	if (n < 2)
+	{
+		return;
+	}
+
+	s.base = v->elems;
+	s.elem_sz = v->elem_sz;
+	s.fn = fn;
+	s.n_runs = 0;
+	s.scratch = malloc ((n / 2 + 1) * v->elem_sz);
+	s.tmp = malloc (v->elem_sz);
+	assert (s.scratch != NULL && s.tmp != NULL);
+
+	min_run = stable_min_run (n);
+	while (lo < n)
+	{
+		len = stable_count_run (&s, lo, n);
+		if (len < min_run)
+		{
+			force = (n - lo < min_run) ? n - lo : min_run;
+			stable_insertion_sort (&s, lo, lo + force, lo + len);
+			len = force;
+		}
+
+		assert (s.n_runs < MAX_RUNS);
+		s.run_start[s.n_runs] = lo;
+		s.run_len[s.n_runs] = len;
+		s.n_runs++;
+		stable_merge_collapse (&s);
+
+		lo += len;
+	}
+
+	while (s.n_runs > 1)
+	{
+		k = s.n_runs - 2;
+		if (k > 0 && s.run_len[k - 1] < s.run_len[k + 1])
+		{
+			k--;
+		}
+		stable_merge_at (&s, k);
+	}
+
+	free (s.scratch);
+	free (s.tmp);
+}
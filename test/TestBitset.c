@@ -0,0 +1,241 @@
+#include "Bitset.h"
+#include "unity.h"
+#include "TestRng.h"
+#include <string.h>
+
+/* a bitset and a byte per bit holding the same bits, set with density in
+ * 1024 and a dense stretch in the middle */
+static bitset *
+make_bitset (size_t n_bits, unsigned density, uint8_t *bytes)
+{
+	bitset *bs = bitset_init (n_bits);
+	size_t i;
+
+	for (i = 0; i < n_bits; i++)
+	{
+		bytes[i] = (rng_next () % 1024 < density) || (i > n_bits / 3 && i < n_bits / 3 + 700);
+		if (bytes[i])
+		{
+			bitset_set (bs, i);
+		}
+	}
+	return bs;
+}
+
+static void
+test_bitset_set_test_clear (void)
+{
+	bitset *bs = bitset_init (1000);
+	size_t i;
+
+	TEST_ASSERT_MESSAGE (bitset_size (bs) == 1000 && bitset_count (bs) == 0, "new bitset not clear");
+	for (i = 0; i < 1000; i += 3)
+	{
+		bitset_set (bs, i);
+	}
+	for (i = 0; i < 1000; i += 6)
+	{
+		bitset_clear (bs, i);
+	}
+	for (i = 0; i < 1000; i++)
+	{
+		TEST_ASSERT_MESSAGE (bitset_test (bs, i) == (i % 3 == 0 && i % 6 != 0), "bitset test wrong");
+	}
+	TEST_ASSERT_MESSAGE (bitset_count (bs) == 167, "bitset count wrong");
+
+	/* growing adds clear bits, shrinking drops the bits past the end */
+	bitset_resize (bs, 5000);
+	TEST_ASSERT_MESSAGE (bitset_count (bs) == 167 && !bitset_test (bs, 4999), "bitset grow wrong");
+	bitset_resize (bs, 100);
+	bitset_resize (bs, 200);
+	TEST_ASSERT_MESSAGE (bitset_count (bs) == 17 && !bitset_test (bs, 111), "bitset shrink wrong");
+
+	bitset_clear_all (bs);
+	TEST_ASSERT_MESSAGE (bitset_count (bs) == 0, "bitset clear all wrong");
+	bitset_destroy (bs);
+}
+
+static void
+test_bitset_bulk (void)
+{
+	size_t sizes[] = { 1, 63, 64, 65, 255, 256, 257, 10000 + 13 }, s, i, n, expect;
+	uint8_t *a_bytes = malloc (10100), *b_bytes = malloc (10100);
+	bitset *a, *b, *dst;
+	int op;
+
+	for (s = 0; s < sizeof (sizes) / sizeof (sizes[0]); s++)
+	{
+		n = sizes[s];
+		a = make_bitset (n, 300, a_bytes);
+		b = make_bitset (n, 600, b_bytes);
+		for (op = 0; op < 4; op++)
+		{
+			dst = bitset_init (n);
+			bitset_or (dst, a);
+			switch (op)
+			{
+			case 0: bitset_and (dst, b); break;
+			case 1: bitset_or (dst, b); break;
+			case 2: bitset_xor (dst, b); break;
+			default: bitset_andnot (dst, b); break;
+			}
+			expect = 0;
+			for (i = 0; i < n; i++)
+			{
+				bool bit = (op == 0) ? a_bytes[i] && b_bytes[i]
+				         : (op == 1) ? a_bytes[i] || b_bytes[i]
+				         : (op == 2) ? a_bytes[i] != b_bytes[i]
+				                     : a_bytes[i] && !b_bytes[i];
+				expect += bit;
+				TEST_ASSERT_MESSAGE (bitset_test (dst, i) == bit, "bitset bulk op wrong");
+			}
+			TEST_ASSERT_MESSAGE (bitset_count (dst) == expect, "bitset bulk count wrong");
+			bitset_destroy (dst);
+		}
+		bitset_destroy (a);
+		bitset_destroy (b);
+	}
+	free (a_bytes);
+	free (b_bytes);
+}
+
+static void
+test_bitset_rank_select (void)
+{
+	size_t n = 300000, i, rank = 0;
+	unsigned densities[] = { 0, 1, 100, 1023 }, d;
+	uint8_t *bytes = malloc (n);
+	bitset *bs;
+
+	for (d = 0; d < sizeof (densities) / sizeof (densities[0]); d++)
+	{
+		bs = make_bitset (n, densities[d], bytes);
+		rank = 0;
+		for (i = 0; i < n; i++)
+		{
+			TEST_ASSERT_MESSAGE (bitset_rank (bs, i) == rank, "bitset rank wrong");
+			if (bytes[i])
+			{
+				TEST_ASSERT_MESSAGE (bitset_select (bs, rank) == i, "bitset select wrong");
+				rank++;
+			}
+		}
+		TEST_ASSERT_MESSAGE (bitset_rank (bs, n) == rank && bitset_count (bs) == rank, "bitset rank at end wrong");
+
+		/* a change drops the index */
+		bitset_set (bs, n - 1);
+		bitset_clear (bs, n / 3 + 1);
+		TEST_ASSERT_MESSAGE (bitset_rank (bs, n) == rank + !bytes[n - 1] - 1, "bitset rank after change wrong");
+		bitset_destroy (bs);
+	}
+	free (bytes);
+}
+
+static void
+test_bitset_iter (void)
+{
+	size_t n = 20000 + 5, starts[] = { 0, 1, 64, 6667, 20000, 20005 }, s, i, pos;
+	size_t max_ns[] = { 1, 3, 63, 64, 100, 1000 }, got[1000], n_got, j;
+	uint8_t *bytes = malloc (n);
+	bitset *bs = make_bitset (n, 40, bytes);
+	bitset_iter it;
+
+	for (s = 0; s < sizeof (starts) / sizeof (starts[0]); s++)
+	{
+		bitset_iter_init (bs, &it, starts[s]);
+		for (i = starts[s]; i < n; i++)
+		{
+			if (bytes[i])
+			{
+				TEST_ASSERT_MESSAGE (bitset_iter_next (&it, &pos) && pos == i, "bitset iter wrong bit");
+			}
+		}
+		TEST_ASSERT_MESSAGE (!bitset_iter_next (&it, &pos), "bitset iter ran past the end");
+	}
+
+	/* batches smaller and larger than a word, from part way into a word */
+	for (s = 0; s < sizeof (max_ns) / sizeof (max_ns[0]); s++)
+	{
+		bitset_iter_init (bs, &it, 70);
+		i = 70;
+		while ((n_got = bitset_iter_next_many (&it, got, max_ns[s])) > 0)
+		{
+			TEST_ASSERT_MESSAGE (n_got <= max_ns[s], "bitset batch too long");
+			for (j = 0; j < n_got; j++, i++)
+			{
+				while (!bytes[i])
+				{
+					i++;
+				}
+				TEST_ASSERT_MESSAGE (got[j] == i, "bitset batch wrong bit");
+			}
+		}
+		while (i < n && !bytes[i])
+		{
+			i++;
+		}
+		TEST_ASSERT_MESSAGE (i == n, "bitset batches stopped early");
+	}
+
+	free (bytes);
+	bitset_destroy (bs);
+}
+
+static void
+test_bitset_vector (void)
+{
+	uint32_t ids32[] = { 70, 3, 64, 0, 1000, 63 }, sorted32[] = { 0, 3, 63, 64, 70, 1000 };
+	vector *v = vector_init (sizeof (uint32_t), 0, NULL), *back;
+	uint64_t id64;
+	bitset *bs;
+	size_t i;
+
+	for (i = 0; i < 6; i++)
+	{
+		vector_append (v, &ids32[i]);
+	}
+	bs = bitset_from_vector (v);
+	TEST_ASSERT_MESSAGE (bitset_size (bs) == 1001 && bitset_count (bs) == 6, "bitset from vector wrong");
+
+	back = bitset_to_vector (bs, sizeof (uint32_t));
+	TEST_ASSERT_MESSAGE (vector_size (back) == 6, "bitset to vector wrong size");
+	TEST_ASSERT_MESSAGE (memcmp (vector_access (back, 0), sorted32, sizeof (sorted32)) == 0,
+	                     "bitset to vector wrong ids");
+	vector_destroy (back);
+
+	back = bitset_to_vector (bs, sizeof (uint64_t));
+	for (i = 0; i < 6; i++)
+	{
+		memcpy (&id64, vector_access (back, (int)i), sizeof (id64));
+		TEST_ASSERT_MESSAGE (id64 == sorted32[i], "bitset to vector of uint64_t wrong");
+	}
+	bitset_destroy (bs);
+
+	/* back from the uint64_t vector to the same bits */
+	bs = bitset_from_vector (back);
+	TEST_ASSERT_MESSAGE (bitset_count (bs) == 6 && bitset_test (bs, 64) && !bitset_test (bs, 65),
+	                     "bitset from vector of uint64_t wrong");
+	bitset_destroy (bs);
+	vector_destroy (back);
+
+	vector_clear (v);
+	bs = bitset_from_vector (v);
+	TEST_ASSERT_MESSAGE (bitset_size (bs) == 0, "bitset from empty vector wrong");
+	back = bitset_to_vector (bs, sizeof (uint32_t));
+	TEST_ASSERT_MESSAGE (vector_size (back) == 0, "bitset to vector from empty wrong");
+	bitset_destroy (bs);
+	vector_destroy (back);
+	vector_destroy (v);
+}
+
+int
+main(void)
+{
+	UNITY_BEGIN ();
+	RUN_TEST (test_bitset_set_test_clear);
+	RUN_TEST (test_bitset_bulk);
+	RUN_TEST (test_bitset_rank_select);
+	RUN_TEST (test_bitset_iter);
+	RUN_TEST (test_bitset_vector);
+	return UNITY_END ();
+}
@@ -0,0 +1,126 @@
+#include "Bloom.h"
+#include "unity.h"
+#include "TestRng.h"
+#include <string.h>
+
+static size_t
+hash_u64 (const void *key)
+{
+	return *(const uint64_t *)key;
+}
+
+/* adds n random keys with the low bit clear and counts how many of n with it set pass */
+static size_t
+count_false_positives (bloom *b, uint64_t n)
+{
+	uint64_t i, key;
+	size_t n_fp = 0;
+
+	rng_state = RNG_SEED;
+	for (i = 0; i < n; i++)
+	{
+		key = rng_next () & ~1ULL;
+		bloom_add (b, &key);
+	}
+	rng_state = RNG_SEED;
+	for (i = 0; i < n; i++)
+	{
+		key = rng_next () & ~1ULL;
+		TEST_ASSERT_MESSAGE (bloom_contains (b, &key), "bloom false negative");
+		key |= 1;
+		n_fp += bloom_contains (b, &key);
+	}
+	return n_fp;
+}
+
+static void
+test_bloom_fp_rate (void)
+{
+	double rates[] = { 0.2, 0.01, 0.001, 0.0001 }, expect, off;
+	size_t r, n = 200000, n_fp, bytes = 0;
+	bloom *b;
+
+	for (r = 0; r < sizeof (rates) / sizeof (rates[0]); r++)
+	{
+		b = bloom_init (sizeof (uint64_t), n, rates[r], hash_u64);
+		TEST_ASSERT_MESSAGE (bloom_bytes (b) > bytes, "bloom not larger for a lower rate");
+		bytes = bloom_bytes (b);
+
+		n_fp = count_false_positives (b, n);
+		expect = bloom_fp_rate (b);
+		TEST_ASSERT_MESSAGE (expect <= rates[r] && expect > rates[r] / 2, "bloom sized for the wrong rate");
+
+		/* within five standard deviations of the expected count */
+		off = (double)n_fp - expect * (double)n;
+		off = (off < 0 ? -off : off) - 1;
+		TEST_ASSERT_MESSAGE (off < 0 || off * off < 25 * expect * (double)n, "bloom false positive rate off");
+		bloom_destroy (b);
+	}
+
+	/* overfilling raises the rate */
+	b = bloom_init (sizeof (uint64_t), 1000, 0.01, hash_u64);
+	n_fp = count_false_positives (b, 10000);
+	TEST_ASSERT_MESSAGE (bloom_fp_rate (b) > 0.1 && n_fp > 1000, "bloom overfilled rate wrong");
+	bloom_destroy (b);
+}
+
+static void
+test_bloom_many (void)
+{
+	size_t sizes[] = { 0, 1, 15, 16, 17, 1000 + 7 }, s, i, count;
+	uint64_t keys[1007];
+	bool maybe[1007];
+	bloom *b = bloom_init (sizeof (uint64_t), 500, 0.05, hash_u64);
+
+	for (i = 0; i < 1007; i++)
+	{
+		keys[i] = i * 7;
+		if (i % 2 == 0)
+		{
+			bloom_add (b, &keys[i]);
+		}
+	}
+	for (s = 0; s < sizeof (sizes) / sizeof (sizes[0]); s++)
+	{
+		memset (maybe, 0, sizeof (maybe));
+		count = bloom_contains_many (b, keys, sizes[s], maybe);
+		for (i = 0; i < sizes[s]; i++)
+		{
+			TEST_ASSERT_MESSAGE (maybe[i] == bloom_contains (b, &keys[i]), "bloom batch differs");
+			TEST_ASSERT_MESSAGE (maybe[i] || i % 2 == 1, "bloom batch false negative");
+			count -= maybe[i];
+		}
+		TEST_ASSERT_MESSAGE (count == 0, "bloom batch count wrong");
+	}
+	bloom_destroy (b);
+}
+
+static void
+test_bloom_clear (void)
+{
+	bloom *b = bloom_init (sizeof (uint64_t), 0, 0.5, hash_u64);
+	size_t bytes = bloom_bytes (b);
+	uint64_t key;
+
+	for (key = 0; key < 100; key++)
+	{
+		bloom_add (b, &key);
+	}
+	bloom_clear (b);
+	TEST_ASSERT_MESSAGE (bloom_fp_rate (b) == 0.0 && bloom_bytes (b) == bytes, "bloom clear wrong");
+	for (key = 0; key < 100; key++)
+	{
+		TEST_ASSERT_MESSAGE (!bloom_contains (b, &key), "bloom clear left bits");
+	}
+	bloom_destroy (b);
+}
+
+int
+main(void)
+{
+	UNITY_BEGIN ();
+	RUN_TEST (test_bloom_fp_rate);
+	RUN_TEST (test_bloom_many);
+	RUN_TEST (test_bloom_clear);
+	return UNITY_END ();
+}
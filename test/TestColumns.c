@@ -0,0 +1,170 @@
+#include "Columns.h"
+#include "unity.h"
+#include <stddef.h>
+#include <string.h>
+
+typedef struct
+{
+	uint64_t id;
+	float price;
+	uint8_t flag;
+	uint32_t qty;
+} trade;
+
+static const size_t trade_sz[] = { sizeof (uint64_t), sizeof (float), sizeof (uint8_t), sizeof (uint32_t) };
+static const size_t trade_off[] = { offsetof (trade, id), offsetof (trade, price),
+                                    offsetof (trade, flag), offsetof (trade, qty) };
+
+static int
+compare_u32 (const void *elem1, const void *elem2)
+{
+	const uint32_t *ptr1 = elem1;
+	const uint32_t *ptr2 = elem2;
+
+	return (*ptr1 > *ptr2) - (*ptr1 < *ptr2);
+}
+
+static int
+compare_u8 (const void *elem1, const void *elem2)
+{
+	return (int)*(const uint8_t *)elem1 - (int)*(const uint8_t *)elem2;
+}
+
+static trade
+make_trade (uint64_t i)
+{
+	trade t;
+
+	memset (&t, 0, sizeof (t));
+	t.id = i * 1000003;
+	t.price = (float)(i % 977) / 4.0f;
+	t.flag = (uint8_t)(i % 3);
+	t.qty = (uint32_t)((i * 7919) % 101);
+	return t;
+}
+
+static void
+test_columns_append_get (void)
+{
+	columns *c = columns_init (4, trade_sz, trade_off, sizeof (trade), 0);
+	const float *price;
+	trade t, got;
+	size_t i;
+
+	for (i = 0; i < 10000; i++)
+	{
+		t = make_trade (i);
+		columns_append (c, &t);
+	}
+	TEST_ASSERT_MESSAGE (columns_size (c) == 10000, "columns size wrong");
+
+	/* each column is one aligned array of its field */
+	price = columns_column (c, 1);
+	TEST_ASSERT_MESSAGE ((uintptr_t)price % CACHE_LINE_SZ == 0, "column not aligned");
+	for (i = 0; i < 10000; i++)
+	{
+		t = make_trade (i);
+		TEST_ASSERT_MESSAGE (price[i] == t.price, "price column wrong");
+		TEST_ASSERT_MESSAGE (*(uint32_t *)columns_at (c, i, 3) == t.qty, "columns at wrong");
+
+		memset (&got, 0, sizeof (got));
+		columns_get (c, i, &got);
+		TEST_ASSERT_MESSAGE (memcmp (&got, &t, sizeof (t)) == 0, "columns get wrong row");
+	}
+
+	columns_clear (c);
+	TEST_ASSERT_MESSAGE (columns_size (c) == 0, "columns clear left rows");
+	columns_destroy (c);
+}
+
+static void
+test_columns_packed (void)
+{
+	size_t sz[] = { 2, 5, 1 };
+	uint8_t row[8], got[8];
+	columns *c = columns_init (3, sz, NULL, sizeof (row), 4);
+	size_t i;
+
+	for (i = 0; i < 100; i++)
+	{
+		memset (row, (int)i, sizeof (row));
+		columns_append (c, row);
+	}
+	for (i = 0; i < 100; i++)
+	{
+		memset (row, (int)i, sizeof (row));
+		columns_get (c, i, got);
+		TEST_ASSERT_MESSAGE (memcmp (got, row, sizeof (row)) == 0, "packed row wrong");
+		TEST_ASSERT_MESSAGE (*(uint8_t *)columns_at (c, i, 2) == i, "packed field wrong");
+	}
+	columns_destroy (c);
+}
+
+static void
+test_columns_sort (void)
+{
+	columns *c = columns_init (4, trade_sz, trade_off, sizeof (trade), 0);
+	trade t, prev, cur;
+	size_t i;
+
+	for (i = 0; i < 5000; i++)
+	{
+		t = make_trade (i);
+		columns_append (c, &t);
+	}
+
+	/* by flag, then stably by qty, gives qty major and flag minor */
+	columns_sort (c, 2, compare_u8);
+	columns_sort (c, 3, compare_u32);
+
+	columns_get (c, 0, &prev);
+	for (i = 1; i < 5000; i++)
+	{
+		columns_get (c, i, &cur);
+		TEST_ASSERT_MESSAGE (prev.qty < cur.qty || (prev.qty == cur.qty && prev.flag <= cur.flag),
+		                     "columns sort out of order");
+		TEST_ASSERT_MESSAGE (cur.price == make_trade (cur.id / 1000003).price, "columns sort split a row");
+		prev = cur;
+	}
+	columns_destroy (c);
+}
+
+static void
+test_columns_vector_round_trip (void)
+{
+	vector *rows = vector_init (sizeof (trade), 0, NULL), *back;
+	columns *c;
+	trade t;
+	size_t i;
+
+	for (i = 0; i < 3000; i++)
+	{
+		t = make_trade (i);
+		vector_append (rows, &t);
+	}
+
+	c = columns_from_vector (rows, 4, trade_sz, trade_off);
+	TEST_ASSERT_MESSAGE (columns_size (c) == 3000, "columns from vector wrong size");
+	TEST_ASSERT_MESSAGE (((uint64_t *)columns_column (c, 0))[2999] == 2999 * 1000003ULL,
+	                     "columns from vector wrong id");
+
+	back = columns_to_vector (c);
+	TEST_ASSERT_MESSAGE (vector_size (back) == 3000, "columns to vector wrong size");
+	TEST_ASSERT_MESSAGE (memcmp (vector_access (back, 0), vector_access (rows, 0), 3000 * sizeof (trade)) == 0,
+	                     "columns to vector wrong rows");
+
+	vector_destroy (rows);
+	vector_destroy (back);
+	columns_destroy (c);
+}
+
+int
+main(void)
+{
+	UNITY_BEGIN ();
+	RUN_TEST (test_columns_append_get);
+	RUN_TEST (test_columns_packed);
+	RUN_TEST (test_columns_sort);
+	RUN_TEST (test_columns_vector_round_trip);
+	return UNITY_END ();
+}
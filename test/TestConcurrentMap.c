@@ -0,0 +1,188 @@
+#include "ConcurrentMap.h"
+#include "unity.h"
+#include <pthread.h>
+
+#define N_KEYS      (100000UL)
+#define N_WRITERS   (4)
+#define N_READERS   (4)
+#define N_ROUNDS    (19)
+
+typedef struct
+{
+	uint64_t round;
+	uint64_t check;
+} value;
+
+static concurrent_map *m;
+static unsigned n_destroyed;
+
+static size_t
+hash_u64 (const void *key)
+{
+	return (size_t)*(const uint64_t *)key;
+}
+
+static int
+compare_u64 (const void *elem1, const void *elem2)
+{
+	const uint64_t *ptr1 = elem1;
+	const uint64_t *ptr2 = elem2;
+
+	return (*ptr1 > *ptr2) - (*ptr1 < *ptr2);
+}
+
+static void
+count_destroy (void *addr)
+{
+	++n_destroyed;
+}
+
+static void
+test_concurrent_map_single_thread (void)
+{
+	uint64_t key;
+	value v;
+
+	m = concurrent_map_init (sizeof (uint64_t), sizeof (value), hash_u64,
+	                         compare_u64, count_destroy);
+	TEST_ASSERT_MESSAGE (m != NULL, "failed map initialization");
+
+	for (key = 0; key < N_KEYS; key++)
+	{
+		v.round = 0;
+		v.check = key * 3;
+		TEST_ASSERT_MESSAGE (concurrent_map_put (m, &key, &v), "put of new key failed");
+	}
+	TEST_ASSERT_MESSAGE (concurrent_map_size (m) == N_KEYS, "size incorrect after put");
+
+	for (key = 0; key < N_KEYS; key++)
+	{
+		TEST_ASSERT_MESSAGE (concurrent_map_get (m, &key, &v), "stored key missing");
+		TEST_ASSERT_MESSAGE (v.check == key * 3, "wrong value stored");
+	}
+	key = N_KEYS;
+	TEST_ASSERT_MESSAGE (!concurrent_map_get (m, &key, NULL), "absent key found");
+
+	n_destroyed = 0;
+	key = 7;
+	v.check = 99;
+	TEST_ASSERT_MESSAGE (!concurrent_map_put (m, &key, &v), "replace reported an add");
+	TEST_ASSERT_MESSAGE (n_destroyed == 1, "replaced entry not destroyed");
+	concurrent_map_get (m, &key, &v);
+	TEST_ASSERT_MESSAGE (v.check == 99, "replace kept old value");
+
+	for (key = 0; key < N_KEYS; key += 2)
+	{
+		TEST_ASSERT_MESSAGE (concurrent_map_remove (m, &key), "remove failed");
+	}
+	key = 0;
+	TEST_ASSERT_MESSAGE (!concurrent_map_remove (m, &key), "removed twice");
+	TEST_ASSERT_MESSAGE (concurrent_map_size (m) == N_KEYS / 2, "size incorrect after remove");
+
+	/* backward shift deletion must leave every probe run intact */
+	for (key = 0; key < N_KEYS; key++)
+	{
+		TEST_ASSERT_MESSAGE (concurrent_map_get (m, &key, NULL) == (key & 1),
+		                     "wrong keys removed");
+	}
+
+	n_destroyed = 0;
+	concurrent_map_destroy (m);
+	TEST_ASSERT_MESSAGE (n_destroyed == N_KEYS / 2, "destroy missed entries");
+}
+
+static atomic_bool writers_done;
+static bool torn_read;
+
+static void *
+writer (void *arg)
+{
+	uint64_t id = (uintptr_t)arg, round, key;
+	value v;
+
+	/* each writer owns the keys equal to its id modulo N_WRITERS */
+	for (round = 1; round <= N_ROUNDS; round++)
+	{
+		for (key = id; key < N_KEYS; key += N_WRITERS)
+		{
+			v.round = round;
+			v.check = key ^ round;
+			if (round % 4 == 0)
+			{
+				concurrent_map_remove (m, &key);
+			}
+			else
+			{
+				concurrent_map_put (m, &key, &v);
+			}
+		}
+	}
+	return NULL;
+}
+
+static void *
+reader (void *arg)
+{
+	uint64_t key = (uintptr_t)arg;
+	value v;
+
+	while (!atomic_load (&writers_done))
+	{
+		key = (key * 6364136223846793005ULL + 1442695040888963407ULL);
+		if (concurrent_map_get (m, &(uint64_t){ key % N_KEYS }, &v)
+		    && v.check != ((key % N_KEYS) ^ v.round))
+		{
+			torn_read = true;
+		}
+	}
+	return NULL;
+}
+
+static void
+test_concurrent_map_threads (void)
+{
+	pthread_t writers[N_WRITERS], readers[N_READERS];
+	uint64_t key;
+	value v;
+	uintptr_t i;
+
+	m = concurrent_map_init (sizeof (uint64_t), sizeof (value), hash_u64,
+	                         compare_u64, NULL);
+	atomic_init (&writers_done, false);
+
+	for (i = 0; i < N_READERS; i++)
+	{
+		pthread_create (&readers[i], NULL, reader, (void *)(i + 1));
+	}
+	for (i = 0; i < N_WRITERS; i++)
+	{
+		pthread_create (&writers[i], NULL, writer, (void *)i);
+	}
+	for (i = 0; i < N_WRITERS; i++)
+	{
+		pthread_join (writers[i], NULL);
+	}
+	atomic_store (&writers_done, true);
+	for (i = 0; i < N_READERS; i++)
+	{
+		pthread_join (readers[i], NULL);
+	}
+
+	TEST_ASSERT_MESSAGE (!torn_read, "reader saw a half written value");
+	TEST_ASSERT_MESSAGE (concurrent_map_size (m) == N_KEYS, "writers lost entries");
+	for (key = 0; key < N_KEYS; key++)
+	{
+		TEST_ASSERT_MESSAGE (concurrent_map_get (m, &key, &v) && v.round == N_ROUNDS,
+		                     "final value wrong");
+	}
+	concurrent_map_destroy (m);
+}
+
+int
+main(void)
+{
+	UNITY_BEGIN ();
+	RUN_TEST (test_concurrent_map_single_thread);
+	RUN_TEST (test_concurrent_map_threads);
+	return UNITY_END ();
+}
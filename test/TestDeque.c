@@ -0,0 +1,157 @@
+#include "Deque.h"
+#include "unity.h"
+
+static deque *d;
+static unsigned n_destroyed;
+
+static void
+count_destroy (void *addr)
+{
+	++n_destroyed;
+}
+
+static void
+test_deque_init (void)
+{
+	d = deque_init (sizeof (unsigned), 4, count_destroy);
+	TEST_ASSERT_MESSAGE (d != NULL, "failed deque initialization");
+	TEST_ASSERT_MESSAGE (deque_size (d) == 0, "new deque not empty");
+	TEST_ASSERT_MESSAGE (deque_front (d) == NULL, "new deque has a front");
+	TEST_ASSERT_MESSAGE (deque_back (d) == NULL, "new deque has a back");
+}
+
+static void
+test_deque_push_front_large (void)
+{
+	unsigned i;
+	unsigned *ptr;
+
+	/* the reverse fill that costs O(n) per insert in the vector */
+	for (i = 0; i < 10000; i++)
+	{
+		deque_push_front (d, &i);
+	}
+	TEST_ASSERT_MESSAGE (deque_size (d) == 10000, "size incorrect after push front");
+
+	for (i = 0; i < 10000; i++)
+	{
+		ptr = deque_access (d, i);
+		TEST_ASSERT_MESSAGE ((10000 - i - 1) == *ptr, "deque push front fail");
+	}
+}
+
+static void
+test_deque_pop_both_ends (void)
+{
+	unsigned front, back, i;
+
+	for (i = 0; i < 5000; i++)
+	{
+		deque_pop_front (d, &front);
+		deque_pop_back (d, &back);
+		TEST_ASSERT_MESSAGE (front == 10000 - i - 1, "deque pop front fail");
+		TEST_ASSERT_MESSAGE (back == i, "deque pop back fail");
+	}
+	TEST_ASSERT_MESSAGE (deque_size (d) == 0, "deque not empty after pops");
+}
+
+static void
+test_deque_wrap_and_grow (void)
+{
+	unsigned i, out;
+	unsigned *ptr;
+
+	/* walk the head around the buffer so growth has to unwrap it */
+	for (i = 0; i < 1000; i++)
+	{
+		deque_push_back (d, &i);
+		deque_pop_front (d, &out);
+		TEST_ASSERT_MESSAGE (out == i, "deque fifo order fail");
+	}
+
+	for (i = 0; i < 3000; i++)
+	{
+		if (i & 1)
+		{
+			deque_push_back (d, &i);
+		}
+		else
+		{
+			deque_push_front (d, &i);
+		}
+	}
+
+	/* evens descending then odds ascending */
+	for (i = 0; i < 1500; i++)
+	{
+		ptr = deque_access (d, i);
+		TEST_ASSERT_MESSAGE (*ptr == 2998 - 2 * i, "deque wrap fail");
+		ptr = deque_access (d, 1500 + i);
+		TEST_ASSERT_MESSAGE (*ptr == 2 * i + 1, "deque wrap fail");
+	}
+
+	n_destroyed = 0;
+	deque_clear (d);
+	TEST_ASSERT_MESSAGE (n_destroyed == 3000, "clear missed elements");
+}
+
+static void
+test_deque_bulk (void)
+{
+	unsigned in[1000], out[1000], i;
+	unsigned *ptr;
+
+	for (i = 0; i < 1000; i++)
+	{
+		in[i] = i;
+	}
+
+	deque_push_back_many (d, in + 500, 500);
+	deque_push_front_many (d, in, 500);
+	TEST_ASSERT_MESSAGE (deque_size (d) == 1000, "size incorrect after bulk push");
+
+	for (i = 0; i < 1000; i++)
+	{
+		ptr = deque_access (d, i);
+		TEST_ASSERT_MESSAGE (*ptr == i, "deque bulk push fail");
+	}
+
+	deque_pop_back_many (d, out, 300);
+	for (i = 0; i < 300; i++)
+	{
+		TEST_ASSERT_MESSAGE (out[i] == 700 + i, "deque bulk pop back fail");
+	}
+
+	deque_pop_front_many (d, out, 300);
+	for (i = 0; i < 300; i++)
+	{
+		TEST_ASSERT_MESSAGE (out[i] == i, "deque bulk pop front fail");
+	}
+
+	n_destroyed = 0;
+	deque_pop_front_many (d, NULL, 100);
+	TEST_ASSERT_MESSAGE (n_destroyed == 100, "bulk pop did not destroy");
+	TEST_ASSERT_MESSAGE (*(unsigned *)deque_front (d) == 400, "front incorrect");
+	TEST_ASSERT_MESSAGE (*(unsigned *)deque_back (d) == 699, "back incorrect");
+}
+
+static void
+test_deque_destroy (void)
+{
+	n_destroyed = 0;
+	deque_destroy (d);
+	TEST_ASSERT_MESSAGE (n_destroyed == 300, "destroy missed elements");
+}
+
+int
+main(void)
+{
+	UNITY_BEGIN ();
+	RUN_TEST (test_deque_init);
+	RUN_TEST (test_deque_push_front_large);
+	RUN_TEST (test_deque_pop_both_ends);
+	RUN_TEST (test_deque_wrap_and_grow);
+	RUN_TEST (test_deque_bulk);
+	RUN_TEST (test_deque_destroy);
+	return UNITY_END ();
+}
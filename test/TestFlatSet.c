@@ -0,0 +1,203 @@
+#include "FlatSet.h"
+#include "unity.h"
+
+#define N_ELEMS (10000)
+
+typedef struct
+{
+	double weight;
+	unsigned count;
+} row;
+
+static unsigned n_destroyed;
+
+static int
+compare_int (const void *elem1, const void *elem2)
+{
+	const int *ptr1 = elem1;
+	const int *ptr2 = elem2;
+
+	return (*ptr1 > *ptr2) - (*ptr1 < *ptr2);
+}
+
+static void
+count_destroy (void *addr)
+{
+	++n_destroyed;
+}
+
+static void
+check_sorted_unique (flat_set *s)
+{
+	size_t i;
+
+	for (i = 1; i < flat_set_size (s); i++)
+	{
+		TEST_ASSERT_MESSAGE (*(int *)flat_set_at (s, i - 1) < *(int *)flat_set_at (s, i),
+		                     "flat set not sorted and unique");
+	}
+}
+
+static void
+test_flat_set_insert (void)
+{
+	flat_set *s = flat_set_init (sizeof (int), compare_int, NULL);
+	int i, val;
+
+	for (i = 0; i < N_ELEMS; i++)
+	{
+		val = (i * 7919) % N_ELEMS;
+		TEST_ASSERT_MESSAGE (flat_set_insert (s, &val), "insert of new key failed");
+	}
+	val = 5;
+	TEST_ASSERT_MESSAGE (!flat_set_insert (s, &val), "insert of duplicate passed");
+	TEST_ASSERT_MESSAGE (flat_set_size (s) == N_ELEMS, "size incorrect after insert");
+	check_sorted_unique (s);
+
+	TEST_ASSERT_MESSAGE (*(int *)flat_set_find (s, &val) == 5, "find failed");
+	val = N_ELEMS;
+	TEST_ASSERT_MESSAGE (!flat_set_contains (s, &val), "absent key found");
+	flat_set_destroy (s);
+}
+
+static void
+test_flat_set_insert_many (void)
+{
+	flat_set *s = flat_set_init (sizeof (int), compare_int, NULL);
+	int batch[N_ELEMS], i;
+
+	for (i = 0; i < N_ELEMS; i++)
+	{
+		batch[i] = 2 * (rand () % N_ELEMS);
+	}
+	flat_set_insert_many (s, batch, N_ELEMS);
+	check_sorted_unique (s);
+	for (i = 0; i < N_ELEMS; i++)
+	{
+		TEST_ASSERT_MESSAGE (flat_set_contains (s, &batch[i]), "batch element missing");
+	}
+
+	/* a second batch overlapping the first, with duplicates inside it */
+	for (i = 0; i < N_ELEMS; i++)
+	{
+		batch[i] = i % (N_ELEMS / 2);
+	}
+	flat_set_insert_many (s, batch, N_ELEMS);
+	check_sorted_unique (s);
+	for (i = 0; i < N_ELEMS / 2; i++)
+	{
+		TEST_ASSERT_MESSAGE (flat_set_contains (s, &i), "merged element missing");
+	}
+
+	/* a small batch into a large set */
+	batch[0] = -1;
+	batch[1] = 3 * N_ELEMS;
+	TEST_ASSERT_MESSAGE (flat_set_insert_many (s, batch, 2) == 2, "small batch count wrong");
+	TEST_ASSERT_MESSAGE (*(int *)flat_set_at (s, 0) == -1, "small batch head missing");
+	TEST_ASSERT_MESSAGE (*(int *)flat_set_at (s, flat_set_size (s) - 1) == 3 * N_ELEMS,
+	                     "small batch tail missing");
+	flat_set_destroy (s);
+}
+
+static void
+test_flat_set_ranges (void)
+{
+	flat_set *s = flat_set_init (sizeof (int), compare_int, count_destroy);
+	int batch[100], i, from = 20, to = 40;
+	size_t first, last;
+
+	for (i = 0; i < 100; i++)
+	{
+		batch[i] = 2 * i;
+	}
+	flat_set_insert_many (s, batch, 100);
+
+	i = 21;
+	TEST_ASSERT_MESSAGE (flat_set_lower_bound (s, &i) == 11, "lower bound between keys wrong");
+	i = 1000;
+	TEST_ASSERT_MESSAGE (flat_set_lower_bound (s, &i) == 100, "lower bound past end wrong");
+
+	n_destroyed = 0;
+	first = flat_set_lower_bound (s, &from);
+	last = flat_set_lower_bound (s, &to);
+	flat_set_erase_range (s, first, last);
+	TEST_ASSERT_MESSAGE (n_destroyed == 10, "erased range not destroyed");
+	TEST_ASSERT_MESSAGE (flat_set_size (s) == 90, "size incorrect after range erase");
+	TEST_ASSERT_MESSAGE (*(int *)flat_set_at (s, first) == 40, "range erase left a gap");
+
+	TEST_ASSERT_MESSAGE (flat_set_remove (s, &to), "remove failed");
+	TEST_ASSERT_MESSAGE (!flat_set_remove (s, &to), "removed twice");
+	check_sorted_unique (s);
+
+	flat_set_destroy (s);
+	TEST_ASSERT_MESSAGE (n_destroyed == 100, "destroy missed elements");
+}
+
+static void
+test_flat_map (void)
+{
+	flat_map *m = flat_map_init (sizeof (int), sizeof (row), compare_int, NULL);
+	int keys[100], i;
+	row rows[100], *r;
+
+	for (i = 0; i < 100; i++)
+	{
+		keys[i] = 99 - i;
+		rows[i].weight = 0.5 * (99 - i);
+		rows[i].count = 99 - i;
+	}
+	TEST_ASSERT_MESSAGE (flat_map_insert_many (m, keys, rows, 50) == 50, "map batch count wrong");
+	for (i = 50; i < 100; i++)
+	{
+		TEST_ASSERT_MESSAGE (flat_map_insert (m, &keys[i], &rows[i]), "map insert failed");
+	}
+	TEST_ASSERT_MESSAGE (!flat_map_insert (m, &keys[0], &rows[1]), "map insert of duplicate passed");
+	TEST_ASSERT_MESSAGE (flat_map_size (m) == 100, "map size incorrect");
+
+	for (i = 0; i < 100; i++)
+	{
+		TEST_ASSERT_MESSAGE (*(int *)flat_map_key_at (m, i) == i, "map keys out of order");
+		r = flat_map_value_at (m, i);
+		TEST_ASSERT_MESSAGE (r->count == (unsigned)i && r->weight == 0.5 * i, "map value wrong");
+	}
+
+	i = 42;
+	r = flat_map_find (m, &i);
+	r->count = 1000;
+	TEST_ASSERT_MESSAGE (((row *)flat_map_find (m, &i))->count == 1000, "map value not updated in place");
+
+	flat_map_erase_range (m, 0, flat_map_lower_bound (m, &i));
+	TEST_ASSERT_MESSAGE (*(int *)flat_map_key_at (m, 0) == 42, "map range erase wrong");
+	TEST_ASSERT_MESSAGE (flat_map_remove (m, &i), "map remove failed");
+	TEST_ASSERT_MESSAGE (flat_map_find (m, &i) == NULL, "removed key found");
+
+	/* of equal keys in a batch the first is the one added */
+	for (i = 0; i < 100; i++)
+	{
+		keys[i] = 200 + i % 3;
+		rows[i].count = i;
+	}
+	TEST_ASSERT_MESSAGE (flat_map_insert_many (m, keys, rows, 100) == 3, "map batch of duplicates count wrong");
+	for (i = 0; i < 3; i++)
+	{
+		TEST_ASSERT_MESSAGE (((row *)flat_map_find (m, &keys[i]))->count == (unsigned)i, "map batch kept a later duplicate");
+	}
+
+	flat_map_destroy (m);
+}
+
+int
+main(void)
+{
+	time_t t;
+
+	/* Intializes random number generator */
+	srand((unsigned) time(&t));
+
+	UNITY_BEGIN ();
+	RUN_TEST (test_flat_set_insert);
+	RUN_TEST (test_flat_set_insert_many);
+	RUN_TEST (test_flat_set_ranges);
+	RUN_TEST (test_flat_map);
+	return UNITY_END ();
+}
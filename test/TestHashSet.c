@@ -0,0 +1,173 @@
+#include "HashSet.h"
+#include "unity.h"
+
+static hashset *h;
+static unsigned n_destroyed;
+
+static size_t
+hash_unsigned (const void *key)
+{
+	return *(const unsigned *)key;
+}
+
+/* sends every key to the same probe start to exercise long probe runs */
+static size_t
+hash_constant (const void *key)
+{
+	(void) key;
+	return 42;
+}
+
+static int
+compare_unsigned (const void *elem1, const void *elem2)
+{
+	const unsigned *ptr1 = elem1;
+	const unsigned *ptr2 = elem2;
+
+	return (*ptr1 > *ptr2) - (*ptr1 < *ptr2);
+}
+
+static void
+count_destroy (void *addr)
+{
+	(void) addr;
+	++n_destroyed;
+}
+
+static void
+test_hashset_init (void)
+{
+	h = hashset_init (sizeof (unsigned), hash_unsigned, compare_unsigned, count_destroy);
+	TEST_ASSERT_MESSAGE (h != NULL, "failed hashset initialization");
+	TEST_ASSERT_MESSAGE (hashset_is_empty (h), "new hashset not empty");
+}
+
+static void
+test_hashset_add (void)
+{
+	unsigned i;
+
+	for (i = 0; i < 100000; i++)
+	{
+		TEST_ASSERT_MESSAGE (hashset_add (h, &i), "hashset add of new key failed");
+	}
+	TEST_ASSERT_MESSAGE (hashset_size (h) == 100000, "size incorrect after add");
+
+	i = 777;
+	TEST_ASSERT_MESSAGE (!hashset_add (h, &i), "hashset add of duplicate passed");
+
+	for (i = 0; i < 100000; i++)
+	{
+		TEST_ASSERT_MESSAGE (hashset_contains (h, &i), "added key missing");
+	}
+	for (i = 100000; i < 200000; i++)
+	{
+		TEST_ASSERT_MESSAGE (!hashset_contains (h, &i), "absent key found");
+	}
+}
+
+static void
+test_hashset_remove (void)
+{
+	unsigned i;
+
+	n_destroyed = 0;
+	for (i = 0; i < 100000; i += 2)
+	{
+		TEST_ASSERT_MESSAGE (hashset_remove (h, &i), "hashset remove failed");
+	}
+	TEST_ASSERT_MESSAGE (n_destroyed == 50000, "removed keys not destroyed");
+	TEST_ASSERT_MESSAGE (hashset_size (h) == 50000, "size incorrect after remove");
+
+	i = 0;
+	TEST_ASSERT_MESSAGE (!hashset_remove (h, &i), "removed twice");
+
+	for (i = 0; i < 100000; i++)
+	{
+		TEST_ASSERT_MESSAGE (hashset_contains (h, &i) == (i & 1), "wrong keys removed");
+	}
+}
+
+static void
+test_hashset_churn (void)
+{
+	static bool present[5000];
+	size_t capacity;
+	unsigned i, key;
+
+	hashset_clear (h);
+	TEST_ASSERT_MESSAGE (hashset_is_empty (h), "clear left elements");
+
+	/* steady churn must recycle tombstones rather than grow the table */
+	hashset_reserve (h, 5000);
+	capacity = h->capacity;
+	for (i = 0; i < 1000000; i++)
+	{
+		key = (unsigned)(rand () % 5000);
+		if (rand () & 1)
+		{
+			TEST_ASSERT_MESSAGE (hashset_add (h, &key) == !present[key], "add result wrong");
+			present[key] = true;
+		}
+		else
+		{
+			TEST_ASSERT_MESSAGE (hashset_remove (h, &key) == present[key], "remove result wrong");
+			present[key] = false;
+		}
+	}
+	TEST_ASSERT_MESSAGE (h->capacity == capacity, "churn grew the table");
+
+	for (key = 0; key < 5000; key++)
+	{
+		TEST_ASSERT_MESSAGE (hashset_contains (h, &key) == present[key], "hashset churn failed");
+	}
+}
+
+static void
+test_hashset_collisions (void)
+{
+	hashset *c = hashset_init (sizeof (unsigned), hash_constant, compare_unsigned, NULL);
+	unsigned i;
+
+	for (i = 0; i < 1000; i++)
+	{
+		hashset_add (c, &i);
+	}
+	for (i = 0; i < 1000; i += 3)
+	{
+		hashset_remove (c, &i);
+	}
+	for (i = 0; i < 1000; i++)
+	{
+		TEST_ASSERT_MESSAGE (hashset_contains (c, &i) == (i % 3 != 0), "colliding keys lost");
+	}
+	hashset_destroy (c);
+}
+
+static void
+test_hashset_destroy (void)
+{
+	size_t n = hashset_size (h);
+
+	n_destroyed = 0;
+	hashset_destroy (h);
+	TEST_ASSERT_MESSAGE (n_destroyed == n, "destroy missed elements");
+}
+
+int
+main(void)
+{
+	time_t t;
+
+	/* Intializes random number generator */
+	srand((unsigned) time(&t));
+
+	UNITY_BEGIN ();
+	RUN_TEST (test_hashset_init);
+	RUN_TEST (test_hashset_add);
+	RUN_TEST (test_hashset_remove);
+	RUN_TEST (test_hashset_churn);
+	RUN_TEST (test_hashset_collisions);
+	RUN_TEST (test_hashset_destroy);
+	return UNITY_END ();
+}
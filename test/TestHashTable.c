@@ -0,0 +1,156 @@
+#include "HashTable.h"
+#include "List.h"
+#include "unity.h"
+#include <stddef.h>
+
+#define N_NODES (100000)
+
+typedef struct
+{
+	list_elem le;
+	hash_elem he;
+	unsigned id;
+} session;
+
+static hash_table *t;
+static session *nodes;
+static unsigned n_destroyed;
+
+static size_t
+hash_unsigned (const void *key)
+{
+	return *(const unsigned *)key;
+}
+
+static int
+compare_unsigned (const void *elem1, const void *elem2)
+{
+	const unsigned *ptr1 = elem1;
+	const unsigned *ptr2 = elem2;
+
+	return (*ptr1 > *ptr2) - (*ptr1 < *ptr2);
+}
+
+static void
+count_destroy (void *addr)
+{
+	++n_destroyed;
+}
+
+static void
+test_hash_table_init (void)
+{
+	t = hash_table_init (offsetof (session, he), offsetof (session, id),
+	                     hash_unsigned, compare_unsigned, count_destroy);
+	TEST_ASSERT_MESSAGE (t != NULL, "failed hash table initialization");
+	TEST_ASSERT_MESSAGE (hash_table_is_empty (t), "new hash table not empty");
+
+	nodes = calloc (N_NODES, sizeof (session));
+}
+
+static void
+test_hash_table_insert (void)
+{
+	session dup;
+	unsigned i;
+
+	for (i = 0; i < N_NODES; i++)
+	{
+		nodes[i].id = i;
+		TEST_ASSERT_MESSAGE (hash_table_insert (t, &nodes[i]), "insert of new key failed");
+
+		/* lookups must see nodes on both sides of a grow in progress */
+		if (t->old_buckets != NULL)
+		{
+			TEST_ASSERT_MESSAGE (hash_table_find (t, &nodes[i / 2].id) == &nodes[i / 2],
+			                     "lookup during growth failed");
+		}
+	}
+	TEST_ASSERT_MESSAGE (hash_table_size (t) == N_NODES, "size incorrect after insert");
+
+	dup.id = 500;
+	TEST_ASSERT_MESSAGE (!hash_table_insert (t, &dup), "insert of duplicate passed");
+
+	for (i = 0; i < N_NODES; i++)
+	{
+		TEST_ASSERT_MESSAGE (hash_table_find (t, &i) == &nodes[i], "inserted node missing");
+	}
+	i = N_NODES;
+	TEST_ASSERT_MESSAGE (hash_table_find (t, &i) == NULL, "absent key found");
+}
+
+static void
+test_hash_table_remove (void)
+{
+	unsigned i;
+
+	for (i = 0; i < N_NODES; i += 4)
+	{
+		hash_table_remove (t, &nodes[i]);
+	}
+	for (i = 1; i < N_NODES; i += 4)
+	{
+		TEST_ASSERT_MESSAGE (hash_table_remove_key (t, &i) == &nodes[i], "remove by key failed");
+	}
+	i = 0;
+	TEST_ASSERT_MESSAGE (hash_table_remove_key (t, &i) == NULL, "removed twice");
+	TEST_ASSERT_MESSAGE (hash_table_size (t) == N_NODES / 2, "size incorrect after remove");
+
+	for (i = 0; i < N_NODES; i++)
+	{
+		TEST_ASSERT_MESSAGE ((hash_table_find (t, &i) != NULL) == (i % 4 >= 2),
+		                     "wrong nodes removed");
+	}
+
+	/* removed nodes can be linked again */
+	for (i = 0; i < N_NODES; i += 4)
+	{
+		TEST_ASSERT_MESSAGE (hash_table_insert (t, &nodes[i]), "reinsert failed");
+	}
+}
+
+static void
+test_hash_table_with_list (void)
+{
+	list *l = list_init (NULL);
+	session *s;
+	unsigned i, key = 8;
+
+	/* the same nodes can sit in a list while indexed */
+	for (i = 0; i < 16; i++)
+	{
+		if (hash_table_find (t, &nodes[i].id))
+		{
+			list_push_back (l, &nodes[i]);
+		}
+	}
+
+	s = hash_table_find (t, &key);
+	list_remove (l, s);
+	TEST_ASSERT_MESSAGE (hash_table_find (t, &key) == s, "list unlink broke the index");
+
+	list_destroy (l);
+}
+
+static void
+test_hash_table_destroy (void)
+{
+	size_t n = hash_table_size (t);
+
+	n_destroyed = 0;
+	hash_table_destroy (t);
+	TEST_ASSERT_MESSAGE (n_destroyed == n, "destroy missed nodes");
+	free (nodes);
+}
+
+int
+main(void)
+{
+	UNITY_BEGIN ();
+	RUN_TEST (test_hash_table_init);
+	RUN_TEST (test_hash_table_insert);
+	RUN_TEST (test_hash_table_remove);
+	RUN_TEST (test_hash_table_with_list);
+	RUN_TEST (test_hash_table_destroy);
+	return UNITY_END ();
+}
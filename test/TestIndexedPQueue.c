@@ -0,0 +1,133 @@
+#include "IndexedPQueue.h"
+#include "unity.h"
+
+#define N_HANDLES (2000)
+
+static unsigned n_destroyed;
+
+static int
+compare_int (const void *elem1, const void *elem2)
+{
+	const int *ptr1 = elem1;
+	const int *ptr2 = elem2;
+
+	return (*ptr1 > *ptr2) - (*ptr1 < *ptr2);
+}
+
+static void
+count_destroy (void *addr)
+{
+	++n_destroyed;
+}
+
+static void
+test_ipqueue_push_pop (void)
+{
+	ipqueue *q = ipqueue_init (sizeof (int), 2, 0, compare_int, NULL);
+	int val, prev;
+	size_t h;
+
+	/* handles past the hint grow the queue */
+	for (h = 0; h < N_HANDLES; h++)
+	{
+		val = rand () % 1000;
+		ipqueue_push (q, h, &val);
+	}
+	TEST_ASSERT_MESSAGE (ipqueue_size (q) == N_HANDLES, "size incorrect after push");
+	TEST_ASSERT_MESSAGE (ipqueue_contains (q, N_HANDLES - 1), "pushed handle missing");
+	TEST_ASSERT_MESSAGE (!ipqueue_contains (q, N_HANDLES), "absent handle found");
+
+	h = ipqueue_pop (q, &prev);
+	TEST_ASSERT_MESSAGE (!ipqueue_contains (q, h), "popped handle still queued");
+	while (!ipqueue_is_empty (q))
+	{
+		ipqueue_pop (q, &val);
+		TEST_ASSERT_MESSAGE (prev <= val, "ipqueue pop order fail");
+		prev = val;
+	}
+	ipqueue_destroy (q);
+}
+
+static void
+test_ipqueue_change_keys (void)
+{
+	static int ref[N_HANDLES];
+	static bool queued[N_HANDLES];
+	ipqueue *q = ipqueue_init (sizeof (int), 4, N_HANDLES, compare_int, NULL);
+	size_t h, best, i;
+	int val;
+
+	for (i = 0; i < 100000; i++)
+	{
+		h = (size_t)rand () % N_HANDLES;
+		val = rand () % 100000;
+
+		if (!queued[h])
+		{
+			ipqueue_push (q, h, &val);
+			queued[h] = true;
+		}
+		else if (rand () % 8 == 0)
+		{
+			ipqueue_remove (q, h, &val);
+			TEST_ASSERT_MESSAGE (val == ref[h], "removed wrong element");
+			queued[h] = false;
+			continue;
+		}
+		else if (val < ref[h])
+		{
+			ipqueue_decrease_key (q, h, &val);
+		}
+		else
+		{
+			ipqueue_increase_key (q, h, &val);
+		}
+		ref[h] = val;
+		TEST_ASSERT_MESSAGE (*(int *)ipqueue_access (q, h) == val, "key not updated");
+
+		/* the top must match a scan of the reference */
+		best = ipqueue_top (q);
+		for (h = 0; h < N_HANDLES; h++)
+		{
+			TEST_ASSERT_MESSAGE (!queued[h] || ref[h] >= ref[best], "top not smallest");
+		}
+	}
+	ipqueue_destroy (q);
+}
+
+static void
+test_ipqueue_destroy (void)
+{
+	ipqueue *q = ipqueue_init (sizeof (int), 2, 16, compare_int, count_destroy);
+	int i, val = 5;
+
+	for (i = 0; i < 10; i++)
+	{
+		ipqueue_push (q, (size_t)i, &i);
+	}
+
+	n_destroyed = 0;
+	ipqueue_increase_key (q, 0, &val);
+	TEST_ASSERT_MESSAGE (n_destroyed == 1, "replaced key not destroyed");
+	ipqueue_remove (q, 3, NULL);
+	TEST_ASSERT_MESSAGE (n_destroyed == 2, "remove to NULL did not destroy");
+	TEST_ASSERT_MESSAGE (ipqueue_top (q) == 1, "wrong top after changes");
+
+	ipqueue_destroy (q);
+	TEST_ASSERT_MESSAGE (n_destroyed == 11, "destroy missed elements");
+}
+
+int
+main(void)
+{
+	time_t t;
+
+	/* Intializes random number generator */
+	srand((unsigned) time(&t));
+
+	UNITY_BEGIN ();
+	RUN_TEST (test_ipqueue_push_pop);
+	RUN_TEST (test_ipqueue_change_keys);
+	RUN_TEST (test_ipqueue_destroy);
+	return UNITY_END ();
+}
@@ -0,0 +1,179 @@
+#include "LRUCache.h"
+#include "unity.h"
+#include <stddef.h>
+
+static lru_cache *c;
+static unsigned n_destroyed;
+
+typedef struct
+{
+	lru_elem le;
+	unsigned key;
+	unsigned data;
+} my_entry;
+
+static size_t
+hash_unsigned (const void *key)
+{
+	return *(const unsigned *)key;
+}
+
+static int
+compare_unsigned (const void *elem1, const void *elem2)
+{
+	const unsigned *ptr1 = elem1;
+	const unsigned *ptr2 = elem2;
+
+	return (*ptr1 > *ptr2) - (*ptr1 < *ptr2);
+}
+
+static void
+my_entry_destroy (void *addr)
+{
+	++n_destroyed;
+	free (addr);
+}
+
+static my_entry *
+my_entry_new (unsigned key, unsigned data)
+{
+	my_entry *e = malloc (sizeof (my_entry));
+	e->key = key;
+	e->data = data;
+	return e;
+}
+
+static void
+test_lru_cache_init (void)
+{
+	c = lru_cache_init (100, offsetof (my_entry, key), hash_unsigned,
+	                    compare_unsigned, my_entry_destroy);
+	TEST_ASSERT_MESSAGE (c != NULL, "failed lru cache initialization");
+	TEST_ASSERT_MESSAGE (lru_cache_size (c) == 0, "new cache not empty");
+	TEST_ASSERT_MESSAGE (lru_cache_capacity (c) == 100, "capacity incorrect");
+}
+
+static void
+test_lru_cache_insert_get (void)
+{
+	my_entry *e;
+	unsigned i;
+
+	for (i = 0; i < 100; i++)
+	{
+		lru_cache_insert (c, my_entry_new (i, i * 2));
+	}
+	TEST_ASSERT_MESSAGE (lru_cache_size (c) == 100, "size incorrect after insert");
+
+	for (i = 0; i < 100; i++)
+	{
+		e = lru_cache_get (c, &i);
+		TEST_ASSERT_MESSAGE (e != NULL, "cached key not found");
+		TEST_ASSERT_MESSAGE (e->data == i * 2, "incorrect data");
+	}
+
+	i = 100;
+	TEST_ASSERT_MESSAGE (lru_cache_get (c, &i) == NULL, "uncached key found");
+	TEST_ASSERT_MESSAGE (lru_cache_hits (c) == 100, "hit count incorrect");
+	TEST_ASSERT_MESSAGE (lru_cache_misses (c) == 1, "miss count incorrect");
+}
+
+static void
+test_lru_cache_evict (void)
+{
+	unsigned i, key;
+
+	/* the gets above left key 0 least recent, promote it past the others */
+	key = 0;
+	lru_cache_get (c, &key);
+
+	n_destroyed = 0;
+	for (i = 100; i < 110; i++)
+	{
+		lru_cache_insert (c, my_entry_new (i, i * 2));
+	}
+
+	TEST_ASSERT_MESSAGE (lru_cache_size (c) == 100, "cache grew past capacity");
+	TEST_ASSERT_MESSAGE (n_destroyed == 10, "evicted nodes not destroyed");
+	TEST_ASSERT_MESSAGE (lru_cache_get (c, &key) != NULL, "promoted key evicted");
+
+	for (key = 1; key <= 10; key++)
+	{
+		TEST_ASSERT_MESSAGE (lru_cache_get (c, &key) == NULL, "lru key kept");
+	}
+	key = 11;
+	TEST_ASSERT_MESSAGE (lru_cache_get (c, &key) != NULL, "recent key evicted");
+}
+
+static void
+test_lru_cache_replace (void)
+{
+	my_entry *e;
+	unsigned key = 105;
+
+	n_destroyed = 0;
+	lru_cache_insert (c, my_entry_new (key, 0xdeadbeef));
+	TEST_ASSERT_MESSAGE (n_destroyed == 1, "replaced node not destroyed");
+	TEST_ASSERT_MESSAGE (lru_cache_size (c) == 100, "size changed on replace");
+
+	e = lru_cache_get (c, &key);
+	TEST_ASSERT_MESSAGE (e != NULL && e->data == 0xdeadbeef, "replace failed");
+
+	/* reinserting the cached node itself only refreshes it */
+	e->data = 7;
+	lru_cache_insert (c, e);
+	TEST_ASSERT_MESSAGE (n_destroyed == 1, "reinserted node destroyed");
+	TEST_ASSERT_MESSAGE (lru_cache_size (c) == 100, "size changed on reinsert");
+	TEST_ASSERT_MESSAGE (lru_cache_get (c, &key) == e && e->data == 7, "reinsert failed");
+}
+
+static void
+test_lru_cache_remove (void)
+{
+	unsigned key = 105;
+
+	TEST_ASSERT_MESSAGE (lru_cache_remove (c, &key), "remove failed");
+	TEST_ASSERT_MESSAGE (!lru_cache_remove (c, &key), "removed twice");
+	TEST_ASSERT_MESSAGE (lru_cache_size (c) == 99, "size incorrect after remove");
+}
+
+static void
+test_lru_cache_set_capacity (void)
+{
+	unsigned i;
+
+	lru_cache_set_capacity (c, 10);
+	TEST_ASSERT_MESSAGE (lru_cache_size (c) == 10, "shrink did not evict");
+
+	lru_cache_set_capacity (c, 1000);
+	for (i = 1000; i < 2000; i++)
+	{
+		lru_cache_insert (c, my_entry_new (i, i));
+	}
+	TEST_ASSERT_MESSAGE (lru_cache_size (c) == 1000, "grow did not hold nodes");
+
+	i = 1000;
+	TEST_ASSERT_MESSAGE (lru_cache_get (c, &i) != NULL, "key lost on rehash");
+}
+
+static void
+test_lru_cache_destroy (void)
+{
+	n_destroyed = 0;
+	lru_cache_destroy (c);
+	TEST_ASSERT_MESSAGE (n_destroyed == 1000, "destroy missed nodes");
+}
+
+int
+main(void)
+{
+	UNITY_BEGIN ();
+	RUN_TEST (test_lru_cache_init);
+	RUN_TEST (test_lru_cache_insert_get);
+	RUN_TEST (test_lru_cache_evict);
+	RUN_TEST (test_lru_cache_replace);
+	RUN_TEST (test_lru_cache_remove);
+	RUN_TEST (test_lru_cache_set_capacity);
+	RUN_TEST (test_lru_cache_destroy);
+	return UNITY_END ();
+}
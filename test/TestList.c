@@ -102,9 +102,120 @@ test_list_push_back_large (void)
 	}
 }
 
+static void
+test_list_remove (void)
+{
+	my_node *nodes[3], *front, *back;
+	unsigned i;
+
+	for (i = 0; i < 3; i++)
+	{
+		nodes[i] = malloc (sizeof (my_node));
+		nodes[i]->data = i;
+		list_push_back (l, nodes[i]);
+	}
+
+	/* middle, then both ends */
+	list_remove (l, nodes[1]);
+	TEST_ASSERT_MESSAGE (list_size (l) == 2, "size incorrect in list remove");
+	front = list_front (l);
+	back = list_back (l);
+	TEST_ASSERT_MESSAGE (front->data == 0 && back->data == 2, "incorrect data");
+
+	list_remove (l, nodes[0]);
+	front = list_front (l);
+	TEST_ASSERT_MESSAGE (front->data == 2, "incorrect data");
+
+	list_remove (l, nodes[2]);
+	TEST_ASSERT_MESSAGE (list_size (l) == 0, "size incorrect in list remove");
+	TEST_ASSERT_MESSAGE (list_front (l) == NULL, "list not empty");
+	TEST_ASSERT_MESSAGE (list_back (l) == NULL, "list not empty");
+}
+
+static void
+test_list_traverse (void)
+{
+	my_node *to_insert, *cur;
+	unsigned i;
+
+	/* build 0, 2, 4, ... then fill the odd values in with insert after */
+	for (i = 0; i < 100; i += 2)
+	{
+		to_insert = malloc (sizeof (my_node));
+		to_insert->data = i;
+		list_push_back (l, to_insert);
+	}
+
+	for (cur = list_front (l); cur != NULL; cur = list_next (l, cur))
+	{
+		to_insert = malloc (sizeof (my_node));
+		to_insert->data = cur->data + 1;
+		list_insert_after (l, cur, to_insert);
+		cur = to_insert;
+	}
+	TEST_ASSERT_MESSAGE (list_size (l) == 100, "size incorrect in insert after");
+
+	i = 100;
+	for (cur = list_back (l); cur != NULL; cur = list_prev (l, cur))
+	{
+		TEST_ASSERT_MESSAGE (cur->data == --i, "incorrect order in traversal");
+	}
+	TEST_ASSERT_MESSAGE (i == 0, "traversal missed nodes");
+
+	while (list_front (l))
+	{
+		list_pop_front (l);
+	}
+}
+
+static void
+test_list_splice (void)
+{
+	list other;
+	my_node *to_insert, *front;
+	unsigned i;
+
+	list_init_static (&other, my_list_destroy);
+
+	/* splicing an empty list is a no-op */
+	list_splice (l, &other);
+	TEST_ASSERT_MESSAGE (list_size (l) == 0, "size incorrect in list splice");
+
+	for (i = 0; i < 10; i++)
+	{
+		to_insert = malloc (sizeof (my_node));
+		to_insert->data = i;
+		list_push_back ((i < 4) ? l : &other, to_insert);
+	}
+
+	list_splice (l, &other);
+	TEST_ASSERT_MESSAGE (list_size (l) == 10, "size incorrect in list splice");
+	TEST_ASSERT_MESSAGE (list_size (&other) == 0, "spliced list not empty");
+	TEST_ASSERT_MESSAGE (list_front (&other) == NULL, "spliced list not empty");
+
+	for (i = 0; i < 10; i++)
+	{
+		front = list_front (l);
+		TEST_ASSERT_MESSAGE (front->data == i, "order lost in list splice");
+		list_pop_front (l);
+	}
+
+	list_destroy (&other);
+}
+
 static void
 test_list_destroy (void)
 {
+	my_node *to_insert;
+	unsigned i;
+
+	/* destroy must release the nodes still linked */
+	for (i = 0; i < 100; i++)
+	{
+		to_insert = malloc (sizeof (my_node));
+		list_push_back (l, to_insert);
+	}
+
 	list_destroy (l);
 	TEST_ASSERT_MESSAGE (0 == 0, "destroy passes");
 }
@@ -118,6 +229,9 @@ main(void)
 	RUN_TEST (test_list_push_back_one);
 	RUN_TEST (test_list_push_front_large);
 	RUN_TEST (test_list_push_back_large);
+	RUN_TEST (test_list_remove);
+	RUN_TEST (test_list_splice);
+	RUN_TEST (test_list_traverse);
 	RUN_TEST (test_list_destroy);
 	return UNITY_END ();
 }
\ No newline at end of file
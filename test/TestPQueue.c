@@ -0,0 +1,170 @@
+#include "PQueue.h"
+#include "unity.h"
+
+#define N_ELEMS (10000)
+
+static unsigned n_destroyed;
+
+static int
+compare_int (const void *elem1, const void *elem2)
+{
+	const int *ptr1 = elem1;
+	const int *ptr2 = elem2;
+
+	return (*ptr1 > *ptr2) - (*ptr1 < *ptr2);
+}
+
+static void
+count_destroy (void *addr)
+{
+	++n_destroyed;
+}
+
+static void
+check_drains_sorted (pqueue *q, size_t n)
+{
+	int prev, cur;
+	size_t i;
+
+	TEST_ASSERT_MESSAGE (pqueue_size (q) == n, "queue size incorrect");
+	pqueue_pop (q, &prev);
+	for (i = 1; i < n; i++)
+	{
+		pqueue_pop (q, &cur);
+		TEST_ASSERT_MESSAGE (prev <= cur, "pqueue pop order fail");
+		prev = cur;
+	}
+	TEST_ASSERT_MESSAGE (pqueue_is_empty (q), "queue not empty after draining");
+}
+
+static void
+test_pqueue_push_pop (void)
+{
+	size_t arity;
+	int i, val;
+
+	for (arity = 2; arity <= 8; arity *= 2)
+	{
+		pqueue *q = pqueue_init (sizeof (int), arity, compare_int, NULL);
+		TEST_ASSERT_MESSAGE (pqueue_top (q) == NULL, "empty queue has a top");
+
+		for (i = 0; i < N_ELEMS; i++)
+		{
+			val = rand () % 1000;
+			pqueue_push (q, &val);
+			TEST_ASSERT_MESSAGE (*(int *)pqueue_top (q) <= val, "top not smallest");
+		}
+		check_drains_sorted (q, N_ELEMS);
+		pqueue_destroy (q);
+	}
+}
+
+static void
+test_pqueue_heapify (void)
+{
+	vector *v = vector_init (sizeof (int), 0, NULL);
+	pqueue *q;
+	int i, val;
+
+	for (i = 0; i < N_ELEMS; i++)
+	{
+		val = rand ();
+		vector_append (v, &val);
+	}
+
+	q = pqueue_heapify (v, 4, compare_int);
+	check_drains_sorted (q, N_ELEMS);
+	pqueue_destroy (q);
+}
+
+static void
+test_pqueue_heapify_clone (void)
+{
+	vector *v = vector_init (sizeof (int), 0, NULL), *snap;
+	pqueue *q;
+	int i, val;
+
+	for (i = 10; i > 0; i--)
+	{
+		vector_append (v, &i);
+	}
+
+	/* neither building the heap nor popping from it may reach the clone */
+	snap = vector_clone_cow (v);
+	q = pqueue_heapify (v, 2, compare_int);
+	pqueue_pop (q, &val);
+	TEST_ASSERT_MESSAGE (val == 1, "pqueue top wrong");
+	for (i = 0; i < 10; i++)
+	{
+		TEST_ASSERT_MESSAGE (*(int *)vector_access (snap, i) == 10 - i, "pqueue changed a clone");
+	}
+	check_drains_sorted (q, 9);
+	TEST_ASSERT_MESSAGE (vector_size (snap) == 10, "pqueue shrank a clone");
+	pqueue_destroy (q);
+	vector_destroy (snap);
+}
+
+static void
+test_pqueue_many (void)
+{
+	pqueue *q = pqueue_init (sizeof (int), 4, compare_int, NULL);
+	int batch[N_ELEMS], out[N_ELEMS], i;
+
+	for (i = 0; i < N_ELEMS; i++)
+	{
+		batch[i] = N_ELEMS - i;
+	}
+
+	/* a batch into an empty queue is heapified */
+	pqueue_push_many (q, batch, N_ELEMS / 2);
+	/* a smaller batch is sifted up element by element */
+	pqueue_push_many (q, batch + N_ELEMS / 2, 100);
+
+	TEST_ASSERT_MESSAGE (pqueue_pop_many (q, out, 200) == 200, "pop many count wrong");
+	for (i = 0; i < 200; i++)
+	{
+		TEST_ASSERT_MESSAGE (out[i] == N_ELEMS / 2 - 100 + 1 + i, "pop many order fail");
+	}
+
+	TEST_ASSERT_MESSAGE (pqueue_pop_many (q, out, N_ELEMS) == N_ELEMS / 2 + 100 - 200,
+	                     "pop many past the end wrong");
+	TEST_ASSERT_MESSAGE (pqueue_is_empty (q), "queue not empty");
+	pqueue_destroy (q);
+}
+
+static void
+test_pqueue_destroy (void)
+{
+	pqueue *q = pqueue_init (sizeof (int), 2, compare_int, count_destroy);
+	int i;
+
+	for (i = 0; i < 100; i++)
+	{
+		pqueue_push (q, &i);
+	}
+
+	n_destroyed = 0;
+	pqueue_pop (q, NULL);
+	TEST_ASSERT_MESSAGE (n_destroyed == 1, "pop to NULL did not destroy");
+	TEST_ASSERT_MESSAGE (*(int *)pqueue_top (q) == 1, "wrong element popped");
+
+	pqueue_destroy (q);
+	TEST_ASSERT_MESSAGE (n_destroyed == 100, "destroy missed elements");
+}
+
+int
+main(void)
+{
+	time_t t;
+
+	/* Intializes random number generator */
+	srand((unsigned) time(&t));
+
+	UNITY_BEGIN ();
+	RUN_TEST (test_pqueue_push_pop);
+	RUN_TEST (test_pqueue_heapify);
+	RUN_TEST (test_pqueue_heapify_clone);
+	RUN_TEST (test_pqueue_many);
+	RUN_TEST (test_pqueue_destroy);
+	return UNITY_END ();
+}
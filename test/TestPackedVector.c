@@ -0,0 +1,176 @@
+#include "PackedVector.h"
+#include "unity.h"
+#include "TestRng.h"
+#include <string.h>
+
+/* gaps of every kind: runs of repeats, dense runs, small random gaps, the
+ * odd wide gap that becomes an exception, and gaps that force a raw block */
+static uint64_t
+next_gap (size_t i)
+{
+	switch ((i / 1000) % 5)
+	{
+	case 0: return rng_next () % 16;
+	case 1: return 1;
+	case 2: return (rng_next () % 64 == 0) ? rng_next () % 1000000 : rng_next () % 4;
+	case 3: return (i % 7 == 0) ? 0 : rng_next () % 3;
+	default: return (rng_next () % 100 == 0) ? (1ULL << 33) : rng_next () % 100000;
+	}
+}
+
+static uint64_t *
+make_values (size_t n)
+{
+	uint64_t *values = malloc (n * sizeof (uint64_t));
+	uint64_t value = 12345;
+	size_t i;
+
+	for (i = 0; i < n; i++)
+	{
+		value += next_gap (i);
+		values[i] = value;
+	}
+	return values;
+}
+
+static void
+test_packed_vector_append_get (void)
+{
+	packed_vector *pv = packed_vector_init ();
+	size_t n = 20000 + 77, i;
+	uint64_t *values = make_values (n);
+
+	for (i = 0; i < n; i++)
+	{
+		packed_vector_append (pv, values[i]);
+	}
+	TEST_ASSERT_MESSAGE (packed_vector_size (pv) == n, "packed vector size wrong");
+	for (i = 0; i < n; i++)
+	{
+		TEST_ASSERT_MESSAGE (packed_vector_get (pv, i) == values[i], "packed vector get wrong");
+	}
+
+	free (values);
+	packed_vector_destroy (pv);
+}
+
+static void
+test_packed_vector_widths (void)
+{
+	packed_vector *pv;
+	uint64_t values[3 * 128], value;
+	size_t b, i;
+
+	/* blocks of gaps up to b bits for every b from 0 to 32, and past it */
+	for (b = 0; b <= 34; b++)
+	{
+		pv = packed_vector_init ();
+		value = 0;
+		for (i = 0; i < 3 * 128; i++)
+		{
+			value += (b == 0) ? 5 : rng_next () & ((1ULL << b) - 1);
+			values[i] = value;
+			packed_vector_append (pv, value);
+		}
+		for (i = 0; i < 3 * 128; i++)
+		{
+			TEST_ASSERT_MESSAGE (packed_vector_get (pv, i) == values[i], "packed vector width wrong");
+		}
+		packed_vector_destroy (pv);
+	}
+
+	/* a dense run packs to almost nothing */
+	pv = packed_vector_init ();
+	for (i = 0; i < 128 * 1000; i++)
+	{
+		packed_vector_append (pv, 1000000 + i);
+	}
+	TEST_ASSERT_MESSAGE (packed_vector_bytes (pv) < 128 * 1000 / 2, "packed vector dense run too big");
+	for (i = 0; i < 128 * 1000; i += 997)
+	{
+		TEST_ASSERT_MESSAGE (packed_vector_get (pv, i) == 1000000 + i, "packed vector dense run wrong");
+	}
+	packed_vector_destroy (pv);
+}
+
+static void
+test_packed_vector_search (void)
+{
+	packed_vector *pv = packed_vector_init ();
+	size_t n = 10000 + 50, i, index, expect;
+	uint64_t *values = make_values (n), probe;
+	bool found;
+
+	TEST_ASSERT_MESSAGE (!packed_vector_search (pv, 7, &index) && index == 0, "empty search wrong");
+	for (i = 0; i < n; i++)
+	{
+		packed_vector_append (pv, values[i]);
+	}
+
+	for (i = 0; i < n; i++)
+	{
+		found = packed_vector_search (pv, values[i], &index);
+		TEST_ASSERT_MESSAGE (found, "packed vector search missed a value");
+		TEST_ASSERT_MESSAGE (index == 0 || values[index - 1] < values[i], "packed vector search not first");
+		TEST_ASSERT_MESSAGE (values[index] == values[i], "packed vector search wrong index");
+
+		/* one above each value, found only when it is the next value */
+		probe = values[i] + 1;
+		expect = i + 1;
+		while (expect < n && values[expect] < probe)
+		{
+			expect++;
+		}
+		found = packed_vector_search (pv, probe, &index);
+		TEST_ASSERT_MESSAGE (index == expect, "packed vector lower bound wrong");
+		TEST_ASSERT_MESSAGE (found == (expect < n && values[expect] == probe), "packed vector found wrong");
+	}
+	TEST_ASSERT_MESSAGE (!packed_vector_search (pv, 0, &index) && index == 0, "search below first wrong");
+	TEST_ASSERT_MESSAGE (!packed_vector_search (pv, UINT64_MAX, &index) && index == n, "search above last wrong");
+
+	free (values);
+	packed_vector_destroy (pv);
+}
+
+static void
+test_packed_vector_iter (void)
+{
+	packed_vector *pv = packed_vector_init ();
+	size_t n = 5000 + 3, starts[] = { 0, 1, 127, 128, 4991, 4992, 5000, 5003 }, s, i, run;
+	uint64_t *values = make_values (n);
+	const uint64_t *out;
+	packed_vector_iter it;
+
+	for (i = 0; i < n; i++)
+	{
+		packed_vector_append (pv, values[i]);
+	}
+	for (s = 0; s < sizeof (starts) / sizeof (starts[0]); s++)
+	{
+		i = starts[s];
+		packed_vector_iter_init (pv, &it, i);
+		while ((run = packed_vector_iter_next (&it, &out)) > 0)
+		{
+			TEST_ASSERT_MESSAGE (i + run <= n, "packed vector iter ran past the end");
+			TEST_ASSERT_MESSAGE (memcmp (out, values + i, run * sizeof (uint64_t)) == 0,
+			                     "packed vector iter wrong values");
+			i += run;
+		}
+		TEST_ASSERT_MESSAGE (i == n, "packed vector iter stopped early");
+		TEST_ASSERT_MESSAGE (packed_vector_iter_next (&it, &out) == 0, "packed vector iter restarted");
+	}
+
+	free (values);
+	packed_vector_destroy (pv);
+}
+
+int
+main(void)
+{
+	UNITY_BEGIN ();
+	RUN_TEST (test_packed_vector_append_get);
+	RUN_TEST (test_packed_vector_widths);
+	RUN_TEST (test_packed_vector_search);
+	RUN_TEST (test_packed_vector_iter);
+	return UNITY_END ();
+}
@@ -0,0 +1,245 @@
+#include "RingBuffer.h"
+#include "unity.h"
+#include <pthread.h>
+
+#define N_HANDOFF   (200000UL)
+#define N_THREADS   (4)
+
+static unsigned n_destroyed;
+
+typedef struct
+{
+	uint32_t producer;
+	uint32_t seq;
+} record;
+
+static void
+count_destroy (void *addr)
+{
+	++n_destroyed;
+}
+
+static void
+test_spsc_ring_single_thread (void)
+{
+	spsc_ring *r = spsc_ring_init (sizeof (unsigned), 100, count_destroy);
+	unsigned i, out, batch[300];
+
+	/* capacity rounds up to 128 */
+	for (i = 0; i < 128; i++)
+	{
+		TEST_ASSERT_MESSAGE (spsc_ring_enqueue (r, &i), "enqueue into free ring failed");
+	}
+	TEST_ASSERT_MESSAGE (!spsc_ring_enqueue (r, &i), "enqueue into full ring passed");
+	TEST_ASSERT_MESSAGE (spsc_ring_size (r) == 128, "size incorrect when full");
+
+	for (i = 0; i < 100; i++)
+	{
+		TEST_ASSERT_MESSAGE (spsc_ring_dequeue (r, &out), "dequeue failed");
+		TEST_ASSERT_MESSAGE (out == i, "spsc ring order fail");
+	}
+
+	/* a batch that wraps and is cut short by the free space */
+	for (i = 0; i < 300; i++)
+	{
+		batch[i] = 1000 + i;
+	}
+	TEST_ASSERT_MESSAGE (spsc_ring_enqueue_many (r, batch, 300) == 100, "batch enqueue count wrong");
+
+	TEST_ASSERT_MESSAGE (spsc_ring_dequeue_many (r, batch, 300) == 128, "batch dequeue count wrong");
+	for (i = 0; i < 28; i++)
+	{
+		TEST_ASSERT_MESSAGE (batch[i] == 100 + i, "spsc batch order fail");
+	}
+	for (i = 0; i < 100; i++)
+	{
+		TEST_ASSERT_MESSAGE (batch[28 + i] == 1000 + i, "spsc batch order fail");
+	}
+	TEST_ASSERT_MESSAGE (!spsc_ring_dequeue (r, &out), "dequeue from empty ring passed");
+
+	spsc_ring_enqueue_many (r, batch, 5);
+	n_destroyed = 0;
+	spsc_ring_destroy (r);
+	TEST_ASSERT_MESSAGE (n_destroyed == 5, "destroy missed elements");
+}
+
+static void
+test_mpmc_ring_single_thread (void)
+{
+	mpmc_ring *r = mpmc_ring_init (sizeof (unsigned), 64, count_destroy);
+	unsigned i, out, batch[100];
+
+	for (i = 0; i < 64; i++)
+	{
+		TEST_ASSERT_MESSAGE (mpmc_ring_enqueue (r, &i), "enqueue into free ring failed");
+	}
+	TEST_ASSERT_MESSAGE (!mpmc_ring_enqueue (r, &i), "enqueue into full ring passed");
+
+	for (i = 0; i < 40; i++)
+	{
+		TEST_ASSERT_MESSAGE (mpmc_ring_dequeue (r, &out), "dequeue failed");
+		TEST_ASSERT_MESSAGE (out == i, "mpmc ring order fail");
+	}
+
+	for (i = 0; i < 100; i++)
+	{
+		batch[i] = 1000 + i;
+	}
+	TEST_ASSERT_MESSAGE (mpmc_ring_enqueue_many (r, batch, 100) == 40, "batch enqueue count wrong");
+	TEST_ASSERT_MESSAGE (mpmc_ring_size (r) == 64, "size incorrect when full");
+
+	TEST_ASSERT_MESSAGE (mpmc_ring_dequeue_many (r, batch, 100) == 64, "batch dequeue count wrong");
+	for (i = 0; i < 24; i++)
+	{
+		TEST_ASSERT_MESSAGE (batch[i] == 40 + i, "mpmc batch order fail");
+	}
+	for (i = 0; i < 40; i++)
+	{
+		TEST_ASSERT_MESSAGE (batch[24 + i] == 1000 + i, "mpmc batch order fail");
+	}
+	TEST_ASSERT_MESSAGE (!mpmc_ring_dequeue (r, &out), "dequeue from empty ring passed");
+
+	mpmc_ring_enqueue_many (r, batch, 7);
+	n_destroyed = 0;
+	mpmc_ring_destroy (r);
+	TEST_ASSERT_MESSAGE (n_destroyed == 7, "destroy missed elements");
+}
+
+static void *
+spsc_producer (void *arg)
+{
+	spsc_ring *r = arg;
+	record rec = { 0, 0 };
+
+	while (rec.seq < N_HANDOFF)
+	{
+		if (spsc_ring_enqueue (r, &rec))
+		{
+			++rec.seq;
+		}
+		else
+		{
+			sched_yield ();
+		}
+	}
+	return NULL;
+}
+
+static void
+test_spsc_ring_threads (void)
+{
+	spsc_ring *r = spsc_ring_init (sizeof (record), 256, NULL);
+	pthread_t producer;
+	record batch[32];
+	uint32_t expected = 0;
+	size_t n, i;
+	bool in_order = true;
+
+	pthread_create (&producer, NULL, spsc_producer, r);
+
+	while (expected < N_HANDOFF)
+	{
+		n = spsc_ring_dequeue_many (r, batch, 32);
+		if (n == 0)
+		{
+			sched_yield ();
+		}
+		for (i = 0; i < n; i++)
+		{
+			in_order &= (batch[i].seq == expected++);
+		}
+	}
+
+	pthread_join (producer, NULL);
+	TEST_ASSERT_MESSAGE (in_order, "spsc handoff lost or reordered records");
+	spsc_ring_destroy (r);
+}
+
+static mpmc_ring *shared;
+static atomic_size_t n_consumed;
+static uint32_t last_seen[N_THREADS][N_THREADS];
+static bool mpmc_in_order = true;
+
+static void *
+mpmc_producer (void *arg)
+{
+	record rec = { (uint32_t)(uintptr_t)arg, 0 };
+
+	while (rec.seq < N_HANDOFF)
+	{
+		if (mpmc_ring_enqueue (shared, &rec))
+		{
+			++rec.seq;
+		}
+		else
+		{
+			sched_yield ();
+		}
+	}
+	return NULL;
+}
+
+static void *
+mpmc_consumer (void *arg)
+{
+	size_t me = (uintptr_t)arg, n, i;
+	record batch[8];
+
+	while (atomic_load (&n_consumed) < N_HANDOFF * N_THREADS)
+	{
+		n = mpmc_ring_dequeue_many (shared, batch, 8);
+		if (n == 0)
+		{
+			sched_yield ();
+		}
+		for (i = 0; i < n; i++)
+		{
+			/* each consumer sees any one producer's records in order */
+			if (batch[i].seq + 1 <= last_seen[me][batch[i].producer])
+			{
+				mpmc_in_order = false;
+			}
+			last_seen[me][batch[i].producer] = batch[i].seq + 1;
+		}
+		atomic_fetch_add (&n_consumed, n);
+	}
+	return NULL;
+}
+
+static void
+test_mpmc_ring_threads (void)
+{
+	pthread_t producers[N_THREADS], consumers[N_THREADS];
+	uintptr_t i;
+
+	shared = mpmc_ring_init (sizeof (record), 128, NULL);
+	atomic_init (&n_consumed, 0);
+
+	for (i = 0; i < N_THREADS; i++)
+	{
+		pthread_create (&consumers[i], NULL, mpmc_consumer, (void *)i);
+		pthread_create (&producers[i], NULL, mpmc_producer, (void *)i);
+	}
+	for (i = 0; i < N_THREADS; i++)
+	{
+		pthread_join (producers[i], NULL);
+		pthread_join (consumers[i], NULL);
+	}
+
+	TEST_ASSERT_MESSAGE (atomic_load (&n_consumed) == N_HANDOFF * N_THREADS,
+	                     "mpmc handoff lost or duplicated records");
+	TEST_ASSERT_MESSAGE (mpmc_in_order, "mpmc handoff reordered a producer");
+	TEST_ASSERT_MESSAGE (mpmc_ring_size (shared) == 0, "mpmc ring not drained");
+	mpmc_ring_destroy (shared);
+}
+
+int
+main(void)
+{
+	UNITY_BEGIN ();
+	RUN_TEST (test_spsc_ring_single_thread);
+	RUN_TEST (test_mpmc_ring_single_thread);
+	RUN_TEST (test_spsc_ring_threads);
+	RUN_TEST (test_mpmc_ring_threads);
+	return UNITY_END ();
+}
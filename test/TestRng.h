@@ -0,0 +1,26 @@
+/**
+ * File: TestRng.h
+ * ------------------------------------------------------
+ * The xorshift generator for tests that need 64 bit random values, which
+ * rand () does not give, from a fixed seed so that a failure repeats.
+ */
+
+#ifndef TEST_RNG_H
+#define TEST_RNG_H
+
+#include <stdint.h>
+
+#define RNG_SEED (0x2545f4914f6cdd1dULL)
+
+static uint64_t rng_state = RNG_SEED;
+
+static inline uint64_t
+rng_next (void)
+{
+	rng_state ^= rng_state << 13;
+	rng_state ^= rng_state >> 7;
+	rng_state ^= rng_state << 17;
+	return rng_state;
+}
+
+#endif /* TEST_RNG_H */
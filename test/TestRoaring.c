@@ -0,0 +1,373 @@
+#include "Roaring.h"
+#include "unity.h"
+#include "TestRng.h"
+#include <string.h>
+#include <unistd.h>
+
+#define N_IDS (16 * 65536)
+
+/* checks a bitmap against a byte per id below N_IDS: membership, the count,
+ * and the iterator's order */
+static void
+check_matches (const roaring *r, const uint8_t *bytes)
+{
+	size_t i, n = 0;
+	uint32_t id;
+	roaring_iter it;
+
+	for (i = 0; i < N_IDS; i++)
+	{
+		TEST_ASSERT_MESSAGE (roaring_contains (r, (uint32_t)i) == bytes[i], "roaring contains wrong");
+		n += bytes[i];
+	}
+	TEST_ASSERT_MESSAGE (roaring_cardinality (r) == n, "roaring cardinality wrong");
+
+	roaring_iter_init (r, &it);
+	for (i = 0; i < N_IDS; i++)
+	{
+		if (bytes[i])
+		{
+			TEST_ASSERT_MESSAGE (roaring_iter_next (&it, &id) && id == i, "roaring iter wrong id");
+		}
+	}
+	TEST_ASSERT_MESSAGE (!roaring_iter_next (&it, &id), "roaring iter ran past the end");
+}
+
+/* fills a bitmap chunk by chunk in one of five ways: empty, sparse, dense,
+ * ranges, or nearly whole, so every container type and pair turns up */
+static roaring *
+make_roaring (uint8_t *bytes)
+{
+	roaring *r = roaring_init ();
+	uint32_t chunk, base, i, first, len;
+
+	memset (bytes, 0, N_IDS);
+	for (chunk = 0; chunk < N_IDS / 65536; chunk++)
+	{
+		base = chunk * 65536;
+		switch (rng_next () % 5)
+		{
+		case 0:
+			break;
+		case 1:
+		case 2:
+			for (i = 0; i < 65536; i++)
+			{
+				if (rng_next () % ((chunk % 2) ? 64 : 2) == 0)
+				{
+					bytes[base + i] = 1;
+					roaring_add (r, base + i);
+				}
+			}
+			break;
+		case 3:
+			for (first = (uint32_t)(rng_next () % 500); first < 65536; first += len + 1 + (uint32_t)(rng_next () % 3000))
+			{
+				len = (uint32_t)(rng_next () % 2000);
+				len = (first + len < 65536) ? len : 65535 - first;
+				roaring_add_range (r, base + first, base + first + len);
+				memset (bytes + base + first, 1, len + 1);
+			}
+			break;
+		default:
+			roaring_add_range (r, base + 3, base + 65535);
+			memset (bytes + base + 3, 1, 65533);
+			break;
+		}
+	}
+	return r;
+}
+
+static void
+test_roaring_add_remove (void)
+{
+	uint8_t *bytes = calloc (N_IDS, 1);
+	roaring *r = roaring_init ();
+	uint32_t i, id;
+
+	TEST_ASSERT_MESSAGE (roaring_cardinality (r) == 0 && !roaring_contains (r, 0), "new roaring not empty");
+
+	/* an array fills to ROARING_ARRAY_MAX, turns into a bitmap past it and
+	 * back into an array below it */
+	for (i = 0; i < ROARING_ARRAY_MAX; i++)
+	{
+		TEST_ASSERT_MESSAGE (roaring_add (r, 65536 + 7 * i), "roaring add of a new id failed");
+	}
+	TEST_ASSERT_MESSAGE (!roaring_add (r, 65536), "roaring add of a present id succeeded");
+	TEST_ASSERT_MESSAGE (r->containers[0].type == ROARING_ARRAY, "roaring array turned early");
+	roaring_add (r, 65536 + 1);
+	TEST_ASSERT_MESSAGE (r->containers[0].type == ROARING_BITMAP, "roaring array did not turn to a bitmap");
+	TEST_ASSERT_MESSAGE (roaring_remove (r, 65536) && !roaring_remove (r, 65536), "roaring remove wrong");
+	TEST_ASSERT_MESSAGE (r->containers[0].type == ROARING_ARRAY, "roaring bitmap did not turn to an array");
+	roaring_destroy (r);
+
+	/* random adds and removes against a byte per id */
+	r = roaring_init ();
+	for (i = 0; i < 400000; i++)
+	{
+		id = (uint32_t)(rng_next () % ((i % 2) ? N_IDS : 4 * 65536));
+		TEST_ASSERT_MESSAGE (roaring_add (r, id) == !bytes[id], "roaring add result wrong");
+		bytes[id] = 1;
+	}
+	check_matches (r, bytes);
+	for (i = 0; i < 600000; i++)
+	{
+		id = (uint32_t)(rng_next () % N_IDS);
+		TEST_ASSERT_MESSAGE (roaring_remove (r, id) == bytes[id], "roaring remove result wrong");
+		bytes[id] = 0;
+	}
+	check_matches (r, bytes);
+
+	/* emptied containers go */
+	for (i = 0; i < N_IDS; i++)
+	{
+		roaring_remove (r, i);
+	}
+	TEST_ASSERT_MESSAGE (r->n_containers == 0, "roaring kept empty containers");
+	TEST_ASSERT_MESSAGE (roaring_add (r, UINT32_MAX) && roaring_contains (r, UINT32_MAX), "roaring top id wrong");
+	roaring_destroy (r);
+	free (bytes);
+}
+
+static void
+test_roaring_runs (void)
+{
+	uint8_t *bytes = calloc (N_IDS, 1);
+	roaring *r = roaring_init ();
+	uint32_t i, ids[] = { 99, 200, 201, 300, 2999, 65535, 65536, 100000 };
+
+	/* a range over three chunks makes three single runs */
+	roaring_add_range (r, 60000, 140000);
+	memset (bytes + 60000, 1, 80001);
+	TEST_ASSERT_MESSAGE (r->n_containers == 3 && r->containers[1].type == ROARING_RUN &&
+	                     r->containers[1].n == 1 && r->containers[1].card == 65536, "roaring range wrong");
+	check_matches (r, bytes);
+
+	/* splitting, trimming, joining and filling gaps between runs */
+	roaring_add_range (r, 100, 3000);
+	memset (bytes + 100, 1, 2901);
+	for (i = 0; i < sizeof (ids) / sizeof (ids[0]); i++)
+	{
+		TEST_ASSERT_MESSAGE (roaring_remove (r, ids[i]) == bytes[ids[i]], "roaring run remove wrong");
+		bytes[ids[i]] = 0;
+	}
+	TEST_ASSERT_MESSAGE (r->containers[0].type == ROARING_RUN && r->containers[0].n == 5, "roaring run split wrong");
+	check_matches (r, bytes);
+	for (i = 0; i < sizeof (ids) / sizeof (ids[0]); i++)
+	{
+		TEST_ASSERT_MESSAGE (roaring_add (r, ids[i]) != bytes[ids[i]], "roaring run add wrong");
+		bytes[ids[i]] = 1;
+	}
+	TEST_ASSERT_MESSAGE (r->containers[0].n == 2 && r->containers[1].n == 1, "roaring runs not joined");
+	check_matches (r, bytes);
+
+	/* every other id splits a run apart until a bitmap is smaller */
+	for (i = 65536 + 1; i < 2 * 65536; i += 2)
+	{
+		roaring_remove (r, i);
+		bytes[i] = 0;
+	}
+	TEST_ASSERT_MESSAGE (r->containers[1].type == ROARING_BITMAP, "roaring split runs not turned to a bitmap");
+	check_matches (r, bytes);
+	roaring_destroy (r);
+
+	/* optimizing makes runs of long stretches and undoes runs of scattered ids */
+	r = roaring_init ();
+	memset (bytes, 0, N_IDS);
+	for (i = 0; i < 30000; i++)
+	{
+		roaring_add (r, i);
+		roaring_add (r, 65536 + i * 2);
+		bytes[i] = bytes[65536 + i * 2] = 1;
+	}
+	roaring_add_range (r, 3 * 65536, 3 * 65536 + 5);
+	memset (bytes + 3 * 65536, 1, 6);
+	for (i = 3 * 65536 + 10; i < 3 * 65536 + 60; i += 2)
+	{
+		roaring_add (r, i);
+		bytes[i] = 1;
+	}
+	roaring_optimize (r);
+	TEST_ASSERT_MESSAGE (r->containers[0].type == ROARING_RUN, "roaring optimize missed a run");
+	TEST_ASSERT_MESSAGE (r->containers[1].type == ROARING_BITMAP, "roaring optimize changed a bitmap");
+	TEST_ASSERT_MESSAGE (r->containers[2].type == ROARING_ARRAY, "roaring optimize kept scattered runs");
+	TEST_ASSERT_MESSAGE (roaring_bytes (r) < 2 * 8192, "roaring bytes too high");
+	check_matches (r, bytes);
+	roaring_destroy (r);
+	free (bytes);
+}
+
+static void
+test_roaring_union_intersect (void)
+{
+	uint8_t *a_bytes = malloc (N_IDS), *b_bytes = malloc (N_IDS), *expect = malloc (N_IDS);
+	roaring *a, *b, *u, *x, *empty = roaring_init ();
+	size_t round, i;
+
+	for (round = 0; round < 8; round++)
+	{
+		a = make_roaring (a_bytes);
+		b = make_roaring (b_bytes);
+		if (round % 2)
+		{
+			roaring_optimize (a);
+		}
+
+		u = roaring_union (a, b);
+		for (i = 0; i < N_IDS; i++)
+		{
+			expect[i] = a_bytes[i] | b_bytes[i];
+		}
+		check_matches (u, expect);
+
+		x = roaring_intersect (a, b);
+		for (i = 0; i < N_IDS; i++)
+		{
+			expect[i] = a_bytes[i] & b_bytes[i];
+		}
+		check_matches (x, expect);
+		for (i = 0; i < x->n_containers; i++)
+		{
+			TEST_ASSERT_MESSAGE (x->containers[i].card > 0, "roaring intersect kept an empty container");
+			TEST_ASSERT_MESSAGE ((x->containers[i].type == ROARING_BITMAP) == (x->containers[i].card > ROARING_ARRAY_MAX) ||
+			                     x->containers[i].type == ROARING_RUN, "roaring intersect container wrong type");
+		}
+		roaring_destroy (u);
+		roaring_destroy (x);
+
+		/* with an empty bitmap, and with itself */
+		u = roaring_union (a, empty);
+		check_matches (u, a_bytes);
+		roaring_destroy (u);
+		x = roaring_intersect (empty, a);
+		TEST_ASSERT_MESSAGE (roaring_cardinality (x) == 0 && x->n_containers == 0, "roaring intersect with empty wrong");
+		roaring_destroy (x);
+		x = roaring_intersect (a, a);
+		check_matches (x, a_bytes);
+		roaring_destroy (x);
+
+		roaring_destroy (a);
+		roaring_destroy (b);
+	}
+	roaring_destroy (empty);
+	free (a_bytes);
+	free (b_bytes);
+	free (expect);
+}
+
+static void
+test_roaring_write_read (void)
+{
+	char path[] = "/tmp/TestRoaringXXXXXX";
+	uint8_t *bytes = malloc (N_IDS), flip;
+	roaring *r = make_roaring (bytes), *empty = roaring_init (), *back;
+	int fd = mkstemp (path);
+	off_t off;
+
+	TEST_ASSERT_MESSAGE (fd >= 0, "roaring temp file failed");
+	unlink (path);
+	roaring_optimize (r);
+
+	/* two streams back to back, each read exactly */
+	TEST_ASSERT_MESSAGE (roaring_write (r, fd) && roaring_write (empty, fd), "roaring write failed");
+	lseek (fd, 0, SEEK_SET);
+	back = roaring_read (fd);
+	TEST_ASSERT_MESSAGE (back != NULL && back->n_containers == r->n_containers, "roaring read failed");
+	check_matches (back, bytes);
+	roaring_destroy (back);
+	back = roaring_read (fd);
+	TEST_ASSERT_MESSAGE (back != NULL && roaring_cardinality (back) == 0, "roaring read of empty failed");
+	roaring_destroy (back);
+	TEST_ASSERT_MESSAGE (roaring_read (fd) == NULL, "roaring read past the end succeeded");
+
+	/* a flipped bit in the data fails the checksum */
+	off = lseek (fd, 0, SEEK_END);
+	pread (fd, &flip, 1, off / 2);
+	flip ^= 0x10;
+	pwrite (fd, &flip, 1, off / 2);
+	lseek (fd, 0, SEEK_SET);
+	TEST_ASSERT_MESSAGE (roaring_read (fd) == NULL, "roaring read accepted a corrupt stream");
+
+	/* a short file ends early */
+	flip ^= 0x10;
+	pwrite (fd, &flip, 1, off / 2);
+	TEST_ASSERT_MESSAGE (ftruncate (fd, off / 3) == 0, "roaring truncate failed");
+	lseek (fd, 0, SEEK_SET);
+	TEST_ASSERT_MESSAGE (roaring_read (fd) == NULL, "roaring read accepted a short stream");
+
+	close (fd);
+	roaring_destroy (r);
+	roaring_destroy (empty);
+	free (bytes);
+}
+
+static void
+test_roaring_vector (void)
+{
+	uint32_t unsorted[] = { 70000, 3, 64, 3, 0, UINT32_MAX, 65536 };
+	uint32_t sorted[] = { 0, 3, 64, 65536, 70000, UINT32_MAX };
+	vector *v = vector_init (sizeof (uint32_t), 0, NULL), *back;
+	uint8_t *bytes = calloc (N_IDS, 1);
+	roaring *r;
+	uint32_t i, id;
+
+	for (i = 0; i < sizeof (unsorted) / sizeof (unsorted[0]); i++)
+	{
+		vector_append (v, &unsorted[i]);
+	}
+	r = roaring_from_vector (v);
+	back = roaring_to_vector (r);
+	TEST_ASSERT_MESSAGE (vector_size (back) == 6 && memcmp (vector_access (back, 0), sorted, sizeof (sorted)) == 0,
+	                     "roaring unsorted vector round trip wrong");
+	roaring_destroy (r);
+	vector_destroy (back);
+
+	/* sorted with repeats, one chunk with more than an array's worth of
+	 * entries but few enough distinct ids for one, and one dense chunk */
+	vector_clear (v);
+	for (i = 0; i < 3 * 65536; i++)
+	{
+		id = (i < 65536) ? i / 20 : (i < 2 * 65536) ? 65536 + (i - 65536) / 3 : i;
+		if (i < 2 * 65536 || rng_next () % 2)
+		{
+			vector_append (v, &id);
+			bytes[id] = 1;
+		}
+	}
+	r = roaring_from_vector (v);
+	TEST_ASSERT_MESSAGE (r->containers[0].type == ROARING_ARRAY && r->containers[1].type == ROARING_BITMAP,
+	                     "roaring sorted vector containers wrong");
+	check_matches (r, bytes);
+
+	back = roaring_to_vector (r);
+	TEST_ASSERT_MESSAGE (vector_size (back) == roaring_cardinality (r), "roaring to vector wrong size");
+	for (i = 0; i < vector_size (back); i++)
+	{
+		memcpy (&id, vector_access (back, (int)i), sizeof (id));
+		TEST_ASSERT_MESSAGE (bytes[id] && (i == 0 || id > *(uint32_t *)vector_access (back, (int)i - 1)),
+		                     "roaring to vector wrong ids");
+	}
+	roaring_destroy (r);
+	vector_destroy (back);
+
+	vector_clear (v);
+	r = roaring_from_vector (v);
+	back = roaring_to_vector (r);
+	TEST_ASSERT_MESSAGE (roaring_cardinality (r) == 0 && vector_size (back) == 0, "roaring empty vector wrong");
+	roaring_destroy (r);
+	vector_destroy (back);
+	vector_destroy (v);
+	free (bytes);
+}
+
+int
+main(void)
+{
+	UNITY_BEGIN ();
+	RUN_TEST (test_roaring_add_remove);
+	RUN_TEST (test_roaring_runs);
+	RUN_TEST (test_roaring_union_intersect);
+	RUN_TEST (test_roaring_write_read);
+	RUN_TEST (test_roaring_vector);
+	return UNITY_END ();
+}
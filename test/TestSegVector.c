@@ -0,0 +1,145 @@
+#include "SegVector.h"
+#include "unity.h"
+
+static unsigned n_destroyed;
+
+static void
+count_destroy (void *addr)
+{
+	++n_destroyed;
+}
+
+static void
+test_seg_vector_append_access (void)
+{
+	seg_vector *sv = seg_vector_init (sizeof (size_t), 0, NULL);
+	size_t i, *ptr;
+
+	for (i = 0; i < 100000; i++)
+	{
+		ptr = seg_vector_append (sv, &i);
+		TEST_ASSERT_MESSAGE (*ptr == i, "seg vector append returned wrong slot");
+	}
+
+	TEST_ASSERT_MESSAGE (seg_vector_size (sv) == 100000, "seg vector size wrong");
+	for (i = 0; i < 100000; i++)
+	{
+		ptr = seg_vector_access (sv, i);
+		TEST_ASSERT_MESSAGE (*ptr == i, "seg vector access wrong");
+	}
+
+	seg_vector_destroy (sv);
+}
+
+static void
+test_seg_vector_stable_addresses (void)
+{
+	seg_vector *sv = seg_vector_init (sizeof (unsigned), 0, NULL);
+	unsigned *first, *hundredth, i;
+
+	for (i = 0; i < 100; i++)
+	{
+		seg_vector_append (sv, &i);
+	}
+	first = seg_vector_access (sv, 0);
+	hundredth = seg_vector_access (sv, 99);
+
+	/* grow through many chunks; earlier elements must not move */
+	for (i = 100; i < 200000; i++)
+	{
+		seg_vector_append (sv, &i);
+	}
+
+	TEST_ASSERT_MESSAGE (first == seg_vector_access (sv, 0), "seg vector moved an element");
+	TEST_ASSERT_MESSAGE (hundredth == seg_vector_access (sv, 99), "seg vector moved an element");
+	TEST_ASSERT_MESSAGE (*first == 0 && *hundredth == 99, "seg vector element changed");
+
+	seg_vector_destroy (sv);
+}
+
+static void
+test_seg_vector_span (void)
+{
+	seg_vector *sv = seg_vector_init (sizeof (unsigned), 1000, NULL);
+	unsigned i, *run;
+	size_t n_run, k, idx = 0, n_spans = 0;
+
+	for (i = 0; i < 5000; i++)
+	{
+		seg_vector_append (sv, &i);
+	}
+
+	/* the spans cover every element once, in order */
+	while (idx < seg_vector_size (sv))
+	{
+		run = seg_vector_span (sv, idx, &n_run);
+		TEST_ASSERT_MESSAGE (n_run > 0, "seg vector span empty");
+		for (k = 0; k < n_run; k++)
+		{
+			TEST_ASSERT_MESSAGE (run[k] == idx + k, "seg vector span wrong");
+		}
+		idx += n_run;
+		n_spans++;
+	}
+	TEST_ASSERT_MESSAGE (idx == 5000, "seg vector spans overran");
+	TEST_ASSERT_MESSAGE (n_spans < 12, "seg vector chunks not doubling");
+
+	/* a span starting mid chunk runs to the end of that chunk */
+	run = seg_vector_span (sv, 17, &n_run);
+	TEST_ASSERT_MESSAGE (*run == 17 && n_run == 31, "seg vector mid chunk span wrong");
+
+	seg_vector_destroy (sv);
+}
+
+static void
+test_seg_vector_replace_remove (void)
+{
+	seg_vector *sv = seg_vector_init (sizeof (unsigned), 0, count_destroy);
+	unsigned i, val = 0xdeadbeef;
+
+	n_destroyed = 0;
+	for (i = 0; i < 1000; i++)
+	{
+		seg_vector_append (sv, &i);
+	}
+
+	seg_vector_replace (sv, &val, 500);
+	TEST_ASSERT_MESSAGE (*(unsigned *)seg_vector_access (sv, 500) == val, "seg vector replace failed");
+	TEST_ASSERT_MESSAGE (n_destroyed == 1, "seg vector replace did not destroy");
+
+	for (i = 0; i < 10; i++)
+	{
+		seg_vector_remove_last (sv);
+	}
+	TEST_ASSERT_MESSAGE (seg_vector_size (sv) == 990, "seg vector remove last failed");
+	TEST_ASSERT_MESSAGE (*(unsigned *)seg_vector_access (sv, 989) == 989, "seg vector remove last wrong");
+	TEST_ASSERT_MESSAGE (n_destroyed == 11, "seg vector remove last did not destroy");
+
+	/* refill after clear reuses the chunks */
+	seg_vector_clear (sv);
+	TEST_ASSERT_MESSAGE (n_destroyed == 1001, "seg vector clear did not destroy");
+	for (i = 0; i < 100; i++)
+	{
+		seg_vector_append (sv, &i);
+	}
+	TEST_ASSERT_MESSAGE (*(unsigned *)seg_vector_access (sv, 99) == 99, "seg vector refill failed");
+
+	seg_vector_destroy (sv);
+	TEST_ASSERT_MESSAGE (n_destroyed == 1101, "seg vector destroy did not destroy");
+}
+
+int
+main (void)
+{
+	time_t t;
+
+	/* Intializes random number generator */
+	srand ((unsigned) time (&t));
+
+	UNITY_BEGIN ();
+	RUN_TEST (test_seg_vector_append_access);
+	RUN_TEST (test_seg_vector_stable_addresses);
+	RUN_TEST (test_seg_vector_span);
+	RUN_TEST (test_seg_vector_replace_remove);
+	return UNITY_END ();
+}
@@ -1,9 +1,318 @@
 #include "Set.h"
 #include "unity.h"
+#include <stdlib.h>
+#include <unistd.h>
 
-int 
+static set *s;
+static unsigned n_destroyed;
+
+static int
+compare_unsigned (const void *elem1, const void *elem2)
+{
+	const unsigned *ptr1 = elem1;
+	const unsigned *ptr2 = elem2;
+
+	return (*ptr1 > *ptr2) - (*ptr1 < *ptr2);
+}
+
+static int
+compare_reversed (const void *elem1, const void *elem2)
+{
+	return compare_unsigned (elem2, elem1);
+}
+
+static void
+count_destroy (void *addr)
+{
+	++n_destroyed;
+}
+
+/**
+ * Returns the black height of the subtree, or -1 if it breaks the red-black
+ * or ordering rules.
+ */
+static int
+black_height (const set_elem *se, const unsigned *lo, const unsigned *hi)
+{
+	int left, right;
+	const unsigned *val;
+
+	if (se == NULL)
+	{
+		return 1;
+	}
+
+	val = (const unsigned *)se->data;
+	if ((lo && *val <= *lo) || (hi && *val >= *hi))
+	{
+		return -1;
+	}
+	if (se->is_red && ((se->links[0] && se->links[0]->is_red)
+	                   || (se->links[1] && se->links[1]->is_red)))
+	{
+		return -1;
+	}
+
+	left = black_height (se->links[0], lo, val);
+	right = black_height (se->links[1], val, hi);
+	if (left < 0 || right < 0 || left != right)
+	{
+		return -1;
+	}
+
+	return left + !se->is_red;
+}
+
+static void
+test_set_init (void)
+{
+	s = set_init (sizeof (unsigned), compare_unsigned, count_destroy);
+	TEST_ASSERT_MESSAGE (s != NULL, "failed set initialization");
+	TEST_ASSERT_MESSAGE (set_is_empty (s), "new set not empty");
+}
+
+static void
+test_set_add (void)
+{
+	unsigned i;
+
+	for (i = 0; i < 10000; i++)
+	{
+		TEST_ASSERT_MESSAGE (set_add (s, &i), "set add of new key failed");
+	}
+	TEST_ASSERT_MESSAGE (set_size (s) == 10000, "size incorrect after add");
+
+	i = 500;
+	TEST_ASSERT_MESSAGE (!set_add (s, &i), "set add of duplicate passed");
+	TEST_ASSERT_MESSAGE (set_size (s) == 10000, "duplicate changed size");
+
+	for (i = 0; i < 10000; i++)
+	{
+		TEST_ASSERT_MESSAGE (set_contains (s, &i), "added key missing");
+	}
+	i = 10000;
+	TEST_ASSERT_MESSAGE (!set_contains (s, &i), "absent key found");
+	TEST_ASSERT_MESSAGE (black_height (s->root, NULL, NULL) > 0, "tree unbalanced");
+}
+
+static void
+test_set_remove (void)
+{
+	unsigned i;
+
+	n_destroyed = 0;
+	for (i = 0; i < 10000; i += 2)
+	{
+		TEST_ASSERT_MESSAGE (set_remove (s, &i), "set remove failed");
+	}
+	TEST_ASSERT_MESSAGE (n_destroyed == 5000, "removed keys not destroyed");
+	TEST_ASSERT_MESSAGE (set_size (s) == 5000, "size incorrect after remove");
+
+	i = 0;
+	TEST_ASSERT_MESSAGE (!set_remove (s, &i), "removed twice");
+
+	for (i = 0; i < 10000; i++)
+	{
+		TEST_ASSERT_MESSAGE (set_contains (s, &i) == (i & 1), "wrong keys removed");
+	}
+	TEST_ASSERT_MESSAGE (black_height (s->root, NULL, NULL) > 0, "tree unbalanced");
+}
+
+static void
+test_set_random (void)
+{
+	static bool present[1000];
+	unsigned i, key;
+
+	for (i = 1; i < 10000; i += 2)
+	{
+		set_remove (s, &i);
+	}
+
+	for (i = 0; i < 100000; i++)
+	{
+		key = (unsigned)(rand () % 1000);
+		if (rand () & 1)
+		{
+			TEST_ASSERT_MESSAGE (set_add (s, &key) == !present[key], "add result wrong");
+			present[key] = true;
+		}
+		else
+		{
+			TEST_ASSERT_MESSAGE (set_remove (s, &key) == present[key], "remove result wrong");
+			present[key] = false;
+		}
+	}
+
+	for (key = 0; key < 1000; key++)
+	{
+		TEST_ASSERT_MESSAGE (set_contains (s, &key) == present[key], "set random ops failed");
+	}
+	TEST_ASSERT_MESSAGE (black_height (s->root, NULL, NULL) > 0, "tree unbalanced");
+}
+
+static bool
+set_matches (const set *a, const set *b)
+{
+	unsigned key;
+
+	for (key = 0; key < 1000; key++)
+	{
+		if (set_contains (a, &key) != set_contains (b, &key))
+		{
+			return false;
+		}
+	}
+	return set_size (a) == set_size (b);
+}
+
+static void
+test_set_write_read (void)
+{
+	char path[] = "/tmp/TestSetXXXXXX";
+	int fd = mkstemp (path);
+	set *big, *back;
+	unsigned i, j, key;
+	uint8_t flip;
+	off_t off;
+
+	TEST_ASSERT_MESSAGE (fd >= 0, "could not create temporary file");
+
+	/* every size up to a few levels, checked for balance */
+	for (i = 0; i < 70; i++)
+	{
+		big = set_init (sizeof (unsigned), compare_unsigned, NULL);
+		for (j = 0; j < i; j++)
+		{
+			key = j * 3;
+			set_add (big, &key);
+		}
+		ftruncate (fd, 0);
+		lseek (fd, 0, SEEK_SET);
+		TEST_ASSERT_MESSAGE (set_write (big, fd), "set write failed");
+		lseek (fd, 0, SEEK_SET);
+		back = set_read (fd, compare_unsigned, NULL);
+		TEST_ASSERT_MESSAGE (back != NULL && set_size (back) == i, "set read failed");
+		TEST_ASSERT_MESSAGE (black_height (back->root, NULL, NULL) > 0, "set read tree unbalanced");
+		for (j = 0; j < 3 * i; j++)
+		{
+			TEST_ASSERT_MESSAGE (set_contains (back, &j) == (j % 3 == 0), "set read wrong keys");
+		}
+		set_destroy (big);
+		set_destroy (back);
+	}
+
+	/* the set left by the random test, then one spanning several chunks */
+	big = set_init (sizeof (unsigned), compare_unsigned, NULL);
+	for (i = 0; i < 1000000; i++)
+	{
+		set_add (big, &i);
+	}
+	ftruncate (fd, 0);
+	lseek (fd, 0, SEEK_SET);
+	TEST_ASSERT_MESSAGE (set_write (s, fd) && set_write (big, fd), "set write failed");
+
+	lseek (fd, 0, SEEK_SET);
+	back = set_read (fd, compare_unsigned, count_destroy);
+	TEST_ASSERT_MESSAGE (back != NULL && set_matches (s, back), "set read differs");
+	n_destroyed = 0;
+	set_destroy (back);
+	TEST_ASSERT_MESSAGE (n_destroyed == set_size (s), "set read lost the destroy function");
+
+	off = lseek (fd, 0, SEEK_CUR);
+	back = set_read (fd, compare_unsigned, NULL);
+	TEST_ASSERT_MESSAGE (back != NULL && set_size (back) == 1000000, "set read of large set failed");
+	TEST_ASSERT_MESSAGE (black_height (back->root, NULL, NULL) > 0, "set read tree unbalanced");
+	for (i = 0; i < 1000000; i += 997)
+	{
+		TEST_ASSERT_MESSAGE (set_contains (back, &i), "set read of large set lost keys");
+	}
+	set_destroy (back);
+
+	/* reading under the reverse order finds the elements out of order */
+	lseek (fd, off, SEEK_SET);
+	TEST_ASSERT_MESSAGE (set_read (fd, compare_reversed, NULL) == NULL, "set read accepted elements out of order");
+
+	/* a flipped bit in the third chunk fails the checksum */
+	pread (fd, &flip, 1, off + 3000000);
+	flip ^= 0x01;
+	pwrite (fd, &flip, 1, off + 3000000);
+	lseek (fd, off, SEEK_SET);
+	TEST_ASSERT_MESSAGE (set_read (fd, compare_unsigned, NULL) == NULL, "set read accepted a corrupt stream");
+
+	set_destroy (big);
+	close (fd);
+	unlink (path);
+}
+
+static size_t
+hash_unsigned (const void *key)
+{
+	return *(const unsigned *)key;
+}
+
+static void
+test_set_filter (void)
+{
+	set *f = set_init (sizeof (unsigned), compare_unsigned, NULL);
+	unsigned i;
+
+	for (i = 0; i < 100; i++)
+	{
+		set_add (f, &i);
+	}
+	set_use_filter (f, hash_unsigned, 0.01);
+	TEST_ASSERT_MESSAGE (f->filter != NULL && f->filter->n_added == 100, "set filter not built from the elements");
+
+	/* adding past the filter's capacity rebuilds it with room to spare */
+	for (i = 100; i < 5000; i++)
+	{
+		set_add (f, &i);
+	}
+	TEST_ASSERT_MESSAGE (f->filter->capacity >= 5000 && f->filter->n_added <= f->filter->capacity,
+	                     "set filter not rebuilt");
+	for (i = 0; i < 5000; i += 3)
+	{
+		set_remove (f, &i);
+	}
+	for (i = 0; i < 20000; i++)
+	{
+		TEST_ASSERT_MESSAGE (set_contains (f, &i) == (i < 5000 && i % 3 != 0), "set with filter wrong");
+	}
+
+	set_use_filter (f, NULL, 0);
+	TEST_ASSERT_MESSAGE (f->filter == NULL, "set filter not removed");
+	i = 1;
+	TEST_ASSERT_MESSAGE (set_contains (f, &i), "set without filter wrong");
+	set_use_filter (f, hash_unsigned, 0.001);
+	set_destroy (f);
+}
+
+static void
+test_set_destroy (void)
+{
+	size_t n = set_size (s);
+
+	n_destroyed = 0;
+	set_destroy (s);
+	TEST_ASSERT_MESSAGE (n_destroyed == n, "destroy missed elements");
+}
+
+int
 main(void)
 {
+	time_t t;
+
+	/* Intializes random number generator */
+	srand((unsigned) time(&t));
+
 	UNITY_BEGIN ();
+	RUN_TEST (test_set_init);
+	RUN_TEST (test_set_add);
+	RUN_TEST (test_set_remove);
+	RUN_TEST (test_set_random);
+	RUN_TEST (test_set_write_read);
+	RUN_TEST (test_set_filter);
+	RUN_TEST (test_set_destroy);
 	return UNITY_END ();
-}
\ No newline at end of file
+}
@@ -0,0 +1,176 @@
+#include "TimerWheel.h"
+#include "unity.h"
+
+static timer_wheel *tw;
+static unsigned n_fired, n_late, n_destroyed;
+
+typedef struct
+{
+	timer_elem te;
+	unsigned rearm;
+} my_timer;
+
+static void
+my_timer_fire (void *timer)
+{
+	my_timer *t = timer;
+
+	++n_fired;
+	if (t->te.expires != timer_wheel_now (tw))
+	{
+		++n_late;
+	}
+
+	if (t->rearm)
+	{
+		--t->rearm;
+		timer_add (tw, t, timer_wheel_now (tw) + 1000);
+	}
+}
+
+static void
+my_timer_destroy (void *addr)
+{
+	++n_destroyed;
+}
+
+static void
+test_timer_wheel_init (void)
+{
+	tw = timer_wheel_init (5, my_timer_fire, my_timer_destroy);
+	TEST_ASSERT_MESSAGE (tw != NULL, "failed timer wheel initialization");
+	TEST_ASSERT_MESSAGE (timer_wheel_size (tw) == 0, "new wheel not empty");
+	TEST_ASSERT_MESSAGE (timer_wheel_now (tw) == 5, "start tick incorrect");
+}
+
+static void
+test_timer_fire_on_time (void)
+{
+	static my_timer timers[2000];
+	uint64_t start = timer_wheel_now (tw);
+	unsigned i;
+
+	/* spread over every level, both in and out of tick order */
+	for (i = 0; i < 2000; i++)
+	{
+		timer_init (&timers[i]);
+		timers[i].rearm = 0;
+		timer_add (tw, &timers[i], start + 1 + ((uint64_t)i * 7919 * 7919) % 20000000);
+	}
+	TEST_ASSERT_MESSAGE (timer_wheel_size (tw) == 2000, "size incorrect after add");
+
+	n_fired = n_late = 0;
+	timer_advance (tw, start + 10000000);
+	timer_advance (tw, start + 20000000);
+
+	TEST_ASSERT_MESSAGE (n_fired == 2000, "not every timer fired");
+	TEST_ASSERT_MESSAGE (n_late == 0, "timer fired on the wrong tick");
+	TEST_ASSERT_MESSAGE (timer_wheel_size (tw) == 0, "fired timers still pending");
+	TEST_ASSERT_MESSAGE (!timer_pending (&timers[0]), "fired timer pending");
+}
+
+static void
+test_timer_cancel (void)
+{
+	my_timer a, b;
+	uint64_t now = timer_wheel_now (tw);
+
+	timer_init (&a);
+	timer_init (&b);
+	a.rearm = b.rearm = 0;
+
+	TEST_ASSERT_MESSAGE (!timer_cancel (tw, &a), "cancelled idle timer");
+
+	timer_add (tw, &a, now + 300);
+	timer_add (tw, &b, now + 300);
+	TEST_ASSERT_MESSAGE (timer_pending (&a), "armed timer not pending");
+	TEST_ASSERT_MESSAGE (timer_cancel (tw, &a), "cancel of armed timer failed");
+	TEST_ASSERT_MESSAGE (!timer_pending (&a), "cancelled timer pending");
+
+	n_fired = 0;
+	TEST_ASSERT_MESSAGE (timer_advance (tw, now + 1000) == 1, "advance count wrong");
+	TEST_ASSERT_MESSAGE (n_fired == 1, "cancelled timer fired");
+}
+
+static void
+test_timer_rearm (void)
+{
+	my_timer a;
+	uint64_t now = timer_wheel_now (tw);
+
+	timer_init (&a);
+	a.rearm = 0;
+
+	/* re-arming a pending timer moves it rather than adding it twice */
+	timer_add (tw, &a, now + 10);
+	timer_add (tw, &a, now + 70000);
+	TEST_ASSERT_MESSAGE (timer_wheel_size (tw) == 1, "re-arm duplicated timer");
+
+	n_fired = n_late = 0;
+	timer_advance (tw, now + 69999);
+	TEST_ASSERT_MESSAGE (n_fired == 0, "re-armed timer fired early");
+	timer_advance (tw, now + 70000);
+	TEST_ASSERT_MESSAGE (n_fired == 1 && n_late == 0, "re-armed timer missed");
+
+	/* re-arming from the fire callback */
+	a.rearm = 3;
+	timer_add (tw, &a, now + 70001);
+	n_fired = n_late = 0;
+	timer_advance (tw, now + 100000);
+	TEST_ASSERT_MESSAGE (n_fired == 4 && n_late == 0, "callback re-arm failed");
+}
+
+static void
+test_timer_expired_and_far (void)
+{
+	my_timer past, far;
+	uint64_t now = timer_wheel_now (tw);
+
+	timer_init (&past);
+	timer_init (&far);
+	past.rearm = far.rearm = 0;
+
+	/* past expiries fire on the next advance */
+	n_fired = 0;
+	timer_add (tw, &past, now - 3);
+	timer_advance (tw, now + 1);
+	TEST_ASSERT_MESSAGE (n_fired == 1, "expired timer did not fire");
+
+	/* beyond the range of the wheel */
+	n_fired = n_late = 0;
+	timer_add (tw, &far, now + (1ULL << 33) + 12345);
+	timer_advance (tw, now + (1ULL << 33));
+	TEST_ASSERT_MESSAGE (n_fired == 0, "far timer fired early");
+	timer_advance (tw, now + (1ULL << 34));
+	TEST_ASSERT_MESSAGE (n_fired == 1 && n_late == 0, "far timer missed");
+}
+
+static void
+test_timer_wheel_destroy (void)
+{
+	static my_timer timers[10];
+	unsigned i;
+
+	for (i = 0; i < 10; i++)
+	{
+		timer_init (&timers[i]);
+		timer_add (tw, &timers[i], timer_wheel_now (tw) + i * 1000);
+	}
+
+	n_destroyed = 0;
+	timer_wheel_destroy (tw);
+	TEST_ASSERT_MESSAGE (n_destroyed == 10, "destroy missed pending timers");
+}
+
+int
+main(void)
+{
+	UNITY_BEGIN ();
+	RUN_TEST (test_timer_wheel_init);
+	RUN_TEST (test_timer_fire_on_time);
+	RUN_TEST (test_timer_cancel);
+	RUN_TEST (test_timer_rearm);
+	RUN_TEST (test_timer_expired_and_far);
+	RUN_TEST (test_timer_wheel_destroy);
+	return UNITY_END ();
+}
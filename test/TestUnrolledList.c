@@ -0,0 +1,198 @@
+#include "UnrolledList.h"
+#include "unity.h"
+#include <string.h>
+
+#define REF_MAX 5000
+
+static unrolled_list *ul;
+static unsigned ref[REF_MAX];
+static size_t n_ref;
+static unsigned n_destroyed;
+
+static void
+count_destroy (void *addr)
+{
+	++n_destroyed;
+}
+
+static bool
+matches_reference (void)
+{
+	size_t i;
+	unsigned *ptr;
+
+	if (unrolled_list_size (ul) != n_ref)
+	{
+		return false;
+	}
+
+	for (i = 0; i < n_ref; i++)
+	{
+		ptr = unrolled_list_access (ul, i);
+		if (*ptr != ref[i])
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static void
+test_unrolled_list_init (void)
+{
+	ul = unrolled_list_init (sizeof (unsigned), 8, 0, count_destroy);
+	TEST_ASSERT_MESSAGE (ul != NULL, "failed unrolled list initialization");
+	TEST_ASSERT_MESSAGE (unrolled_list_size (ul) == 0, "new list not empty");
+}
+
+static void
+test_unrolled_list_append (void)
+{
+	unsigned i;
+
+	for (i = 0; i < 1000; i++)
+	{
+		unrolled_list_append (ul, &i);
+		ref[n_ref++] = i;
+	}
+	TEST_ASSERT_MESSAGE (matches_reference (), "unrolled list append failed");
+}
+
+static void
+test_unrolled_list_insert_front (void)
+{
+	unsigned i;
+
+	unrolled_list_clear (ul);
+	n_ref = 0;
+
+	for (i = 0; i < 1000; i++)
+	{
+		unrolled_list_insert (ul, &i, 0);
+		memmove (ref + 1, ref, n_ref * sizeof (unsigned));
+		ref[0] = i;
+		++n_ref;
+	}
+	TEST_ASSERT_MESSAGE (matches_reference (), "unrolled list front insert failed");
+}
+
+static void
+test_unrolled_list_random_ops (void)
+{
+	unsigned i, val;
+	size_t index;
+
+	/* mixed inserts and removes at random positions against an array */
+	for (i = 0; i < 20000; i++)
+	{
+		if (n_ref == 0 || (n_ref < REF_MAX && rand () % 3 != 0))
+		{
+			index = (size_t)rand () % (n_ref + 1);
+			val = (unsigned)rand ();
+			unrolled_list_insert (ul, &val, index);
+			memmove (ref + index + 1, ref + index, (n_ref - index) * sizeof (unsigned));
+			ref[index] = val;
+			++n_ref;
+		}
+		else
+		{
+			index = (size_t)rand () % n_ref;
+			unrolled_list_remove (ul, index);
+			memmove (ref + index, ref + index + 1, (n_ref - index - 1) * sizeof (unsigned));
+			--n_ref;
+		}
+	}
+	TEST_ASSERT_MESSAGE (matches_reference (), "unrolled list random ops failed");
+}
+
+static void
+test_unrolled_list_remove_all (void)
+{
+	n_destroyed = 0;
+	while (n_ref > 0)
+	{
+		unrolled_list_remove (ul, (n_ref - 1) / 2);
+		memmove (ref + (n_ref - 1) / 2, ref + (n_ref - 1) / 2 + 1,
+		         (n_ref - (n_ref - 1) / 2 - 1) * sizeof (unsigned));
+		--n_ref;
+	}
+	TEST_ASSERT_MESSAGE (matches_reference (), "unrolled list remove failed");
+	TEST_ASSERT_MESSAGE (n_destroyed > 0, "removed elements not destroyed");
+}
+
+static void
+test_unrolled_list_replace (void)
+{
+	unsigned i, data = 0xdeadbeef;
+	unsigned *ptr;
+
+	for (i = 0; i < 100; i++)
+	{
+		unrolled_list_append (ul, &i);
+	}
+
+	n_destroyed = 0;
+	for (i = 0; i < 100; i++)
+	{
+		unrolled_list_replace (ul, &data, i);
+	}
+	TEST_ASSERT_MESSAGE (n_destroyed == 100, "replaced elements not destroyed");
+
+	for (i = 0; i < 100; i++)
+	{
+		ptr = unrolled_list_access (ul, i);
+		TEST_ASSERT_MESSAGE (*ptr == data, "unrolled list replace failed");
+	}
+}
+
+static void
+test_unrolled_list_fill (void)
+{
+	unrolled_list *packed = unrolled_list_init (sizeof (unsigned), 8, 0.75, NULL);
+	unrolled_list_node *node;
+	unsigned i;
+
+	/* splits keep 6 of 8 in the first node, and no node but the last drops below 2 */
+	for (i = 0; i < 1000; i++)
+	{
+		unrolled_list_insert (packed, &i, (size_t)rand () % (i + 1));
+	}
+	for (i = 0; i < 900; i++)
+	{
+		unrolled_list_remove (packed, (size_t)rand () % unrolled_list_size (packed));
+	}
+	for (node = packed->head; node != NULL && node->next != NULL; node = node->next)
+	{
+		TEST_ASSERT_MESSAGE (node->n_elems >= 2 && node->n_elems <= 8, "node fill out of range");
+	}
+	TEST_ASSERT_MESSAGE (unrolled_list_size (packed) == 100, "fill list size wrong");
+	unrolled_list_destroy (packed);
+}
+
+static void
+test_unrolled_list_destroy (void)
+{
+	n_destroyed = 0;
+	unrolled_list_destroy (ul);
+	TEST_ASSERT_MESSAGE (n_destroyed == 100, "destroy missed elements");
+}
+
+int
+main(void)
+{
+	time_t t;
+
+	/* Intializes random number generator */
+	srand((unsigned) time(&t));
+
+	UNITY_BEGIN ();
+	RUN_TEST (test_unrolled_list_init);
+	RUN_TEST (test_unrolled_list_append);
+	RUN_TEST (test_unrolled_list_insert_front);
+	RUN_TEST (test_unrolled_list_random_ops);
+	RUN_TEST (test_unrolled_list_remove_all);
+	RUN_TEST (test_unrolled_list_replace);
+	RUN_TEST (test_unrolled_list_fill);
+	RUN_TEST (test_unrolled_list_destroy);
+	return UNITY_END ();
+}
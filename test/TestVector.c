@@ -1,5 +1,12 @@
 #include "Vector.h"
 #include "unity.h"
+#include <string.h>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+#endif
 
 static vector *v;
 
@@ -190,6 +197,196 @@ test_vector_sort (void)
 
 }
 
+static void
+test_vector_unique (void)
+{
+	unsigned i, *cur, *prev;
+	vector *w;
+
+	vector_init_random (v, 1000, 100);
+	vector_sort (v, compare_unsigned);
+	w = vector_init (sizeof (unsigned), 0, NULL);
+	for (i = 0; i < vector_size (v); i++)
+	{
+		vector_append (w, vector_access (v, i));
+	}
+
+	/* the generic and the integer kernel must agree */
+	TEST_ASSERT_MESSAGE (vector_unique (v, compare_unsigned) == vector_unique (w, vector_compare_u32),
+	                     "vector unique kernels removed different counts");
+	TEST_ASSERT_MESSAGE (vector_size (v) == vector_size (w) && vector_size (v) <= 100,
+	                     "vector unique left duplicates");
+	for (i = 1; i < vector_size (v); i++)
+	{
+		prev = vector_access (v, i - 1);
+		cur = vector_access (v, i);
+		TEST_ASSERT_MESSAGE (*prev < *cur, "vector unique left duplicates");
+		TEST_ASSERT_MESSAGE (*cur == *(unsigned *)vector_access (w, i), "vector unique kernels differ");
+	}
+
+	vector_destroy (w);
+}
+
+#define SET_DOMAIN (4096)
+
+/**
+ * Fills a sorted, duplicate free vector from a random subset of the domain
+ * where roughly one value in every per_member is present.
+ */
+static void
+vector_init_subset (vector *s, bool *present, unsigned per_member)
+{
+	uint32_t i;
+	uint64_t wide;
+
+	vector_clear (s);
+	for (i = 0; i < SET_DOMAIN; i++)
+	{
+		present[i] = (rand () % per_member == 0);
+		if (present[i])
+		{
+			wide = i;
+			if (s->elem_sz == sizeof (uint64_t))
+			{
+				vector_append (s, &wide);
+			}
+			else
+			{
+				vector_append (s, &i);
+			}
+		}
+	}
+}
+
+static void
+check_set_result (vector *out, size_t n_appended, const bool *expect, const char *msg)
+{
+	size_t i, k = 0;
+	uint64_t val;
+
+	TEST_ASSERT_MESSAGE (n_appended == vector_size (out), msg);
+	for (i = 0; i < SET_DOMAIN; i++)
+	{
+		if (!expect[i])
+		{
+			continue;
+		}
+		TEST_ASSERT_MESSAGE (k < vector_size (out), msg);
+		val = (out->elem_sz == sizeof (uint64_t)) ? *(uint64_t *)vector_access (out, k)
+		                                          : *(uint32_t *)vector_access (out, k);
+		TEST_ASSERT_MESSAGE (val == i, msg);
+		k++;
+	}
+	TEST_ASSERT_MESSAGE (k == vector_size (out), msg);
+}
+
+/**
+ * Runs every set operation on random subsets and checks it against the
+ * membership arrays. The density pairs cover balanced inputs, which take the
+ * linear and block kernels, and skewed ones, which gallop.
+ */
+static void
+check_set_ops (size_t elem_sz, compare_fn fn)
+{
+	static const unsigned densities[][2] = { {2, 2}, {3, 5}, {1, 1}, {1, 200}, {300, 1} };
+	bool in_a[SET_DOMAIN], in_b[SET_DOMAIN], expect[SET_DOMAIN];
+	vector *a = vector_init (elem_sz, 0, NULL);
+	vector *b = vector_init (elem_sz, 0, NULL);
+	vector *out = vector_init (elem_sz, 0, NULL);
+	size_t d, i, n, n_a, n_common;
+
+	for (d = 0; d < sizeof (densities) / sizeof (densities[0]); d++)
+	{
+		vector_init_subset (a, in_a, densities[d][0]);
+		vector_init_subset (b, in_b, densities[d][1]);
+
+		vector_clear (out);
+		for (i = 0; i < SET_DOMAIN; i++)
+		{
+			expect[i] = in_a[i] || in_b[i];
+		}
+		check_set_result (out, vector_union_sorted (out, a, b, fn), expect, "vector union failed");
+
+		vector_clear (out);
+		for (i = 0; i < SET_DOMAIN; i++)
+		{
+			expect[i] = in_a[i] && in_b[i];
+		}
+		check_set_result (out, vector_intersect_sorted (out, a, b, fn), expect, "vector intersect failed");
+
+		vector_clear (out);
+		for (i = 0; i < SET_DOMAIN; i++)
+		{
+			expect[i] = in_a[i] && !in_b[i];
+		}
+		check_set_result (out, vector_difference_sorted (out, a, b, fn), expect, "vector difference failed");
+
+		/* merge keeps both copies of common elements */
+		vector_clear (out);
+		n_a = vector_size (a);
+		n = vector_merge_sorted (out, a, b, fn);
+		TEST_ASSERT_MESSAGE (n == n_a + vector_size (b), "vector merge lost elements");
+		for (i = 1; i < n; i++)
+		{
+			TEST_ASSERT_MESSAGE (fn (vector_access (out, i - 1), vector_access (out, i)) <= 0,
+			                     "vector merge not sorted");
+		}
+		n_common = 0;
+		for (i = 0; i < SET_DOMAIN; i++)
+		{
+			expect[i] = in_a[i] || in_b[i];
+			n_common += in_a[i] && in_b[i];
+		}
+		TEST_ASSERT_MESSAGE (vector_unique (out, fn) == n_common, "vector merge lost duplicates");
+		check_set_result (out, vector_size (out), expect, "vector merge failed");
+	}
+
+	vector_destroy (a);
+	vector_destroy (b);
+	vector_destroy (out);
+}
+
+static void
+test_vector_set_ops (void)
+{
+	check_set_ops (sizeof (uint32_t), compare_unsigned);
+	check_set_ops (sizeof (uint32_t), vector_compare_u32);
+	check_set_ops (sizeof (uint64_t), vector_compare_u64);
+}
+
+static void
+test_vector_set_ops_append (void)
+{
+	uint32_t odd[] = { 1, 3, 5, 7, 9, 11, 13 }, low[] = { 1, 2, 3, 4, 5 }, i;
+	vector *a = vector_init (sizeof (uint32_t), 0, NULL);
+	vector *b = vector_init (sizeof (uint32_t), 0, NULL);
+	vector *out = vector_init (sizeof (uint32_t), 1, NULL);
+
+	for (i = 0; i < 7; i++)
+	{
+		vector_append (a, &odd[i]);
+	}
+	for (i = 0; i < 5; i++)
+	{
+		vector_append (b, &low[i]);
+	}
+
+	/* results go after whatever out already holds */
+	vector_append (out, &odd[6]);
+	TEST_ASSERT_MESSAGE (vector_intersect_sorted (out, a, b, vector_compare_u32) == 3,
+	                     "vector intersect count wrong");
+	TEST_ASSERT_MESSAGE (vector_difference_sorted (out, a, b, vector_compare_u32) == 4,
+	                     "vector difference count wrong");
+	TEST_ASSERT_MESSAGE (vector_size (out) == 8, "vector set ops did not append");
+	TEST_ASSERT_MESSAGE (*(uint32_t *)vector_access (out, 0) == 13, "vector set ops overwrote out");
+	TEST_ASSERT_MESSAGE (*(uint32_t *)vector_access (out, 3) == 5, "vector intersect wrong");
+	TEST_ASSERT_MESSAGE (*(uint32_t *)vector_access (out, 4) == 7, "vector difference wrong");
+
+	vector_destroy (a);
+	vector_destroy (b);
+	vector_destroy (out);
+}
+
 static void 
 test_vector_destroy (void)
 {
@@ -197,6 +394,528 @@ test_vector_destroy (void)
 	TEST_ASSERT_MESSAGE (0 == 0, "vector destroy should pass");
 }
 
+/**
+ * Fills the vector with one of several orderings: random values with many
+ * duplicates, ascending, descending, all equal, and an organ pipe rising then
+ * falling. Returns a sorted copy for reference.
+ */
+static vector *
+vector_init_pattern (size_t n, int pattern)
+{
+	vector *sorted = vector_init (sizeof (unsigned), n + 1, NULL);
+	unsigned i, val;
+
+	vector_clear (v);
+	for (i = 0; i < n; i++)
+	{
+		switch (pattern)
+		{
+		case 0: val = (unsigned)(rand () % 50); break;
+		case 1: val = i; break;
+		case 2: val = (unsigned)n - i; break;
+		case 3: val = 7; break;
+		default: val = (i < n / 2) ? i : (unsigned)n - i; break;
+		}
+		vector_append (v, &val);
+		vector_append (sorted, &val);
+	}
+	vector_sort (sorted, compare_unsigned);
+
+	return sorted;
+}
+
+static void
+test_vector_nth_element (void)
+{
+	static const size_t sizes[] = { 1, 2, 17, 100, 5000 };
+	unsigned *nth, i;
+	size_t s, n, k;
+	int pattern;
+	vector *sorted;
+
+	v = vector_init (sizeof (unsigned), 0, NULL);
+	for (s = 0; s < sizeof (sizes) / sizeof (sizes[0]); s++)
+	{
+		for (pattern = 0; pattern < 5; pattern++)
+		{
+			n = sizes[s];
+			k = (size_t)rand () % n;
+			sorted = vector_init_pattern (n, pattern);
+
+			vector_nth_element (v, k, compare_unsigned);
+			nth = vector_access (v, k);
+			TEST_ASSERT_MESSAGE (*nth == *(unsigned *)vector_access (sorted, k),
+			                     "vector nth element wrong");
+			for (i = 0; i < n; i++)
+			{
+				TEST_ASSERT_MESSAGE ((i < k) ? *(unsigned *)vector_access (v, i) <= *nth
+				                             : *(unsigned *)vector_access (v, i) >= *nth,
+				                     "vector nth element not partitioned");
+			}
+			vector_destroy (sorted);
+		}
+	}
+	vector_destroy (v);
+}
+
+static void
+test_vector_partial_sort (void)
+{
+	static const size_t ks[] = { 0, 1, 10, 999, 1000 };
+	size_t i, k;
+	int pattern;
+	vector *sorted;
+
+	v = vector_init (sizeof (unsigned), 0, NULL);
+	for (k = 0; k < sizeof (ks) / sizeof (ks[0]); k++)
+	{
+		for (pattern = 0; pattern < 5; pattern++)
+		{
+			sorted = vector_init_pattern (1000, pattern);
+			vector_partial_sort (v, ks[k], compare_unsigned);
+			for (i = 0; i < ks[k]; i++)
+			{
+				TEST_ASSERT_MESSAGE (*(unsigned *)vector_access (v, i) == *(unsigned *)vector_access (sorted, i),
+				                     "vector partial sort wrong");
+			}
+			vector_destroy (sorted);
+		}
+	}
+	vector_destroy (v);
+}
+
+static void
+test_vector_top_k (void)
+{
+	/* small k takes the heap, large k the copy and select, too large k all */
+	static const size_t ks[] = { 1, 5, 64, 4000, 5000, 6000 };
+	vector *sorted, *out;
+	size_t i, k, n, want;
+	int pattern;
+
+	v = vector_init (sizeof (unsigned), 0, NULL);
+	out = vector_init (sizeof (unsigned), 0, NULL);
+	for (k = 0; k < sizeof (ks) / sizeof (ks[0]); k++)
+	{
+		for (pattern = 0; pattern < 5; pattern++)
+		{
+			sorted = vector_init_pattern (5000, pattern);
+			vector_clear (out);
+			want = (ks[k] < 5000) ? ks[k] : 5000;
+
+			n = vector_top_k (v, ks[k], compare_unsigned, out);
+			TEST_ASSERT_MESSAGE (n == want && vector_size (out) == want, "vector top k count wrong");
+			for (i = 0; i < want; i++)
+			{
+				TEST_ASSERT_MESSAGE (*(unsigned *)vector_access (out, i) == *(unsigned *)vector_access (sorted, i),
+				                     "vector top k wrong");
+			}
+
+			/* the source is left as it was */
+			if (pattern == 1)
+			{
+				for (i = 0; i < 5000; i++)
+				{
+					TEST_ASSERT_MESSAGE (*(unsigned *)vector_access (v, i) == i, "vector top k changed source");
+				}
+			}
+			vector_destroy (sorted);
+		}
+	}
+	vector_destroy (out);
+	vector_destroy (v);
+}
+
+typedef struct
+{
+	unsigned key;
+	unsigned seq;
+} keyed;
+
+static int
+compare_keyed (const void *elem1, const void *elem2)
+{
+	const keyed *ptr1 = elem1;
+	const keyed *ptr2 = elem2;
+
+	return (ptr1->key > ptr2->key) - (ptr1->key < ptr2->key);
+}
+
+/**
+ * Stable sorts records with few distinct keys in several orderings: random,
+ * ascending, descending, ascending with a random tail appended, and a saw
+ * tooth of short runs alternating direction. Checks the keys are in order and
+ * that equal keys kept their original order.
+ */
+static void
+test_vector_sort_stable (void)
+{
+	static const size_t sizes[] = { 0, 1, 2, 63, 64, 65, 1000, 50000 };
+	vector *r = vector_init (sizeof (keyed), 0, NULL);
+	keyed rec, *prev, *cur;
+	size_t s, i, n;
+	int pattern;
+
+	for (s = 0; s < sizeof (sizes) / sizeof (sizes[0]); s++)
+	{
+		n = sizes[s];
+		for (pattern = 0; pattern < 5; pattern++)
+		{
+			vector_clear (r);
+			for (i = 0; i < n; i++)
+			{
+				rec.seq = (unsigned)i;
+				switch (pattern)
+				{
+				case 0: rec.key = (unsigned)(rand () % 20); break;
+				case 1: rec.key = (unsigned)(i / 3); break;
+				case 2: rec.key = (unsigned)((n - i) / 3); break;
+				case 3: rec.key = (i < n - n / 10) ? (unsigned)i : (unsigned)(rand () % n); break;
+				default: rec.key = ((i / 100) % 2) ? (unsigned)(100 - i % 100) / 4 : (unsigned)(i % 100) / 4; break;
+				}
+				vector_append (r, &rec);
+			}
+
+			vector_sort_stable (r, compare_keyed);
+
+			TEST_ASSERT_MESSAGE (vector_size (r) == n, "vector stable sort lost elements");
+			for (i = 1; i < n; i++)
+			{
+				prev = vector_access (r, i - 1);
+				cur = vector_access (r, i);
+				TEST_ASSERT_MESSAGE (prev->key <= cur->key, "vector stable sort not sorted");
+				TEST_ASSERT_MESSAGE (prev->key < cur->key || prev->seq < cur->seq,
+				                     "vector stable sort not stable");
+			}
+		}
+	}
+
+	vector_destroy (r);
+}
+
+static void
+test_vector_large_mapped (void)
+{
+	/* 9M elements of 8 bytes is past the 64 MB at which storage is mapped */
+	size_t i, n = 9UL << 20;
+	uint64_t val;
+	vector *big = vector_init (sizeof (uint64_t), 0, NULL);
+
+	vector_set_huge_pages (big, true);
+	for (i = 0; i < n; i++)
+	{
+		val = i * 3;
+		vector_append (big, &val);
+	}
+
+#ifdef __linux__
+	TEST_ASSERT_MESSAGE (vector_is_mapped (big), "large vector not mapped");
+#endif
+	for (i = 0; i < n; i += 4099)
+	{
+		TEST_ASSERT_MESSAGE (*(uint64_t *)vector_access (big, i) == i * 3, "large vector lost elements");
+	}
+	TEST_ASSERT_MESSAGE (*(uint64_t *)vector_access (big, n - 1) == (n - 1) * 3, "large vector lost elements");
+
+	/* cleared pages are returned and the vector is still usable */
+	vector_clear (big);
+	TEST_ASSERT_MESSAGE (vector_size (big) == 0, "large vector clear failed");
+	for (i = 0; i < 1000; i++)
+	{
+		vector_append (big, &i);
+	}
+	TEST_ASSERT_MESSAGE (*(uint64_t *)vector_access (big, 999) == 999, "large vector refill failed");
+	vector_destroy (big);
+
+	/* a large capacity hint maps up front */
+	big = vector_init (sizeof (uint64_t), n, NULL);
+#ifdef __linux__
+	TEST_ASSERT_MESSAGE (vector_is_mapped (big), "large hint not mapped");
+#endif
+	vector_destroy (big);
+}
+
+static void
+test_vector_map_file (void)
+{
+#ifdef __linux__
+	char path[] = "/tmp/TestVectorXXXXXX";
+	int fd = mkstemp (path);
+	vector *mv;
+	uint64_t i, val;
+
+	TEST_ASSERT_MESSAGE (fd >= 0, "could not create temporary file");
+	close (fd);
+
+	/* the empty file is initialized, then filled through several growths */
+	mv = vector_map_file (path, sizeof (uint64_t), VECTOR_MAP_RDWR | VECTOR_MAP_CREATE);
+	TEST_ASSERT_MESSAGE (mv != NULL, "vector map file create failed");
+	for (i = 0; i < 100000; i++)
+	{
+		val = i * 7;
+		vector_append (mv, &val);
+	}
+	TEST_ASSERT_MESSAGE (vector_sync (mv), "vector sync failed");
+	vector_destroy (mv);
+
+	/* the contents survive and map read only */
+	mv = vector_map_file (path, sizeof (uint64_t), VECTOR_MAP_RDONLY);
+	TEST_ASSERT_MESSAGE (mv != NULL, "vector map file reopen failed");
+	TEST_ASSERT_MESSAGE (vector_size (mv) == 100000, "vector map file lost its count");
+	for (i = 0; i < 100000; i++)
+	{
+		TEST_ASSERT_MESSAGE (*(uint64_t *)vector_access (mv, i) == i * 7, "vector map file lost elements");
+	}
+	val = 500 * 7;
+	TEST_ASSERT_MESSAGE (vector_search (mv, &val, vector_compare_u64, true) == vector_access (mv, 500),
+	                     "vector map file search failed");
+	vector_destroy (mv);
+
+	/* changes without a sync are recorded by destroy */
+	mv = vector_map_file (path, sizeof (uint64_t), VECTOR_MAP_RDWR);
+	vector_remove (mv, 0);
+	vector_destroy (mv);
+	mv = vector_map_file (path, sizeof (uint64_t), VECTOR_MAP_RDONLY);
+	TEST_ASSERT_MESSAGE (vector_size (mv) == 99999, "vector map file destroy lost the count");
+	TEST_ASSERT_MESSAGE (*(uint64_t *)vector_access (mv, 0) == 7, "vector map file remove lost");
+	vector_destroy (mv);
+
+	/* a mismatched element size or a missing file is refused */
+	TEST_ASSERT_MESSAGE (vector_map_file (path, sizeof (uint32_t), VECTOR_MAP_RDONLY) == NULL,
+	                     "vector map file accepted wrong element size");
+	unlink (path);
+	TEST_ASSERT_MESSAGE (vector_map_file (path, sizeof (uint64_t), VECTOR_MAP_RDONLY) == NULL,
+	                     "vector map file opened a missing file");
+#endif
+}
+
+static void
+test_vector_write_read (void)
+{
+#ifdef __linux__
+	char path[] = "/tmp/TestVectorXXXXXX";
+	int fd = mkstemp (path);
+	vector *big, *odd, *empty, *back;
+	uint64_t i, val;
+	uint8_t triple[3], flip;
+
+	TEST_ASSERT_MESSAGE (fd >= 0, "could not create temporary file");
+
+	/* several megabyte chunks, elements that do not divide 32, and nothing */
+	big = vector_init (sizeof (uint64_t), 0, NULL);
+	for (i = 0; i < 500000; i++)
+	{
+		val = i * 0x9e3779b97f4a7c15ULL;
+		vector_append (big, &val);
+	}
+	odd = vector_init (sizeof (triple), 0, NULL);
+	for (i = 0; i < 1000003; i++)
+	{
+		triple[0] = (uint8_t)i;
+		triple[1] = (uint8_t)(i >> 8);
+		triple[2] = (uint8_t)(i >> 16);
+		vector_append (odd, triple);
+	}
+	empty = vector_init (sizeof (uint32_t), 0, NULL);
+
+	TEST_ASSERT_MESSAGE (vector_write (big, fd), "vector write failed");
+	TEST_ASSERT_MESSAGE (vector_write (odd, fd), "vector write of odd elements failed");
+	TEST_ASSERT_MESSAGE (vector_write (empty, fd), "vector write of empty vector failed");
+
+	/* streams follow one another on the descriptor */
+	lseek (fd, 0, SEEK_SET);
+	back = vector_read (fd);
+	TEST_ASSERT_MESSAGE (back != NULL, "vector read failed");
+	TEST_ASSERT_MESSAGE (vector_size (back) == 500000, "vector read wrong size");
+	TEST_ASSERT_MESSAGE (memcmp (vector_access (back, 0), vector_access (big, 0), 500000 * sizeof (uint64_t)) == 0,
+	                     "vector read wrong elements");
+	vector_destroy (back);
+
+	back = vector_read (fd);
+	TEST_ASSERT_MESSAGE (back != NULL && vector_size (back) == 1000003, "vector read of odd elements failed");
+	TEST_ASSERT_MESSAGE (memcmp (vector_access (back, 0), vector_access (odd, 0), 1000003 * sizeof (triple)) == 0,
+	                     "vector read of odd elements wrong");
+	vector_destroy (back);
+
+	back = vector_read (fd);
+	TEST_ASSERT_MESSAGE (back != NULL && vector_size (back) == 0, "vector read of empty vector failed");
+	vector_destroy (back);
+	TEST_ASSERT_MESSAGE (vector_read (fd) == NULL, "vector read past the end");
+
+	/* a flipped bit in the elements fails the checksum */
+	pread (fd, &flip, 1, 100000);
+	flip ^= 0x10;
+	pwrite (fd, &flip, 1, 100000);
+	lseek (fd, 0, SEEK_SET);
+	TEST_ASSERT_MESSAGE (vector_read (fd) == NULL, "vector read accepted a corrupt stream");
+
+	/* so does a stream cut short, and one that is not a vector */
+	ftruncate (fd, 1000);
+	lseek (fd, 0, SEEK_SET);
+	TEST_ASSERT_MESSAGE (vector_read (fd) == NULL, "vector read accepted a truncated stream");
+	pwrite (fd, "ADTSSTRM", 8, 0);
+	lseek (fd, 0, SEEK_SET);
+	TEST_ASSERT_MESSAGE (vector_read (fd) == NULL, "vector read accepted another stream");
+
+	vector_destroy (big);
+	vector_destroy (odd);
+	vector_destroy (empty);
+	close (fd);
+	unlink (path);
+#endif
+}
+
+static unsigned n_destroyed;
+
+static void
+count_destroy (void *addr)
+{
+	++n_destroyed;
+}
+
+static void
+test_vector_init_static (void)
+{
+	struct { int tag; vector ids; } holder;
+	unsigned first[4], i;
+	vector small;
+
+	/* the object lives inside another struct, the elements on the heap */
+	vector_init_static (&holder.ids, sizeof (unsigned), 0, count_destroy);
+	for (i = 0; i < 100; i++)
+	{
+		vector_append (&holder.ids, &i);
+	}
+	TEST_ASSERT_MESSAGE (*(unsigned *)vector_access (&holder.ids, 99) == 99, "static vector lost elements");
+	n_destroyed = 0;
+	vector_destroy (&holder.ids);
+	TEST_ASSERT_MESSAGE (n_destroyed == 100, "static vector destroy missed elements");
+
+	/* elements stay in the buffer until it is outgrown */
+	vector_init_buffer (&small, sizeof (unsigned), first, sizeof (first), count_destroy);
+	for (i = 0; i < 4; i++)
+	{
+		vector_append (&small, &i);
+	}
+	TEST_ASSERT_MESSAGE (vector_access (&small, 0) == first, "buffer vector left its buffer early");
+	vector_insert (&small, &i, 2);
+	TEST_ASSERT_MESSAGE (vector_access (&small, 0) != first, "buffer vector did not spill");
+	TEST_ASSERT_MESSAGE (vector_size (&small) == 5 && *(unsigned *)vector_access (&small, 2) == 4 &&
+	                     *(unsigned *)vector_access (&small, 4) == 3, "buffer vector spill lost elements");
+	for (i = 0; i < 1000; i++)
+	{
+		vector_append (&small, &i);
+	}
+	n_destroyed = 0;
+	vector_destroy (&small);
+	TEST_ASSERT_MESSAGE (n_destroyed == 1005, "buffer vector destroy missed elements");
+
+	/* one that never spills is destroyed without touching the heap */
+	vector_init_buffer (&small, sizeof (unsigned), first, sizeof (first), NULL);
+	vector_append (&small, &i);
+	vector_sort (&small, compare_unsigned);
+	vector_destroy (&small);
+	TEST_ASSERT_MESSAGE (first[0] == i, "buffer vector did not use the buffer");
+}
+
+#ifdef __linux__
+/**
+ * Reads a snapshot on another thread, then lets go of it.
+ */
+static void *
+clone_reader (void *arg)
+{
+	vector *snapshot = arg;
+	uint64_t sum = 0;
+	size_t i;
+
+	for (i = 0; i < vector_size (snapshot); i++)
+	{
+		sum += *(unsigned *)vector_access (snapshot, i);
+	}
+	vector_destroy (snapshot);
+
+	return (void *)(uintptr_t)(sum == 999 * 1000 / 2);
+}
+#endif
+
+static void
+test_vector_clone_cow (void)
+{
+	vector *orig, *a, *b;
+	unsigned i, val = 12345;
+	void *before;
+
+	orig = vector_init (sizeof (unsigned), 0, NULL);
+	for (i = 0; i < 1000; i++)
+	{
+		vector_append (orig, &i);
+	}
+
+	/* clones share the array until one of them changes */
+	a = vector_clone_cow (orig);
+	b = vector_clone_cow (a);
+	TEST_ASSERT_MESSAGE (vector_access (a, 0) == vector_access (orig, 0) &&
+	                     vector_access (b, 0) == vector_access (orig, 0), "clone copied the elements");
+
+	vector_replace (a, &val, 10);
+	TEST_ASSERT_MESSAGE (vector_access (a, 0) != vector_access (orig, 0), "changed clone still shares");
+	TEST_ASSERT_MESSAGE (*(unsigned *)vector_access (a, 10) == val, "clone replace lost");
+	TEST_ASSERT_MESSAGE (*(unsigned *)vector_access (orig, 10) == 10 &&
+	                     *(unsigned *)vector_access (b, 10) == 10, "clone replace leaked to sharers");
+
+	vector_sort (orig, compare_unsigned);
+	vector_remove (orig, 0);
+	TEST_ASSERT_MESSAGE (vector_size (orig) == 999 && vector_size (b) == 1000, "clone remove leaked");
+	TEST_ASSERT_MESSAGE (*(unsigned *)vector_access (b, 0) == 0, "clone changed by the original");
+
+	/* b is now the only sharer left and keeps the array without a copy */
+	vector_destroy (a);
+	before = vector_access (b, 0);
+	vector_append (b, &val);
+	TEST_ASSERT_MESSAGE (vector_access (b, 0) == before, "last sharer copied its array");
+	vector_destroy (b);
+
+	/* clearing a clone leaves the shared elements to the original */
+	a = vector_clone_cow (orig);
+	vector_clear (a);
+	vector_append (a, &val);
+	TEST_ASSERT_MESSAGE (vector_size (a) == 1 && *(unsigned *)vector_access (a, 0) == val, "cleared clone wrong");
+	TEST_ASSERT_MESSAGE (vector_size (orig) == 999 && *(unsigned *)vector_access (orig, 0) == 1,
+	                     "clearing a clone changed the original");
+	vector_destroy (a);
+
+	/* the original may be destroyed while clones still read */
+	a = vector_clone_cow (orig);
+	vector_destroy (orig);
+	TEST_ASSERT_MESSAGE (vector_size (a) == 999 && *(unsigned *)vector_access (a, 998) == 999,
+	                     "clone lost elements when the original was destroyed");
+
+#ifdef __linux__
+	/* snapshots read on other threads while the writer changes its own */
+	pthread_t readers[4];
+	void *ok;
+
+	orig = vector_init (sizeof (unsigned), 0, NULL);
+	for (i = 0; i < 1000; i++)
+	{
+		vector_append (orig, &i);
+	}
+	for (i = 0; i < 4; i++)
+	{
+		pthread_create (&readers[i], NULL, clone_reader, vector_clone_cow (orig));
+	}
+	vector_replace (orig, &val, 0);
+	for (i = 0; i < 4; i++)
+	{
+		pthread_join (readers[i], &ok);
+		TEST_ASSERT_MESSAGE (ok != NULL, "snapshot read on another thread changed");
+	}
+	vector_destroy (orig);
+#endif
+	vector_destroy (a);
+}
+
 static int 
 vector_size_compare (const void *elem1, const void *elem2)
 {
@@ -281,7 +1000,19 @@ main(void)
 	RUN_TEST (test_vector_bsearch);
 	RUN_TEST (test_vector_lsearch);
 	RUN_TEST (test_vector_sort);
+	RUN_TEST (test_vector_unique);
+	RUN_TEST (test_vector_set_ops);
+	RUN_TEST (test_vector_set_ops_append);
 	RUN_TEST (test_vector_destroy);
 	RUN_TEST (test_complex_vector);
+	RUN_TEST (test_vector_nth_element);
+	RUN_TEST (test_vector_partial_sort);
+	RUN_TEST (test_vector_top_k);
+	RUN_TEST (test_vector_sort_stable);
+	RUN_TEST (test_vector_large_mapped);
+	RUN_TEST (test_vector_map_file);
+	RUN_TEST (test_vector_write_read);
+	RUN_TEST (test_vector_init_static);
+	RUN_TEST (test_vector_clone_cow);
 	return UNITY_END ();
 }